@@ -15,11 +15,56 @@ namespace
 	GLuint VBO, VAO;
 
 	Shader* currentShader;
+
+	// Threads that decode textures and import models.
+	ThreadPool* workers = NULL;
 }
 
 // Variable to toggle the Flash Light.
 GLuint flashLight = 0;
 
+// Feature keywords of the lit shaders, bit i of a variant key enables keyword i.
+const char* LIGHTING_KEYWORDS[] = { "POINT_LIGHT", "FLASH_LIGHT", "REFLECTION_MAP" };
+const unsigned int FEATURE_POINT_LIGHT = 1 << 0;
+const unsigned int FEATURE_FLASH_LIGHT = 1 << 1;
+const unsigned int FEATURE_REFLECTION_MAP = 1 << 2;
+
+// Per-draw uniforms of one variant of the wall shader.
+struct WallUniforms
+{
+	UniformSampler	diffuseMap;
+	UniformSampler	specularMap;
+	UniformSampler	normalMap;
+	UniformSampler	shadowMap;
+	UniformSampler	pointShadowMap;
+	UniformMat4		model;
+};
+
+// Per-draw uniforms of one variant of the model shader.
+struct ModelUniforms
+{
+	UniformSampler	shadowMap;
+	UniformSampler	pointShadowMap;
+	UniformSampler	skybox;
+	UniformMat4		model;
+};
+
+// Variable to toggle the profiler overlay.
+bool showOverlay = false;
+
+// Camera path that is played back in benchmark mode and recorded with F5.
+CameraPath cameraPath;
+GLfloat pathTime = 0.0f;
+GLfloat nextKeyTime = 0.0f;
+bool recordingPath = false;
+
+// Frames of a benchmark run that are left out of the statistics, and its fixed timestep.
+const unsigned int BENCHMARK_WARMUP_FRAMES = 30;
+const GLfloat BENCHMARK_TIMESTEP = 1.0f / 60.0f;
+
+// Seconds per loading screen frame the main thread spends on tasks of the load graph.
+const double LOADING_TASK_BUDGET = 0.008;
+
 // Camera
 Camera camera(glm::vec3(1.0f, 0.0f, -1.0f));
 
@@ -37,6 +82,39 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	//cout << key << endl;
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
+	// F3 shows/hides the profiler overlay.
+	if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+		showOverlay = !showOverlay;
+	// F5 starts/stops recording the camera flight to camera_path.txt.
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS)
+	{
+		if (recordingPath)
+			cameraPath.Save("camera_path.txt");
+
+		cameraPath.Clear();
+		pathTime = nextKeyTime = 0.0f;
+		recordingPath = !recordingPath;
+	}
+	// L turns the model LODs on/off.
+	if (key == GLFW_KEY_L && action == GLFW_PRESS)
+	{
+		Model::SetLodEnabled(!Model::IsLodEnabled());
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_RENDER, "Model LODs %s.", Model::IsLodEnabled() ? "on" : "off");
+	}
+	// C turns the meshlet culling on/off.
+	if (key == GLFW_KEY_C && action == GLFW_PRESS)
+	{
+		Model::SetClusterCullingEnabled(!Model::IsClusterCullingEnabled());
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_RENDER, "Cluster culling %s.", Model::IsClusterCullingEnabled() ? "on" : "off");
+	}
+	// F9 starts/stops a trace capture of the CPU zones.
+	if (key == GLFW_KEY_F9 && action == GLFW_PRESS)
+	{
+		if (Profiler::IsTracing())
+			Profiler::StopTrace();
+		else
+			Profiler::StartTrace("trace.json", 0);
+	}
 	if (key >= 0 && key < 1024)
 	{
 		if (action == GLFW_PRESS)
@@ -138,6 +216,65 @@ Application::Application(const char* title, int width, int height)
 	appTitle = title;
 	appWidth = width;
 	appHeight = height;
+	traceFrames = 0;
+	telemetryPath = NULL;
+	benchmarkFrames = 0;
+	benchmarkPath = NULL;
+	benchmarkReport = NULL;
+	packPath = NULL;
+}
+
+/*
+	Records a trace capture of the first frames,
+	loading included, to trace.json. Has to be
+	called before Run().
+
+	frames	-	Number of frames to record.
+*/
+void Application::CaptureTrace(unsigned int frames)
+{
+	traceFrames = frames;
+}
+
+/*
+	Streams the telemetry of every frame to a CSV
+	file. Has to be called before Run().
+
+	csvPath	-	Path of the CSV file.
+*/
+void Application::StreamTelemetry(const char* csvPath)
+{
+	telemetryPath = csvPath;
+}
+
+/*
+	Turns Run() into a benchmark : the window is hidden,
+	the camera follows a recorded path instead of the
+	input, time advances in fixed steps and after the
+	given number of frames a JSON report is written and
+	the application exits. Has to be called before Run().
+
+	frames		-	Number of frames to render, warm-up included.
+	cameraPath	-	Camera path file (see CameraPath), or NULL
+					for a lap around the room.
+	reportPath	-	File the JSON report is written to.
+*/
+void Application::EnableBenchmark(unsigned int frames, const char* cameraPath, const char* reportPath)
+{
+	benchmarkFrames = frames;
+	benchmarkPath = cameraPath;
+	benchmarkReport = reportPath;
+}
+
+/*
+	Reads the assets from a pack (see FileSystem) instead
+	of the loose files. Has to be called before Run().
+
+	packPath	-	Pack file, as written by FileSystem::BuildPack().
+*/
+void Application::MountPack(const char* packPath)
+{
+	this->packPath = packPath;
 }
 
 /*
@@ -146,9 +283,7 @@ Application::Application(const char* title, int width, int height)
 */
 bool Application::InitGLFW()
 {
-#ifdef DEBUG
-	log("Starting GLFW context, OpenGL 3.3.");
-#endif
+	LOG_DEBUG(LOG_CATEGORY_CORE, "Starting GLFW context, OpenGL 3.3.");
 	// Init GLFW
 	glfwInit();
 	// Set all the required options for GLFW
@@ -157,6 +292,11 @@ bool Application::InitGLFW()
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
 
+	// Benchmarks render into a window that is never shown, so they
+	// run on machines without a desktop (e.g. with Mesa's llvmpipe).
+	if (benchmarkFrames > 0)
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
 	glEnable(GL_MULTISAMPLE); // Enabled by default on some drivers, but not all so always enable to make sure
 
 	// Create a GLFWwindow object that we can use for GLFW's functions
@@ -164,21 +304,21 @@ bool Application::InitGLFW()
 	//appWindow = glfwCreateWindow(appWidth, appHeight, appTitle, glfwGetPrimaryMonitor(), NULL);
 	if (appWindow == nullptr)
 	{
-	#ifdef DEBUG
-		log("Failed to create GLFW window.");
-	#endif
+		LOG_ERROR(LOG_CATEGORY_CORE, "Failed to create GLFW window.");
 		
 		glfwTerminate();
 		return false;
 	}
 	else
 	{
-	#ifdef DEBUG
-		log("GLFW Window created successfully.");
-	#endif
-		
+		LOG_DEBUG(LOG_CATEGORY_CORE, "GLFW Window created successfully.");
 	}
 	glfwMakeContextCurrent(appWindow);
+
+	// Don't let the display's refresh rate cap benchmark frame times.
+	if (benchmarkFrames > 0)
+		glfwSwapInterval(0);
+
 	// Set the required callback functions
 	glfwSetKeyCallback(appWindow, key_callback);
 
@@ -195,16 +335,12 @@ bool Application::InitGLEW()
 	// Initialize GLEW to setup the OpenGL Function pointers
 	if (glewInit() != GLEW_OK)
 	{
-	#ifdef DEBUG
-		log("Failed to initialize GLEW.");
-	#endif
+		LOG_ERROR(LOG_CATEGORY_CORE, "Failed to initialize GLEW.");
 		return false;
 	}
 	else
 	{
-	#ifdef DEBUG
-		log("GLEW initialized successfully.");
-	#endif
+		LOG_DEBUG(LOG_CATEGORY_CORE, "GLEW initialized successfully.");
 	}
 
 	return true;
@@ -218,20 +354,59 @@ bool Application::InitGLEW()
 bool Application::InitEngine()
 {
 	InitUtility();
+	Profiler::Init();
+
+	if (traceFrames > 0)
+		Profiler::StartTrace("trace.json", traceFrames);
+
+	// Not fatal either, histograms and averages work without the CSV file.
+	Telemetry::Init(telemetryPath);
 
 	log("===Initializing Engine===");
 
-#ifdef DEBUG
-	log("Utilities initialized successfully.");
-#endif
+	// Not fatal, the assets are read as loose files without it.
+	if (packPath != NULL)
+		FileSystem::Mount(packPath);
+
+	if (FileSystem::IsMounted())
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "Reading assets from the pack%s.", FileSystem::IsLooseFilesEnabled() ? " and loose files" : " only");
+	else if (!FileSystem::IsLooseFilesEnabled())
+		LOG_WARNING(LOG_CATEGORY_ASSET, "No pack mounted and loose files are off, no assets can be read.");
+
+	LOG_DEBUG(LOG_CATEGORY_CORE, "Utilities initialized successfully.");
 
 	if (!InitGLFW())
 		return false;
 	if (!InitGLEW())
 		return false;
+
+	// Not fatal, programs are compiled from source without it.
+	ShaderCache::Init("ShaderCache");
+
+	workers = new ThreadPool(ThreadPool::GetDefaultThreadCount());
+	TextureStreamer::Init(workers);
+	TextureCache::Init(true);
+
 	if (!TextRenderer::Init(appWidth, appHeight))
 		return false;
 
+	// Not fatal, the engine runs without GPU timings.
+	GpuProfiler::Init();
+
+	if (benchmarkFrames > 0)
+	{
+		// Same particles and the same camera flight on every run.
+		srand(1);
+
+		if (benchmarkPath == NULL)
+			cameraPath.CreateDefault();
+		else if (!cameraPath.Load(benchmarkPath))
+			return false;
+
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Benchmark : %u frames, %u camera keys, %.1f s path.",
+			benchmarkFrames, cameraPath.GetKeyCount(), cameraPath.GetDuration());
+	}
+
 	// Define the viewport dimensions
 	glViewport(0, 0, appWidth, appHeight);
 
@@ -248,36 +423,82 @@ int Application::Run()
 {
 	// Initialize the engine.
 	if (!InitEngine())
+	{
+		Shutdown();
 		return 1;
+	}
 
-#ifdef DEBUG
-	log("Engine intialization complete.");
-#endif
+	LOG_DEBUG(LOG_CATEGORY_CORE, "Engine intialization complete.");
+
+	// The scene's objects are destroyed when it returns, so they give back
+	// their textures and buffers while the caches and the context exist.
+	int result = RunScene();
+
+	Shutdown();
+	return result;
+}
+
+/*
+	Creates the scene and runs the main loop until the
+	window is closed or the benchmark has finished.
+*/
+int Application::RunScene()
+{
+	// Presented until the scene has loaded, so the window never freezes.
+	LoadingScreen* loadingScreen = new LoadingScreen("Textures/loading_screen.gif");
+
+	// The models are read and imported on the workers while the rest of the scene
+	// is set up here, then their meshes are uploaded between loading screen frames.
+	// The graph is declared last, so it waits for its tasks before the models go.
+	Model pedestal, nanosuit;
+	ModelLoad pedestalLoad, nanosuitLoad;
+	LoadGraph sceneLoad(workers);
+
+	unsigned int pedestalImport = sceneLoad.Add("Importing Liberty Statue", LOAD_TASK_WORKER, 4.0f,
+		[&pedestalLoad]() { Model::Prepare("Models/LibertyStatue/LibertStatue.obj", pedestalLoad); });
+	unsigned int pedestalUpload = sceneLoad.Add("Uploading Liberty Statue", LOAD_TASK_MAIN, 1.0f,
+		[&pedestal, &pedestalLoad]() { pedestal.Upload(pedestalLoad); });
+	sceneLoad.AddDependency(pedestalUpload, pedestalImport);
+
+	unsigned int nanosuitImport = sceneLoad.Add("Importing Nanosuit", LOAD_TASK_WORKER, 4.0f,
+		[&nanosuitLoad]() { Model::Prepare("Models/Nanosuit/nanosuit.obj", nanosuitLoad); });
+	unsigned int nanosuitUpload = sceneLoad.Add("Uploading Nanosuit", LOAD_TASK_MAIN, 1.0f,
+		[&nanosuit, &nanosuitLoad]() { nanosuit.Upload(nanosuitLoad); });
+	sceneLoad.AddDependency(nanosuitUpload, nanosuitImport);
+
+	sceneLoad.Start();
+
+	PresentLoadingScreen(*loadingScreen, sceneLoad, "Setting up the scene");
+	double firstFrameTime = getTimeElapsed();
 
 	// Create a rain particle system.
 	ParticleSystem rain("Textures/Particle.bmp", 1000, false);
 
-	float prevTime = 0.0f;
-	float currTime = 0.0f;
-	float deltaTime = 0.0f;
-
-	prevTime = getTimeElapsed();
+	double prevTime = 0.0;
+	double currTime = 0.0;
+	double deltaTime = 0.0;
 
 	// Set the required callback functions
 	glfwSetKeyCallback(appWindow, key_callback);
-	glfwSetCursorPosCallback(appWindow, mouse_callback);
-	glfwSetScrollCallback(appWindow, scroll_callback);
 
-#ifdef DEBUG
-	log("Callback functions successfully set.");
-#endif
+	// Benchmarks fly the camera along the path, mouse input would make runs differ.
+	if (benchmarkFrames == 0)
+	{
+		glfwSetCursorPosCallback(appWindow, mouse_callback);
+		glfwSetScrollCallback(appWindow, scroll_callback);
+	}
+
+	LOG_DEBUG(LOG_CATEGORY_CORE, "Callback functions successfully set.");
 	
 	// Options
 	glfwSetInputMode(appWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
 	log("");
 	log("===Basic Shader===");
-	Shader ourShader("Shaders/basic.vert", "Shaders/basic.frag");
+	ShaderPermutations wallShaders("Shaders/basic.vert", "Shaders/basic.frag", LIGHTING_KEYWORDS, 2);
+	wallShaders.Precompile();
+
+	PresentLoadingScreen(*loadingScreen, sceneLoad, "Building the walls");
 
 	// World space positions of our walls
 	glm::vec3 wallTranslations[] = {
@@ -400,16 +621,7 @@ int Application::Run()
 	glBindVertexArray(VAO_WALL);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_WALL);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(wall_vertices), &wall_vertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(11 * sizeof(GLfloat)));
+	SetupVertexAttributes<TangentVertex>();
 
 	glBindVertexArray(0);
 
@@ -489,16 +701,7 @@ int Application::Run()
 	glBindVertexArray(VAO_WALL_FRONT);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_WALL_FRONT);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(front_wall_vertices), &front_wall_vertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(11 * sizeof(GLfloat)));
+	SetupVertexAttributes<TangentVertex>();
 
 	glBindVertexArray(0);
 
@@ -578,16 +781,7 @@ int Application::Run()
 	glBindVertexArray(VAO_WALL_LEFT);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_WALL_LEFT);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(wall_left_vertices), &wall_left_vertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(11 * sizeof(GLfloat)));
+	SetupVertexAttributes<TangentVertex>();
 
 	glBindVertexArray(0);
 
@@ -667,16 +861,7 @@ int Application::Run()
 	glBindVertexArray(VAO_WALL_RIGHT);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_WALL_RIGHT);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(right_wall_vertices), &right_wall_vertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(11 * sizeof(GLfloat)));
+	SetupVertexAttributes<TangentVertex>();
 
 	glBindVertexArray(0);
 
@@ -765,16 +950,7 @@ int Application::Run()
 	glBindVertexArray(VAO_FLOOR);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_FLOOR);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(floor_vertices), &floor_vertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(11 * sizeof(GLfloat)));
+	SetupVertexAttributes<TangentVertex>();
 
 	glBindVertexArray(0);
 
@@ -782,6 +958,8 @@ int Application::Run()
 	log("===Floor RenderObject===");
 	RenderObject floor("Textures/floor_diffuse.bmp", "Textures/floor_normal.bmp", "Textures/floor_specular.bmp", floor_vertices, VAO_FLOOR, VBO_FLOOR);
 
+	PresentLoadingScreen(*loadingScreen, sceneLoad, "Setting up the skybox");
+
 	// Point Lights.
 	log("");
 	log("===Point Light Shader===");
@@ -811,6 +989,8 @@ int Application::Run()
 	faces.push_back("Textures/skybox_front.jpg");
 	skybox.LoadCubemap(faces);
 
+	PresentLoadingScreen(*loadingScreen, sceneLoad, "Compiling shaders");
+
 	// For post-processing
 	GLfloat quadVertices[] = {   // Vertex attributes for a quad that fills the entire screen in Normalized Device Coordinates.
 		// Positions   // TexCoords
@@ -851,7 +1031,7 @@ int Application::Run()
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
 
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << endl;
+		LOG_ERROR(LOG_CATEGORY_RENDER, "Framebuffer is not complete!");
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	// second framebuffer
@@ -862,24 +1042,17 @@ int Application::Run()
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, screenTexture, 0);	// We only need a color buffer
 
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		cout << "ERROR::FRAMEBUFFER:: Intermediate framebuffer is not complete!" << endl;
+		LOG_ERROR(LOG_CATEGORY_RENDER, "Intermediate framebuffer is not complete!");
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	log("");
 	log("===Post Processing Shader===");
 	Shader screenShader("Shaders/post_processing.vert", "Shaders/post_processing.frag");
 
-	log("");
-	log("===Liberty Statue Model===");
-	Model pedestal("Models/LibertyStatue/LibertStatue.obj");
-	
-	log("");
-	log("===Nanosuit Model===");
-	Model nanosuit("Models/Nanosuit/nanosuit.obj");
-	
 	log("");
 	log("===Model Loading Shader===");
-	Shader model_loading("Shaders/crysis.vert", "Shaders/crysis.frag");
+	ShaderPermutations modelShaders("Shaders/crysis.vert", "Shaders/crysis.frag", LIGHTING_KEYWORDS, 3);
+	modelShaders.Precompile();
 
 	log("");
 	log("===Particle Shader===");
@@ -893,6 +1066,8 @@ int Application::Run()
 	log("===Environment Shader===");
 	Shader environmentShader("Shaders/environment.vert", "Shaders/environment.frag");
 
+	PresentLoadingScreen(*loadingScreen, sceneLoad, "Setting up the shadow maps");
+
 	GLfloat cubeVertices[] = {
 		// Positions        // Normals  
 		-1.0f, 1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
@@ -948,9 +1123,16 @@ int Application::Run()
 	glReadBuffer(GL_NONE);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-#ifdef DEBUG
-	log("Buffers initialized.");
-#endif
+	LOG_DEBUG(LOG_CATEGORY_CORE, "Buffers initialized.");
+
+	// The shadow maps are only rendered here, with the models, so they have to be loaded.
+	while (!sceneLoad.IsFinished() && !glfwWindowShouldClose(appWindow))
+		PresentLoadingScreen(*loadingScreen, sceneLoad, NULL);
+	sceneLoad.LogReport();
+
+	// Free the image and its texture, they aren't shown again.
+	delete loadingScreen;
+	loadingScreen = NULL;
 
 	// Render to generate the depth map
 	glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
@@ -969,13 +1151,16 @@ int Application::Run()
 
 	simpleDepthShader.Use();
 
-	GLint lightSpaceMatrixLocation = glGetUniformLocation(simpleDepthShader.program, "lightSpaceMatrix");
-	glUniformMatrix4fv(lightSpaceMatrixLocation, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
+	UniformMat4(simpleDepthShader.GetUniform("lightSpaceMatrix")).Set(lightSpaceMatrix);
+	UniformMat4 depthModel = simpleDepthShader.GetUniform("model");
 
 	glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
 
 	// Render scene onto the depth-map
 	{
+		PROFILE_SCOPE("Shadow Pass (Directional)");
+		GPU_SCOPE("Shadow Pass (Directional)");
+
 		// Rendering the wall.
 		glBindVertexArray(front_wall.VAO);
 		for (GLuint i = 0; i < 5; i++)
@@ -984,7 +1169,7 @@ int Application::Run()
 			glm::mat4 model;
 			model = glm::translate(model, wallTranslations[i]);
 			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			depthModel.Set(model);
 			front_wall.Render(simpleDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -996,7 +1181,7 @@ int Application::Run()
 			glm::mat4 model;
 			model = glm::translate(model, wallTranslations[i]);
 			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			depthModel.Set(model);
 			back_wall.Render(simpleDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -1008,7 +1193,7 @@ int Application::Run()
 			glm::mat4 model;
 			model = glm::translate(model, wallTranslations[i]);
 			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			depthModel.Set(model);
 			left_wall.Render(simpleDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -1020,7 +1205,7 @@ int Application::Run()
 			glm::mat4 model;
 			model = glm::translate(model, wallTranslations[i]);
 			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			depthModel.Set(model);
 			right_wall.Render(simpleDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -1031,7 +1216,7 @@ int Application::Run()
 			// Calculate the model matrix for each object and pass it to shader before drawing
 			glm::mat4 model;
 			model = glm::translate(model, floorTranslations[i]);
-			glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			depthModel.Set(model);
 			floor.Render(simpleDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -1040,7 +1225,7 @@ int Application::Run()
 		glm::mat4 model_cube;
 		model_cube = glm::translate(model_cube, glm::vec3(10.0f, -2.0f, -10.0f)); // Translate it down a bit so it's at the center of the scene
 		model_cube = glm::scale(model_cube, glm::vec3(1.0f));
-		glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model_cube));
+		depthModel.Set(model_cube);
 
 		glBindVertexArray(cubeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -1053,15 +1238,17 @@ int Application::Run()
 		model_2 = glm::translate(model_2, glm::vec3(20.0f, -2.5f, -2.0f)); // Translate it down a bit so it's at the center of the scene
 		model_2 = glm::rotate(model_2, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		model_2 = glm::scale(model_2, glm::vec3(3.0f));
-		glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model_2));
-		pedestal.Draw(simpleDepthShader);
+		depthModel.Set(model_2);
+		pedestal.SelectLod(LOD_PASS_SHADOW, model_2, lightView, lightProjection, (float)SHADOW_HEIGHT);
+		pedestal.Draw(simpleDepthShader, LOD_PASS_SHADOW);
 
 		// Now draw the nanosuit
 		glm::mat4 model_3;
 		model_3 = glm::translate(model_3, glm::vec3(10.0f, -2.5f, -12.5f)); // Translate it down a bit so it's at the center of the scene
 		model_3 = glm::scale(model_3, glm::vec3(0.2f));
-		glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model_3));
-		nanosuit.Draw(simpleDepthShader);
+		depthModel.Set(model_3);
+		nanosuit.SelectLod(LOD_PASS_SHADOW, model_3, lightView, lightProjection, (float)SHADOW_HEIGHT);
+		nanosuit.Draw(simpleDepthShader, LOD_PASS_SHADOW);
 #endif
 	}
 
@@ -1114,13 +1301,16 @@ int Application::Run()
 
 	pointDepthShader.Use();
 
-	lightSpaceMatrixLocation = glGetUniformLocation(pointDepthShader.program, "lightSpaceMatrix");
-	glUniformMatrix4fv(lightSpaceMatrixLocation, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
+	UniformMat4(pointDepthShader.GetUniform("lightSpaceMatrix")).Set(lightSpaceMatrix);
+	UniformMat4 pointDepthModel = pointDepthShader.GetUniform("model");
 
 	glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
 
 	// Render scene onto the depth-map
 	{
+		PROFILE_SCOPE("Shadow Pass (Point)");
+		GPU_SCOPE("Shadow Pass (Point)");
+
 		// Rendering the wall.
 		glBindVertexArray(front_wall.VAO);
 		for (GLuint i = 0; i < 5; i++)
@@ -1129,7 +1319,7 @@ int Application::Run()
 			glm::mat4 model;
 			model = glm::translate(model, wallTranslations[i]);
 			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(pointDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			pointDepthModel.Set(model);
 			front_wall.Render(pointDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -1141,7 +1331,7 @@ int Application::Run()
 			glm::mat4 model;
 			model = glm::translate(model, wallTranslations[i]);
 			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(pointDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			pointDepthModel.Set(model);
 			back_wall.Render(pointDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -1153,7 +1343,7 @@ int Application::Run()
 			glm::mat4 model;
 			model = glm::translate(model, wallTranslations[i]);
 			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(pointDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			pointDepthModel.Set(model);
 			left_wall.Render(pointDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -1165,7 +1355,7 @@ int Application::Run()
 			glm::mat4 model;
 			model = glm::translate(model, wallTranslations[i]);
 			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(pointDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			pointDepthModel.Set(model);
 			right_wall.Render(pointDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -1176,7 +1366,7 @@ int Application::Run()
 			// Calculate the model matrix for each object and pass it to shader before drawing
 			glm::mat4 model;
 			model = glm::translate(model, floorTranslations[i]);
-			glUniformMatrix4fv(glGetUniformLocation(pointDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+			pointDepthModel.Set(model);
 			floor.Render(pointDepthShader, false);
 		}
 		glBindVertexArray(0);
@@ -1185,7 +1375,7 @@ int Application::Run()
 		glm::mat4 model_cube;
 		model_cube = glm::translate(model_cube, glm::vec3(10.0f, -2.0f, -10.0f)); // Translate it down a bit so it's at the center of the scene
 		model_cube = glm::scale(model_cube, glm::vec3(1.0f));
-		glUniformMatrix4fv(glGetUniformLocation(pointDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model_cube));
+		pointDepthModel.Set(model_cube);
 
 		glBindVertexArray(cubeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -1197,37 +1387,133 @@ int Application::Run()
 		model_2 = glm::translate(model_2, glm::vec3(20.0f, -2.5f, -2.0f)); // Translate it down a bit so it's at the center of the scene
 		model_2 = glm::rotate(model_2, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		model_2 = glm::scale(model_2, glm::vec3(3.0f));
-		glUniformMatrix4fv(glGetUniformLocation(pointDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model_2));
-		pedestal.Draw(pointDepthShader);
+		pointDepthModel.Set(model_2);
+		pedestal.SelectLod(LOD_PASS_SHADOW, model_2, lightView, lightProjection, (float)SHADOW_HEIGHT);
+		pedestal.Draw(pointDepthShader, LOD_PASS_SHADOW);
 
 		// Now draw the nanosuit
 		glm::mat4 model_3;
 		model_3 = glm::translate(model_3, glm::vec3(10.0f, -2.5f, -12.5f)); // Translate it down a bit so it's at the center of the scene
 		model_3 = glm::scale(model_3, glm::vec3(0.2f));
-		glUniformMatrix4fv(glGetUniformLocation(pointDepthShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model_3));
-		nanosuit.Draw(pointDepthShader);
+		pointDepthModel.Set(model_3);
+		nanosuit.SelectLod(LOD_PASS_SHADOW, model_3, lightView, lightProjection, (float)SHADOW_HEIGHT);
+		nanosuit.Draw(pointDepthShader, LOD_PASS_SHADOW);
 #endif
 	}
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-#ifdef DEBUG
-	log("Depth Maps Generated.");
+	LOG_DEBUG(LOG_CATEGORY_CORE, "Depth Maps Generated.");
+
+	// Camera, light and shadow data live in uniform buffers shared by all programs.
+	UniformBuffer frameBuffer, lightBuffer, shadowBuffer;
+	frameBuffer.Create(UNIFORM_BINDING_FRAME, sizeof(FrameConstants));
+	lightBuffer.Create(UNIFORM_BINDING_LIGHTS, sizeof(LightConstants));
+	shadowBuffer.Create(UNIFORM_BINDING_SHADOWS, sizeof(ShadowConstants));
+
+	ShadowConstants shadowConstants;
+	shadowConstants.direcLightSpaceMatrix = direcLightSpaceMatrix;
+	shadowConstants.pointLightSpaceMatrix = pointLightSpaceMatrix;
+	shadowBuffer.Update(&shadowConstants);
+
+	FrameConstants frameConstants;
+	LightConstants lightConstants;
+	memset(&frameConstants, 0, sizeof(frameConstants));
+	memset(&lightConstants, 0, sizeof(lightConstants));
+	lightConstants.lightPos = glm::vec3(-2.4f, 1.0f, -15.0f);
+
+	// Resolve the remaining per-draw uniforms once, the loop does no name lookups.
+	std::vector<WallUniforms> wallUniforms(wallShaders.GetVariantCount());
+	for (unsigned int key = 0; key < wallUniforms.size(); ++key)
+	{
+		Shader& shader = wallShaders.Get(key);
+		wallUniforms[key].diffuseMap = shader.GetUniform("diffuseMap");
+		wallUniforms[key].specularMap = shader.GetUniform("specularMap");
+		wallUniforms[key].normalMap = shader.GetUniform("normalMap");
+		wallUniforms[key].shadowMap = shader.GetUniform("shadowMap");
+		wallUniforms[key].pointShadowMap = shader.GetUniform("pointShadowMap");
+		wallUniforms[key].model = shader.GetUniform("model");
+	}
+
+	UniformMat4 lampModel = pointLightShader.GetUniform("model");
+
+#ifdef RENDER_MODELS
+	std::vector<ModelUniforms> modelUniforms(modelShaders.GetVariantCount());
+	for (unsigned int key = 0; key < modelUniforms.size(); ++key)
+	{
+		Shader& shader = modelShaders.Get(key);
+		modelUniforms[key].shadowMap = shader.GetUniform("shadowMap");
+		modelUniforms[key].pointShadowMap = shader.GetUniform("pointShadowMap");
+		modelUniforms[key].skybox = shader.GetUniform("skybox");
+		modelUniforms[key].model = shader.GetUniform("model");
+	}
+#endif
+
+#ifdef RENDER_ENVIRONMENT_CUBE
+	UniformMat4 environmentModel = environmentShader.GetUniform("model");
+	UniformSampler environmentSkybox = environmentShader.GetUniform("skybox");
 #endif
 
+	UniformSampler screenTextureSampler = screenShader.GetUniform("screenTexture");
+
+	// Benchmarks render every frame with the final textures.
+	if (benchmarkFrames > 0)
+		TextureStreamer::Finish();
+
+	// Everything up to here (window, shaders, textures, models, shadow maps) counts as startup.
+	double startupTime = getTimeElapsed();
+	prevTime = startupTime;
+
+	// Cold startup : the same run with every program compiled from source.
+	ShaderCacheStats cacheStats;
+	ShaderCache::GetStats(cacheStats);
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Startup : %.1f ms (%.1f ms cold), shaders : %.1f ms (%.1f ms cold), shader cache hits : %u, misses : %u.",
+		startupTime * 1000.0, startupTime * 1000.0 - cacheStats.buildTime + cacheStats.coldTime,
+		cacheStats.buildTime, cacheStats.coldTime, cacheStats.hits, cacheStats.misses);
+	FileSystem::LogReport();
+
+	unsigned int frameIndex = 0;
+	double interactiveTime = 0.0;
+
 	// Main application loop
-	while (!glfwWindowShouldClose(appWindow))
+	while (!glfwWindowShouldClose(appWindow) && (benchmarkFrames == 0 || frameIndex < benchmarkFrames))
 	{
+		Profiler::BeginFrame();
+		GpuProfiler::BeginFrame();
+		Telemetry::BeginFrame();
+
 		// Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
 		glfwPollEvents();
 
+		// Upload the textures that have been decoded since the last frame.
+		TextureStreamer::Update();
+
 		currTime = getTimeElapsed();
 		deltaTime = currTime - prevTime;
+		prevTime = currTime;
 
 		// Update
-		Update(deltaTime);
+		{
+			PROFILE_SCOPE("Update");
+			Update(benchmarkFrames > 0 ? BENCHMARK_TIMESTEP : (float)deltaTime);
+		}
+
+		// Camera and light data for all passes below.
+		frameConstants.view = camera.GetViewMatrix();
+		frameConstants.projection = glm::perspective(camera.Zoom, (float)appWidth / (float)appHeight, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+		frameConstants.viewPos = camera.Position;
+		frameConstants.cameraDir = camera.Front;
+		frameBuffer.Update(&frameConstants);
+
+		lightConstants.pointLightOn = pointLightOn;
+		lightConstants.flashLight = flashLight;
+		lightBuffer.Update(&lightConstants);
+
+		// Shader variants only contain the lights that are on.
+		unsigned int lightKey = (pointLightOn ? FEATURE_POINT_LIGHT : 0) | (flashLight ? FEATURE_FLASH_LIGHT : 0);
 
 		// 1. Draw scene as normal in multisampled buffers
+		int scenePass = GpuProfiler::BeginPass("Scene (MSAA)");
 		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
 		// Clear the colorbuffer
@@ -1235,272 +1521,248 @@ int Application::Run()
 		glClearColor(0.5f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		
-		// Draw skybox first
-		skyboxShader.Use();
-		glm::mat4 view = glm::mat4(glm::mat3(camera.GetViewMatrix()));	// Remove any translation component of the view matrix
-		glm::mat4 projection = glm::perspective(camera.Zoom, (float)appWidth / (float)appHeight, 0.1f, 100.0f);
-		
-		glUniformMatrix4fv(glGetUniformLocation(skyboxShader.program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-		glUniformMatrix4fv(glGetUniformLocation(skyboxShader.program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+		{
+			PROFILE_SCOPE("Skybox");
 
-		skybox.Render(skyboxShader);
+			// Draw skybox first
+			skyboxShader.Use();
+			skybox.Render(skyboxShader);
+		}
 		
-		// Activate shader
-		ourShader.Use();
-
-		glUniform1i(glGetUniformLocation(ourShader.program, "pointLightOn"), pointLightOn);
-
-		glUniform1i(glGetUniformLocation(ourShader.program, "diffuseMap"), 0);
-		glUniform1i(glGetUniformLocation(ourShader.program, "specularMap"), 1);
-		glUniform1i(glGetUniformLocation(ourShader.program, "normalMap"), 2);
-
-		glActiveTexture(GL_TEXTURE3); // We already have 3 texture units active (in this shader) so set the skybox as the 4th texture unit (texture units are 0 based so index number 3)
-		glUniform1i(glGetUniformLocation(ourShader.program, "shadowMap"), 3);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-
-		glActiveTexture(GL_TEXTURE4); // We already have 3 texture units active (in this shader) so set the skybox as the 4th texture unit (texture units are 0 based so index number 3)
-		glUniform1i(glGetUniformLocation(ourShader.program, "pointShadowMap"), 4);
-		glBindTexture(GL_TEXTURE_2D, pointDepthMap);
-
-		lightSpaceMatrixLocation = glGetUniformLocation(ourShader.program, "direcLightSpaceMatrix");
-		glUniformMatrix4fv(lightSpaceMatrixLocation, 1, GL_FALSE, glm::value_ptr(direcLightSpaceMatrix));
-
-		lightSpaceMatrixLocation = glGetUniformLocation(ourShader.program, "pointLightSpaceMatrix");
-		glUniformMatrix4fv(lightSpaceMatrixLocation, 1, GL_FALSE, glm::value_ptr(pointLightSpaceMatrix));
-
-		GLint viewPosLoc = glGetUniformLocation(ourShader.program, "viewPos");
-		glUniform3f(viewPosLoc, camera.Position.x, camera.Position.y, camera.Position.z);
-
-		GLint lightPosLoc = glGetUniformLocation(ourShader.program, "lightPos");
-		glUniform3f(lightPosLoc, -2.4f, 1.0f, -15.0f);
-
-		GLint cameraDirLoc = glGetUniformLocation(ourShader.program, "cameraDir");
-		glUniform3f(cameraDirLoc, camera.Front.x, camera.Front.y, camera.Front.z);
-
-		GLint flashLightLoc = glGetUniformLocation(ourShader.program, "flashLight");
-		glUniform1i(flashLightLoc, flashLight);
-
-		// Create camera transformation
-		view = camera.GetViewMatrix();
-		projection = glm::perspective(camera.Zoom, (float)appWidth / (float)appHeight, 0.1f, 1000.0f);
-		// Get the uniform locations
-		GLint modelLoc = glGetUniformLocation(ourShader.program, "model");
-		GLint viewLoc = glGetUniformLocation(ourShader.program, "view");
-		GLint projLoc = glGetUniformLocation(ourShader.program, "projection");
-		// Pass the matrices to the shader
-		glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-		glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-		// Rendering the wall.
-		glBindVertexArray(front_wall.VAO);
-		for (GLuint i = 0; i < 5; i++)
 		{
-			// Calculate the model matrix for each object and pass it to shader before drawing
-			glm::mat4 model;
-			model = glm::translate(model, wallTranslations[i]);
-			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(ourShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-			front_wall.Render(ourShader);
+			PROFILE_SCOPE("Walls");
+
+			// Activate shader
+			Shader& wallShader = wallShaders.Get(lightKey);
+			WallUniforms& wall = wallUniforms[lightKey];
+			wallShader.Use();
+
+			wall.diffuseMap.Set(0);
+			wall.specularMap.Set(1);
+			wall.normalMap.Set(2);
+
+			glActiveTexture(GL_TEXTURE3); // We already have 3 texture units active (in this shader) so set the skybox as the 4th texture unit (texture units are 0 based so index number 3)
+			wall.shadowMap.Set(3);
+			glBindTexture(GL_TEXTURE_2D, depthMap);
+
+			glActiveTexture(GL_TEXTURE4); // We already have 3 texture units active (in this shader) so set the skybox as the 4th texture unit (texture units are 0 based so index number 3)
+			wall.pointShadowMap.Set(4);
+			glBindTexture(GL_TEXTURE_2D, pointDepthMap);
+
+			// Rendering the wall.
+			glBindVertexArray(front_wall.VAO);
+			for (GLuint i = 0; i < 5; i++)
+			{
+				// Calculate the model matrix for each object and pass it to shader before drawing
+				glm::mat4 model;
+				model = glm::translate(model, wallTranslations[i]);
+				model = glm::scale(model, glm::vec3(5.0f));
+				wall.model.Set(model);
+				front_wall.Render(wallShader);
+			}
+			glBindVertexArray(0);
+
+			glBindVertexArray(back_wall.VAO);
+			for (GLuint i = 5; i < 10; i++)
+			{
+				// Calculate the model matrix for each object and pass it to shader before drawing
+				glm::mat4 model;
+				model = glm::translate(model, wallTranslations[i]);
+				model = glm::scale(model, glm::vec3(5.0f));
+				wall.model.Set(model);
+				back_wall.Render(wallShader);
+			}
+			glBindVertexArray(0);
+
+			glBindVertexArray(left_wall.VAO);
+			for (GLuint i = 10; i < 15; i++)
+			{
+				// Calculate the model matrix for each object and pass it to shader before drawing
+				glm::mat4 model;
+				model = glm::translate(model, wallTranslations[i]);
+				model = glm::scale(model, glm::vec3(5.0f));
+				wall.model.Set(model);
+				left_wall.Render(wallShader);
+			}
+			glBindVertexArray(0);
+
+			glBindVertexArray(right_wall.VAO);
+			for (GLuint i = 15; i < 20; i++)
+			{
+				// Calculate the model matrix for each object and pass it to shader before drawing
+				glm::mat4 model;
+				model = glm::translate(model, wallTranslations[i]);
+				model = glm::scale(model, glm::vec3(5.0f));
+				wall.model.Set(model);
+				right_wall.Render(wallShader);
+			}
+			glBindVertexArray(0);
+
+			// Rendering the floor.
+		
+			glBindVertexArray(floor.VAO);
+			for (GLuint i = 0; i < 4; i++)
+			{
+				// Calculate the model matrix for each object and pass it to shader before drawing
+				glm::mat4 model;
+				model = glm::translate(model, floorTranslations[i]);
+				wall.model.Set(model);
+				floor.Render(wallShader);
+			}
+			glBindVertexArray(0);
 		}
-		glBindVertexArray(0);
 
-		glBindVertexArray(back_wall.VAO);
-		for (GLuint i = 5; i < 10; i++)
 		{
-			// Calculate the model matrix for each object and pass it to shader before drawing
-			glm::mat4 model;
-			model = glm::translate(model, wallTranslations[i]);
-			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(ourShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-			back_wall.Render(ourShader);
-		}
-		glBindVertexArray(0);
+			PROFILE_SCOPE("Point Light");
 
-		glBindVertexArray(left_wall.VAO);
-		for (GLuint i = 10; i < 15; i++)
-		{
-			// Calculate the model matrix for each object and pass it to shader before drawing
-			glm::mat4 model;
-			model = glm::translate(model, wallTranslations[i]);
-			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(ourShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-			left_wall.Render(ourShader);
-		}
-		glBindVertexArray(0);
+			// Render the light cube
+			pointLightShader.Use();
 
-		glBindVertexArray(right_wall.VAO);
-		for (GLuint i = 15; i < 20; i++)
-		{
-			// Calculate the model matrix for each object and pass it to shader before drawing
+			glBindVertexArray(skybox.skyboxVAO);
 			glm::mat4 model;
-			model = glm::translate(model, wallTranslations[i]);
-			model = glm::scale(model, glm::vec3(5.0f));
-			glUniformMatrix4fv(glGetUniformLocation(ourShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-			right_wall.Render(ourShader);
+			model = glm::translate(model, glm::vec3(-2.4f, 1.0f, -15.0f));
+			model = glm::scale(model, glm::vec3(0.05, 0.1, 0.2));
+			lampModel.Set(model);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+			Telemetry::CountDraw(12);
+			glBindVertexArray(0);
 		}
-		glBindVertexArray(0);
 
-		// Rendering the floor.
-		
-		glBindVertexArray(floor.VAO);
-		for (GLuint i = 0; i < 4; i++)
+#ifdef RENDER_MODELS
 		{
-			// Calculate the model matrix for each object and pass it to shader before drawing
-			glm::mat4 model;
-			model = glm::translate(model, floorTranslations[i]);
-			glUniformMatrix4fv(glGetUniformLocation(ourShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-			floor.Render(ourShader);
+			PROFILE_SCOPE("Models");
+
+			// Render the models
+			glActiveTexture(GL_TEXTURE3);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, skybox.cubemapTexture);
+
+			glActiveTexture(GL_TEXTURE4);
+			glBindTexture(GL_TEXTURE_2D, depthMap);
+
+			glActiveTexture(GL_TEXTURE5);
+			glBindTexture(GL_TEXTURE_2D, pointDepthMap);
+
+			// Draw the Statue of Liberty, without reflections
+			Shader& pedestalShader = modelShaders.Get(lightKey);
+			ModelUniforms& pedestalUniforms = modelUniforms[lightKey];
+			pedestalShader.Use();
+
+			pedestalUniforms.shadowMap.Set(4);
+			pedestalUniforms.pointShadowMap.Set(5);
+
+			glm::mat4 model_2;
+			model_2 = glm::translate(model_2, glm::vec3(20.0f, -2.5f, -2.0f)); // Translate it down a bit so it's at the center of the scene
+			model_2 = glm::rotate(model_2, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			model_2 = glm::scale(model_2, glm::vec3(3.0f));
+			pedestalUniforms.model.Set(model_2);
+			pedestal.SelectLod(LOD_PASS_MAIN, model_2, frameConstants.view, frameConstants.projection, (float)appHeight);
+			pedestal.CullClusters(model_2, frameConstants.view, frameConstants.projection, camera.Position);
+			pedestal.Draw(pedestalShader);
+
+			// Draw the Nanosuit, reflecting the skybox
+			Shader& nanosuitShader = modelShaders.Get(lightKey | FEATURE_REFLECTION_MAP);
+			ModelUniforms& nanosuitUniforms = modelUniforms[lightKey | FEATURE_REFLECTION_MAP];
+			nanosuitShader.Use();
+
+			nanosuitUniforms.shadowMap.Set(4);
+			nanosuitUniforms.pointShadowMap.Set(5);
+			nanosuitUniforms.skybox.Set(3);
+
+			glm::mat4 model_3;
+			model_3 = glm::translate(model_3, glm::vec3(10.0f, -2.5f, -12.5f)); // Translate it down a bit so it's at the center of the scene
+			model_3 = glm::scale(model_3, glm::vec3(0.2f));
+			nanosuitUniforms.model.Set(model_3);
+			nanosuit.SelectLod(LOD_PASS_MAIN, model_3, frameConstants.view, frameConstants.projection, (float)appHeight);
+			nanosuit.CullClusters(model_3, frameConstants.view, frameConstants.projection, camera.Position);
+			nanosuit.Draw(nanosuitShader);
 		}
-		glBindVertexArray(0);
-
-		// Render the light cube
-		pointLightShader.Use();
-
-		glUniform1i(glGetUniformLocation(pointLightShader.program, "pointLightOn"), pointLightOn);
-
-		// Get the uniform locations
-		modelLoc = glGetUniformLocation(pointLightShader.program, "model");
-		viewLoc = glGetUniformLocation(pointLightShader.program, "view");
-		projLoc = glGetUniformLocation(pointLightShader.program, "projection");
-		// Pass the matrices to the shader
-		glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-		glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-		glBindVertexArray(skybox.skyboxVAO);
-		glm::mat4 model;
-		model = glm::translate(model, glm::vec3(-2.4f, 1.0f, -15.0f));
-		model = glm::scale(model, glm::vec3(0.05, 0.1, 0.2));
-		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
-
-#ifdef RENDER_MODELS
-		// Render the models
-		model_loading.Use();   // <-- Don't forget this one!
-
-		glUniform1i(glGetUniformLocation(model_loading.program, "pointLightOn"), pointLightOn);
-
-		glActiveTexture(GL_TEXTURE4); // We already have 3 texture units active (in this shader) so set the skybox as the 4th texture unit (texture units are 0 based so index number 3)
-		glUniform1i(glGetUniformLocation(model_loading.program, "shadowMap"), 4);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
-
-		glActiveTexture(GL_TEXTURE5); // We already have 3 texture units active (in this shader) so set the skybox as the 4th texture unit (texture units are 0 based so index number 3)
-		glUniform1i(glGetUniformLocation(model_loading.program, "pointShadowMap"), 5);
-		glBindTexture(GL_TEXTURE_2D, pointDepthMap);
-
-		lightSpaceMatrixLocation = glGetUniformLocation(model_loading.program, "direcLightSpaceMatrix");
-		glUniformMatrix4fv(lightSpaceMatrixLocation, 1, GL_FALSE, glm::value_ptr(direcLightSpaceMatrix));
-
-		lightSpaceMatrixLocation = glGetUniformLocation(model_loading.program, "pointLightSpaceMatrix");
-		glUniformMatrix4fv(lightSpaceMatrixLocation, 1, GL_FALSE, glm::value_ptr(pointLightSpaceMatrix));
-
-		viewPosLoc = glGetUniformLocation(model_loading.program, "viewPos");
-		glUniform3f(viewPosLoc, camera.Position.x, camera.Position.y, camera.Position.z);
-
-		flashLightLoc = glGetUniformLocation(model_loading.program, "flashLight");
-		glUniform1i(flashLightLoc, flashLight);
-
-		cameraDirLoc = glGetUniformLocation(ourShader.program, "cameraDir");
-		glUniform3f(cameraDirLoc, camera.Front.x, camera.Front.y, camera.Front.z);
-
-		// Transformation matrices
-		projection = glm::perspective(camera.Zoom, (float)appWidth / (float)appHeight, 0.1f, 100.0f);
-		view = camera.GetViewMatrix();
-		glUniformMatrix4fv(glGetUniformLocation(model_loading.program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-		glUniformMatrix4fv(glGetUniformLocation(model_loading.program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-
-		// Draw the Statue of Liberty
-		glUniform1i(glGetUniformLocation(model_loading.program, "reflectionMap"), 0);
-
-		glm::mat4 model_2;
-		model_2 = glm::translate(model_2, glm::vec3(20.0f, -2.5f, -2.0f)); // Translate it down a bit so it's at the center of the scene
-		model_2 = glm::rotate(model_2, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-		model_2 = glm::scale(model_2, glm::vec3(3.0f));
-		glUniformMatrix4fv(glGetUniformLocation(model_loading.program, "model"), 1, GL_FALSE, glm::value_ptr(model_2));
-		pedestal.Draw(model_loading);
-
-		// Draw the Nanosuit
-		glUniform1i(glGetUniformLocation(model_loading.program, "reflectionMap"), 1);
-		
-		glActiveTexture(GL_TEXTURE3); // We already have 3 texture units active (in this shader) so set the skybox as the 4th texture unit (texture units are 0 based so index number 3)
-		glUniform1i(glGetUniformLocation(model_loading.program, "skybox"), 3);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, skybox.cubemapTexture);
-
-		// Now draw the nanosuit
-		glm::mat4 model_3;
-		model_3 = glm::translate(model_3, glm::vec3(10.0f, -2.5f, -12.5f)); // Translate it down a bit so it's at the center of the scene
-		model_3 = glm::scale(model_3, glm::vec3(0.2f));
-		glUniformMatrix4fv(glGetUniformLocation(model_loading.program, "model"), 1, GL_FALSE, glm::value_ptr(model_3));
-		nanosuit.Draw(model_loading);
 #endif
 
 #ifdef RENDER_ENVIRONMENT_CUBE
-		environmentShader.Use();
-
-		// Set uniforms
-
-		projection = glm::perspective(camera.Zoom, (float)appWidth / (float)appHeight, 0.1f, 100.0f);
-		view = camera.GetViewMatrix();
-		glUniformMatrix4fv(glGetUniformLocation(environmentShader.program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-		glUniformMatrix4fv(glGetUniformLocation(environmentShader.program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+		{
+			PROFILE_SCOPE("Environment Cube");
 
-		glm::mat4 model_cube;
-		model_cube = glm::translate(model_cube, glm::vec3(10.0f, -2.0f, -10.0f)); // Translate it down a bit so it's at the center of the scene
-		model_cube = glm::scale(model_cube, glm::vec3(1.0f));
-		glUniformMatrix4fv(glGetUniformLocation(environmentShader.program, "model"), 1, GL_FALSE, glm::value_ptr(model_cube));
+			environmentShader.Use();
 
-		glUniform3f(glGetUniformLocation(environmentShader.program, "cameraPos"), camera.Position.x, camera.Position.y, camera.Position.z);
+			// Set uniforms
+			glm::mat4 model_cube;
+			model_cube = glm::translate(model_cube, glm::vec3(10.0f, -2.0f, -10.0f)); // Translate it down a bit so it's at the center of the scene
+			model_cube = glm::scale(model_cube, glm::vec3(1.0f));
+			environmentModel.Set(model_cube);
 
-		glActiveTexture(GL_TEXTURE0);
-		glUniform1i(glGetUniformLocation(environmentShader.program, "skybox"), 0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, skybox.cubemapTexture);
+			glActiveTexture(GL_TEXTURE0);
+			environmentSkybox.Set(0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, skybox.cubemapTexture);
 
-		// Perform the render call
+			// Perform the render call
 
-		glBindVertexArray(cubeVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindVertexArray(0);
+			glBindVertexArray(cubeVAO);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+			Telemetry::CountDraw(2);
+			glBindVertexArray(0);
+		}
 #endif
 
 #ifdef RENDER_PARTICLES
-		// Render the particle system
-		particleShader.Use();
+		{
+			PROFILE_SCOPE("Particles");
 
-		projection = glm::perspective(camera.Zoom, (float)appWidth / (float)appHeight, 0.1f, 100.0f);
-		view = camera.GetViewMatrix();
+			// Render the particle system
+			particleShader.Use();
 
-		glUniformMatrix4fv(glGetUniformLocation(particleShader.program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-		glUniformMatrix4fv(glGetUniformLocation(particleShader.program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-		
-		rain.Render(particleShader, camera.Front, glm::vec3(0.02f, 0.1f, 0.02f));
-		rain.Update();
+			rain.Render(particleShader, camera.Front, glm::vec3(0.02f, 0.1f, 0.02f));
+			rain.Update();
+		}
 
 #endif
 
-		// 2. Now blit multisampled buffer(s) to normal colorbuffer of intermediate FBO. Image is stored in screenTexture
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFBO);
-		glBlitFramebuffer(0, 0, 800, 600, 0, 0, 800, 600, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-		// 3. Now render quad with scene's visuals as its texture image
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-		glDisable(GL_DEPTH_TEST);
+		GpuProfiler::EndPass(scenePass);
 
-		// Draw Screen quad
-		screenShader.Use();
+		{
+			PROFILE_SCOPE("Post Processing");
+
+			{
+				GPU_SCOPE("Blit");
+
+				// 2. Now blit multisampled buffer(s) to normal colorbuffer of intermediate FBO. Image is stored in screenTexture
+				glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFBO);
+				glBlitFramebuffer(0, 0, 800, 600, 0, 0, 800, 600, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			}
+
+			{
+				GPU_SCOPE("Post Processing");
+
+				// 3. Now render quad with scene's visuals as its texture image
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT);
+				glDisable(GL_DEPTH_TEST);
+
+				// Draw Screen quad
+				screenShader.Use();
+
+				glActiveTexture(GL_TEXTURE0);
+				screenTextureSampler.Set(0);
+				glBindTexture(GL_TEXTURE_2D, screenTexture);
+
+				glBindVertexArray(quadVAO);
+				glDrawArrays(GL_TRIANGLES, 0, 6);
+				Telemetry::CountDraw(2);
+				glBindVertexArray(0);
+			}
+		}
 
-		glActiveTexture(GL_TEXTURE0);
-		glUniform1i(glGetUniformLocation(screenShader.program, "screenTexture"), 0);
-		glBindTexture(GL_TEXTURE_2D, screenTexture);
+		if (showOverlay)
+		{
+			PROFILE_SCOPE("Overlay");
+			GPU_SCOPE("Overlay");
 
-		glBindVertexArray(quadVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindVertexArray(0);
+			RenderOverlay();
+		}
 
 		// Calculate FPS for debugging.
-		interval += deltaTime;
+		interval += (float)deltaTime;
 		++noOfFrames;
 
 		if (interval >= 1.0f)
@@ -1510,16 +1772,57 @@ int Application::Run()
 			noOfFrames = 0;
 		}
 
+		GpuProfiler::EndFrame();
+
 		// Swap the screen buffers
-		glfwSwapBuffers(appWindow);
+		{
+			PROFILE_SCOPE("Swap Buffers");
+			glfwSwapBuffers(appWindow);
+		}
+
+		// The first frame of the scene : from here on the input is handled.
+		if (frameIndex == 0)
+		{
+			interactiveTime = getTimeElapsed();
+			LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Time to first frame : %.1f ms, time to interactive : %.1f ms.",
+				firstFrameTime * 1000.0, interactiveTime * 1000.0);
+		}
+
+		Profiler::EndFrame();
+		Telemetry::EndFrame((float)(deltaTime * 1000.0), (float)Profiler::GetFrameTime(), (float)GpuProfiler::GetFrameTime());
+
+		// Leave out the frames in which caches and drivers warm up.
+		if (++frameIndex == BENCHMARK_WARMUP_FRAMES && benchmarkFrames > 0)
+			Telemetry::ResetStatistics();
 	}
 
-	Shutdown();
-	return 0;
+	int result = 0;
+	if (benchmarkFrames > 0 && !WriteBenchmarkReport(startupTime, firstFrameTime, interactiveTime))
+		result = 1;
+
+	frameBuffer.Destroy();
+	lightBuffer.Destroy();
+	shadowBuffer.Destroy();
+
+	return result;
 }
 
 void Application::Update(float deltaTime)
 {
+	// Benchmarks play the camera path in a loop and ignore the input.
+	if (benchmarkFrames > 0)
+	{
+		pathTime += deltaTime;
+
+		GLfloat duration = cameraPath.GetDuration();
+		glm::vec3 position;
+		GLfloat yaw, pitch;
+		cameraPath.Evaluate(duration > 0.0f ? fmod(pathTime, duration) : 0.0f, position, yaw, pitch);
+		camera.SetPose(position, yaw, pitch);
+
+		return;
+	}
+
 	// Camera controls
 	if (keys[GLFW_KEY_W])
 		camera.ProcessKeyboard(FORWARD, deltaTime);
@@ -1537,6 +1840,17 @@ void Application::Update(float deltaTime)
 		pointLightOn = 1;
 	if (keys[GLFW_KEY_P])
 		pointLightOn = 0;
+
+	// Record a camera key four times a second.
+	if (recordingPath)
+	{
+		if (pathTime >= nextKeyTime)
+		{
+			cameraPath.AddKey(pathTime, camera.Position, camera.Yaw, camera.Pitch);
+			nextKeyTime += 0.25f;
+		}
+		pathTime += deltaTime;
+	}
 }
 
 void Application::Render()
@@ -1545,21 +1859,262 @@ void Application::Render()
 
 void Application::CalculateFPS(int noOfFrames, float interval)
 {
-	fps = 60;
+	fps = (int)(noOfFrames / interval + 0.5f);
+
+	TelemetrySummary summary;
+	Telemetry::GetSummary(summary);
 
 	std::stringstream ss;
-	ss << "LightEngine Demo  ||  FPS : " << fps;
+	ss.precision(3);
+	ss << "LightEngine Demo  ||  FPS : " << fps << "  ||  " << summary.avgFrameTime << " ms (p99 " << summary.p99 << ")";
 
 	glfwSetWindowTitle(appWindow, ss.str().c_str());
 }
 
+/*
+	Draws the latest CPU frame time and the GPU time
+	of every pass in the top left corner (toggle : F3).
+*/
+void Application::RenderOverlay()
+{
+	const GLfloat scale = 0.3f;
+	const GLfloat lineHeight = 16.0f;
+	const glm::vec3 color(1.0f, 1.0f, 0.0f);
+
+	GLfloat y = appHeight - lineHeight;
+	char line[128];
+
+	TelemetrySummary summary;
+	Telemetry::GetSummary(summary);
+
+	_snprintf_s(line, sizeof(line), _TRUNCATE, "Frame : %.2f ms avg, p50 %.2f, p99 %.2f, p99.9 %.2f, stutters %u",
+		summary.avgFrameTime, summary.p50, summary.p99, summary.p999, summary.stutters);
+	TextRenderer::Render(line, 8.0f, y, scale, color);
+	y -= lineHeight;
+
+	_snprintf_s(line, sizeof(line), _TRUNCATE, "Draw calls : %.0f, triangles : %.0f, LODs %s", summary.avgDrawCalls, summary.avgTriangles,
+		Model::IsLodEnabled() ? "on" : "off");
+	TextRenderer::Render(line, 8.0f, y, scale, color);
+	y -= lineHeight;
+
+	_snprintf_s(line, sizeof(line), _TRUNCATE, "Clusters : %.0f, culled %.0f (%.0f triangles)", summary.avgClusters, summary.avgClustersCulled, summary.avgTrianglesCulled);
+	TextRenderer::Render(line, 8.0f, y, scale, color);
+	y -= lineHeight;
+
+	ProfilerZoneStats cpu;
+	int frameZone = Profiler::FindZone("Frame");
+	if (frameZone >= 0 && Profiler::GetZoneStats(frameZone, cpu))
+	{
+		_snprintf_s(line, sizeof(line), _TRUNCATE, "CPU Frame : %.2f ms (avg %.2f, p99 %.2f)", cpu.last, cpu.avg, cpu.p99);
+		TextRenderer::Render(line, 8.0f, y, scale, color);
+		y -= lineHeight;
+	}
+
+	if (!GpuProfiler::IsEnabled())
+	{
+		TextRenderer::Render("GPU : timer queries not supported", 8.0f, y, scale, color);
+		return;
+	}
+
+	for (unsigned int i = 0; i < GpuProfiler::GetPassCount(); ++i)
+	{
+		GpuPassStats gpu;
+		GpuProfiler::GetPassStats(i, gpu);
+
+		_snprintf_s(line, sizeof(line), _TRUNCATE, "GPU %s : %.2f ms (avg %.2f, max %.2f)", gpu.name, gpu.last, gpu.avg, gpu.max);
+		TextRenderer::Render(line, 8.0f + 16.0f * gpu.depth, y, scale, color);
+		y -= lineHeight;
+	}
+}
+
+/*
+	Presents a frame of the loading screen. The main
+	thread tasks of the load graph that fit into
+	LOADING_TASK_BUDGET run first, and the textures that
+	have been decoded are uploaded, so loading goes on
+	between the frames. Below the progress bar, the
+	status lists what is being loaded.
+
+	screen	-	Loading screen to draw.
+	graph	-	Graph of the scene's loading tasks.
+	stage	-	What the main thread sets up itself, or NULL.
+*/
+void Application::PresentLoadingScreen(LoadingScreen& screen, LoadGraph& graph, const char* stage)
+{
+	glfwPollEvents();
+
+	graph.Update(LOADING_TASK_BUDGET);
+	TextureStreamer::Update();
+
+	screen.Render(appWidth, appHeight, graph.GetProgress());
+
+	std::string status = stage != NULL ? stage : "";
+	std::string tasks = graph.GetStatus();
+	if (!tasks.empty())
+		status += (status.empty() ? "" : ", ") + tasks;
+
+	unsigned int textures = TextureStreamer::GetPendingCount();
+	if (textures > 0)
+	{
+		char line[64];
+		_snprintf_s(line, sizeof(line), _TRUNCATE, "%s%u texture(s) streaming", status.empty() ? "" : ", ", textures);
+		status += line;
+	}
+
+	TextRenderer::Render(status, 8.0f, 8.0f, 0.3f, glm::vec3(0.8f, 0.8f, 0.8f));
+
+	glfwSwapBuffers(appWindow);
+}
+
+/*
+	Writes the results of a benchmark run as JSON : frame
+	time percentiles, startup time and the CPU zone and
+	GPU pass timings.
+
+	startupTime		-	Seconds from InitUtility() to the end of the loading.
+	firstFrameTime	-	Seconds to the first loading screen frame.
+	interactiveTime	-	Seconds to the first frame of the scene.
+*/
+bool Application::WriteBenchmarkReport(double startupTime, double firstFrameTime, double interactiveTime)
+{
+	FILE* file = NULL;
+	if (fopen_s(&file, benchmarkReport, "w") != 0 || file == NULL)
+	{
+		LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_CORE, "Could not write benchmark report %s.", benchmarkReport);
+		return false;
+	}
+
+	TelemetrySummary summary;
+	Telemetry::GetSummary(summary);
+
+	ShaderCacheStats cacheStats;
+	ShaderCache::GetStats(cacheStats);
+
+	TextureCacheStats textureStats;
+	TextureCache::GetStats(textureStats);
+
+	FileSystemStats fileStats;
+	FileSystem::GetStats(fileStats);
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"renderer\": ");
+	writeJsonString(file, (const char*)glGetString(GL_RENDERER));
+	fprintf(file, ",\n\t\"version\": ");
+	writeJsonString(file, (const char*)glGetString(GL_VERSION));
+	fprintf(file, ",\n\t\"camera_path\": ");
+	writeJsonString(file, benchmarkPath != NULL ? benchmarkPath : "default");
+	fprintf(file, ",\n\t\"resolution\": [%d, %d],\n", appWidth, appHeight);
+	fprintf(file, "\t\"frames\": %u,\n", summary.frames);
+	fprintf(file, "\t\"warmup_frames\": %u,\n", BENCHMARK_WARMUP_FRAMES);
+	fprintf(file, "\t\"timestep_ms\": %.4f,\n", BENCHMARK_TIMESTEP * 1000.0f);
+	fprintf(file, "\t\"startup_ms\": %.3f,\n", startupTime * 1000.0);
+	fprintf(file, "\t\"startup_cold_ms\": %.3f,\n", startupTime * 1000.0 - cacheStats.buildTime + cacheStats.coldTime);
+	fprintf(file, "\t\"time_to_first_frame_ms\": %.3f,\n", firstFrameTime * 1000.0);
+	fprintf(file, "\t\"time_to_interactive_ms\": %.3f,\n", interactiveTime * 1000.0);
+	fprintf(file, "\t\"shader_cache\": { \"hits\": %u, \"misses\": %u, \"build_ms\": %.3f, \"cold_compile_ms\": %.3f },\n",
+		cacheStats.hits, cacheStats.misses, cacheStats.buildTime, cacheStats.coldTime);
+	fprintf(file, "\t\"texture_cache\": { \"textures\": %u, \"path_hits\": %u, \"content_hits\": %u, \"misses\": %u, \"resident_mb\": %.2f, \"saved_mb\": %.2f },\n",
+		textureStats.textures, textureStats.pathHits, textureStats.contentHits, textureStats.misses,
+		textureStats.residentBytes / (1024.0 * 1024.0), textureStats.savedBytes / (1024.0 * 1024.0));
+	fprintf(file, "\t\"file_system\": { \"pack\": %s, \"files_opened\": %u, \"pack_reads\": %u, \"loose_reads\": %u, \"failed_reads\": %u, \"read_mb\": %.2f, \"read_ms\": %.3f, \"decompress_ms\": %.3f },\n",
+		FileSystem::IsMounted() ? "true" : "false", fileStats.filesOpened, fileStats.packReads, fileStats.looseReads, fileStats.failedReads,
+		fileStats.bytesRead / (1024.0 * 1024.0), fileStats.readTime * 1000.0, fileStats.decompressTime * 1000.0);
+	fprintf(file, "\t\"frame_time_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"p99.9\": %.4f },\n",
+		summary.mean, summary.p50, summary.p90, summary.p99, summary.p999);
+	fprintf(file, "\t\"stutters\": %u,\n", summary.stutters);
+	fprintf(file, "\t\"draw_calls\": %.0f,\n", summary.avgDrawCalls);
+	fprintf(file, "\t\"triangles\": %.0f,\n", summary.avgTriangles);
+	fprintf(file, "\t\"lods\": %s,\n", Model::IsLodEnabled() ? "true" : "false");
+	fprintf(file, "\t\"cluster_culling\": { \"enabled\": %s, \"clusters\": %.0f, \"clusters_culled\": %.0f, \"triangles_culled\": %.0f },\n",
+		Model::IsClusterCullingEnabled() ? "true" : "false", summary.avgClusters, summary.avgClustersCulled, summary.avgTrianglesCulled);
+
+	fprintf(file, "\t\"texture_compression\": %s,\n", TextureStreamer::IsCompressionEnabled() ? "true" : "false");
+	fprintf(file, "\t\"cpu_mipmaps\": %s,\n", TextureStreamer::IsCpuMipmapsEnabled() ? "true" : "false");
+	fprintf(file, "\t\"materials\": %u,\n", MaterialLibrary::GetMaterialCount());
+	fprintf(file, "\t\"geometry_pools\": [");
+	for (unsigned int i = 0; i < GeometryPool::GetPoolCount(); ++i)
+	{
+		GeometryPoolStats pool;
+		GeometryPool::GetStats(i, pool);
+
+		fprintf(file, "%s\n\t\t{ \"format\": ", i > 0 ? "," : "");
+		writeJsonString(file, GetVertexFormatName(pool.vertexFormat));
+		fprintf(file, ", \"index_bits\": %u, \"meshes\": %u, \"grows\": %u, \"vertex_mb\": %.2f, \"vertex_capacity_mb\": %.2f, \"index_mb\": %.2f, \"index_capacity_mb\": %.2f, "
+			"\"largest_free_vertices\": %u, \"largest_free_indices\": %u, \"vertex_fragmentation\": %.4f, \"index_fragmentation\": %.4f }",
+			pool.indexType == GL_UNSIGNED_SHORT ? 16 : 32, pool.vertices.allocations, pool.grows,
+			pool.vertices.used * pool.vertexStride / (1024.0 * 1024.0), pool.vertices.capacity * pool.vertexStride / (1024.0 * 1024.0),
+			pool.indices.used * pool.indexSize / (1024.0 * 1024.0), pool.indices.capacity * pool.indexSize / (1024.0 * 1024.0),
+			pool.vertices.largestFree, pool.indices.largestFree, pool.vertices.fragmentation, pool.indices.fragmentation);
+	}
+	fprintf(file, "\n\t],\n");
+
+	fprintf(file, "\t\"cpu_zones_ms\": [");
+	for (unsigned int i = 0; i < Profiler::GetZoneCount(); ++i)
+	{
+		ProfilerZoneStats zone;
+		Profiler::GetZoneStats(i, zone);
+
+		fprintf(file, "%s\n\t\t{ \"name\": ", i > 0 ? "," : "");
+		writeJsonString(file, zone.name);
+		fprintf(file, ", \"depth\": %u, \"samples\": %u, \"min\": %.4f, \"avg\": %.4f, \"p95\": %.4f, \"p99\": %.4f }",
+			zone.depth, zone.samples, zone.min, zone.avg, zone.p95, zone.p99);
+	}
+	fprintf(file, "\n\t],\n");
+
+	fprintf(file, "\t\"gpu_passes_ms\": [");
+	for (unsigned int i = 0; i < GpuProfiler::GetPassCount(); ++i)
+	{
+		GpuPassStats pass;
+		GpuProfiler::GetPassStats(i, pass);
+
+		fprintf(file, "%s\n\t\t{ \"name\": ", i > 0 ? "," : "");
+		writeJsonString(file, pass.name);
+		fprintf(file, ", \"depth\": %u, \"samples\": %u, \"avg\": %.4f, \"max\": %.4f }",
+			pass.depth, pass.samples, pass.avg, pass.max);
+	}
+	fprintf(file, "\n\t]\n");
+	fprintf(file, "}\n");
+
+	fclose(file);
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Benchmark report written to %s (p50 %.2f ms, p99 %.2f ms).",
+		benchmarkReport, summary.p50, summary.p99);
+
+	return true;
+}
+
 void Application::Shutdown()
 {
+	// Read back the timer queries that are still in flight while the context exists.
+	GpuProfiler::Shutdown();
+
+	// Report the geometry pools and free their buffers while the context exists.
+	GeometryPool::LogReport();
+	GeometryPool::Shutdown();
+	MaterialLibrary::Shutdown();
+
+	// Report the texture cache and stop streaming before the context and the decoding threads go away.
+	TextureCache::Shutdown();
+	TextureStreamer::Shutdown();
+	delete workers;
+	workers = NULL;
+
+	// Nothing reads from the pack anymore.
+	FileSystem::Unmount();
+
 	// Terminate GLFW, clearing any resources allocated by GLFW.
 	glfwTerminate();
-#ifdef DEBUG
-	log("Engine shutdown complete.");
-#endif
+	LOG_DEBUG(LOG_CATEGORY_CORE, "Engine shutdown complete.");
+
+	// Write out a capture that is still running and the per-zone frame times of the session.
+	Profiler::StopTrace();
+	Profiler::LogReport();
+	GpuProfiler::LogReport();
+	Telemetry::Shutdown();
+	Telemetry::LogReport();
+
+	// Write out everything that is still queued in the logger.
+	ShutdownUtility();
 }
 
 Application::~Application()
@@ -1,5 +1,9 @@
 #pragma once
 
+// Forward declarations.
+class LoadingScreen;
+class LoadGraph;
+
 /*
 	Application is the main class whose instance defines
 	how and what the game/demo is going to do.
@@ -12,17 +16,25 @@ class Application
 public:
 	Application(const char* title, int width, int height);
 	int Run();
+	void CaptureTrace(unsigned int frames);
+	void StreamTelemetry(const char* csvPath);
+	void EnableBenchmark(unsigned int frames, const char* cameraPath, const char* reportPath);
+	void MountPack(const char* packPath);
 	~Application();
 
 private:
 	bool InitEngine();
 	bool InitGLFW();
 	bool InitGLEW();
+	int RunScene();
 
 	void Update(float deltaTime);
 	void Render();
 	void Shutdown();
 	void CalculateFPS(int noOfFrames, float interval);
+	void RenderOverlay();
+	void PresentLoadingScreen(LoadingScreen& screen, LoadGraph& graph, const char* stage);
+	bool WriteBenchmarkReport(double startupTime, double firstFrameTime, double interactiveTime);
 
 // Variables
 
@@ -31,4 +43,10 @@ private:
 	int				appWidth;
 	int				appHeight;
 	float			fps;
+	unsigned int	traceFrames;
+	const char*		telemetryPath;
+	unsigned int	benchmarkFrames;
+	const char*		benchmarkPath;
+	const char*		benchmarkReport;
+	const char*		packPath;
 };
\ No newline at end of file
@@ -0,0 +1,534 @@
+#include "AssetCooker.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+namespace
+{
+	const char* const TYPE_NAMES[COOK_ASSET_TYPE_COUNT] = { "Models", "Textures", "Shaders" };
+	const char* const RESULT_NAMES[COOK_RESULT_COUNT] = { "up to date", "from store", "built", "skipped", "FAILED" };
+
+	/*
+		Identifies an asset in the graph and the manifest :
+		the same image can be cooked for several formats.
+	*/
+	std::string AssetId(const std::string& path, GLint internalFormat)
+	{
+		char format[16];
+		_snprintf_s(format, sizeof(format), _TRUNCATE, "|%x", (unsigned int)internalFormat);
+		return FileSystem::NormalizePath(path.c_str()) + format;
+	}
+
+	/*
+		Whether a normalized path ends with an extension.
+	*/
+	bool HasExtension(const std::string& path, const char* extension)
+	{
+		size_t length = strlen(extension);
+		return path.size() >= length && path.compare(path.size() - length, length, extension) == 0;
+	}
+
+	/*
+		Whether a normalized path ends with one of the
+		given extensions.
+	*/
+	bool HasExtension(const std::string& path, const char* const* extensions, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			if (HasExtension(path, extensions[i]))
+				return true;
+		}
+		return false;
+	}
+
+	/*
+		Copies a file. The copy gets a new write time, so the
+		engine sees it as newer than its source.
+	*/
+	bool CopyFileContents(const char* from, const char* to)
+	{
+		FileData data;
+		if (!FileSystem::ReadFile(from, data))
+			return false;
+
+		FILE* file = NULL;
+		if (fopen_s(&file, to, "wb") != 0 || file == NULL)
+			return false;
+
+		bool written = data.GetSize() == 0 || fwrite(data.GetData(), 1, data.GetSize(), file) == data.GetSize();
+		fclose(file);
+		return written;
+	}
+
+	/*
+		Appends the material libraries an .obj file names
+		with "mtllib", relative to its directory.
+	*/
+	void FindMaterialLibraries(const FileData& model, const std::string& directory, std::vector<std::string>& inputs)
+	{
+		const char* text = (const char*)model.GetData();
+		const char* end = text + model.GetSize();
+
+		for (const char* line = text; line < end;)
+		{
+			const char* next = (const char*)memchr(line, '\n', end - line);
+			if (next == NULL)
+				next = end;
+
+			if (next - line > 7 && strncmp(line, "mtllib", 6) == 0 && isspace((unsigned char)line[6]))
+			{
+				const char* name = line + 7;
+				const char* nameEnd = next;
+				while (name < nameEnd && isspace((unsigned char)*name))
+					++name;
+				while (nameEnd > name && isspace((unsigned char)nameEnd[-1]))
+					--nameEnd;
+
+				if (nameEnd > name)
+					inputs.push_back(directory + "/" + std::string(name, nameEnd));
+			}
+
+			line = next + 1;
+		}
+	}
+}
+
+/*
+	Constructor.
+
+	pool	-	Threads the assets of a stage are cooked on,
+				may be NULL.
+*/
+AssetCooker::AssetCooker(ThreadPool* pool)
+{
+	this->pool = pool;
+	shaderContext = false;
+	modelTextureEdges = 0;
+}
+
+/*
+	Finds the models, textures and shaders to cook and
+	reads which outputs are installed.
+*/
+void AssetCooker::Scan(void)
+{
+	loadManifest();
+
+	std::vector<std::string> files;
+	FileSystem::ListFiles(COOK_MODEL_DIRECTORY, files);
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		if (HasExtension(FileSystem::NormalizePath(files[i].c_str()), COOK_MODEL_EXTENSIONS, sizeof(COOK_MODEL_EXTENSIONS) / sizeof(COOK_MODEL_EXTENSIONS[0])))
+			addAsset(COOK_ASSET_MODEL, files[i], 0);
+	}
+
+	files.clear();
+	FileSystem::ListFiles(COOK_TEXTURE_DIRECTORY, files);
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		std::string name = FileSystem::NormalizePath(files[i].c_str());
+		if (!HasExtension(name, COOK_TEXTURE_EXTENSIONS, sizeof(COOK_TEXTURE_EXTENSIONS) / sizeof(COOK_TEXTURE_EXTENSIONS[0])))
+			continue;
+
+		GLint internalFormat = GL_RGB;
+		for (unsigned int r = 0; r < sizeof(COOK_TEXTURE_RULES) / sizeof(COOK_TEXTURE_RULES[0]); ++r)
+		{
+			if (name.find(COOK_TEXTURE_RULES[r].pattern, name.find_last_of('/') + 1) != std::string::npos)
+			{
+				internalFormat = COOK_TEXTURE_RULES[r].internalFormat;
+				break;
+			}
+		}
+
+		addAsset(COOK_ASSET_TEXTURE, files[i], internalFormat);
+	}
+
+	files.clear();
+	FileSystem::ListFiles(COOK_SHADER_DIRECTORY, files);
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		if (HasExtension(FileSystem::NormalizePath(files[i].c_str()), COOK_SHADER_EXTENSIONS, sizeof(COOK_SHADER_EXTENSIONS) / sizeof(COOK_SHADER_EXTENSIONS[0])))
+			addAsset(COOK_ASSET_SHADER, files[i], 0);
+	}
+}
+
+/*
+	Cooks the models, then the textures (including those
+	of the models) and then the shaders, and records the
+	installed outputs. Returns false if an asset failed.
+
+	compileShaders	-	Whether an OpenGL context is current on
+						this thread to compile the shaders with.
+						Shaders are skipped otherwise.
+*/
+bool AssetCooker::Run(bool compileShaders)
+{
+	shaderContext = compileShaders;
+	CreateDirectoryA(COOK_STORE_DIRECTORY, NULL);
+
+	runStage(COOK_ASSET_MODEL);
+
+	// The textures of a model are only known once it is imported.
+	size_t count = assets.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (assets[i].type == COOK_ASSET_MODEL && assets[i].result != COOK_RESULT_FAILED)
+			addModelTextures(assets[i]);
+	}
+
+	runStage(COOK_ASSET_TEXTURE);
+	runStage(COOK_ASSET_SHADER);
+
+	bool failed = false;
+	for (size_t i = 0; i < assets.size(); ++i)
+	{
+		const CookAsset& asset = assets[i];
+		if (asset.result == COOK_RESULT_UP_TO_DATE || asset.result == COOK_RESULT_CACHED || asset.result == COOK_RESULT_BUILT)
+			manifest[AssetId(asset.path, asset.internalFormat)] = asset.key;
+		failed = failed || asset.result == COOK_RESULT_FAILED;
+	}
+
+	return saveManifest() && !failed;
+}
+
+/*
+	Prints the time and result of every asset, then the
+	totals and cache hits per kind of asset.
+*/
+void AssetCooker::PrintReport(void) const
+{
+	unsigned int inputEdges = 0;
+	for (size_t i = 0; i < assets.size(); ++i)
+		inputEdges += (unsigned int)assets[i].inputs.size() - (assets[i].inputs.empty() ? 0 : 1);
+
+	printf("Dependency graph : %u assets, %u material libraries, %u model textures\n", (unsigned int)assets.size(), inputEdges, modelTextureEdges);
+
+	unsigned int totalHits = 0, totalCooked = 0;
+	for (unsigned int type = 0; type < COOK_ASSET_TYPE_COUNT; ++type)
+	{
+		unsigned int results[COOK_RESULT_COUNT] = { 0 };
+		double time = 0.0;
+
+		printf("%s\n", TYPE_NAMES[type]);
+		for (size_t i = 0; i < assets.size(); ++i)
+		{
+			const CookAsset& asset = assets[i];
+			if (asset.type != type)
+				continue;
+
+			printf("  %-10s %9.1f ms  %s\n", RESULT_NAMES[asset.result], asset.time * 1000.0, asset.path.c_str());
+			++results[asset.result];
+			time += asset.time;
+		}
+
+		unsigned int hits = results[COOK_RESULT_UP_TO_DATE] + results[COOK_RESULT_CACHED];
+		unsigned int cooked = hits + results[COOK_RESULT_BUILT] + results[COOK_RESULT_FAILED];
+		printf("  %u up to date, %u from the store, %u built, %u skipped, %u failed : %.1f ms of work, %.0f%% cache hits\n",
+			results[COOK_RESULT_UP_TO_DATE], results[COOK_RESULT_CACHED], results[COOK_RESULT_BUILT], results[COOK_RESULT_SKIPPED], results[COOK_RESULT_FAILED],
+			time * 1000.0, cooked > 0 ? 100.0 * hits / cooked : 100.0);
+
+		totalHits += hits;
+		totalCooked += cooked;
+	}
+
+	printf("Cache hits : %u of %u assets (%.0f%%)\n", totalHits, totalCooked, totalCooked > 0 ? 100.0 * totalHits / totalCooked : 100.0);
+}
+
+/*
+	Cooks every asset of a kind. Models and textures are
+	cooked in parallel, shaders on this thread, which owns
+	the OpenGL context.
+*/
+void AssetCooker::runStage(CookAssetType type)
+{
+	std::vector<unsigned int> stage;
+	for (unsigned int i = 0; i < (unsigned int)assets.size(); ++i)
+	{
+		if (assets[i].type == type)
+			stage.push_back(i);
+	}
+
+	if (pool != NULL && type != COOK_ASSET_SHADER)
+	{
+		pool->ParallelFor((unsigned int)stage.size(), [&](unsigned int i) { cook(assets[stage[i]]); });
+	}
+	else
+	{
+		for (size_t i = 0; i < stage.size(); ++i)
+			cook(assets[stage[i]]);
+	}
+}
+
+/*
+	Adds an asset to the graph, unless it is already in
+	it for the same format.
+
+	type			-	What the asset is converted with.
+	path			-	Source file.
+	internalFormat	-	Format of a texture, 0 otherwise.
+*/
+void AssetCooker::addAsset(CookAssetType type, const std::string& path, GLint internalFormat)
+{
+	if (!added.insert(AssetId(path, internalFormat)).second)
+		return;
+
+	CookAsset asset;
+	asset.type = type;
+	asset.path = path;
+	asset.internalFormat = internalFormat;
+	asset.key = 0;
+	asset.result = COOK_RESULT_SKIPPED;
+	asset.time = 0.0;
+
+	if (type == COOK_ASSET_MODEL)
+		asset.outputPath = Model::GetCachePath(path);
+	else if (type == COOK_ASSET_TEXTURE)
+		asset.outputPath = TextureCooker::GetCookedPath(path.c_str(), internalFormat);
+
+	assets.push_back(asset);
+}
+
+/*
+	Adds the textures the materials of a cooked model
+	use, in the format the Model asks for them in.
+*/
+void AssetCooker::addModelTextures(const CookAsset& model)
+{
+	MeshCache cache;
+	if (!cache.Open(model.outputPath.c_str()))
+		return;
+
+	std::string directory = model.path.substr(0, model.path.find_last_of('/'));
+	std::set<std::string> textures;
+	for (unsigned int m = 0; m < cache.GetMeshCount(); ++m)
+	{
+		const MeshCacheMesh& mesh = cache.GetMesh(m);
+		for (unsigned int t = 0; t < mesh.textureCount; ++t)
+			textures.insert(directory + "/" + cache.GetTexture(mesh.firstTexture + t).path);
+	}
+
+	for (std::set<std::string>::const_iterator texture = textures.begin(); texture != textures.end(); ++texture)
+		addAsset(COOK_ASSET_TEXTURE, *texture, MODEL_TEXTURE_FORMAT);
+	modelTextureEdges += (unsigned int)textures.size();
+}
+
+/*
+	Brings the output of an asset up to date : nothing
+	to do if the installed one was built from the same
+	inputs, a copy if the store holds such an output,
+	otherwise a build, which is then stored. Runs on the
+	pool, every asset only touches its own record.
+*/
+void AssetCooker::cook(CookAsset& asset) const
+{
+	double start = getTimeElapsed();
+
+	if (!hashInputs(asset))
+	{
+		asset.result = COOK_RESULT_FAILED;
+	}
+	else
+	{
+		std::map<std::string, unsigned long long>::const_iterator installed = manifest.find(AssetId(asset.path, asset.internalFormat));
+		if (installed != manifest.end() && installed->second == asset.key && isInstalled(asset))
+		{
+			asset.result = COOK_RESULT_UP_TO_DATE;
+		}
+		else if (asset.type == COOK_ASSET_SHADER)
+		{
+			if (!shaderContext)
+				asset.result = COOK_RESULT_SKIPPED;
+			else
+				asset.result = compileShader(asset) ? COOK_RESULT_BUILT : COOK_RESULT_FAILED;
+		}
+		else
+		{
+			std::string storePath = getStorePath(asset);
+			unsigned long long storeTime;
+			if (getFileWriteTime(storePath.c_str(), storeTime) && CopyFileContents(storePath.c_str(), asset.outputPath.c_str()))
+			{
+				asset.result = COOK_RESULT_CACHED;
+			}
+			else if (build(asset))
+			{
+				// Not fatal, the output is only built again next time.
+				CopyFileContents(asset.outputPath.c_str(), storePath.c_str());
+				asset.result = COOK_RESULT_BUILT;
+			}
+			else
+			{
+				asset.result = COOK_RESULT_FAILED;
+			}
+		}
+	}
+
+	asset.time = getTimeElapsed() - start;
+}
+
+/*
+	Finds the inputs of an asset and hashes them into
+	its key. Returns false if one can't be read.
+*/
+bool AssetCooker::hashInputs(CookAsset& asset) const
+{
+	unsigned int salt[] = { COOK_VERSION, (unsigned int)asset.type, (unsigned int)asset.internalFormat, MESH_CACHE_VERSION };
+	unsigned long long hash = hashBytes(salt, sizeof(salt));
+
+	asset.inputs.clear();
+	asset.inputs.push_back(asset.path);
+
+	for (size_t i = 0; i < asset.inputs.size(); ++i)
+	{
+		FileData data;
+		if (!FileSystem::ReadFile(asset.inputs[i].c_str(), data))
+		{
+			printf("Could not read %s\n", asset.inputs[i].c_str());
+			return false;
+		}
+
+		// Material libraries are inputs of the model, changing one rebuilds it.
+		if (i == 0 && asset.type == COOK_ASSET_MODEL && HasExtension(FileSystem::NormalizePath(asset.path.c_str()), ".obj"))
+			FindMaterialLibraries(data, asset.path.substr(0, asset.path.find_last_of('/')), asset.inputs);
+
+		std::string name = FileSystem::NormalizePath(asset.inputs[i].c_str());
+		hash = hashBytes(name.c_str(), name.size() + 1, hash);
+		hash = hashBytes(data.GetData(), data.GetSize(), hash);
+	}
+
+	asset.key = hash;
+	return true;
+}
+
+/*
+	Whether the output of an asset exists and the engine
+	will take it as it is.
+*/
+bool AssetCooker::isInstalled(const CookAsset& asset) const
+{
+	switch (asset.type)
+	{
+	case COOK_ASSET_MODEL:
+		return MeshCache::IsFresh(asset.outputPath.c_str(), asset.path.c_str());
+	case COOK_ASSET_TEXTURE:
+		return TextureCooker::IsFresh(asset.outputPath.c_str(), asset.path.c_str());
+	default:
+		return true;
+	}
+}
+
+/*
+	Converts a model or a texture into its output, on
+	the calling thread.
+*/
+bool AssetCooker::build(CookAsset& asset) const
+{
+	if (asset.type == COOK_ASSET_MODEL)
+	{
+		vector<MeshSource> sources;
+		return Model::Import(asset.path, sources) && MeshCache::Write(asset.outputPath.c_str(), sources);
+	}
+
+	return TextureCooker::Cook(asset.path.c_str(), asset.internalFormat, true, asset.outputPath.c_str());
+}
+
+/*
+	Compiles a shader stage as it is, without the
+	defines of its permutations, and prints the errors.
+*/
+bool AssetCooker::compileShader(const CookAsset& asset) const
+{
+	FileData source;
+	if (!FileSystem::ReadFile(asset.path.c_str(), source))
+		return false;
+
+	std::string name = FileSystem::NormalizePath(asset.path.c_str());
+	GLenum type = GL_FRAGMENT_SHADER;
+	if (HasExtension(name, ".vert"))
+		type = GL_VERTEX_SHADER;
+	else if (HasExtension(name, ".gs"))
+		type = GL_GEOMETRY_SHADER;
+
+	const GLchar* code = (const GLchar*)source.GetData();
+	GLint length = (GLint)source.GetSize();
+
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &code, &length);
+	glCompileShader(shader);
+
+	GLint success;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		GLchar infoLog[1024];
+		glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+		printf("%s :\n%s\n", asset.path.c_str(), infoLog);
+	}
+
+	glDeleteShader(shader);
+	return success != 0;
+}
+
+/*
+	File of the store holding the output for the inputs
+	of an asset.
+*/
+std::string AssetCooker::getStorePath(const CookAsset& asset) const
+{
+	char name[32];
+	_snprintf_s(name, sizeof(name), _TRUNCATE, "/%016llx", asset.key);
+	return std::string(COOK_STORE_DIRECTORY) + name + (asset.type == COOK_ASSET_MODEL ? ".lemc" : ".ktx");
+}
+
+/*
+	Reads the keys of the installed outputs. A missing
+	manifest makes every output count as not installed,
+	they are then copied from the store or built.
+*/
+void AssetCooker::loadManifest(void)
+{
+	manifest.clear();
+
+	FILE* file = NULL;
+	if (fopen_s(&file, (std::string(COOK_STORE_DIRECTORY) + "/" + COOK_MANIFEST_FILE).c_str(), "r") != 0 || file == NULL)
+		return;
+
+	char line[1024];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		// "<key> <asset>", one asset per line.
+		char* id = NULL;
+		unsigned long long key = _strtoui64(line, &id, 16);
+		if (id == line || *id != ' ')
+			continue;
+
+		std::string name(id + 1);
+		while (!name.empty() && (name[name.size() - 1] == '\n' || name[name.size() - 1] == '\r'))
+			name.erase(name.size() - 1);
+		manifest[name] = key;
+	}
+
+	fclose(file);
+}
+
+/*
+	Writes the keys of the installed outputs.
+*/
+bool AssetCooker::saveManifest(void) const
+{
+	std::string path = std::string(COOK_STORE_DIRECTORY) + "/" + COOK_MANIFEST_FILE;
+
+	FILE* file = NULL;
+	if (fopen_s(&file, path.c_str(), "w") != 0 || file == NULL)
+	{
+		printf("Could not write %s\n", path.c_str());
+		return false;
+	}
+
+	for (std::map<std::string, unsigned long long>::const_iterator entry = manifest.begin(); entry != manifest.end(); ++entry)
+		fprintf(file, "%016llx %s\n", entry->second, entry->first.c_str());
+
+	fclose(file);
+	return true;
+}
\ No newline at end of file
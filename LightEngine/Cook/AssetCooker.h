@@ -0,0 +1,152 @@
+#pragma once
+
+// Includes.
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include "..\Contrib\Include\gl\glew.h"
+#include "..\Util\Utility.h"
+#include "..\Util\ThreadPool.h"
+#include "..\Util\FileSystem.h"
+#include "..\Util\TextureCooker.h"
+#include "..\Renderer\Model.h"
+
+// Bump to rebuild every output, e.g. after changing how assets are converted.
+const unsigned int COOK_VERSION = 1;
+
+// Directory of the content-addressed outputs, and the file recording what is installed.
+const char* const COOK_STORE_DIRECTORY = "Cooked";
+const char* const COOK_MANIFEST_FILE = "manifest.txt";
+
+// Directories scanned for each kind of asset.
+const char* const COOK_MODEL_DIRECTORY = "Models";
+const char* const COOK_TEXTURE_DIRECTORY = "Textures";
+const char* const COOK_SHADER_DIRECTORY = "Shaders";
+
+// Extensions of the files cooked in those directories.
+const char* const COOK_MODEL_EXTENSIONS[] = { ".obj", ".fbx", ".dae", ".3ds" };
+const char* const COOK_TEXTURE_EXTENSIONS[] = { ".bmp", ".png", ".jpg", ".tga" };
+const char* const COOK_SHADER_EXTENSIONS[] = { ".vert", ".gs", ".frag" };
+
+/*
+	Format the engine asks for an image of the texture
+	directory in, picked by a part of its file name.
+	Images matching no rule are cooked as GL_RGB.
+*/
+struct CookTextureRule
+{
+	const char*	pattern;
+	GLint		internalFormat;
+};
+
+const CookTextureRule COOK_TEXTURE_RULES[] = {
+	{ "_normal", GL_RG },
+	{ "_diffuse", GL_SRGB },
+	{ "particle", GL_RGBA }
+};
+
+enum CookAssetType
+{
+	COOK_ASSET_MODEL,
+	COOK_ASSET_TEXTURE,
+	COOK_ASSET_SHADER,
+	COOK_ASSET_TYPE_COUNT
+};
+
+enum CookResult
+{
+	COOK_RESULT_UP_TO_DATE,		// The installed output was built from the same inputs.
+	COOK_RESULT_CACHED,			// Copied from the store, built from the same inputs before.
+	COOK_RESULT_BUILT,
+	COOK_RESULT_SKIPPED,
+	COOK_RESULT_FAILED,
+	COOK_RESULT_COUNT
+};
+
+/*
+	One node of the dependency graph.
+
+	type			-	What the asset is converted with.
+	path			-	Source file.
+	internalFormat	-	Format textures are cooked for.
+	outputPath		-	File the engine loads, next to the source.
+	inputs			-	Files the output depends on, path first.
+	key				-	Hash of COOK_VERSION, the type, the format
+						and the contents of every input.
+	result			-	What Run() did.
+	time			-	Seconds it took.
+*/
+struct CookAsset
+{
+	CookAssetType				type;
+	std::string					path;
+	GLint						internalFormat;
+	std::string					outputPath;
+	std::vector<std::string>	inputs;
+	unsigned long long			key;
+	CookResult					result;
+	double						time;
+};
+
+/*
+	Offline asset pipeline behind the LightEngineCook
+	target : it converts everything the engine would
+	otherwise convert on first load, so the engine
+	only ever reads finished files.
+
+		Models		-	Imported and optimized into mesh
+						caches (see MeshCache).
+		Textures	-	Mip mapped and block compressed into
+						KTX files (see TextureCooker).
+		Shaders		-	Every stage compiled, to report errors
+						before the engine runs.
+
+	Scan() builds the dependency graph : a model depends
+	on its material libraries, and its textures are added
+	as assets of their own once the model is cooked. Run()
+	cooks a stage at a time, the assets of a stage in
+	parallel on the pool.
+
+	Outputs are keyed by a hash of everything they are
+	built from and kept in COOK_STORE_DIRECTORY. An asset
+	whose inputs didn't change is never rebuilt : its
+	output is either still installed or copied back from
+	the store (e.g. after switching branches).
+*/
+class AssetCooker
+{
+public:
+
+// Functions
+
+	AssetCooker(ThreadPool* pool);
+	void Scan(void);
+	bool Run(bool compileShaders);
+	void PrintReport(void) const;
+
+private:
+
+// Functions
+
+	void runStage(CookAssetType type);
+	void addAsset(CookAssetType type, const std::string& path, GLint internalFormat);
+	void addModelTextures(const CookAsset& model);
+	void cook(CookAsset& asset) const;
+	bool hashInputs(CookAsset& asset) const;
+	bool isInstalled(const CookAsset& asset) const;
+	bool build(CookAsset& asset) const;
+	bool compileShader(const CookAsset& asset) const;
+	std::string getStorePath(const CookAsset& asset) const;
+	void loadManifest(void);
+	bool saveManifest(void) const;
+
+// Variables
+
+	ThreadPool*									pool;
+	std::vector<CookAsset>						assets;
+	std::set<std::string>						added;		// Normalized path and format of every asset.
+	std::map<std::string, unsigned long long>	manifest;	// Key of the installed output of every asset.
+	bool										shaderContext;
+	unsigned int								modelTextureEdges;
+};
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "AssetCooker.h"
+#include "..\Contrib\Include\GLFW\glfw3.h"
+#include <cstring>
+#include <cstdlib>
+
+// Linking libraries
+#pragma comment(lib, "opengl32.lib")
+#pragma comment(lib, "glew32.lib")
+#pragma comment(lib, "glfw3.lib")
+#pragma comment(lib, "SOIL.lib")
+#pragma comment(lib, "assimp.lib")
+
+namespace
+{
+	/*
+		Creates a hidden window whose OpenGL context, the
+		one the engine asks for, compiles the shaders.
+		Returns NULL if there is no such context, e.g. on
+		a build machine without a GPU.
+	*/
+	GLFWwindow* CreateShaderContext(void)
+	{
+		if (!glfwInit())
+			return NULL;
+
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+		GLFWwindow* window = glfwCreateWindow(64, 64, "LightEngineCook", nullptr, nullptr);
+		if (window == NULL)
+			return NULL;
+
+		glfwMakeContextCurrent(window);
+		glewExperimental = GL_TRUE;
+		if (glewInit() != GLEW_OK)
+		{
+			glfwDestroyWindow(window);
+			return NULL;
+		}
+
+		return window;
+	}
+}
+
+/*
+	LightEngineCook : cooks the assets of the working
+	directory (see AssetCooker), so the engine loads
+	finished files only.
+
+	--threads n		-	Threads the assets are cooked on.
+	--no-shaders	-	Don't compile the shaders.
+	--pack [file]	-	Pack the assets afterwards, for --pack
+						of the engine.
+*/
+int main(int argc, char* argv[])
+{
+	unsigned int threads = ThreadPool::GetDefaultThreadCount();
+	bool shaders = true;
+	const char* packPath = NULL;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+			threads = (unsigned int)atoi(argv[i + 1]);
+		if (strcmp(argv[i], "--no-shaders") == 0)
+			shaders = false;
+		if (strcmp(argv[i], "--pack") == 0)
+			packPath = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[i + 1] : FILE_SYSTEM_DEFAULT_PACK;
+	}
+
+	// The engine's log.log is left alone.
+	InitUtility("cook.log");
+
+	GLFWwindow* context = shaders ? CreateShaderContext() : NULL;
+	if (shaders && context == NULL)
+		printf("No OpenGL 3.3 context, the shaders are not compiled\n");
+
+	int result = 0;
+	{
+		ThreadPool pool(threads);
+		printf("Cooking on %u thread(s)\n", pool.GetThreadCount());
+
+		double start = getTimeElapsed();
+
+		AssetCooker cooker(&pool);
+		cooker.Scan();
+		if (!cooker.Run(context != NULL))
+			result = 1;
+
+		double seconds = getTimeElapsed() - start;
+
+		cooker.PrintReport();
+		printf("Cooked in %.1f ms\n", seconds * 1000.0);
+
+		if (packPath != NULL)
+		{
+			if (FileSystem::BuildPack(packPath, true, &pool))
+			{
+				printf("Packed into %s\n", packPath);
+			}
+			else
+			{
+				printf("Could not write pack %s\n", packPath);
+				result = 1;
+			}
+		}
+	}
+
+	if (context != NULL)
+		glfwDestroyWindow(context);
+	glfwTerminate();
+
+	ShutdownUtility();
+	return result;
+}
\ No newline at end of file
@@ -1,5 +1,10 @@
 #include "Application.h"
+#include "Util\Benchmark.h"
+#include "Renderer\VertexQuantizer.h"
+#include "Renderer\Model.h"
 #include <Windows.h>
+#include <cstring>
+#include <cstdlib>
 
 // The MAIN function, from here we start the application and run the game loop
 //int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
@@ -9,8 +14,136 @@
 //	return app.Run();
 //}
 
-int main()
+int main(int argc, char* argv[])
 {
+	// The microbenchmarks time themselves with the Utility timer, the engine restarts it.
+	InitTimer();
+
+	// Microbenchmarks that run without opening a window.
+	for (int i = 1; i < argc; ++i)
+	{
+		// --bench-logger [threads] [messages per thread]
+		if (strcmp(argv[i], "--bench-logger") == 0)
+		{
+			int threads = (i + 1 < argc) ? atoi(argv[i + 1]) : 4;
+			int messages = (i + 2 < argc) ? atoi(argv[i + 2]) : 100000;
+			return RunLoggerBenchmark(threads, messages);
+		}
+		// --bench-models [iterations] : Assimp vs mesh cache load times of the bundled models.
+		if (strcmp(argv[i], "--bench-models") == 0)
+		{
+			int iterations = (i + 1 < argc) ? atoi(argv[i + 1]) : 10;
+			return RunModelLoadBenchmark(iterations);
+		}
+		// --bench-culling [iterations] : meshlets and triangles culled around the bundled models, SSE vs scalar.
+		if (strcmp(argv[i], "--bench-culling") == 0)
+		{
+			int iterations = (i + 1 < argc) ? atoi(argv[i + 1]) : 100;
+			return RunClusterCullingBenchmark(iterations);
+		}
+		// --bench-allocator [iterations] : free-list churn and fragmentation of a geometry pool allocator.
+		if (strcmp(argv[i], "--bench-allocator") == 0)
+		{
+			int iterations = (i + 1 < argc) ? atoi(argv[i + 1]) : 100000;
+			return RunAllocatorBenchmark(iterations);
+		}
+		// --bench-materials [iterations] : per-draw texture binding cost, sampler names vs interned binding tables.
+		if (strcmp(argv[i], "--bench-materials") == 0)
+		{
+			int iterations = (i + 1 < argc) ? atoi(argv[i + 1]) : 100000;
+			return RunMaterialBenchmark(iterations);
+		}
+		// --bench-bc [iterations] : block compression speed, ratio and quality on the bundled textures.
+		if (strcmp(argv[i], "--bench-bc") == 0)
+		{
+			int iterations = (i + 1 < argc) ? atoi(argv[i + 1]) : 10;
+			return RunBlockCompressionBenchmark(iterations);
+		}
+		// --bench-mips [iterations] : mip chain speed of every filter on the bundled textures.
+		if (strcmp(argv[i], "--bench-mips") == 0)
+		{
+			int iterations = (i + 1 < argc) ? atoi(argv[i + 1]) : 10;
+			return RunMipBenchmark(iterations);
+		}
+		// --build-pack [file] : pack the assets into one compressed archive for --pack.
+		if (strcmp(argv[i], "--build-pack") == 0)
+		{
+			const char* path = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[i + 1] : FILE_SYSTEM_DEFAULT_PACK;
+			return RunPackBuild(path);
+		}
+		// --bench-vfs [iterations] : cold asset reads from loose files vs the pack.
+		if (strcmp(argv[i], "--bench-vfs") == 0)
+		{
+			int iterations = (i + 1 < argc) ? atoi(argv[i + 1]) : 10;
+			return RunFileSystemBenchmark(iterations);
+		}
+		// --bench-import [iterations] : model import times on 1, 2, 4 and 8 threads.
+		if (strcmp(argv[i], "--bench-import") == 0)
+		{
+			int iterations = (i + 1 < argc) ? atoi(argv[i + 1]) : 5;
+			return RunImportBenchmark(iterations);
+		}
+	}
+
 	Application app("LightEngine Demo", 800, 600);
+
+	for (int i = 1; i < argc; ++i)
+	{
+		// --trace [frames] : write a Chrome trace of the first frames to trace.json.
+		if (strcmp(argv[i], "--trace") == 0)
+		{
+			int frames = (i + 1 < argc) ? atoi(argv[i + 1]) : 300;
+			app.CaptureTrace(frames > 0 ? frames : 300);
+		}
+		// --benchmark [frames] [camera path] : hidden window, scripted camera, writes benchmark.json.
+		if (strcmp(argv[i], "--benchmark") == 0)
+		{
+			int frames = (i + 1 < argc) ? atoi(argv[i + 1]) : 0;
+			const char* path = (i + 2 < argc && argv[i + 2][0] != '-') ? argv[i + 2] : NULL;
+			app.EnableBenchmark(frames > 0 ? frames : 1000, path, "benchmark.json");
+		}
+		// --telemetry [file] : stream per-frame telemetry to a CSV file.
+		if (strcmp(argv[i], "--telemetry") == 0)
+		{
+			const char* path = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[i + 1] : "telemetry.csv";
+			app.StreamTelemetry(path);
+		}
+		// --vertex-error [position] [normal] [uv] : largest errors of the quantized vertex formats.
+		if (strcmp(argv[i], "--vertex-error") == 0)
+		{
+			VertexErrorBounds bounds = VERTEX_ERROR_BOUNDS_DEFAULT;
+			float* values[] = { &bounds.position, &bounds.normal, &bounds.texCoord };
+			for (int v = 0; v < 3 && i + 1 + v < argc && argv[i + 1 + v][0] != '-'; ++v)
+				*values[v] = (float)atof(argv[i + 1 + v]);
+			VertexQuantizer::SetErrorBounds(bounds);
+		}
+		// --no-lod : draw every model at full detail, to compare frame times and triangle counts.
+		if (strcmp(argv[i], "--no-lod") == 0)
+			Model::SetLodEnabled(false);
+		// --lod-error [main] [shadow] : largest error of a selected LOD on screen, in pixels.
+		if (strcmp(argv[i], "--lod-error") == 0)
+		{
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				Model::SetLodPixelError(LOD_PASS_MAIN, (float)atof(argv[i + 1]));
+			if (i + 2 < argc && argv[i + 1][0] != '-' && argv[i + 2][0] != '-')
+				Model::SetLodPixelError(LOD_PASS_SHADOW, (float)atof(argv[i + 2]));
+		}
+		// --no-cluster-culling : draw whole meshes instead of their visible meshlets.
+		if (strcmp(argv[i], "--no-cluster-culling") == 0)
+			Model::SetClusterCullingEnabled(false);
+		// --no-texture-compression : upload the images uncompressed instead of their cooked BC files.
+		if (strcmp(argv[i], "--no-texture-compression") == 0)
+			TextureStreamer::SetCompression(false);
+		// --gpu-mipmaps : let the driver generate the mips of uncompressed textures.
+		if (strcmp(argv[i], "--gpu-mipmaps") == 0)
+			TextureStreamer::SetCpuMipmaps(false);
+		// --pack [file] : read the assets from a pack built by --build-pack.
+		if (strcmp(argv[i], "--pack") == 0)
+			app.MountPack((i + 1 < argc && argv[i + 1][0] != '-') ? argv[i + 1] : FILE_SYSTEM_DEFAULT_PACK);
+		// --no-loose-files : fail on assets the pack doesn't hold instead of reading them from disk.
+		if (strcmp(argv[i], "--no-loose-files") == 0)
+			FileSystem::SetLooseFiles(false);
+	}
+
 	return app.Run();
 }
\ No newline at end of file
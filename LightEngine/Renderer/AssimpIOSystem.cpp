@@ -0,0 +1,143 @@
+#include "AssimpIOSystem.h"
+#include <cstring>
+#include <algorithm>
+
+/*
+	Stream over a file, which it takes ownership of.
+
+	file	-	Contents of the file.
+*/
+AssimpIOStream::AssimpIOStream(FileData* file)
+{
+	this->file = file;
+	position = 0;
+}
+
+/*
+	Copies up to count items of size bytes, see fread().
+*/
+size_t AssimpIOStream::Read(void* buffer, size_t size, size_t count)
+{
+	if (size == 0)
+		return 0;
+
+	size_t items = std::min(count, (file->GetSize() - position) / size);
+	memcpy(buffer, file->GetData() + position, items * size);
+	position += items * size;
+	return items;
+}
+
+/*
+	Files are read only.
+*/
+size_t AssimpIOStream::Write(const void* buffer, size_t size, size_t count)
+{
+	return 0;
+}
+
+/*
+	Moves the read position, see fseek(). The offset
+	counts backwards from aiOrigin_END.
+*/
+aiReturn AssimpIOStream::Seek(size_t offset, aiOrigin origin)
+{
+	size_t target;
+	if (origin == aiOrigin_SET)
+		target = offset;
+	else if (origin == aiOrigin_CUR)
+		target = position + offset;
+	else
+		target = file->GetSize() - offset;
+
+	if (target > file->GetSize())
+		return aiReturn_FAILURE;
+
+	position = target;
+	return aiReturn_SUCCESS;
+}
+
+/*
+	Read position.
+*/
+size_t AssimpIOStream::Tell(void) const
+{
+	return position;
+}
+
+/*
+	Size of the file.
+*/
+size_t AssimpIOStream::FileSize(void) const
+{
+	return file->GetSize();
+}
+
+/*
+	Nothing is ever written.
+*/
+void AssimpIOStream::Flush(void)
+{
+}
+
+/*
+	Destructor, frees the file.
+*/
+AssimpIOStream::~AssimpIOStream()
+{
+	delete file;
+}
+
+/*
+	Constructor.
+
+	pool	-	Threads to decompress on, may be NULL. Not the
+				pool of the task that imports.
+*/
+AssimpIOSystem::AssimpIOSystem(ThreadPool* pool)
+{
+	this->pool = pool;
+}
+
+/*
+	Whether the file is in the pack or on disk.
+*/
+bool AssimpIOSystem::Exists(const char* path) const
+{
+	return FileSystem::Exists(path);
+}
+
+/*
+	Separator Assimp builds the paths of referenced files
+	with, the FileSystem takes either.
+*/
+char AssimpIOSystem::getOsSeparator(void) const
+{
+	return '/';
+}
+
+/*
+	Reads the whole file. Returns NULL if it can't be read
+	or is to be written.
+*/
+Assimp::IOStream* AssimpIOSystem::Open(const char* path, const char* mode)
+{
+	if (strchr(mode, 'w') != NULL)
+		return NULL;
+
+	FileData* file = new FileData();
+	if (!FileSystem::ReadFile(path, *file, pool))
+	{
+		delete file;
+		return NULL;
+	}
+
+	return new AssimpIOStream(file);
+}
+
+/*
+	Frees a stream returned by Open().
+*/
+void AssimpIOSystem::Close(Assimp::IOStream* stream)
+{
+	delete stream;
+}
\ No newline at end of file
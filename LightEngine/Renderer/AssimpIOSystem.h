@@ -0,0 +1,58 @@
+#pragma once
+
+// Includes.
+#include "..\Contrib\Include\assimp\IOSystem.hpp"
+#include "..\Contrib\Include\assimp\IOStream.hpp"
+#include "..\Util\FileSystem.h"
+
+/*
+	File read by Assimp, held in memory. Read only.
+*/
+class AssimpIOStream : public Assimp::IOStream
+{
+public:
+
+// Functions
+
+	AssimpIOStream(FileData* file);
+	size_t Read(void* buffer, size_t size, size_t count);
+	size_t Write(const void* buffer, size_t size, size_t count);
+	aiReturn Seek(size_t offset, aiOrigin origin);
+	size_t Tell(void) const;
+	size_t FileSize(void) const;
+	void Flush(void);
+	~AssimpIOStream();
+
+private:
+
+// Variables
+
+	FileData*	file;
+	size_t		position;
+};
+
+/*
+	Lets Assimp read models, and the material libraries
+	and other files they refer to, through the FileSystem,
+	so they can come from the pack. Assimp owns the
+	instance it is given with Importer::SetIOHandler().
+*/
+class AssimpIOSystem : public Assimp::IOSystem
+{
+public:
+
+// Functions
+
+	AssimpIOSystem(ThreadPool* pool = NULL);
+	bool Exists(const char* path) const;
+	char getOsSeparator(void) const;
+	Assimp::IOStream* Open(const char* path, const char* mode = "rb");
+	void Close(Assimp::IOStream* stream);
+
+private:
+
+// Variables
+
+	// Threads large files are decompressed on.
+	ThreadPool*	pool;
+};
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "ClusterCuller.h"
+#include <xmmintrin.h>
+
+/*
+	Copies the bounds of meshlets into a ClusterBounds.
+
+	meshlets	-	Meshlets of a mesh.
+	bounds		-	Receives their bounds, padded.
+*/
+void ClusterCuller::BuildBounds(const vector<Meshlet>& meshlets, ClusterBounds& bounds)
+{
+	bounds.count = (unsigned int)meshlets.size();
+	size_t padded = (meshlets.size() + 3) & ~(size_t)3;
+
+	bounds.centerX.assign(padded, 0.0f);
+	bounds.centerY.assign(padded, 0.0f);
+	bounds.centerZ.assign(padded, 0.0f);
+	bounds.radius.assign(padded, -1.0f);
+	bounds.axisX.assign(padded, 0.0f);
+	bounds.axisY.assign(padded, 0.0f);
+	bounds.axisZ.assign(padded, 0.0f);
+	bounds.cutoff.assign(padded, 1.0f);
+
+	for (size_t i = 0; i < meshlets.size(); ++i)
+	{
+		const Meshlet& meshlet = meshlets[i];
+		bounds.centerX[i] = meshlet.center.x;
+		bounds.centerY[i] = meshlet.center.y;
+		bounds.centerZ[i] = meshlet.center.z;
+		bounds.radius[i] = meshlet.radius;
+		bounds.axisX[i] = meshlet.coneAxis.x;
+		bounds.axisY[i] = meshlet.coneAxis.y;
+		bounds.axisZ[i] = meshlet.coneAxis.z;
+		bounds.cutoff[i] = meshlet.coneCutoff;
+	}
+}
+
+/*
+	Tests four clusters at a time and flags the visible
+	ones. Returns the number of visible clusters.
+
+	bounds				-	Bounds of the clusters.
+	modelViewProjection	-	Matrix the clusters are drawn with.
+	viewer				-	Camera position in object space.
+	visible				-	Receives 1 or 0 per cluster, including
+							the padding ones.
+*/
+unsigned int ClusterCuller::Cull(const ClusterBounds& bounds, const glm::mat4& modelViewProjection, const glm::vec3& viewer, unsigned char* visible)
+{
+	glm::vec4 planes[6];
+	GetFrustumPlanes(modelViewProjection, planes);
+
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int p = 0; p < 6; ++p)
+	{
+		planeX[p] = _mm_set1_ps(planes[p].x);
+		planeY[p] = _mm_set1_ps(planes[p].y);
+		planeZ[p] = _mm_set1_ps(planes[p].z);
+		planeW[p] = _mm_set1_ps(planes[p].w);
+	}
+
+	__m128 viewerX = _mm_set1_ps(viewer.x), viewerY = _mm_set1_ps(viewer.y), viewerZ = _mm_set1_ps(viewer.z);
+	__m128 zero = _mm_setzero_ps();
+	unsigned int visibleCount = 0;
+
+	for (size_t i = 0; i < bounds.radius.size(); i += 4)
+	{
+		__m128 centerX = _mm_loadu_ps(&bounds.centerX[i]);
+		__m128 centerY = _mm_loadu_ps(&bounds.centerY[i]);
+		__m128 centerZ = _mm_loadu_ps(&bounds.centerZ[i]);
+		__m128 radius = _mm_loadu_ps(&bounds.radius[i]);
+		__m128 negativeRadius = _mm_sub_ps(zero, radius);
+
+		// Padding clusters have a negative radius.
+		__m128 culled = _mm_cmplt_ps(radius, zero);
+
+		for (int p = 0; p < 6; ++p)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)),
+				_mm_add_ps(_mm_mul_ps(planeZ[p], centerZ), planeW[p]));
+			culled = _mm_or_ps(culled, _mm_cmplt_ps(distance, negativeRadius));
+		}
+
+		// Back-facing if dot(center - viewer, axis) >= cutoff * |center - viewer| + radius.
+		__m128 toX = _mm_sub_ps(centerX, viewerX);
+		__m128 toY = _mm_sub_ps(centerY, viewerY);
+		__m128 toZ = _mm_sub_ps(centerZ, viewerZ);
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(toX, toX), _mm_mul_ps(toY, toY)), _mm_mul_ps(toZ, toZ)));
+		__m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toX, _mm_loadu_ps(&bounds.axisX[i])), _mm_mul_ps(toY, _mm_loadu_ps(&bounds.axisY[i]))),
+			_mm_mul_ps(toZ, _mm_loadu_ps(&bounds.axisZ[i])));
+		__m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&bounds.cutoff[i]), length), radius);
+		culled = _mm_or_ps(culled, _mm_cmpge_ps(along, limit));
+
+		int mask = _mm_movemask_ps(culled);
+		for (int k = 0; k < 4; ++k)
+		{
+			visible[i + k] = (mask & (1 << k)) == 0 ? 1 : 0;
+			visibleCount += visible[i + k];
+		}
+	}
+
+	return visibleCount;
+}
+
+/*
+	Same as Cull(), one cluster at a time without SSE.
+	Kept as the reference the SSE version is measured and
+	checked against.
+*/
+unsigned int ClusterCuller::CullScalar(const ClusterBounds& bounds, const glm::mat4& modelViewProjection, const glm::vec3& viewer, unsigned char* visible)
+{
+	glm::vec4 planes[6];
+	GetFrustumPlanes(modelViewProjection, planes);
+
+	unsigned int visibleCount = 0;
+	for (size_t i = 0; i < bounds.radius.size(); ++i)
+	{
+		glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+		float radius = bounds.radius[i];
+		bool culled = radius < 0.0f;
+
+		for (int p = 0; p < 6 && !culled; ++p)
+			culled = glm::dot(glm::vec3(planes[p]), center) + planes[p].w < -radius;
+
+		glm::vec3 to = center - viewer;
+		glm::vec3 axis(bounds.axisX[i], bounds.axisY[i], bounds.axisZ[i]);
+		culled = culled || glm::dot(to, axis) >= bounds.cutoff[i] * glm::length(to) + radius;
+
+		visible[i] = culled ? 0 : 1;
+		visibleCount += visible[i];
+	}
+
+	return visibleCount;
+}
+
+/*
+	Frustum planes of a matrix (Gribb and Hartmann), in the
+	space the matrix transforms from. The normals point
+	inwards and are normalized, so a plane gives the
+	signed distance of a point.
+
+	modelViewProjection	-	Matrix to take the planes of.
+	planes				-	Receives left, right, bottom, top, near
+							and far.
+*/
+void ClusterCuller::GetFrustumPlanes(const glm::mat4& modelViewProjection, glm::vec4 planes[6])
+{
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; ++r)
+		rows[r] = glm::vec4(modelViewProjection[0][r], modelViewProjection[1][r], modelViewProjection[2][r], modelViewProjection[3][r]);
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		planes[axis * 2] = rows[3] + rows[axis];
+		planes[axis * 2 + 1] = rows[3] - rows[axis];
+	}
+
+	for (int p = 0; p < 6; ++p)
+		planes[p] /= glm::length(glm::vec3(planes[p]));
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+// Includes.
+#include <vector>
+#include "VertexLayout.h"
+using namespace std;
+
+// Most vertices and triangles of a meshlet.
+const unsigned int MESHLET_MAX_VERTICES = 64;
+const unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+/*
+	Cluster of neighbouring triangles of LOD 0, a range of
+	the index buffer, with the bounds the ClusterCuller
+	tests it with.
+
+	center, radius			-	Object-space bounding sphere.
+	coneAxis, coneCutoff	-	Normal cone : the average direction the
+								triangles face and the sine of the
+								largest angle between it and any of
+								their normals; a cutoff of 1 is never
+								back-facing.
+*/
+struct Meshlet
+{
+	GLuint		firstIndex;
+	GLuint		indexCount;
+	glm::vec3	center;
+	float		radius;
+	glm::vec3	coneAxis;
+	float		coneCutoff;
+};
+
+// Meshlets are stored in mesh cache files as is.
+static_assert(sizeof(Meshlet) == 40, "Meshlet must be tightly packed.");
+
+/*
+	Meshlet bounds as structure of arrays, padded to a
+	multiple of 4 clusters so the culler can test four at
+	a time. Padding clusters have a negative radius and are
+	never visible.
+*/
+struct ClusterBounds
+{
+	unsigned int	count;		// Real clusters, without padding.
+	vector<float>	centerX;
+	vector<float>	centerY;
+	vector<float>	centerZ;
+	vector<float>	radius;
+	vector<float>	axisX;
+	vector<float>	axisY;
+	vector<float>	axisZ;
+	vector<float>	cutoff;
+};
+
+/*
+	Clusters a ClusterCuller pass looked at and rejected.
+*/
+struct ClusterCullStats
+{
+	unsigned int	clusters;
+	unsigned int	clustersCulled;
+	unsigned int	trianglesCulled;
+};
+
+/*
+	CPU culling of meshlets, with SSE. A cluster is
+	rejected if its bounding sphere is outside one of the
+	frustum planes, or if its normal cone shows that all
+	of its triangles face away from the viewer.
+
+	Everything is tested in the mesh's object space : the
+	frustum planes come from the full model-view-projection
+	matrix and the viewer is moved into object space, so
+	the bounds are never transformed. The cone test
+	assumes a uniform scale and a perspective projection.
+*/
+class ClusterCuller
+{
+public:
+
+// Functions
+
+	static void BuildBounds(const vector<Meshlet>& meshlets, ClusterBounds& bounds);
+	static unsigned int Cull(const ClusterBounds& bounds, const glm::mat4& modelViewProjection, const glm::vec3& viewer, unsigned char* visible);
+	static unsigned int CullScalar(const ClusterBounds& bounds, const glm::mat4& modelViewProjection, const glm::vec3& viewer, unsigned char* visible);
+	static void GetFrustumPlanes(const glm::mat4& modelViewProjection, glm::vec4 planes[6]);
+};
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "GeometryPool.h"
+
+std::vector<GeometryPool::Pool>	GeometryPool::pools;
+unsigned int					GeometryPool::boundPool = GEOMETRY_POOL_NONE;
+
+/*
+	Copies a mesh into the pool of its vertex format and
+	index type, enlarging the pool if it doesn't fit. The
+	data is only read during the call. Leaves no VAO bound.
+
+	vertices		-	First vertex.
+	vertexFormat	-	Format of the vertices.
+	vertexCount		-	Number of vertices.
+	indices			-	First index, relative to the first vertex.
+	indexType		-	GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+	indexCount		-	Number of indices.
+	allocation		-	Receives where the mesh was put.
+*/
+void GeometryPool::Allocate(const void* vertices, VertexFormat vertexFormat, GLuint vertexCount, const void* indices, GLenum indexType, GLuint indexCount,
+	GeometryAllocation& allocation)
+{
+	allocation.pool = GEOMETRY_POOL_NONE;
+	allocation.firstVertex = allocation.firstIndex = 0;
+	allocation.vertexCount = allocation.indexCount = 0;
+	if (vertexCount == 0 || indexCount == 0)
+		return;
+
+	unsigned int poolIndex = findPool(vertexFormat, indexType, vertexCount, indexCount);
+	Pool& pool = pools[poolIndex];
+	size_t stride = GetVertexFormatStride(vertexFormat);
+	size_t indexSize = getIndexSize(indexType);
+
+	glBindVertexArray(pool.VAO);
+	boundPool = GEOMETRY_POOL_NONE;
+
+	GLuint firstVertex, firstIndex;
+	if (!pool.vertices.Allocate(vertexCount, firstVertex))
+	{
+		// Doubling leaves a free block at the end that the vertices fit in.
+		GLuint capacity = pool.vertices.GetCapacity();
+		GLuint newCapacity = std::max(capacity * 2, capacity + vertexCount);
+		growBuffer(pool.VBO, capacity * stride, newCapacity * stride);
+		pool.vertices.Grow(newCapacity);
+		++pool.grows;
+
+		// The attribute pointers refer to the buffer bound when they were set.
+		glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+		SetupVertexFormat(vertexFormat);
+
+		pool.vertices.Allocate(vertexCount, firstVertex);
+		LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_RENDER, "Geometry pool %u grown to %u vertices.", poolIndex, newCapacity);
+	}
+	if (!pool.indices.Allocate(indexCount, firstIndex))
+	{
+		GLuint capacity = pool.indices.GetCapacity();
+		GLuint newCapacity = std::max(capacity * 2, capacity + indexCount);
+		growBuffer(pool.EBO, capacity * indexSize, newCapacity * indexSize);
+		pool.indices.Grow(newCapacity);
+		++pool.grows;
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.EBO);
+
+		pool.indices.Allocate(indexCount, firstIndex);
+		LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_RENDER, "Geometry pool %u grown to %u indices.", poolIndex, newCapacity);
+	}
+
+	// The element buffer is bound through the VAO.
+	glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, firstVertex * stride, vertexCount * stride, vertices);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * indexSize, indexCount * indexSize, indices);
+	glBindVertexArray(0);
+
+	allocation.pool = poolIndex;
+	allocation.firstVertex = firstVertex;
+	allocation.vertexCount = vertexCount;
+	allocation.firstIndex = firstIndex;
+	allocation.indexCount = indexCount;
+}
+
+/*
+	Gives the ranges of an allocation back to its pool,
+	without touching the buffers, so it is safe without a
+	context and after Shutdown(). The allocation becomes
+	empty.
+
+	allocation	-	Allocation to free.
+*/
+void GeometryPool::Free(GeometryAllocation& allocation)
+{
+	if (allocation.pool < pools.size())
+	{
+		Pool& pool = pools[allocation.pool];
+		pool.vertices.Free(allocation.firstVertex, allocation.vertexCount);
+		pool.indices.Free(allocation.firstIndex, allocation.indexCount);
+	}
+
+	allocation.pool = GEOMETRY_POOL_NONE;
+	allocation.vertexCount = allocation.indexCount = 0;
+}
+
+/*
+	Binds the VAO of a pool, unless it is still bound
+	from the last call. Whoever binds a pool unbinds it
+	with Unbind() before other VAOs are bound.
+
+	pool	-	Index of the pool.
+*/
+void GeometryPool::Bind(unsigned int pool)
+{
+	if (pool == boundPool || pool >= pools.size())
+		return;
+
+	glBindVertexArray(pools[pool].VAO);
+	boundPool = pool;
+}
+
+/*
+	Unbinds the pool bound by Bind().
+*/
+void GeometryPool::Unbind(void)
+{
+	if (boundPool == GEOMETRY_POOL_NONE)
+		return;
+
+	glBindVertexArray(0);
+	boundPool = GEOMETRY_POOL_NONE;
+}
+
+/*
+	Number of pools, one per vertex format and index type in use.
+*/
+unsigned int GeometryPool::GetPoolCount(void)
+{
+	return (unsigned int)pools.size();
+}
+
+/*
+	Fills in the usage of a pool.
+
+	pool	-	Index of the pool, less than GetPoolCount().
+	stats	-	Receives its usage.
+*/
+void GeometryPool::GetStats(unsigned int pool, GeometryPoolStats& stats)
+{
+	const Pool& source = pools[pool];
+	stats.vertexFormat = source.vertexFormat;
+	stats.indexType = source.indexType;
+	stats.vertexStride = GetVertexFormatStride(source.vertexFormat);
+	stats.indexSize = getIndexSize(source.indexType);
+	source.vertices.GetStats(stats.vertices);
+	source.indices.GetStats(stats.indices);
+	stats.grows = source.grows;
+}
+
+/*
+	Logs the usage and fragmentation of every pool.
+*/
+void GeometryPool::LogReport(void)
+{
+	for (unsigned int i = 0; i < pools.size(); ++i)
+	{
+		GeometryPoolStats stats;
+		GetStats(i, stats);
+
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_RENDER, "Geometry pool %u (%s, %s indices) : %u meshes, grown %u time(s).",
+			i, GetVertexFormatName(stats.vertexFormat), stats.indexType == GL_UNSIGNED_SHORT ? "16-bit" : "32-bit", stats.vertices.allocations, stats.grows);
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_RENDER, "  vertices : %.2f / %.2f MB used, %u free block(s), largest %u, fragmentation %.1f%%.",
+			stats.vertices.used * stats.vertexStride / (1024.0 * 1024.0), stats.vertices.capacity * stats.vertexStride / (1024.0 * 1024.0),
+			stats.vertices.freeBlocks, stats.vertices.largestFree, stats.vertices.fragmentation * 100.0f);
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_RENDER, "  indices  : %.2f / %.2f MB used, %u free block(s), largest %u, fragmentation %.1f%%.",
+			stats.indices.used * stats.indexSize / (1024.0 * 1024.0), stats.indices.capacity * stats.indexSize / (1024.0 * 1024.0),
+			stats.indices.freeBlocks, stats.indices.largestFree, stats.indices.fragmentation * 100.0f);
+	}
+}
+
+/*
+	Deletes every pool. Allocations still held become
+	invalid; freeing them afterwards does nothing. Call
+	while the context still exists.
+*/
+void GeometryPool::Shutdown(void)
+{
+	Unbind();
+	for (size_t i = 0; i < pools.size(); ++i)
+	{
+		glDeleteVertexArrays(1, &pools[i].VAO);
+		glDeleteBuffers(1, &pools[i].VBO);
+		glDeleteBuffers(1, &pools[i].EBO);
+	}
+	pools.clear();
+}
+
+/*
+	Index of the pool of a vertex format and index type,
+	created with room for at least the given counts if
+	there is none yet.
+*/
+unsigned int GeometryPool::findPool(VertexFormat vertexFormat, GLenum indexType, GLuint vertexCount, GLuint indexCount)
+{
+	for (unsigned int i = 0; i < pools.size(); ++i)
+	{
+		if (pools[i].vertexFormat == vertexFormat && pools[i].indexType == indexType)
+			return i;
+	}
+
+	Pool pool;
+	pool.vertexFormat = vertexFormat;
+	pool.indexType = indexType;
+	pool.vertices.Reset(std::max(GEOMETRY_POOL_INITIAL_VERTICES, vertexCount));
+	pool.indices.Reset(std::max(GEOMETRY_POOL_INITIAL_INDICES, indexCount));
+	pool.grows = 0;
+
+	glGenVertexArrays(1, &pool.VAO);
+	glGenBuffers(1, &pool.VBO);
+	glGenBuffers(1, &pool.EBO);
+
+	glBindVertexArray(pool.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+	glBufferData(GL_ARRAY_BUFFER, pool.vertices.GetCapacity() * GetVertexFormatStride(vertexFormat), NULL, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, pool.indices.GetCapacity() * getIndexSize(indexType), NULL, GL_STATIC_DRAW);
+	SetupVertexFormat(vertexFormat);
+	glBindVertexArray(0);
+	boundPool = GEOMETRY_POOL_NONE;
+
+	pools.push_back(pool);
+	LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_RENDER, "Geometry pool %u created for %s vertices.", (unsigned int)pools.size() - 1, GetVertexFormatName(vertexFormat));
+	return (unsigned int)pools.size() - 1;
+}
+
+/*
+	Replaces a buffer by a larger one holding the same
+	data at the start, copied on the GPU. The caller binds
+	the new buffer wherever the old one was used.
+
+	buffer	-	Buffer to replace, receives the new one.
+	oldSize	-	Size of its data in bytes.
+	newSize	-	Size of the new buffer in bytes.
+*/
+void GeometryPool::growBuffer(GLuint& buffer, size_t oldSize, size_t newSize)
+{
+	GLuint grown;
+	glGenBuffers(1, &grown);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+	glBufferData(GL_COPY_WRITE_BUFFER, newSize, NULL, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glDeleteBuffers(1, &buffer);
+	buffer = grown;
+}
+
+/*
+	Size of one index of a type in bytes.
+*/
+size_t GeometryPool::getIndexSize(GLenum indexType)
+{
+	return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
\ No newline at end of file
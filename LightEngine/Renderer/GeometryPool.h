@@ -0,0 +1,109 @@
+#pragma once
+
+// Includes.
+#include <vector>
+#include <algorithm>
+#include "..\Contrib\Include\gl\glew.h"
+#include "..\Util\BufferAllocator.h"
+#include "..\Util\Logger.h"
+#include "VertexLayout.h"
+
+// Vertices and indices a new pool has room for, it doubles when it runs out.
+const GLuint GEOMETRY_POOL_INITIAL_VERTICES = 65536;
+const GLuint GEOMETRY_POOL_INITIAL_INDICES = 196608;
+
+// Pool of an empty allocation.
+const unsigned int GEOMETRY_POOL_NONE = 0xFFFFFFFF;
+
+/*
+	Where a mesh lives in a pool. The indices are relative
+	to the mesh's first vertex, which is given to the draw
+	as its base vertex.
+
+	pool		-	Index of the pool, GEOMETRY_POOL_NONE if empty.
+	firstVertex	-	First vertex in the pool's vertex buffer.
+	vertexCount	-	Number of vertices.
+	firstIndex	-	First index in the pool's index buffer.
+	indexCount	-	Number of indices.
+*/
+struct GeometryAllocation
+{
+	unsigned int	pool;
+	GLuint			firstVertex;
+	GLuint			vertexCount;
+	GLuint			firstIndex;
+	GLuint			indexCount;
+};
+
+/*
+	Usage of one pool, see BufferAllocatorStats.
+
+	grows	-	Times one of its buffers had to be enlarged.
+*/
+struct GeometryPoolStats
+{
+	VertexFormat			vertexFormat;
+	GLenum					indexType;
+	size_t					vertexStride;
+	size_t					indexSize;
+	BufferAllocatorStats	vertices;
+	BufferAllocatorStats	indices;
+	unsigned int			grows;
+};
+
+/*
+	Shared vertex and index buffers the meshes are
+	sub-allocated from, one pool per vertex format and
+	index type. A pool has a single VAO, so consecutive
+	meshes of a pool are drawn without switching buffers
+	or attribute pointers, and with one
+	glMultiDrawElementsBaseVertex() if they share their
+	textures and vertex decode (see Mesh::DrawBatch()).
+
+	A pool that is full is doubled : its buffers are copied
+	into larger ones on the GPU with glCopyBufferSubData().
+	Freed ranges are reused by later allocations.
+*/
+class GeometryPool
+{
+public:
+
+// Functions
+
+	static void Allocate(const void* vertices, VertexFormat vertexFormat, GLuint vertexCount, const void* indices, GLenum indexType, GLuint indexCount,
+		GeometryAllocation& allocation);
+	static void Free(GeometryAllocation& allocation);
+	static void Bind(unsigned int pool);
+	static void Unbind(void);
+	static unsigned int GetPoolCount(void);
+	static void GetStats(unsigned int pool, GeometryPoolStats& stats);
+	static void LogReport(void);
+	static void Shutdown(void);
+
+private:
+
+	/*
+		GL objects and bookkeeping of one pool. The
+		allocators count in vertices and indices.
+	*/
+	struct Pool
+	{
+		VertexFormat	vertexFormat;
+		GLenum			indexType;
+		GLuint			VAO, VBO, EBO;
+		BufferAllocator	vertices;
+		BufferAllocator	indices;
+		unsigned int	grows;
+	};
+
+// Functions
+
+	static unsigned int findPool(VertexFormat vertexFormat, GLenum indexType, GLuint vertexCount, GLuint indexCount);
+	static void growBuffer(GLuint& buffer, size_t oldSize, size_t newSize);
+	static size_t getIndexSize(GLenum indexType);
+
+// Variables
+
+	static std::vector<Pool> pools;
+	static unsigned int boundPool;
+};
\ No newline at end of file
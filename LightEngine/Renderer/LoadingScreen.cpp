@@ -0,0 +1,179 @@
+#include "LoadingScreen.h"
+#include <algorithm>
+#include <cfloat>
+
+// Fullscreen quad, flipped vertically : the GIF's rows start at the top.
+GLfloat loadingQuadVertices[] = {
+	// Positions   // TexCoords
+	-1.0f, 1.0f, 0.0f, 0.0f,
+	-1.0f, -1.0f, 0.0f, 1.0f,
+	1.0f, -1.0f, 1.0f, 1.0f,
+
+	-1.0f, 1.0f, 0.0f, 0.0f,
+	1.0f, -1.0f, 1.0f, 1.0f,
+	1.0f, 1.0f, 1.0f, 0.0f
+};
+
+/*
+	Constructor, reads the image and sets up the quad it
+	is drawn on. Without the image, only the progress bar
+	is shown.
+
+	imagePath	-	Path to the .gif file.
+*/
+LoadingScreen::LoadingScreen(const char* imagePath)
+	: shader("Shaders/loading.vert", "Shaders/loading.frag")
+{
+	screenTexture = shader.GetUniform("screenTexture");
+	texture = 0;
+	nextFrameTime = 0.0;
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(loadingQuadVertices), &loadingQuadVertices, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
+	glBindVertexArray(0);
+
+	if (!FileSystem::ReadFile(imagePath, image) || !decoder.Open(image.GetData(), image.GetSize()))
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_RENDER, "Could not read loading screen %s.", imagePath);
+		return;
+	}
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, decoder.GetWidth(), decoder.GetHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_RENDER, "Loading screen %s : %u x %u.", imagePath, decoder.GetWidth(), decoder.GetHeight());
+}
+
+/*
+	Draws the current frame of the image and the progress
+	bar into the default framebuffer. The state it changes
+	(framebuffer, viewport, depth test, clear color,
+	program, VAO, texture) is put back.
+
+	width		-	Width of the window in pixels.
+	height		-	Height of the window in pixels.
+	progress	-	Share of the loading that is done, from 0 to 1.
+*/
+void LoadingScreen::Render(GLsizei width, GLsizei height, float progress)
+{
+	PROFILE_SCOPE("LoadingScreen::Render");
+
+	GLint framebuffer, viewport[4], program, vertexArray, boundTexture;
+	GLfloat clearColor[4];
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDisable(GL_DEPTH_TEST);
+	glViewport(0, 0, width, height);
+	clearRect(0, 0, width, height, LOADING_BACKGROUND_COLOR);
+
+	// Letterbox the image, keeping its aspect ratio.
+	GLint imageX = 0, imageY = 0;
+	GLsizei imageWidth = width, imageHeight = height;
+	if (texture != 0)
+	{
+		this->advance();
+
+		float scale = std::min((float)width / decoder.GetWidth(), (float)height / decoder.GetHeight());
+		imageWidth = (GLsizei)(decoder.GetWidth() * scale);
+		imageHeight = (GLsizei)(decoder.GetHeight() * scale);
+		imageX = (width - imageWidth) / 2;
+		imageY = (height - imageHeight) / 2;
+
+		glViewport(imageX, imageY, imageWidth, imageHeight);
+		shader.Use();
+		screenTexture.Set(0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glBindVertexArray(VAO);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
+		glViewport(0, 0, width, height);
+	}
+
+	// Progress bar, cleared through the scissor rectangle instead of drawn.
+	GLint barX = imageX + (GLint)(imageWidth * LOADING_BAR_LEFT);
+	GLint barY = imageY + (GLint)(imageHeight * (1.0f - LOADING_BAR_TOP)) - LOADING_BAR_HEIGHT;
+	GLsizei barWidth = (GLsizei)(imageWidth * (LOADING_BAR_RIGHT - LOADING_BAR_LEFT));
+	GLsizei fillWidth = (GLsizei)(barWidth * std::min(std::max(progress, 0.0f), 1.0f));
+
+	glEnable(GL_SCISSOR_TEST);
+	clearRect(barX, barY, barWidth, LOADING_BAR_HEIGHT, LOADING_BAR_COLOR);
+	if (fillWidth > 0)
+		clearRect(barX, barY, fillWidth, LOADING_BAR_HEIGHT, LOADING_BAR_FILL_COLOR);
+	glDisable(GL_SCISSOR_TEST);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glUseProgram(program);
+	glBindVertexArray(vertexArray);
+	glBindTexture(GL_TEXTURE_2D, boundTexture);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+	if (depthTest)
+		glEnable(GL_DEPTH_TEST);
+}
+
+/*
+	Destructor, deletes the quad and the texture.
+*/
+LoadingScreen::~LoadingScreen()
+{
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	if (texture != 0)
+		glDeleteTextures(1, &texture);
+}
+
+/*
+	Moves the animation on to the next frame once the
+	current one has been shown for its delay. Frames are
+	never skipped : after a stall the animation continues
+	where it stopped.
+*/
+void LoadingScreen::advance(void)
+{
+	double now = getTimeElapsed();
+	if (now < nextFrameTime)
+		return;
+
+	unsigned int delay;
+	if (!decoder.NextFrame(delay))
+	{
+		// Keep the last good frame.
+		nextFrameTime = DBL_MAX;
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, decoder.GetWidth(), decoder.GetHeight(), GL_RGBA, GL_UNSIGNED_BYTE, decoder.GetPixels());
+	nextFrameTime = now + delay / 1000.0;
+}
+
+/*
+	Clears a rectangle of the bound framebuffer to a color,
+	through the scissor test if it is enabled.
+*/
+void LoadingScreen::clearRect(GLint x, GLint y, GLsizei width, GLsizei height, const glm::vec3& color)
+{
+	glScissor(x, y, width, height);
+	glClearColor(color.r, color.g, color.b, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+}
\ No newline at end of file
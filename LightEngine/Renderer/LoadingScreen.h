@@ -0,0 +1,60 @@
+#pragma once
+
+// Includes.
+#include "..\Contrib\Include\gl\glew.h"
+#include "..\Util\Utility.h"
+#include "..\Util\Profiler.h"
+#include "..\Util\Shader.h"
+#include "..\Util\FileSystem.h"
+#include "..\Util\GifDecoder.h"
+
+// Progress bar, in fractions of the image : under the artwork's "NOW LOADING..." line, as wide as it.
+const float LOADING_BAR_LEFT = 0.1875f;
+const float LOADING_BAR_RIGHT = 0.9f;
+const float LOADING_BAR_TOP = 0.85f;
+
+// Height of the progress bar in pixels.
+const GLsizei LOADING_BAR_HEIGHT = 6;
+
+// Colors of the background, the empty bar and its filled part.
+const glm::vec3 LOADING_BACKGROUND_COLOR = glm::vec3(0.1f, 0.1f, 0.1f);
+const glm::vec3 LOADING_BAR_COLOR = glm::vec3(0.25f, 0.25f, 0.25f);
+const glm::vec3 LOADING_BAR_FILL_COLOR = glm::vec3(0.55f, 0.85f, 0.95f);
+
+/*
+	Screen presented while the scene loads : an animated
+	GIF (see GifDecoder), letterboxed into the window,
+	above a bar showing the progress.
+
+	Render() draws into the default framebuffer and puts
+	back the state it changes, so the loading code around
+	it isn't disturbed. Advancing the animation costs one
+	texture update per GIF frame.
+*/
+class LoadingScreen
+{
+public:
+
+// Functions
+
+	LoadingScreen(const char* imagePath);
+	void Render(GLsizei width, GLsizei height, float progress);
+	~LoadingScreen();
+
+private:
+
+// Functions
+
+	void advance(void);
+	static void clearRect(GLint x, GLint y, GLsizei width, GLsizei height, const glm::vec3& color);
+
+// Variables
+
+	Shader				shader;
+	UniformSampler		screenTexture;
+	GLuint				VAO, VBO;
+	GLuint				texture;
+	FileData			image;
+	GifDecoder			decoder;
+	double				nextFrameTime;
+};
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "Material.h"
+
+std::vector<MaterialLibrary::Material> MaterialLibrary::materials;
+
+/*
+	Binding table of a set of textures, shared with every
+	earlier mesh that had the same textures. Samplers are
+	named after the texture type and its number among the
+	textures of that type (texture_diffuse1,
+	texture_specular1, ...), textures go to consecutive
+	units.
+
+	textures	-	Textures of a mesh, in sampler order.
+*/
+MaterialId MaterialLibrary::Intern(const std::vector<Texture>& textures)
+{
+	if (textures.empty())
+		return MATERIAL_NONE;
+
+	GLuint diffuseNr = 1;
+	GLuint specularNr = 1;
+	GLuint reflectionNr = 1;
+
+	std::vector<MaterialBinding> bindings;
+	for (GLuint i = 0; i < textures.size(); i++)
+	{
+		// Retrieve texture number (the N in diffuse_textureN)
+		std::stringstream ss;
+		const std::string& name = textures[i].type;
+		if (name == "texture_diffuse")
+			ss << diffuseNr++;				// Transfer diffuseNr to stream
+		else if (name == "texture_specular")
+			ss << specularNr++;				// Transfer specularNr to stream
+		else if (name == "texture_reflection")
+			ss << reflectionNr++;			// Transfer reflectionNr to stream
+
+		MaterialBinding binding;
+		binding.samplerHash = Shader::HashName((name + ss.str()).c_str());
+		binding.unit = (GLint)i;
+		binding.target = GL_TEXTURE_2D;
+		binding.texture = textures[i].id;
+		bindings.push_back(binding);
+	}
+
+	// Models have few materials, a linear search is enough.
+	for (size_t m = 0; m < materials.size(); ++m)
+	{
+		const std::vector<MaterialBinding>& other = materials[m].bindings;
+		if (other.size() == bindings.size() && memcmp(&other[0], &bindings[0], bindings.size() * sizeof(MaterialBinding)) == 0)
+			return (MaterialId)m;
+	}
+
+	if (materials.size() >= MATERIAL_NONE)
+	{
+		LOG_ERROR(LOG_CATEGORY_RENDER, "Too many materials, the mesh is drawn without textures.");
+		return MATERIAL_NONE;
+	}
+
+	Material material;
+	material.bindings = bindings;
+	materials.push_back(material);
+	return (MaterialId)(materials.size() - 1);
+}
+
+/*
+	Binds the textures of a material and points the
+	shader's samplers at their units. The samplers are
+	only uploaded when their unit changed.
+
+	material	-	Material to apply, MATERIAL_NONE binds nothing.
+	shader		-	Shader program in use.
+*/
+void MaterialLibrary::Apply(MaterialId material, Shader& shader)
+{
+	if (material >= materials.size())
+		return;
+
+	Material& source = materials[material];
+	const ShaderTable& table = resolve(source, shader);
+	for (size_t i = 0; i < source.bindings.size(); ++i)
+	{
+		const MaterialBinding& binding = source.bindings[i];
+		UniformSampler sampler = table.samplers[i];
+		sampler.Set(binding.unit);
+
+		glActiveTexture(GL_TEXTURE0 + binding.unit);
+		glBindTexture(binding.target, binding.texture);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/*
+	Binding table of a material.
+
+	material	-	Material to query.
+	count		-	Receives the number of bindings.
+*/
+const MaterialBinding* MaterialLibrary::GetBindings(MaterialId material, unsigned int& count)
+{
+	if (material >= materials.size())
+	{
+		count = 0;
+		return NULL;
+	}
+
+	count = (unsigned int)materials[material].bindings.size();
+	return &materials[material].bindings[0];
+}
+
+/*
+	Number of distinct materials interned.
+*/
+unsigned int MaterialLibrary::GetMaterialCount(void)
+{
+	return (unsigned int)materials.size();
+}
+
+/*
+	Forgets every material. The textures belong to the
+	TextureCache.
+*/
+void MaterialLibrary::Shutdown(void)
+{
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_RENDER, "Material library : %u material(s).", (unsigned int)materials.size());
+	materials.clear();
+}
+
+/*
+	Sampler handles of a shader for a material, looked up
+	by name hash the first time the pair is used. Shaders
+	live until the end of the run, so the handles stay
+	valid; the program is compared as well in case one is
+	rebuilt in place.
+
+	material	-	Material being applied.
+	shader		-	Shader it is applied with.
+*/
+const MaterialLibrary::ShaderTable& MaterialLibrary::resolve(Material& material, Shader& shader)
+{
+	for (size_t i = 0; i < material.tables.size(); ++i)
+	{
+		if (material.tables[i].shader == &shader && material.tables[i].program == shader.program)
+			return material.tables[i];
+	}
+
+	ShaderTable table;
+	table.shader = &shader;
+	table.program = shader.program;
+	for (size_t i = 0; i < material.bindings.size(); ++i)
+		table.samplers.push_back(UniformSampler(shader.GetUniform(material.bindings[i].samplerHash)));
+
+	material.tables.push_back(table);
+	return material.tables.back();
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+// Includes.
+#include <string>
+#include <vector>
+#include "..\Contrib\Include\gl\glew.h"
+#include "..\Contrib\Include\assimp\Importer.hpp"
+#include "..\Util\Shader.h"
+
+// Small handle to an interned material.
+typedef unsigned short MaterialId;
+
+// Material of meshes without textures.
+const MaterialId MATERIAL_NONE = 0xFFFF;
+
+/*
+	Structure to hold current texture state.
+	id		- current texture id for the mapped texture.
+	type	- type of the texture : diffuse, reflection or specular.
+	path	- to determine if the texture has already been loaded.
+*/
+struct Texture {
+	GLuint id;
+	std::string type;
+	aiString path;
+};
+
+/*
+	One texture of a material, resolved at load time.
+
+	samplerHash	-	Shader::HashName() of the sampler it is bound
+					to, e.g. "texture_diffuse1".
+	unit		-	Texture unit it is bound to.
+	target		-	GL_TEXTURE_2D.
+	texture		-	Texture object.
+*/
+struct MaterialBinding
+{
+	unsigned int	samplerHash;
+	GLint			unit;
+	GLenum			target;
+	GLuint			texture;
+};
+
+/*
+	Interned materials : the textures of a mesh and the
+	sampler each is bound to, turned into a flat binding
+	table once when the mesh is loaded. Meshes with the
+	same textures share one material, and refer to it by a
+	MaterialId.
+
+	A material resolves the sampler handles of a shader
+	the first time it is applied with it; afterwards
+	Apply() only walks the table, so drawing doesn't build
+	or hash any names. The shaders take no other
+	per-material parameters.
+*/
+class MaterialLibrary
+{
+public:
+
+// Functions
+
+	static MaterialId Intern(const std::vector<Texture>& textures);
+	static void Apply(MaterialId material, Shader& shader);
+	static const MaterialBinding* GetBindings(MaterialId material, unsigned int& count);
+	static unsigned int GetMaterialCount(void);
+	static void Shutdown(void);
+
+private:
+
+	/*
+		Sampler handles of one shader, one per binding.
+	*/
+	struct ShaderTable
+	{
+		const Shader*				shader;
+		GLuint						program;
+		std::vector<UniformSampler>	samplers;
+	};
+
+	/*
+		Binding table and the shaders it was resolved for.
+	*/
+	struct Material
+	{
+		std::vector<MaterialBinding>	bindings;
+		std::vector<ShaderTable>		tables;
+	};
+
+// Functions
+
+	static const ShaderTable& resolve(Material& material, Shader& shader);
+
+// Variables
+
+	static std::vector<Material> materials;
+};
\ No newline at end of file
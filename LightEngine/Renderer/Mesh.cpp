@@ -1,5 +1,27 @@
 #include "Mesh.h"
 
+namespace
+{
+	// Uniforms of the vertex decode, see VertexDecode.
+	const unsigned int POSITION_SCALE_HASH = Shader::HashName("positionScale");
+	const unsigned int POSITION_OFFSET_HASH = Shader::HashName("positionOffset");
+	const unsigned int TEXCOORD_DECODE_HASH = Shader::HashName("texCoordDecode");
+	const unsigned int OCTAHEDRAL_NORMALS_HASH = Shader::HashName("octahedralNormals");
+
+	/*
+		Whether two vertex decodes set the same uniforms.
+	*/
+	bool SameDecode(const VertexDecode& a, const VertexDecode& b)
+	{
+		return a.positionScale == b.positionScale && a.positionOffset == b.positionOffset &&
+			a.texCoordScale == b.texCoordScale && a.texCoordOffset == b.texCoordOffset && a.octahedral == b.octahedral;
+	}
+}
+
+vector<GLsizei>			Mesh::batchCounts;
+vector<const GLvoid*>	Mesh::batchOffsets;
+vector<GLint>			Mesh::batchBaseVertices;
+
 /*
 	Constructor that takes indexed vertex data and all the associated textures.
 
@@ -13,92 +35,346 @@ Mesh::Mesh(vector<Vertex> vertices, vector<GLuint> indices, vector<Texture> text
 	this->indices = indices;
 	this->textures = textures;
 
+	ComputeBounds(this->vertices.empty() ? NULL : &this->vertices[0], (GLuint)this->vertices.size(), this->boundsMin, this->boundsMax);
+
+	MeshLod lod = { 0, (GLuint)this->indices.size(), 0.0f };
+	this->lods.push_back(lod);
+	ClusterCuller::BuildBounds(this->meshlets, this->clusterBounds);
+
 	// Now that we have all the required data, set the vertex buffers and its attribute pointers.
-	this->setupMesh();
+	const Vertex* vertexData = this->vertices.empty() ? NULL : &this->vertices[0];
+	if (GetIndexType((GLuint)this->vertices.size()) == GL_UNSIGNED_SHORT)
+	{
+		vector<GLushort> shortIndices(this->indices.begin(), this->indices.end());
+		this->setupMesh(vertexData, VERTEX_FORMAT_FLOAT, (GLuint)this->vertices.size(), shortIndices.empty() ? NULL : &shortIndices[0], GL_UNSIGNED_SHORT, (GLuint)shortIndices.size());
+	}
+	else
+	{
+		this->setupMesh(vertexData, VERTEX_FORMAT_FLOAT, (GLuint)this->vertices.size(), this->indices.empty() ? NULL : &this->indices[0], GL_UNSIGNED_INT, (GLuint)this->indices.size());
+	}
+	this->material = MaterialLibrary::Intern(this->textures);
 }
 
 /*
-	Renders the mesh using Indexed Drawing.
-	First loads and maps all the textures :
-	diffuse, specular and reflection.
-	Then, it binds the VAO containing the
-	vertex data and uses glDrawElements().
+	Constructor that uploads indexed vertex data straight
+	from memory owned by the caller, without copying it.
+	The data is only read during the call.
 
-	shader	-	Shader program that we use to render the mesh.
+	vertices		-	First vertex.
+	vertexFormat	-	Format of the vertices.
+	vertexCount		-	Number of vertices.
+	indices			-	First index.
+	indexType		-	GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+	indexCount		-	Number of indices.
+	textures		-	Collection of the Texture structure variables.
+	decode			-	How the shaders decode the vertices.
+	boundsMin		-	Minimum corner of the bounding box.
+	boundsMax		-	Maximum corner of the bounding box.
+	lods			-	Index ranges of the levels of detail,
+						empty if all indices are the only one.
+	meshlets		-	Clusters of LOD 0, may be empty.
+*/
+Mesh::Mesh(const void* vertices, VertexFormat vertexFormat, GLuint vertexCount, const void* indices, GLenum indexType, GLuint indexCount, vector<Texture> textures,
+	const VertexDecode& decode, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const vector<MeshLod>& lods, const vector<Meshlet>& meshlets)
+{
+	this->textures = textures;
+	this->decode = decode;
+	this->boundsMin = boundsMin;
+	this->boundsMax = boundsMax;
+	this->lods = lods;
+	this->meshlets = meshlets;
+
+	if (this->lods.empty())
+	{
+		MeshLod lod = { 0, indexCount, 0.0f };
+		this->lods.push_back(lod);
+	}
+	ClusterCuller::BuildBounds(this->meshlets, this->clusterBounds);
+
+	this->setupMesh(vertices, vertexFormat, vertexCount, indices, indexType, indexCount);
+	this->material = MaterialLibrary::Intern(this->textures);
+}
+
+/*
+	Selects the level of detail a pass draws.
+
+	pass	-	Pass that draws with it.
+	lod		-	Index into lods, clamped to the coarsest.
+*/
+void Mesh::SetLod(LodPass pass, unsigned int lod)
+{
+	this->selectedLods[pass] = std::min(lod, (unsigned int)this->lods.size() - 1);
+}
+
+/*
+	Level of detail a pass draws.
+
+	pass	-	Pass to query.
+*/
+unsigned int Mesh::GetLod(LodPass pass) const
+{
+	return this->selectedLods[pass];
+}
+
+/*
+	Culls the meshlets against the camera, for the next
+	Draw() of the main pass. Does nothing unless the main
+	pass draws LOD 0, which the meshlets belong to.
+
+	modelViewProjection	-	Matrix the mesh is drawn with.
+	viewer				-	Camera position in object space.
+	stats				-	Receives the clusters tested and culled.
+*/
+void Mesh::CullClusters(const glm::mat4& modelViewProjection, const glm::vec3& viewer, ClusterCullStats& stats)
+{
+	stats.clusters = stats.clustersCulled = stats.trianglesCulled = 0;
+	this->clustersCulled = false;
+	if (this->meshlets.empty() || this->selectedLods[LOD_PASS_MAIN] != 0)
+		return;
+
+	this->clusterVisible.resize(this->clusterBounds.radius.size());
+	unsigned int visibleCount = ClusterCuller::Cull(this->clusterBounds, modelViewProjection, viewer, &this->clusterVisible[0]);
+
+	// Neighbouring visible meshlets are drawn as one range.
+	size_t indexSize = (this->indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+	GLuint rangeEnd = 0xFFFFFFFF;
+	this->clusterCounts.clear();
+	this->clusterOffsets.clear();
+	for (size_t i = 0; i < this->meshlets.size(); ++i)
+	{
+		const Meshlet& meshlet = this->meshlets[i];
+		if (!this->clusterVisible[i])
+		{
+			stats.trianglesCulled += meshlet.indexCount / 3;
+			continue;
+		}
+
+		if (meshlet.firstIndex == rangeEnd)
+		{
+			this->clusterCounts.back() += meshlet.indexCount;
+		}
+		else
+		{
+			this->clusterCounts.push_back(meshlet.indexCount);
+			this->clusterOffsets.push_back((const GLvoid*)((this->allocation.firstIndex + meshlet.firstIndex) * indexSize));
+		}
+		rangeEnd = meshlet.firstIndex + meshlet.indexCount;
+	}
+
+	stats.clusters = (unsigned int)this->meshlets.size();
+	stats.clustersCulled = stats.clusters - visibleCount;
+	this->clustersCulled = true;
+}
+
+/*
+	Smallest index type that can address every vertex.
+
+	vertexCount	-	Number of vertices of the mesh.
+*/
+GLenum Mesh::GetIndexType(GLuint vertexCount)
+{
+	return vertexCount <= MESH_MAX_SHORT_INDEX_VERTICES ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+/*
+	Axis-aligned bounding box of the given vertices,
+	zero-sized at the origin if there are none.
+
+	vertices	-	First vertex.
+	vertexCount	-	Number of vertices.
+	boundsMin	-	Receives the minimum corner.
+	boundsMax	-	Receives the maximum corner.
 */
-void Mesh::Draw(Shader shader)
+void Mesh::ComputeBounds(const Vertex* vertices, GLuint vertexCount, glm::vec3& boundsMin, glm::vec3& boundsMax)
 {
-	// Bind appropriate textures
-	GLuint diffuseNr = 1;
-	GLuint specularNr = 1;
-	GLuint reflectionNr = 1;
+	if (vertexCount == 0)
+	{
+		boundsMin = boundsMax = glm::vec3(0.0f);
+		return;
+	}
 
-	for (GLuint i = 0; i < this->textures.size(); i++)
+	boundsMin = boundsMax = vertices[0].Position;
+	for (GLuint i = 1; i < vertexCount; i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i); // Active proper texture unit before binding
-		// Retrieve texture number (the N in diffuse_textureN)
-		stringstream ss;
-		string number;
-		string name = this->textures[i].type;
-		if (name == "texture_diffuse")
-			ss << diffuseNr++;				// Transfer diffuseNr to stream
-		else if (name == "texture_specular")
-			ss << specularNr++;				// Transfer specularNr to stream
-		else if (name == "texture_reflection")
-			ss << reflectionNr++;			// Transfer reflectionNr to stream
-		number = ss.str();
-		// Now set the sampler to the correct texture unit
-		glUniform1i(glGetUniformLocation(shader.program, (name + number).c_str()), i);
-
-		// And finally bind the texture
-		glBindTexture(GL_TEXTURE_2D, this->textures[i].id);
+		boundsMin = glm::min(boundsMin, vertices[i].Position);
+		boundsMax = glm::max(boundsMax, vertices[i].Position);
 	}
-	glActiveTexture(GL_TEXTURE0);
+}
+
+/*
+	Renders the mesh using Indexed Drawing, see
+	DrawBatch(), and unbinds its pool afterwards.
+
+	shader	-	Shader program that we use to render the mesh.
+	pass	-	Pass whose selected LOD is drawn.
+*/
+void Mesh::Draw(Shader& shader, LodPass pass)
+{
+	DrawBatch(shader, pass, this, 1);
+	GeometryPool::Unbind();
+}
+
+/*
+	Renders meshes that CanBatchWith() the first one.
+	First applies the material of the first mesh, which
+	binds its textures : diffuse, specular and reflection.
+	Then, it sets the
+	vertex decode, binds the VAO of the pool and draws
+	with glMultiDrawElementsBaseVertex() the index range
+	of every mesh's level of detail for the pass, or its
+	visible meshlets if they were culled since the last
+	draw of the main pass. The decode stays set, see
+	ResetVertexDecode(), and the pool stays bound until
+	GeometryPool::Unbind().
+
+	shader	-	Shader program that we use to render the meshes.
+	pass	-	Pass whose selected LODs are drawn.
+	meshes	-	First mesh.
+	count	-	Number of meshes, at least 1.
+*/
+void Mesh::DrawBatch(Shader& shader, LodPass pass, Mesh* meshes, size_t count)
+{
+	// The shadow passes only write depth.
+	if (pass != LOD_PASS_SHADOW)
+		MaterialLibrary::Apply(meshes[0].material, shader);
+
+	setVertexDecode(shader, meshes[0].decode);
+
+	batchCounts.clear();
+	batchOffsets.clear();
+	batchBaseVertices.clear();
+
+	GLuint triangles = 0;
+	for (size_t i = 0; i < count; ++i)
+		triangles += meshes[i].appendDraws(pass);
+
+	if (batchCounts.empty())
+		return;
+
+	// Draw meshes
+	GeometryPool::Bind(meshes[0].allocation.pool);
+	if (batchCounts.size() == 1)
+		glDrawElementsBaseVertex(GL_TRIANGLES, batchCounts[0], meshes[0].indexType, batchOffsets[0], batchBaseVertices[0]);
+	else
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, &batchCounts[0], meshes[0].indexType, &batchOffsets[0], (GLsizei)batchCounts.size(), &batchBaseVertices[0]);
+	Telemetry::CountDraw(triangles);
+}
+
+/*
+	Whether DrawBatch() can draw another mesh right after
+	this one in the same draw : they have to be in the
+	same pool and decode their vertices the same way, and
+	except in the shadow passes have the same material.
 
-	// Draw mesh
-	glBindVertexArray(this->VAO);
-	glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	other	-	Mesh that would be drawn after this one.
+	pass	-	Pass they are drawn in.
+*/
+bool Mesh::CanBatchWith(const Mesh& other, LodPass pass) const
+{
+	if (this->allocation.pool != other.allocation.pool || !SameDecode(this->decode, other.decode))
+		return false;
+
+	return pass == LOD_PASS_SHADOW || this->material == other.material;
 }
 
 /*
-	Loads all the relevant vertex data into
-	the buffers. Populates up the Vertex Array,
-	Vertex Buffer and the Element Buffer for
-	Indexed Drawing.
+	Gives the mesh's vertices and indices back to the
+	geometry pool. The mesh draws nothing afterwards.
 */
-void Mesh::setupMesh(void)
+void Mesh::Release(void)
 {
-	// Create buffers/arrays
-	glGenVertexArrays(1, &this->VAO);
-	glGenBuffers(1, &this->VBO);
-	glGenBuffers(1, &this->EBO);
+	GeometryPool::Free(this->allocation);
+	this->clustersCulled = false;
+}
 
-	glBindVertexArray(this->VAO);
+/*
+	Adds the draws of the mesh to the batch : the visible
+	meshlets after CullClusters() in the main pass, else
+	the range of the pass' LOD. Returns their triangles.
 
-	// Load data into vertex buffers
-	glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+	pass	-	Pass whose selected LOD is drawn.
+*/
+GLuint Mesh::appendDraws(LodPass pass)
+{
+	if (this->allocation.pool == GEOMETRY_POOL_NONE)
+	{
+		this->clustersCulled = false;
+		return 0;
+	}
+
+	GLuint indexCount = 0;
+	if (pass == LOD_PASS_MAIN && this->clustersCulled)
+	{
+		for (size_t i = 0; i < this->clusterCounts.size(); ++i)
+		{
+			batchCounts.push_back(this->clusterCounts[i]);
+			batchOffsets.push_back(this->clusterOffsets[i]);
+			batchBaseVertices.push_back((GLint)this->allocation.firstVertex);
+			indexCount += this->clusterCounts[i];
+		}
+		this->clustersCulled = false;
+	}
+	else
+	{
+		const MeshLod& lod = this->lods[this->selectedLods[pass]];
+		size_t indexSize = (this->indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+		batchCounts.push_back(lod.indexCount);
+		batchOffsets.push_back((const GLvoid*)((this->allocation.firstIndex + lod.firstIndex) * indexSize));
+		batchBaseVertices.push_back((GLint)this->allocation.firstVertex);
+		indexCount = lod.indexCount;
+	}
+	return indexCount / 3;
+}
 
-	glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(Vertex), &this->vertices[0], GL_STATIC_DRAW);
+/*
+	Sets the vertex decode back to the identity, for
+	geometry in VERTEX_FORMAT_FLOAT drawn with the same
+	shader after the meshes.
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(GLuint), &this->indices[0], GL_STATIC_DRAW);
+	shader	-	Shader program the meshes were drawn with.
+*/
+void Mesh::ResetVertexDecode(Shader& shader)
+{
+	setVertexDecode(shader, VertexDecode());
+}
 
-	// Set the vertex attribute pointers
+/*
+	Sets the uniforms of a vertex decode. Shaders that
+	don't use some of them (e.g. depth-only ones) ignore them.
 
-	// Vertex Positions
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)0);
+	shader	-	Shader program in use.
+	decode	-	Decode of the vertices drawn next.
+*/
+void Mesh::setVertexDecode(Shader& shader, const VertexDecode& decode)
+{
+	UniformVec3(shader.GetUniform(POSITION_SCALE_HASH)).Set(decode.positionScale);
+	UniformVec3(shader.GetUniform(POSITION_OFFSET_HASH)).Set(decode.positionOffset);
+	UniformVec4(shader.GetUniform(TEXCOORD_DECODE_HASH)).Set(glm::vec4(decode.texCoordScale, decode.texCoordOffset));
+	UniformInt(shader.GetUniform(OCTAHEDRAL_NORMALS_HASH)).Set(decode.octahedral ? 1 : 0);
+}
 
-	// Vertex Normals
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, Normal));
+/*
+	Loads all the relevant vertex data into the
+	GeometryPool of its vertex format and index type,
+	whose VAO has the attribute pointers of the format.
 
-	// Vertex Texture Coords
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)offsetof(Vertex, TexCoords));
+	vertices		-	First vertex.
+	vertexFormat	-	Format of the vertices.
+	vertexCount		-	Number of vertices.
+	indices			-	First index.
+	indexType		-	GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+	indexCount		-	Number of indices.
+*/
+void Mesh::setupMesh(const void* vertices, VertexFormat vertexFormat, GLuint vertexCount, const void* indices, GLenum indexType, GLuint indexCount)
+{
+	this->indexCount = indexCount;
+	this->indexType = indexType;
+	this->vertexFormat = vertexFormat;
+	for (unsigned int pass = 0; pass < LOD_PASS_COUNT; ++pass)
+		this->selectedLods[pass] = 0;
+	this->clustersCulled = false;
 
-	glBindVertexArray(0);
+	GeometryPool::Allocate(vertices, vertexFormat, vertexCount, indices, indexType, indexCount, this->allocation);
 
-	log("Mesh Generated.");
+	LOG_DEBUG(LOG_CATEGORY_ASSET, "Mesh Generated.");
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 using namespace std;
 
 // GL and GLM Includes
@@ -14,30 +15,44 @@ using namespace std;
 #include "..\Contrib\Include\glm\gtc\matrix_transform.hpp"
 #include "..\Contrib\Include\assimp\Importer.hpp"
 #include "..\Util\Shader.h"
+#include "..\Util\Telemetry.h"
+#include "VertexLayout.h"
+#include "ClusterCuller.h"
+#include "GeometryPool.h"
+#include "Material.h"
+
+// Most vertices a mesh can have to be drawn with 16-bit indices.
+const GLuint MESH_MAX_SHORT_INDEX_VERTICES = 65536;
+
+// Most levels of detail a mesh can have, including the full one.
+const unsigned int MESH_MAX_LODS = 4;
 
 /*
-	Structure to hold vertex data
-	for all the vertices in the mesh.
+	One level of detail : a range of the mesh's index
+	buffer that draws the mesh with fewer triangles,
+	using the same vertices. LOD 0 is the full mesh.
+
+	firstIndex	-	First index of the range.
+	indexCount	-	Number of indices in the range.
+	error		-	Largest distance from the full mesh, in
+					object units (see MeshSimplifier).
 */
-struct Vertex {
-	// Position
-	glm::vec3 Position;
-	// Normal
-	glm::vec3 Normal;
-	// TexCoords
-	glm::vec2 TexCoords;
+struct MeshLod
+{
+	GLuint	firstIndex;
+	GLuint	indexCount;
+	float	error;
 };
 
 /*
-	Structure to hold current texture state.
-	id		- current texture id for the mapped texture.
-	type	- type of the texture : diffuse, reflection or specular.
-	path	- to determine if the texture has already been loaded.
+	Passes that select their LOD independently, so the
+	shadow maps can be drawn coarser than the camera view.
 */
-struct Texture {
-	GLuint id;
-	string type;
-	aiString path;
+enum LodPass
+{
+	LOD_PASS_MAIN,
+	LOD_PASS_SHADOW,
+	LOD_PASS_COUNT
 };
 
 /*
@@ -45,6 +60,31 @@ struct Texture {
 	vertices, indices and textures. Each mesh
 	of the entire model is rendered one by one
 	using the Mesh class' Draw Function.
+
+	Meshes created from raw pointers (e.g. a mapped
+	MeshCache file) upload straight from that memory and
+	keep no CPU-side copy : vertices and indices are empty.
+	Their vertices can be in any VertexFormat; Draw() sets
+	the VertexDecode uniforms the shaders need for it.
+
+	The textures are interned into a material when the
+	mesh is created; Draw() applies its binding table.
+
+	Meshes with at most MESH_MAX_SHORT_INDEX_VERTICES
+	vertices are drawn with 16-bit indices.
+
+	The index buffer holds every MeshLod one after the
+	other; Draw() draws the range selected for the pass.
+	LOD 0 is split into meshlets : after CullClusters(),
+	the next Draw() of the main pass only draws the
+	visible ones, with a single multi-draw.
+
+	The vertices and indices are sub-allocated from the
+	GeometryPool of their format. DrawBatch() draws
+	several meshes of a pool with one
+	glMultiDrawElementsBaseVertex() when CanBatchWith()
+	allows it. Release() gives the ranges back; copies of
+	a mesh share them, so only one of them releases.
 */
 class Mesh {
 public:
@@ -55,19 +95,62 @@ public:
 	vector<GLuint> indices;
 	vector<Texture> textures;
 
+	// Object-space bounding box.
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+
+	// Levels of detail, from the full mesh to the coarsest.
+	vector<MeshLod> lods;
+
+	// Clusters of LOD 0.
+	vector<Meshlet> meshlets;
+
 // Functions
 
 	Mesh(vector<Vertex> vertices, vector<GLuint> indices, vector<Texture> textures);
-	void Draw(Shader shader);
+	Mesh(const void* vertices, VertexFormat vertexFormat, GLuint vertexCount, const void* indices, GLenum indexType, GLuint indexCount, vector<Texture> textures,
+		const VertexDecode& decode, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const vector<MeshLod>& lods, const vector<Meshlet>& meshlets);
+	void Draw(Shader& shader, LodPass pass = LOD_PASS_MAIN);
+	static void DrawBatch(Shader& shader, LodPass pass, Mesh* meshes, size_t count);
+	bool CanBatchWith(const Mesh& other, LodPass pass) const;
+	void Release(void);
+	void SetLod(LodPass pass, unsigned int lod);
+	unsigned int GetLod(LodPass pass) const;
+	void CullClusters(const glm::mat4& modelViewProjection, const glm::vec3& viewer, ClusterCullStats& stats);
+	static void ResetVertexDecode(Shader& shader);
+	static void ComputeBounds(const Vertex* vertices, GLuint vertexCount, glm::vec3& boundsMin, glm::vec3& boundsMax);
+	static GLenum GetIndexType(GLuint vertexCount);
 
 private:
 
 // Variables
 
-	// Buffers containing the vertex data.
-	GLuint VAO, VBO, EBO;
+	// Ranges of the pool buffers containing the vertex data.
+	GeometryAllocation allocation;
+	GLuint indexCount;
+	GLenum indexType;
+	VertexFormat vertexFormat;
+	VertexDecode decode;
+	unsigned int selectedLods[LOD_PASS_COUNT];
+
+	// Visible meshlets of the last CullClusters(), merged into index ranges.
+	ClusterBounds clusterBounds;
+	vector<unsigned char> clusterVisible;
+	vector<GLsizei> clusterCounts;
+	vector<const GLvoid*> clusterOffsets;
+	bool clustersCulled;
+
+	// Interned textures and samplers.
+	MaterialId material;
+
+	// Draws of the batch being submitted by DrawBatch().
+	static vector<GLsizei> batchCounts;
+	static vector<const GLvoid*> batchOffsets;
+	static vector<GLint> batchBaseVertices;
 
 // Functions
 
-	void setupMesh();
+	void setupMesh(const void* vertices, VertexFormat vertexFormat, GLuint vertexCount, const void* indices, GLenum indexType, GLuint indexCount);
+	GLuint appendDraws(LodPass pass);
+	static void setVertexDecode(Shader& shader, const VertexDecode& decode);
 };
\ No newline at end of file
@@ -0,0 +1,439 @@
+#include "MeshCache.h"
+
+namespace
+{
+	/*
+		Rounds an offset up to the blob alignment.
+	*/
+	unsigned long long AlignUp(unsigned long long offset)
+	{
+		return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(unsigned long long)(MESH_CACHE_ALIGNMENT - 1);
+	}
+
+	/*
+		Writes zeros until the file position reaches offset.
+	*/
+	bool PadTo(FILE* file, unsigned long long& position, unsigned long long offset)
+	{
+		static const char zeros[MESH_CACHE_ALIGNMENT] = { 0 };
+
+		while (position < offset)
+		{
+			size_t count = (size_t)(offset - position < MESH_CACHE_ALIGNMENT ? offset - position : MESH_CACHE_ALIGNMENT);
+			if (fwrite(zeros, 1, count, file) != count)
+				return false;
+			position += count;
+		}
+		return true;
+	}
+
+	/*
+		Writes a block and advances the file position.
+	*/
+	bool WriteBlock(FILE* file, unsigned long long& position, const void* data, size_t size)
+	{
+		if (size > 0 && fwrite(data, 1, size, file) != size)
+			return false;
+		position += size;
+		return true;
+	}
+}
+
+/*
+	Default constructor, no file is open.
+*/
+MeshCache::MeshCache()
+{
+	header = NULL;
+	meshes = NULL;
+	textures = NULL;
+}
+
+/*
+	Maps a cache file and checks that it can be used.
+	Returns false if it is missing, was written by another
+	version or is damaged.
+
+	path	-	Path to the cache file.
+*/
+bool MeshCache::Open(const char* path)
+{
+	Close();
+
+	if (!file.Open(path))
+		return false;
+
+	header = (const MeshCacheHeader*)file.GetData();
+	meshes = (const MeshCacheMesh*)(file.GetData() + sizeof(MeshCacheHeader));
+
+	if (!Validate())
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Mesh cache %s is outdated or damaged, ignoring it.", path);
+		Close();
+		return false;
+	}
+
+	textures = (const MeshCacheTexture*)(meshes + header->meshCount);
+	return true;
+}
+
+/*
+	Unmaps the file. Vertex and index pointers are invalid
+	afterwards.
+*/
+void MeshCache::Close(void)
+{
+	file.Close();
+	header = NULL;
+	meshes = NULL;
+	textures = NULL;
+}
+
+/*
+	Number of meshes in the file.
+*/
+unsigned int MeshCache::GetMeshCount(void) const
+{
+	return header != NULL ? header->meshCount : 0;
+}
+
+/*
+	Entry of the mesh table.
+
+	index	-	Less than GetMeshCount().
+*/
+const MeshCacheMesh& MeshCache::GetMesh(unsigned int index) const
+{
+	return meshes[index];
+}
+
+/*
+	Vertices of a mesh, pointing into the mapped file.
+	Their format is given by GetVertexFormat().
+*/
+const void* MeshCache::GetVertices(const MeshCacheMesh& mesh) const
+{
+	return file.GetData() + mesh.vertexOffset;
+}
+
+/*
+	Format of a mesh's vertices.
+*/
+VertexFormat MeshCache::GetVertexFormat(const MeshCacheMesh& mesh)
+{
+	return (VertexFormat)mesh.vertexFormat;
+}
+
+/*
+	How the shaders decode a mesh's vertices.
+*/
+VertexDecode MeshCache::GetVertexDecode(const MeshCacheMesh& mesh)
+{
+	VertexDecode decode;
+	decode.positionScale = glm::vec3(mesh.positionScale[0], mesh.positionScale[1], mesh.positionScale[2]);
+	decode.positionOffset = glm::vec3(mesh.positionOffset[0], mesh.positionOffset[1], mesh.positionOffset[2]);
+	decode.texCoordScale = glm::vec2(mesh.texCoordScale[0], mesh.texCoordScale[1]);
+	decode.texCoordOffset = glm::vec2(mesh.texCoordOffset[0], mesh.texCoordOffset[1]);
+	decode.octahedral = mesh.vertexFormat != VERTEX_FORMAT_FLOAT;
+	return decode;
+}
+
+/*
+	Indices of a mesh, pointing into the mapped file.
+	Their type is given by GetIndexType().
+*/
+const void* MeshCache::GetIndices(const MeshCacheMesh& mesh) const
+{
+	return file.GetData() + mesh.indexOffset;
+}
+
+/*
+	Index ranges of a mesh's levels of detail.
+*/
+vector<MeshLod> MeshCache::GetLods(const MeshCacheMesh& mesh)
+{
+	return vector<MeshLod>(mesh.lods, mesh.lods + mesh.lodCount);
+}
+
+/*
+	Meshlets of a mesh, pointing into the mapped file.
+	There are meshletCount of them.
+*/
+const Meshlet* MeshCache::GetMeshlets(const MeshCacheMesh& mesh) const
+{
+	return (const Meshlet*)(file.GetData() + mesh.meshletOffset);
+}
+
+/*
+	GL type of a mesh's indices.
+*/
+GLenum MeshCache::GetIndexType(const MeshCacheMesh& mesh)
+{
+	return mesh.indexSize == sizeof(GLushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+/*
+	Entry of the texture table.
+
+	index	-	Between a mesh's firstTexture and
+				firstTexture + textureCount.
+*/
+const MeshCacheTexture& MeshCache::GetTexture(unsigned int index) const
+{
+	return textures[index];
+}
+
+/*
+	Size of the open file in bytes.
+*/
+size_t MeshCache::GetFileSize(void) const
+{
+	return file.GetSize();
+}
+
+/*
+	Writes imported meshes to a cache file. A file that
+	can't be written completely is deleted again.
+
+	path	-	Path to the cache file, replaced if it exists.
+	meshes	-	Meshes as returned by Model::Import(), with
+				their packed vertices.
+*/
+bool MeshCache::Write(const char* path, const vector<MeshSource>& meshes)
+{
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.vertexSize = sizeof(Vertex);
+	header.meshCount = (unsigned int)meshes.size();
+	header.errorBounds = VertexQuantizer::GetErrorBounds();
+
+	vector<MeshCacheMesh> meshTable(meshes.size());
+	vector<MeshCacheTexture> textureTable;
+
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		MeshCacheMesh& entry = meshTable[i];
+		memset(&entry, 0, sizeof(entry));
+		entry.vertexCount = (unsigned int)meshes[i].vertices.size();
+		entry.indexCount = (unsigned int)meshes[i].indices.size();
+		entry.firstTexture = (unsigned int)textureTable.size();
+		entry.textureCount = (unsigned int)meshes[i].textures.size();
+		entry.indexSize = (Mesh::GetIndexType(entry.vertexCount) == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+		entry.vertexFormat = meshes[i].vertexFormat;
+
+		if (meshes[i].packedVertices.size() != entry.vertexCount * GetVertexFormatStride(meshes[i].vertexFormat))
+		{
+			LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Mesh %u has no packed vertices, not writing mesh cache %s", (unsigned int)i, path);
+			return false;
+		}
+
+		const vector<MeshLod>& lods = meshes[i].lods;
+		if (lods.size() > MESH_MAX_LODS)
+		{
+			LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Mesh %u has too many LODs, not writing mesh cache %s", (unsigned int)i, path);
+			return false;
+		}
+
+		entry.lodCount = lods.empty() ? 1 : (unsigned int)lods.size();
+		if (lods.empty())
+			entry.lods[0].indexCount = entry.indexCount;
+		for (size_t l = 0; l < lods.size(); ++l)
+			entry.lods[l] = lods[l];
+		entry.meshletCount = (unsigned int)meshes[i].meshlets.size();
+
+		const VertexDecode& decode = meshes[i].decode;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			entry.positionScale[axis] = decode.positionScale[axis];
+			entry.positionOffset[axis] = decode.positionOffset[axis];
+		}
+		for (int axis = 0; axis < 2; ++axis)
+		{
+			entry.texCoordScale[axis] = decode.texCoordScale[axis];
+			entry.texCoordOffset[axis] = decode.texCoordOffset[axis];
+		}
+
+		glm::vec3 boundsMin, boundsMax;
+		Mesh::ComputeBounds(meshes[i].vertices.empty() ? NULL : &meshes[i].vertices[0], entry.vertexCount, boundsMin, boundsMax);
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			entry.boundsMin[axis] = boundsMin[axis];
+			entry.boundsMax[axis] = boundsMax[axis];
+		}
+
+		for (size_t t = 0; t < meshes[i].textures.size(); ++t)
+		{
+			const MeshTextureRef& ref = meshes[i].textures[t];
+			if (ref.path.size() >= MESH_CACHE_PATH_LENGTH || ref.type.size() >= MESH_CACHE_TYPE_LENGTH)
+			{
+				LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Texture path too long for the mesh cache: %s", ref.path.c_str());
+				return false;
+			}
+
+			MeshCacheTexture texture;
+			memset(&texture, 0, sizeof(texture));
+			strncpy_s(texture.path, MESH_CACHE_PATH_LENGTH, ref.path.c_str(), _TRUNCATE);
+			strncpy_s(texture.type, MESH_CACHE_TYPE_LENGTH, ref.type.c_str(), _TRUNCATE);
+			textureTable.push_back(texture);
+		}
+	}
+	header.textureCount = (unsigned int)textureTable.size();
+
+	// Lay out the blobs after the tables.
+	unsigned long long offset = sizeof(MeshCacheHeader)
+		+ (unsigned long long)meshTable.size() * sizeof(MeshCacheMesh)
+		+ (unsigned long long)textureTable.size() * sizeof(MeshCacheTexture);
+
+	for (size_t i = 0; i < meshTable.size(); ++i)
+	{
+		meshTable[i].vertexOffset = AlignUp(offset);
+		offset = meshTable[i].vertexOffset + meshes[i].packedVertices.size();
+		meshTable[i].indexOffset = AlignUp(offset);
+		offset = meshTable[i].indexOffset + (unsigned long long)meshTable[i].indexCount * meshTable[i].indexSize;
+		meshTable[i].meshletOffset = AlignUp(offset);
+		offset = meshTable[i].meshletOffset + (unsigned long long)meshTable[i].meshletCount * sizeof(Meshlet);
+	}
+	header.fileSize = offset;
+
+	FILE* cacheFile = NULL;
+	if (fopen_s(&cacheFile, path, "wb") != 0 || cacheFile == NULL)
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Could not write mesh cache %s", path);
+		return false;
+	}
+
+	unsigned long long position = 0;
+	bool written = WriteBlock(cacheFile, position, &header, sizeof(header))
+		&& WriteBlock(cacheFile, position, meshTable.empty() ? NULL : &meshTable[0], meshTable.size() * sizeof(MeshCacheMesh))
+		&& WriteBlock(cacheFile, position, textureTable.empty() ? NULL : &textureTable[0], textureTable.size() * sizeof(MeshCacheTexture));
+
+	for (size_t i = 0; written && i < meshes.size(); ++i)
+	{
+		const vector<GLuint>& indices = meshes[i].indices;
+		vector<GLushort> shortIndices;
+		if (meshTable[i].indexSize == sizeof(GLushort))
+			shortIndices.assign(indices.begin(), indices.end());
+
+		const void* indexData = shortIndices.empty() ? (indices.empty() ? NULL : (const void*)&indices[0]) : (const void*)&shortIndices[0];
+
+		written = PadTo(cacheFile, position, meshTable[i].vertexOffset)
+			&& WriteBlock(cacheFile, position, meshes[i].packedVertices.empty() ? NULL : &meshes[i].packedVertices[0], meshes[i].packedVertices.size())
+			&& PadTo(cacheFile, position, meshTable[i].indexOffset)
+			&& WriteBlock(cacheFile, position, indexData, indices.size() * meshTable[i].indexSize)
+			&& PadTo(cacheFile, position, meshTable[i].meshletOffset)
+			&& WriteBlock(cacheFile, position, meshes[i].meshlets.empty() ? NULL : &meshes[i].meshlets[0], meshes[i].meshlets.size() * sizeof(Meshlet));
+	}
+
+	if (fclose(cacheFile) != 0)
+		written = false;
+
+	if (!written)
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Could not write mesh cache %s", path);
+		remove(path);
+		return false;
+	}
+
+	LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_ASSET, "Mesh cache written: %s", path);
+	return true;
+}
+
+/*
+	Whether a cache file exists and was written after its
+	source model. Only the model file itself is compared,
+	a cache has to be deleted by hand after editing just
+	the material library. Packed models count as written
+	when the file they were packed from was.
+
+	cachePath	-	Path to the cache file.
+	sourcePath	-	Path to the model it was built from.
+*/
+bool MeshCache::IsFresh(const char* cachePath, const char* sourcePath)
+{
+	unsigned long long cacheTime, sourceTime;
+	if (!getFileWriteTime(cachePath, cacheTime) || !FileSystem::GetWriteTime(sourcePath, sourceTime))
+		return false;
+
+	return cacheTime > sourceTime;
+}
+
+/*
+	Destructor, unmaps the file.
+*/
+MeshCache::~MeshCache()
+{
+}
+
+/*
+	Checks the header and that every table and blob lies
+	within the mapped file, so that nothing read later
+	can point past its end.
+*/
+bool MeshCache::Validate(void) const
+{
+	unsigned long long size = file.GetSize();
+
+	if (size < sizeof(MeshCacheHeader))
+		return false;
+	if (header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION || header->vertexSize != sizeof(Vertex))
+		return false;
+
+	const VertexErrorBounds& errorBounds = VertexQuantizer::GetErrorBounds();
+	if (header->errorBounds.position != errorBounds.position || header->errorBounds.normal != errorBounds.normal || header->errorBounds.texCoord != errorBounds.texCoord)
+		return false;
+	if (header->fileSize != size)
+		return false;
+
+	unsigned long long tablesEnd = sizeof(MeshCacheHeader)
+		+ (unsigned long long)header->meshCount * sizeof(MeshCacheMesh)
+		+ (unsigned long long)header->textureCount * sizeof(MeshCacheTexture);
+	if (tablesEnd > size)
+		return false;
+
+	for (unsigned int i = 0; i < header->meshCount; ++i)
+	{
+		const MeshCacheMesh& mesh = meshes[i];
+
+		if (mesh.vertexOffset % MESH_CACHE_ALIGNMENT != 0 || mesh.indexOffset % MESH_CACHE_ALIGNMENT != 0 || mesh.meshletOffset % MESH_CACHE_ALIGNMENT != 0)
+			return false;
+		if (mesh.vertexFormat >= VERTEX_FORMAT_COUNT)
+			return false;
+		if (mesh.vertexOffset < tablesEnd || mesh.vertexOffset + (unsigned long long)mesh.vertexCount * GetVertexFormatStride((VertexFormat)mesh.vertexFormat) > size)
+			return false;
+		if (mesh.indexSize != sizeof(GLushort) && mesh.indexSize != sizeof(GLuint))
+			return false;
+		if (mesh.indexSize == sizeof(GLushort) && mesh.vertexCount > MESH_MAX_SHORT_INDEX_VERTICES)
+			return false;
+		if (mesh.indexOffset < tablesEnd || mesh.indexOffset + (unsigned long long)mesh.indexCount * mesh.indexSize > size)
+			return false;
+		if ((unsigned long long)mesh.firstTexture + mesh.textureCount > header->textureCount)
+			return false;
+		if (mesh.lodCount == 0 || mesh.lodCount > MESH_MAX_LODS)
+			return false;
+		for (unsigned int l = 0; l < mesh.lodCount; ++l)
+		{
+			if ((unsigned long long)mesh.lods[l].firstIndex + mesh.lods[l].indexCount > mesh.indexCount)
+				return false;
+		}
+		if (mesh.meshletOffset < tablesEnd || mesh.meshletOffset + (unsigned long long)mesh.meshletCount * sizeof(Meshlet) > size)
+			return false;
+
+		const Meshlet* meshlets = (const Meshlet*)(file.GetData() + mesh.meshletOffset);
+		for (unsigned int m = 0; m < mesh.meshletCount; ++m)
+		{
+			if ((unsigned long long)meshlets[m].firstIndex + meshlets[m].indexCount > mesh.indexCount)
+				return false;
+		}
+	}
+
+	const MeshCacheTexture* textureTable = (const MeshCacheTexture*)(meshes + header->meshCount);
+	for (unsigned int i = 0; i < header->textureCount; ++i)
+	{
+		if (textureTable[i].path[MESH_CACHE_PATH_LENGTH - 1] != '\0' || textureTable[i].type[MESH_CACHE_TYPE_LENGTH - 1] != '\0')
+			return false;
+	}
+
+	return true;
+}
\ No newline at end of file
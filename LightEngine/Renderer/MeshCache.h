@@ -0,0 +1,158 @@
+#pragma once
+
+// Includes.
+#include "Mesh.h"
+#include "VertexQuantizer.h"
+#include "..\Util\MappedFile.h"
+#include "..\Util\FileSystem.h"
+
+// File format constants.
+const unsigned int MESH_CACHE_MAGIC = 0x434D454C;	// "LEMC"
+const unsigned int MESH_CACHE_VERSION = 5;
+const unsigned int MESH_CACHE_ALIGNMENT = 64;		// Of every vertex and index blob.
+const unsigned int MESH_CACHE_PATH_LENGTH = 224;
+const unsigned int MESH_CACHE_TYPE_LENGTH = 32;
+
+/*
+	Texture a mesh uses, as named by its material.
+
+	path	-	Path relative to the model's directory.
+	type	-	Sampler prefix, e.g. "texture_diffuse".
+*/
+struct MeshTextureRef
+{
+	string path;
+	string type;
+};
+
+/*
+	CPU-side copy of an imported mesh, before upload.
+
+	vertices		-	Vertices as imported.
+	indices			-	Triangles of every LOD, one after the other.
+	lods			-	Index ranges of the LODs, empty if indices
+						is the full mesh only.
+	meshlets		-	Clusters of LOD 0, may be empty.
+	packedVertices	-	The same vertices in vertexFormat, which is
+						what gets uploaded and cached.
+	decode			-	How the shaders decode packedVertices.
+*/
+struct MeshSource
+{
+	vector<Vertex>			vertices;
+	vector<GLuint>			indices;
+	vector<MeshLod>			lods;
+	vector<Meshlet>			meshlets;
+	vector<MeshTextureRef>	textures;
+	VertexFormat			vertexFormat;
+	vector<unsigned char>	packedVertices;
+	VertexDecode			decode;
+
+	MeshSource() : vertexFormat(VERTEX_FORMAT_FLOAT) {}
+};
+
+/*
+	File header. fileSize guards against files that were
+	cut short while being written.
+*/
+struct MeshCacheHeader
+{
+	unsigned int		magic;
+	unsigned int		version;
+	unsigned int		vertexSize;		// sizeof(Vertex) of the writer.
+	unsigned int		meshCount;
+	unsigned int		textureCount;
+	VertexErrorBounds	errorBounds;	// The vertex formats were picked with.
+	unsigned long long	fileSize;
+};
+
+/*
+	One entry of the mesh table, which follows the header.
+	Offsets are from the start of the file.
+*/
+struct MeshCacheMesh
+{
+	unsigned long long	vertexOffset;
+	unsigned long long	indexOffset;
+	unsigned int		vertexCount;
+	unsigned int		indexCount;
+	unsigned int		firstTexture;	// Into the texture table.
+	unsigned int		textureCount;
+	float				boundsMin[3];
+	float				boundsMax[3];
+	unsigned int		indexSize;		// 2 or 4 bytes, see Mesh::GetIndexType().
+	unsigned int		vertexFormat;	// VertexFormat of the vertex blob.
+	float				positionScale[3];
+	float				positionOffset[3];
+	float				texCoordScale[2];
+	float				texCoordOffset[2];
+	unsigned int		lodCount;		// At least 1, at most MESH_MAX_LODS.
+	MeshLod				lods[MESH_MAX_LODS];
+	unsigned int		meshletCount;
+	unsigned long long	meshletOffset;
+};
+
+/*
+	One entry of the texture table, which follows the
+	mesh table. Strings are null-terminated.
+*/
+struct MeshCacheTexture
+{
+	char	path[MESH_CACHE_PATH_LENGTH];
+	char	type[MESH_CACHE_TYPE_LENGTH];
+};
+
+/*
+	Binary mesh cache, so that models can be loaded without
+	Assimp. A file is laid out as :
+
+		MeshCacheHeader
+		MeshCacheMesh		[meshCount]
+		MeshCacheTexture	[textureCount]
+		per mesh : vertices[vertexCount] in their VertexFormat,
+				   GLushort or GLuint[indexCount],
+				   Meshlet[meshletCount]
+
+	Every blob starts at a multiple of MESH_CACHE_ALIGNMENT,
+	so the vertex and index data of a mapped file can be
+	given to glBufferData() as is. The file is only valid
+	for the vertex formats, error bounds and byte order it
+	was written with; anything else is rejected and rebuilt.
+*/
+class MeshCache
+{
+public:
+
+// Functions
+
+	MeshCache();
+	bool Open(const char* path);
+	void Close(void);
+	unsigned int GetMeshCount(void) const;
+	const MeshCacheMesh& GetMesh(unsigned int index) const;
+	const void* GetVertices(const MeshCacheMesh& mesh) const;
+	static VertexFormat GetVertexFormat(const MeshCacheMesh& mesh);
+	static VertexDecode GetVertexDecode(const MeshCacheMesh& mesh);
+	const void* GetIndices(const MeshCacheMesh& mesh) const;
+	static vector<MeshLod> GetLods(const MeshCacheMesh& mesh);
+	const Meshlet* GetMeshlets(const MeshCacheMesh& mesh) const;
+	static GLenum GetIndexType(const MeshCacheMesh& mesh);
+	const MeshCacheTexture& GetTexture(unsigned int index) const;
+	size_t GetFileSize(void) const;
+	static bool Write(const char* path, const vector<MeshSource>& meshes);
+	static bool IsFresh(const char* cachePath, const char* sourcePath);
+	~MeshCache();
+
+private:
+
+// Functions
+
+	bool Validate(void) const;
+
+// Variables
+
+	MappedFile				file;
+	const MeshCacheHeader*	header;
+	const MeshCacheMesh*	meshes;
+	const MeshCacheTexture*	textures;
+};
\ No newline at end of file
@@ -0,0 +1,399 @@
+#include "MeshOptimizer.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	// Scoring constants from Forsyth's "Linear-Speed Vertex Cache Optimisation".
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	const GLuint NO_VERTEX = 0xFFFFFFFF;
+
+	/*
+		How much drawing a triangle with this vertex is worth :
+		more if the vertex is recently used, and more if few
+		triangles are left that need it, so that it can leave
+		the cache for good.
+
+		cachePosition	-	Position in the LRU cache, -1 if not in it.
+		activeTriangles	-	Triangles using the vertex that aren't drawn yet.
+	*/
+	float VertexScore(int cachePosition, unsigned int activeTriangles)
+	{
+		if (activeTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// The last triangle's vertices get a fixed score, so it doesn't matter which order they were in.
+			if (cachePosition < 3)
+				score = LAST_TRIANGLE_SCORE;
+			else
+				score = powf(1.0f - (float)(cachePosition - 3) / (float)(MESH_OPTIMIZER_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+
+		return score + VALENCE_BOOST_SCALE * powf((float)activeTriangles, -VALENCE_BOOST_POWER);
+	}
+
+	/*
+		Optimizes a range of an index buffer for the vertex
+		cache on its own, e.g. a meshlet that is drawn
+		separately. The range is given local vertex numbers,
+		so the work only depends on its size.
+
+		indices		-	Index buffer, the range is reordered in place.
+		firstIndex	-	First index of the range.
+		indexCount	-	Number of indices in the range.
+	*/
+	void OptimizeRangeCache(vector<GLuint>& indices, GLuint firstIndex, GLuint indexCount)
+	{
+		vector<GLuint> globals, locals(indexCount);
+		for (GLuint i = 0; i < indexCount; ++i)
+		{
+			GLuint vertex = indices[firstIndex + i];
+			size_t local = std::find(globals.begin(), globals.end(), vertex) - globals.begin();
+			if (local == globals.size())
+				globals.push_back(vertex);
+			locals[i] = (GLuint)local;
+		}
+
+		MeshOptimizer::OptimizeVertexCache(locals, (unsigned int)globals.size());
+
+		for (GLuint i = 0; i < indexCount; ++i)
+			indices[firstIndex + i] = globals[locals[i]];
+	}
+}
+
+/*
+	Runs all optimizations on a mesh and measures their
+	effect.
+
+	mesh		-	Imported mesh, optimized in place.
+	errorBounds	-	Largest error the vertex format may introduce.
+	stats		-	Receives the numbers before and after.
+*/
+void MeshOptimizer::Optimize(MeshSource& mesh, const VertexErrorBounds& errorBounds, MeshOptimizeStats& stats)
+{
+	stats.triangleCount = (unsigned int)(mesh.indices.size() / 3);
+	stats.verticesBefore = (unsigned int)mesh.vertices.size();
+
+	// Before, every mesh used 32-bit indices.
+	unsigned int misses = CountCacheMisses(mesh.indices, stats.verticesBefore, MESH_OPTIMIZER_FIFO_SIZE);
+	stats.acmrBefore = stats.triangleCount > 0 ? (float)misses / stats.triangleCount : 0.0f;
+	stats.atvrBefore = stats.verticesBefore > 0 ? (float)misses / stats.verticesBefore : 0.0f;
+	stats.gpuBytesBefore = mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(GLuint);
+
+	WeldVertices(mesh.vertices, mesh.indices);
+	GenerateLods(mesh.vertices, mesh.indices, mesh.lods);
+	MeshletBuilder::Build(mesh.vertices, mesh.indices, mesh.lods[0], mesh.meshlets);
+	for (size_t i = 0; i < mesh.meshlets.size(); ++i)
+		OptimizeRangeCache(mesh.indices, mesh.meshlets[i].firstIndex, mesh.meshlets[i].indexCount);
+	OptimizeVertexFetch(mesh.vertices, mesh.indices);
+	mesh.vertexFormat = VertexQuantizer::Quantize(mesh.vertices, errorBounds, mesh.packedVertices, mesh.decode);
+
+	stats.lodCount = (unsigned int)mesh.lods.size();
+	for (unsigned int i = 0; i < stats.lodCount; ++i)
+		stats.lodTriangles[i] = mesh.lods[i].indexCount / 3;
+	stats.meshletCount = (unsigned int)mesh.meshlets.size();
+
+	// The cache is measured on the full mesh, the LODs follow it in the same buffer.
+	vector<GLuint> fullIndices(mesh.indices.begin(), mesh.indices.begin() + mesh.lods[0].indexCount);
+	stats.verticesAfter = (unsigned int)mesh.vertices.size();
+	misses = CountCacheMisses(fullIndices, stats.verticesAfter, MESH_OPTIMIZER_FIFO_SIZE);
+	stats.acmrAfter = stats.triangleCount > 0 ? (float)misses / stats.triangleCount : 0.0f;
+	stats.atvrAfter = stats.verticesAfter > 0 ? (float)misses / stats.verticesAfter : 0.0f;
+	stats.gpuBytesAfter = GetGpuBytes(mesh.vertexFormat, mesh.vertices.size(), mesh.indices.size());
+	stats.vertexFormat = mesh.vertexFormat;
+}
+
+/*
+	Merges vertices whose position, normal and texture
+	coordinates are identical, and points the indices at
+	the remaining copy.
+
+	vertices	-	Vertices, replaced by the unique ones.
+	indices		-	Indices, remapped.
+*/
+void MeshOptimizer::WeldVertices(vector<Vertex>& vertices, vector<GLuint>& indices)
+{
+	// Open-addressing table of indices into unique, at most half full.
+	size_t tableSize = 1;
+	while (tableSize < vertices.size() * 2)
+		tableSize <<= 1;
+	size_t mask = tableSize - 1;
+
+	vector<GLuint> table(tableSize, NO_VERTEX);
+	vector<GLuint> remap(vertices.size());
+	vector<Vertex> unique;
+	unique.reserve(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		size_t slot = hashBytes32(&vertices[i], sizeof(Vertex)) & mask;
+		while (table[slot] != NO_VERTEX && memcmp(&unique[table[slot]], &vertices[i], sizeof(Vertex)) != 0)
+			slot = (slot + 1) & mask;
+
+		if (table[slot] == NO_VERTEX)
+		{
+			table[slot] = (GLuint)unique.size();
+			unique.push_back(vertices[i]);
+		}
+		remap[i] = table[slot];
+	}
+
+	for (size_t i = 0; i < indices.size(); ++i)
+		indices[i] = remap[indices[i]];
+
+	vertices.swap(unique);
+}
+
+/*
+	Builds the levels of detail of a mesh. Each LOD is
+	simplified from the previous one to about
+	MESH_LOD_TRIANGLE_RATIO of its triangles, until
+	MESH_MAX_LODS are made, a LOD barely gets smaller or
+	the error would exceed MESH_LOD_MAX_ERROR of the mesh's
+	size. A LOD's error adds up the errors of the LODs it
+	was simplified from, so it bounds the distance to the
+	full mesh. Every LOD is optimized for the vertex cache
+	and appended to the indices.
+
+	vertices	-	Vertices of the mesh, shared by all LODs.
+	indices		-	Full mesh, replaced by all LODs one after the other.
+	lods		-	Receives the index range of every LOD.
+*/
+void MeshOptimizer::GenerateLods(const vector<Vertex>& vertices, vector<GLuint>& indices, vector<MeshLod>& lods)
+{
+	lods.clear();
+
+	MeshLod full = { 0, (GLuint)indices.size(), 0.0f };
+	lods.push_back(full);
+	OptimizeVertexCache(indices, (unsigned int)vertices.size());
+
+	if (vertices.empty())
+		return;
+
+	glm::vec3 boundsMin, boundsMax;
+	Mesh::ComputeBounds(&vertices[0], (GLuint)vertices.size(), boundsMin, boundsMax);
+	float maxError = glm::length(boundsMax - boundsMin) * MESH_LOD_MAX_ERROR;
+
+	vector<GLuint> previous(indices), simplified;
+	while (lods.size() < MESH_MAX_LODS)
+	{
+		float errorLeft = maxError - lods.back().error;
+		size_t targetIndexCount = (size_t)(previous.size() / 3 * MESH_LOD_TRIANGLE_RATIO) * 3;
+		if (errorLeft <= 0.0f || targetIndexCount == 0)
+			break;
+
+		float error = MeshSimplifier::Simplify(vertices, previous, targetIndexCount, errorLeft, simplified);
+		if (simplified.empty() || simplified.size() > previous.size() * (1.0f - MESH_LOD_MIN_REDUCTION))
+			break;
+
+		OptimizeVertexCache(simplified, (unsigned int)vertices.size());
+
+		MeshLod lod = { (GLuint)indices.size(), (GLuint)simplified.size(), lods.back().error + error };
+		lods.push_back(lod);
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+		previous.swap(simplified);
+	}
+}
+
+/*
+	Reorders the triangles for the post-transform vertex
+	cache. Triangles are drawn greedily : after each one,
+	the triangles around the vertices in a simulated LRU
+	cache are rescored and the best one goes next.
+
+	indices		-	Triangle list, reordered in place.
+	vertexCount	-	Number of vertices the indices refer to.
+*/
+void MeshOptimizer::OptimizeVertexCache(vector<GLuint>& indices, unsigned int vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles of every vertex, the first activeTriangles[v] of them aren't drawn yet.
+	vector<unsigned int> activeTriangles(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		++activeTriangles[indices[i]];
+
+	vector<unsigned int> offsets(vertexCount, 0);
+	for (unsigned int v = 1; v < vertexCount; ++v)
+		offsets[v] = offsets[v - 1] + activeTriangles[v - 1];
+
+	vector<unsigned int> adjacency(triangleCount * 3);
+	vector<unsigned int> fill(offsets);
+	for (size_t t = 0; t < triangleCount; ++t)
+		for (int k = 0; k < 3; ++k)
+			adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+
+	vector<int> cachePositions(vertexCount, -1);
+	vector<float> vertexScores(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; ++v)
+		vertexScores[v] = VertexScore(-1, activeTriangles[v]);
+
+	vector<bool> drawn(triangleCount, false);
+	vector<GLuint> output;
+	output.reserve(triangleCount * 3);
+
+	GLuint cache[MESH_OPTIMIZER_CACHE_SIZE + 3];
+	GLuint newCache[MESH_OPTIMIZER_CACHE_SIZE + 3];
+	unsigned int cacheCount = 0;
+
+	size_t nextUndrawn = 0;
+	long long best = -1;
+
+	while (output.size() < triangleCount * 3)
+	{
+		// Nothing in the cache is left to draw : continue with the first triangle that isn't drawn yet.
+		if (best < 0)
+		{
+			while (drawn[nextUndrawn])
+				++nextUndrawn;
+			best = (long long)nextUndrawn;
+		}
+
+		const GLuint* triangle = &indices[(size_t)best * 3];
+		drawn[(size_t)best] = true;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			output.push_back(triangle[k]);
+
+			// Remove the triangle from the vertex's undrawn ones.
+			unsigned int* list = &adjacency[offsets[triangle[k]]];
+			unsigned int& count = activeTriangles[triangle[k]];
+			for (unsigned int j = 0; j < count; ++j)
+			{
+				if (list[j] == (unsigned int)best)
+				{
+					list[j] = list[count - 1];
+					--count;
+					break;
+				}
+			}
+		}
+
+		// Most recently used first : the triangle's vertices, then the rest of the cache.
+		unsigned int newCount = 0;
+		for (int k = 0; k < 3; ++k)
+		{
+			bool present = false;
+			for (unsigned int j = 0; j < newCount; ++j)
+				present = present || newCache[j] == triangle[k];
+			if (!present)
+				newCache[newCount++] = triangle[k];
+		}
+		for (unsigned int i = 0; i < cacheCount; ++i)
+		{
+			if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+				newCache[newCount++] = cache[i];
+		}
+
+		// Vertices that fell out of the cache.
+		for (unsigned int i = MESH_OPTIMIZER_CACHE_SIZE; i < newCount; ++i)
+		{
+			cachePositions[newCache[i]] = -1;
+			vertexScores[newCache[i]] = VertexScore(-1, activeTriangles[newCache[i]]);
+		}
+
+		cacheCount = newCount < MESH_OPTIMIZER_CACHE_SIZE ? newCount : MESH_OPTIMIZER_CACHE_SIZE;
+		for (unsigned int i = 0; i < cacheCount; ++i)
+		{
+			cache[i] = newCache[i];
+			cachePositions[cache[i]] = (int)i;
+			vertexScores[cache[i]] = VertexScore((int)i, activeTriangles[cache[i]]);
+		}
+
+		// Only triangles around the cache changed their score.
+		best = -1;
+		float bestScore = 0.0f;
+		for (unsigned int i = 0; i < cacheCount; ++i)
+		{
+			GLuint v = cache[i];
+			for (unsigned int j = 0; j < activeTriangles[v]; ++j)
+			{
+				unsigned int t = adjacency[offsets[v] + j];
+				float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+	}
+
+	indices.swap(output);
+}
+
+/*
+	Reorders the vertices in the order the indices first
+	use them, and drops vertices that aren't used at all.
+
+	vertices	-	Vertices, reordered in place.
+	indices		-	Indices, remapped.
+*/
+void MeshOptimizer::OptimizeVertexFetch(vector<Vertex>& vertices, vector<GLuint>& indices)
+{
+	vector<GLuint> remap(vertices.size(), NO_VERTEX);
+	vector<Vertex> ordered;
+	ordered.reserve(vertices.size());
+
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		GLuint& index = indices[i];
+		if (remap[index] == NO_VERTEX)
+		{
+			remap[index] = (GLuint)ordered.size();
+			ordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices.swap(ordered);
+}
+
+/*
+	Vertex shader runs of a triangle list on a FIFO
+	post-transform cache.
+
+	indices		-	Triangle list.
+	vertexCount	-	Number of vertices the indices refer to.
+	cacheSize	-	Entries of the simulated cache.
+*/
+unsigned int MeshOptimizer::CountCacheMisses(const vector<GLuint>& indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+	// A vertex is cached if fewer than cacheSize misses happened since its own.
+	vector<unsigned int> missTime(vertexCount, 0);
+	unsigned int time = cacheSize + 1;
+	unsigned int misses = 0;
+
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		GLuint v = indices[i];
+		if (time - missTime[v] > cacheSize)
+		{
+			missTime[v] = time++;
+			++misses;
+		}
+	}
+
+	return misses;
+}
+
+/*
+	Size of the vertex and index buffers of a mesh, with
+	the index type Mesh picks for it.
+*/
+size_t MeshOptimizer::GetGpuBytes(VertexFormat vertexFormat, size_t vertexCount, size_t indexCount)
+{
+	size_t indexSize = (Mesh::GetIndexType((GLuint)vertexCount) == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+	return vertexCount * GetVertexFormatStride(vertexFormat) + indexCount * indexSize;
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+// Includes.
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+
+// Vertices of the post-transform cache that Forsyth's scoring assumes.
+const unsigned int MESH_OPTIMIZER_CACHE_SIZE = 32;
+
+// FIFO cache size that ACMR/ATVR are measured with.
+const unsigned int MESH_OPTIMIZER_FIFO_SIZE = 16;
+
+// Fraction of the previous LOD's triangles each LOD aims for.
+const float MESH_LOD_TRIANGLE_RATIO = 0.5f;
+
+// A LOD that removes less than this fraction of the previous one's triangles ends the chain.
+const float MESH_LOD_MIN_REDUCTION = 0.15f;
+
+// Largest error of the coarsest LOD, as a fraction of the bounding box diagonal.
+const float MESH_LOD_MAX_ERROR = 0.05f;
+
+/*
+	Effect of MeshOptimizer::Optimize() on one mesh.
+
+	ACMR (average cache miss ratio) is the number of vertex
+	shader runs per triangle, ATVR (average transformed
+	vertex ratio) the number of runs per vertex. Both are
+	measured with a FIFO cache of MESH_OPTIMIZER_FIFO_SIZE;
+	lower is better, 1.0 is the best possible ATVR.
+
+	gpuBytes		-	Vertex plus index buffer size.
+	vertexFormat	-	Format the vertices were quantized to.
+	lodTriangles	-	Triangles of each of the lodCount LODs.
+	meshletCount	-	Meshlets LOD 0 was split into.
+*/
+struct MeshOptimizeStats
+{
+	unsigned int	triangleCount;
+	unsigned int	verticesBefore;
+	unsigned int	verticesAfter;
+	float			acmrBefore;
+	float			acmrAfter;
+	float			atvrBefore;
+	float			atvrAfter;
+	size_t			gpuBytesBefore;
+	size_t			gpuBytesAfter;
+	VertexFormat	vertexFormat;
+	unsigned int	lodCount;
+	unsigned int	lodTriangles[MESH_MAX_LODS];
+	unsigned int	meshletCount;
+};
+
+/*
+	Import-time geometry optimizer for indexed triangle
+	lists :
+
+	1. WeldVertices() merges vertices that are identical
+	   bit for bit, which the OBJ importer leaves split.
+	2. GenerateLods() simplifies the mesh into up to
+	   MESH_MAX_LODS levels of detail, and
+	   OptimizeVertexCache() reorders the triangles of each
+	   so that vertices are reused while they are still in
+	   the post-transform cache (Forsyth's linear-speed
+	   method).
+	3. MeshletBuilder::Build() splits LOD 0 into meshlets
+	   for cluster culling, whose triangles are then
+	   reordered for the vertex cache meshlet by meshlet.
+	4. OptimizeVertexFetch() reorders vertices by first
+	   use, so the vertex fetch reads memory in order.
+	5. VertexQuantizer::Quantize() packs the vertices into
+	   the smallest VertexFormat within the error bounds.
+
+	Meshes with at most 65536 vertices are then drawn with
+	16-bit indices (see Mesh::GetIndexType()).
+*/
+class MeshOptimizer
+{
+public:
+
+// Functions
+
+	static void Optimize(MeshSource& mesh, const VertexErrorBounds& errorBounds, MeshOptimizeStats& stats);
+	static void WeldVertices(vector<Vertex>& vertices, vector<GLuint>& indices);
+	static void GenerateLods(const vector<Vertex>& vertices, vector<GLuint>& indices, vector<MeshLod>& lods);
+	static void OptimizeVertexCache(vector<GLuint>& indices, unsigned int vertexCount);
+	static void OptimizeVertexFetch(vector<Vertex>& vertices, vector<GLuint>& indices);
+	static unsigned int CountCacheMisses(const vector<GLuint>& indices, unsigned int vertexCount, unsigned int cacheSize);
+	static size_t GetGpuBytes(VertexFormat vertexFormat, size_t vertexCount, size_t indexCount);
+};
\ No newline at end of file
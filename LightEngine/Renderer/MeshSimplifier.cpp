@@ -0,0 +1,407 @@
+#include "MeshSimplifier.h"
+#include "..\Util\Utility.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	/*
+		How a vertex may move during simplification.
+	*/
+	enum VertexKind
+	{
+		KIND_MANIFOLD,	// Interior, collapses onto any neighbour.
+		KIND_BORDER,	// On one open border, collapses along it.
+		KIND_SEAM,		// On an attribute seam, collapses along it with its twin.
+		KIND_LOCKED		// Seam corner or non-manifold, never moves.
+	};
+
+	/*
+		Sum of squared distances to a set of weighted planes,
+		stored as the symmetric matrix A, the vector b and
+		the constant c of p'Ap + 2b'p + c.
+	*/
+	struct Quadric
+	{
+		double a00, a01, a02, a11, a12, a22;
+		double b0, b1, b2;
+		double c;
+		double weight;
+	};
+
+	/*
+		Adds the plane n.p + d = 0 with the given weight.
+
+		normal	-	Unit plane normal.
+	*/
+	void AddPlane(Quadric& q, const glm::vec3& normal, float d, float weight)
+	{
+		double x = normal.x, y = normal.y, z = normal.z, w = weight;
+		q.a00 += w * x * x; q.a01 += w * x * y; q.a02 += w * x * z;
+		q.a11 += w * y * y; q.a12 += w * y * z; q.a22 += w * z * z;
+		q.b0 += w * x * d; q.b1 += w * y * d; q.b2 += w * z * d;
+		q.c += w * (double)d * d;
+		q.weight += w;
+	}
+
+	void AddQuadric(Quadric& q, const Quadric& other)
+	{
+		q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02;
+		q.a11 += other.a11; q.a12 += other.a12; q.a22 += other.a22;
+		q.b0 += other.b0; q.b1 += other.b1; q.b2 += other.b2;
+		q.c += other.c;
+		q.weight += other.weight;
+	}
+
+	/*
+		Root mean square distance of a point to the planes.
+	*/
+	float QuadricError(const Quadric& q, const glm::vec3& p)
+	{
+		if (q.weight <= 0.0)
+			return 0.0f;
+
+		double x = p.x, y = p.y, z = p.z;
+		double error = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+			+ 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+			+ 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+
+		return (float)sqrt(std::max(error, 0.0) / q.weight);
+	}
+
+	const GLuint NO_VERTEX = 0xFFFFFFFF;
+
+	/*
+		Key of a directed edge between two vertices.
+	*/
+	unsigned long long EdgeKey(GLuint from, GLuint to)
+	{
+		return ((unsigned long long)from << 32) | to;
+	}
+
+	/*
+		Whether a triangle around a vertex would flip or become
+		degenerate if the vertex moved to the target's position.
+	*/
+	bool CollapseFlips(const std::vector<Vertex>& vertices, const std::vector<GLuint>& triangles, const std::vector<unsigned int>& triangleOffsets,
+		const std::vector<unsigned int>& vertexTriangles, GLuint from, GLuint to)
+	{
+		const glm::vec3& target = vertices[to].Position;
+		for (unsigned int t = triangleOffsets[from]; t < triangleOffsets[from + 1]; ++t)
+		{
+			const GLuint* triangle = &triangles[vertexTriangles[t] * 3];
+			if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				continue;
+
+			glm::vec3 p[3], moved[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				p[k] = vertices[triangle[k]].Position;
+				moved[k] = triangle[k] == from ? target : p[k];
+			}
+
+			glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			if (glm::dot(before, after) <= 1e-2f * glm::length(before) * glm::length(after))
+				return true;
+		}
+		return false;
+	}
+
+	/*
+		Marks every vertex of the triangles around a vertex.
+	*/
+	void TouchTriangles(const std::vector<GLuint>& triangles, const std::vector<unsigned int>& triangleOffsets,
+		const std::vector<unsigned int>& vertexTriangles, GLuint vertex, std::vector<bool>& touched)
+	{
+		for (unsigned int t = triangleOffsets[vertex]; t < triangleOffsets[vertex + 1]; ++t)
+		{
+			const GLuint* triangle = &triangles[vertexTriangles[t] * 3];
+			touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+		}
+	}
+
+	/*
+		Candidate collapse of one vertex onto a neighbour.
+	*/
+	struct Collapse
+	{
+		GLuint	from;
+		GLuint	to;
+		float	error;
+
+		bool operator<(const Collapse& other) const
+		{
+			return error < other.error;
+		}
+	};
+}
+
+/*
+	Simplifies a triangle list until it has at most the
+	target number of indices, or no collapse is left whose
+	error is within the target error.
+
+	vertices			-	Vertices the indices refer to.
+	indices				-	Triangle list to simplify.
+	targetIndexCount	-	Number of indices to reduce to.
+	targetError			-	Largest error of a collapse, in object units.
+	result				-	Receives the simplified triangle list.
+
+	Returns the largest error of the collapses that were made.
+*/
+float MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, size_t targetIndexCount, float targetError, std::vector<GLuint>& result)
+{
+	result = indices;
+	size_t vertexCount = vertices.size();
+	if (vertexCount == 0 || indices.size() <= targetIndexCount)
+		return 0.0f;
+
+	// Vertices that share their position with one other vertex are twins on an attribute seam.
+	size_t tableSize = 1;
+	while (tableSize < vertexCount * 2)
+		tableSize <<= 1;
+
+	std::vector<GLuint> positions(tableSize, NO_VERTEX);
+	std::vector<unsigned int> positionSlots(vertexCount);
+	std::vector<unsigned int> positionCounts(tableSize, 0);
+	std::vector<GLuint> twins(vertexCount, NO_VERTEX);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		size_t slot = hashBytes32(&vertices[i].Position, sizeof(glm::vec3)) & (tableSize - 1);
+		while (positions[slot] != NO_VERTEX && memcmp(&vertices[positions[slot]].Position, &vertices[i].Position, sizeof(glm::vec3)) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (positions[slot] == NO_VERTEX)
+			positions[slot] = (GLuint)i;
+		else
+			twins[i] = positions[slot];
+
+		positionSlots[i] = (unsigned int)slot;
+		++positionCounts[slot];
+	}
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		if (positionCounts[positionSlots[i]] != 2)
+			twins[i] = NO_VERTEX;
+		else if (twins[i] != NO_VERTEX)
+			twins[twins[i]] = (GLuint)i;
+	}
+
+	// Directed edges : an edge without its reverse is on a border, one used twice is non-manifold.
+	std::unordered_map<unsigned long long, unsigned int> edges;
+	for (size_t i = 0; i < indices.size(); i += 3)
+		for (int k = 0; k < 3; ++k)
+			++edges[EdgeKey(indices[i + k], indices[i + (k + 1) % 3])];
+
+	std::vector<unsigned int> borderOut(vertexCount, 0), borderIn(vertexCount, 0);
+	std::vector<bool> complex(vertexCount, false);
+	for (std::unordered_map<unsigned long long, unsigned int>::iterator edge = edges.begin(); edge != edges.end(); ++edge)
+	{
+		GLuint from = (GLuint)(edge->first >> 32), to = (GLuint)(edge->first & 0xFFFFFFFF);
+		if (edge->second > 1)
+			complex[from] = complex[to] = true;
+		if (edges.find(EdgeKey(to, from)) == edges.end())
+		{
+			++borderOut[from];
+			++borderIn[to];
+		}
+	}
+
+	std::vector<VertexKind> kinds(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		bool onOneBorder = borderOut[i] == 1 && borderIn[i] == 1;
+		if (complex[i] || positionCounts[positionSlots[i]] > 2)
+			kinds[i] = KIND_LOCKED;
+		else if (twins[i] != NO_VERTEX)
+			kinds[i] = onOneBorder ? KIND_SEAM : KIND_LOCKED;
+		else if (borderOut[i] == 0 && borderIn[i] == 0)
+			kinds[i] = KIND_MANIFOLD;
+		else
+			kinds[i] = onOneBorder ? KIND_BORDER : KIND_LOCKED;
+	}
+
+	// Surface planes weighted by area, and planes through border edges that keep the outline.
+	Quadric zero;
+	memset(&zero, 0, sizeof(zero));
+	std::vector<Quadric> quadrics(vertexCount, zero);
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const glm::vec3& p0 = vertices[indices[i]].Position;
+		glm::vec3 normal = glm::cross(vertices[indices[i + 1]].Position - p0, vertices[indices[i + 2]].Position - p0);
+		float length = glm::length(normal);
+		if (length <= 0.0f)
+			continue;
+		normal /= length;
+
+		for (int k = 0; k < 3; ++k)
+			AddPlane(quadrics[indices[i + k]], normal, -glm::dot(normal, p0), length * 0.5f);
+
+		for (int k = 0; k < 3; ++k)
+		{
+			GLuint from = indices[i + k], to = indices[i + (k + 1) % 3];
+			if (edges.find(EdgeKey(to, from)) != edges.end())
+				continue;
+
+			glm::vec3 edge = vertices[to].Position - vertices[from].Position;
+			glm::vec3 borderNormal = glm::cross(edge, normal);
+			float borderLength = glm::length(borderNormal);
+			if (borderLength <= 0.0f)
+				continue;
+			borderNormal /= borderLength;
+
+			float weight = glm::dot(edge, edge) * MESH_SIMPLIFIER_BORDER_WEIGHT;
+			float d = -glm::dot(borderNormal, vertices[from].Position);
+			AddPlane(quadrics[from], borderNormal, d, weight);
+			AddPlane(quadrics[to], borderNormal, d, weight);
+		}
+	}
+
+	float resultError = 0.0f;
+	std::vector<GLuint> collapseTo(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+		collapseTo[i] = (GLuint)i;
+
+	std::vector<unsigned int> triangleOffsets(vertexCount + 1);
+	std::vector<unsigned int> vertexTriangles;
+	std::vector<bool> touched(vertexCount);
+	std::vector<Collapse> candidates;
+	std::unordered_set<unsigned long long> currentEdges;
+
+	while (result.size() > targetIndexCount)
+	{
+		size_t triangleCount = result.size() / 3;
+
+		// Triangles around every vertex.
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (size_t i = 0; i < result.size(); ++i)
+			++triangleOffsets[result[i] + 1];
+		for (size_t v = 0; v < vertexCount; ++v)
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		vertexTriangles.resize(result.size());
+		std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (size_t i = 0; i < result.size(); ++i)
+			vertexTriangles[fill[result[i]]++] = (unsigned int)(i / 3);
+
+		// Border vertices move along the borders of the current triangles.
+		currentEdges.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+			for (int k = 0; k < 3; ++k)
+				currentEdges.insert(EdgeKey(result[i + k], result[i + (k + 1) % 3]));
+
+		// The cheaper direction of every edge that may collapse at all.
+		candidates.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				GLuint a = result[i + k], b = result[i + (k + 1) % 3];
+				bool border = currentEdges.find(EdgeKey(b, a)) == currentEdges.end();
+
+				Collapse best;
+				best.error = -1.0f;
+				for (int direction = 0; direction < 2; ++direction)
+				{
+					GLuint from = direction == 0 ? a : b, to = direction == 0 ? b : a;
+					bool allowed = kinds[from] == KIND_MANIFOLD || (kinds[from] == KIND_BORDER && border && kinds[to] != KIND_MANIFOLD);
+
+					// A seam moves on both sides at once, so the twins' edge must run alongside.
+					GLuint twinFrom = twins[from], twinTo = twins[to];
+					if (kinds[from] == KIND_SEAM && border && twinTo != NO_VERTEX && twinFrom != to)
+						allowed = currentEdges.find(EdgeKey(twinFrom, twinTo)) != currentEdges.end() || currentEdges.find(EdgeKey(twinTo, twinFrom)) != currentEdges.end();
+					if (!allowed)
+						continue;
+
+					float error = QuadricError(quadrics[from], vertices[to].Position);
+					if (kinds[from] == KIND_SEAM)
+						error = std::max(error, QuadricError(quadrics[twinFrom], vertices[twinTo].Position));
+					if (best.error < 0.0f || error < best.error)
+					{
+						best.from = from;
+						best.to = to;
+						best.error = error;
+					}
+				}
+
+				if (best.error >= 0.0f)
+					candidates.push_back(best);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		std::fill(touched.begin(), touched.end(), false);
+		size_t targetTriangles = targetIndexCount / 3;
+		unsigned int collapses = 0;
+
+		for (size_t c = 0; c < candidates.size() && triangleCount > targetTriangles; ++c)
+		{
+			const Collapse& collapse = candidates[c];
+			if (collapse.error > targetError)
+				break;
+			if (touched[collapse.from] || touched[collapse.to])
+				continue;
+
+			GLuint twinFrom = NO_VERTEX, twinTo = NO_VERTEX;
+			if (kinds[collapse.from] == KIND_SEAM)
+			{
+				twinFrom = twins[collapse.from];
+				twinTo = twins[collapse.to];
+				if (touched[twinFrom] || touched[twinTo])
+					continue;
+			}
+
+			// Triangles that stay must not flip or become degenerate.
+			if (CollapseFlips(vertices, result, triangleOffsets, vertexTriangles, collapse.from, collapse.to))
+				continue;
+			if (twinFrom != NO_VERTEX && CollapseFlips(vertices, result, triangleOffsets, vertexTriangles, twinFrom, twinTo))
+				continue;
+
+			// Nothing around this collapse may change again in this pass.
+			TouchTriangles(result, triangleOffsets, vertexTriangles, collapse.from, touched);
+			touched[collapse.to] = true;
+
+			if (twinFrom != NO_VERTEX)
+			{
+				TouchTriangles(result, triangleOffsets, vertexTriangles, twinFrom, touched);
+				touched[twinTo] = true;
+
+				collapseTo[twinFrom] = twinTo;
+				AddQuadric(quadrics[twinTo], quadrics[twinFrom]);
+				--triangleCount;
+			}
+
+			collapseTo[collapse.from] = collapse.to;
+			AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+
+			triangleCount -= (kinds[collapse.from] == KIND_MANIFOLD) ? 2 : 1;
+			resultError = std::max(resultError, collapse.error);
+			++collapses;
+		}
+
+		if (collapses == 0)
+			break;
+
+		// Point the indices at the remaining vertices and drop the triangles that collapsed.
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			GLuint a = collapseTo[result[i]], b = collapseTo[result[i + 1]], c = collapseTo[result[i + 2]];
+			if (a == b || b == c || c == a)
+				continue;
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+
+		for (size_t v = 0; v < vertexCount; ++v)
+			collapseTo[v] = (GLuint)v;
+	}
+
+	return resultError;
+}
\ No newline at end of file
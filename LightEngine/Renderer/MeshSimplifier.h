@@ -0,0 +1,35 @@
+#pragma once
+
+// Includes.
+#include <vector>
+#include "VertexLayout.h"
+
+// Weight of the planes that keep open borders in place, relative to the surface planes.
+const float MESH_SIMPLIFIER_BORDER_WEIGHT = 10.0f;
+
+/*
+	Simplifies indexed triangle lists with quadric error
+	metrics (Garland and Heckbert) for the LOD chains.
+
+	Vertices are only ever collapsed onto neighbours, so
+	a simplified index list still refers to the original
+	vertices and can share their buffer. Each vertex sums
+	the area weighted planes of its triangles; collapsing
+	it costs the distance of the neighbour's position to
+	those planes. Collapses are applied cheapest first in
+	passes that don't touch the same triangles twice.
+
+	Interior vertices collapse in any direction and border
+	vertices only along their border. Vertices on an
+	attribute seam (same position, other normal or UV)
+	or on non-manifold edges are kept, so the
+	simplification never opens cracks or tears UVs.
+*/
+class MeshSimplifier
+{
+public:
+
+// Functions
+
+	static float Simplify(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, size_t targetIndexCount, float targetError, std::vector<GLuint>& result);
+};
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include "MeshletBuilder.h"
+#include <cstring>
+
+namespace
+{
+	// Meshlets whose normals stray further from the axis than this (as a cosine) are never back-facing.
+	const float MIN_CONE_DOT = 0.1f;
+
+	const unsigned int NO_MESHLET = 0xFFFFFFFF;
+	const GLuint NO_VERTEX = 0xFFFFFFFF;
+
+	/*
+		Maps every vertex to the first vertex with the same
+		position.
+	*/
+	void MapPositions(const vector<Vertex>& vertices, vector<GLuint>& positions)
+	{
+		size_t tableSize = 1;
+		while (tableSize < vertices.size() * 2)
+			tableSize <<= 1;
+
+		vector<GLuint> table(tableSize, NO_VERTEX);
+		positions.resize(vertices.size());
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			size_t slot = hashBytes32(&vertices[i].Position, sizeof(glm::vec3)) & (tableSize - 1);
+			while (table[slot] != NO_VERTEX && memcmp(&vertices[table[slot]].Position, &vertices[i].Position, sizeof(glm::vec3)) != 0)
+				slot = (slot + 1) & (tableSize - 1);
+
+			if (table[slot] == NO_VERTEX)
+				table[slot] = (GLuint)i;
+			positions[i] = table[slot];
+		}
+	}
+}
+
+/*
+	Splits the triangles of a LOD into meshlets and
+	reorders them so that every meshlet is a consecutive
+	range of the index buffer.
+
+	vertices	-	Vertices of the mesh.
+	indices		-	Index buffer of the mesh, the LOD's range is reordered.
+	lod			-	Range of the index buffer to split.
+	meshlets	-	Receives the meshlets.
+*/
+void MeshletBuilder::Build(const vector<Vertex>& vertices, vector<GLuint>& indices, const MeshLod& lod, vector<Meshlet>& meshlets)
+{
+	meshlets.clear();
+
+	size_t triangleCount = lod.indexCount / 3;
+	const GLuint* triangles = indices.empty() ? NULL : &indices[lod.firstIndex];
+	if (triangleCount == 0)
+		return;
+
+	// Triangles around every position, so meshlets also grow across normal and UV seams.
+	vector<GLuint> positions;
+	MapPositions(vertices, positions);
+
+	vector<unsigned int> triangleOffsets(vertices.size() + 1, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		++triangleOffsets[positions[triangles[i]] + 1];
+	for (size_t v = 0; v < vertices.size(); ++v)
+		triangleOffsets[v + 1] += triangleOffsets[v];
+
+	vector<unsigned int> vertexTriangles(triangleCount * 3);
+	vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		vertexTriangles[fill[positions[triangles[i]]]++] = (unsigned int)(i / 3);
+
+	vector<glm::vec3> centers(triangleCount), normals(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		const glm::vec3& p0 = vertices[triangles[t * 3]].Position;
+		const glm::vec3& p1 = vertices[triangles[t * 3 + 1]].Position;
+		const glm::vec3& p2 = vertices[triangles[t * 3 + 2]].Position;
+		centers[t] = (p0 + p1 + p2) / 3.0f;
+
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(normal);
+		normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+	}
+
+	vector<bool> emitted(triangleCount, false);
+	vector<unsigned int> usedBy(vertices.size(), NO_MESHLET);
+	vector<GLuint> ordered;
+	ordered.reserve(triangleCount * 3);
+
+	vector<GLuint> meshletVertices;
+	size_t nextSeed = 0;
+
+	while (ordered.size() < triangleCount * 3)
+	{
+		unsigned int id = (unsigned int)meshlets.size();
+		Meshlet meshlet;
+		meshlet.firstIndex = lod.firstIndex + (GLuint)ordered.size();
+		meshlet.indexCount = 0;
+		meshletVertices.clear();
+
+		glm::vec3 centerSum(0.0f), normalSum(0.0f);
+
+		// Start at the first triangle that is left, in the vertex cache order.
+		while (emitted[nextSeed])
+			++nextSeed;
+		long long next = (long long)nextSeed;
+
+		while (next >= 0)
+		{
+			size_t t = (size_t)next;
+			emitted[t] = true;
+			for (int k = 0; k < 3; ++k)
+			{
+				GLuint v = triangles[t * 3 + k];
+				ordered.push_back(v);
+				if (usedBy[v] != id)
+				{
+					usedBy[v] = id;
+					meshletVertices.push_back(v);
+				}
+			}
+			meshlet.indexCount += 3;
+			centerSum += centers[t];
+			normalSum += normals[t];
+
+			if (meshlet.indexCount / 3 == MESHLET_MAX_TRIANGLES)
+				break;
+
+			// Grow into the neighbour that adds the fewest vertices, then the closest and most aligned one.
+			glm::vec3 center = centerSum / (float)(meshlet.indexCount / 3);
+			float normalLength = glm::length(normalSum);
+			glm::vec3 axis = normalLength > 0.0f ? normalSum / normalLength : glm::vec3(0.0f);
+
+			next = -1;
+			unsigned int bestNew = 4;
+			float bestScore = 0.0f;
+			for (size_t m = 0; m < meshletVertices.size(); ++m)
+			{
+				GLuint v = positions[meshletVertices[m]];
+				for (unsigned int a = triangleOffsets[v]; a < triangleOffsets[v + 1]; ++a)
+				{
+					unsigned int candidate = vertexTriangles[a];
+					if (emitted[candidate])
+						continue;
+
+					unsigned int newVertices = 0;
+					for (int k = 0; k < 3; ++k)
+						newVertices += (usedBy[triangles[candidate * 3 + k]] != id) ? 1 : 0;
+					if (meshletVertices.size() + newVertices > MESHLET_MAX_VERTICES)
+						continue;
+
+					float score = glm::length(centers[candidate] - center) * (2.0f - glm::dot(normals[candidate], axis));
+					if (newVertices < bestNew || (newVertices == bestNew && score < bestScore))
+					{
+						next = candidate;
+						bestNew = newVertices;
+						bestScore = score;
+					}
+				}
+			}
+		}
+
+		ComputeBounds(vertices, ordered, meshlet.firstIndex - lod.firstIndex, meshlet);
+		meshlets.push_back(meshlet);
+	}
+
+	std::copy(ordered.begin(), ordered.end(), indices.begin() + lod.firstIndex);
+}
+
+/*
+	Fills in the bounding sphere and normal cone of a
+	meshlet from its triangles. The sphere is centered on
+	the bounding box, the cone's axis is the average of
+	the triangle normals.
+
+	vertices	-	Vertices of the mesh.
+	indices		-	Indices the meshlet's triangles are in.
+	first		-	Index of the meshlet's first triangle in indices.
+	meshlet		-	Meshlet with its index count set.
+*/
+void MeshletBuilder::ComputeBounds(const vector<Vertex>& vertices, const vector<GLuint>& indices, GLuint first, Meshlet& meshlet)
+{
+	GLuint last = first + meshlet.indexCount;
+
+	glm::vec3 boundsMin = vertices[indices[first]].Position, boundsMax = boundsMin;
+	for (GLuint i = first; i < last; ++i)
+	{
+		boundsMin = glm::min(boundsMin, vertices[indices[i]].Position);
+		boundsMax = glm::max(boundsMax, vertices[indices[i]].Position);
+	}
+
+	meshlet.center = (boundsMin + boundsMax) * 0.5f;
+	meshlet.radius = 0.0f;
+	for (GLuint i = first; i < last; ++i)
+		meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].Position - meshlet.center));
+
+	// Unit normals, so that large triangles don't hide the direction of small ones.
+	vector<glm::vec3> normals;
+	normals.reserve(meshlet.indexCount / 3);
+	glm::vec3 axis(0.0f);
+	for (GLuint i = first; i < last; i += 3)
+	{
+		const glm::vec3& p0 = vertices[indices[i]].Position;
+		glm::vec3 normal = glm::cross(vertices[indices[i + 1]].Position - p0, vertices[indices[i + 2]].Position - p0);
+		float length = glm::length(normal);
+		if (length <= 0.0f)
+			continue;
+
+		normals.push_back(normal / length);
+		axis += normals.back();
+	}
+
+	meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+	meshlet.coneCutoff = 1.0f;
+
+	float axisLength = glm::length(axis);
+	if (axisLength <= 0.0f)
+		return;
+	axis /= axisLength;
+
+	float minDot = 1.0f;
+	for (size_t n = 0; n < normals.size(); ++n)
+		minDot = std::min(minDot, glm::dot(axis, normals[n]));
+
+	meshlet.coneAxis = axis;
+	if (minDot > MIN_CONE_DOT)
+		meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+}
\ No newline at end of file
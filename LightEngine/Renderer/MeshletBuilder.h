@@ -0,0 +1,28 @@
+#pragma once
+
+// Includes.
+#include "Mesh.h"
+
+/*
+	Splits LOD 0 of a mesh into meshlets for the
+	ClusterCuller.
+
+	A meshlet starts at the first triangle left in the
+	vertex cache order and grows into neighbouring
+	triangles, preferring those that add the fewest
+	vertices, lie closest and face the same way, so the
+	bounding spheres stay small and the normal cones
+	narrow. It ends when no neighbour fits in
+	MESHLET_MAX_VERTICES and MESHLET_MAX_TRIANGLES. The
+	triangles are reordered meshlet by meshlet, so each is
+	a consecutive range of the index buffer.
+*/
+class MeshletBuilder
+{
+public:
+
+// Functions
+
+	static void Build(const vector<Vertex>& vertices, vector<GLuint>& indices, const MeshLod& lod, vector<Meshlet>& meshlets);
+	static void ComputeBounds(const vector<Vertex>& vertices, const vector<GLuint>& indices, GLuint first, Meshlet& meshlet);
+};
\ No newline at end of file
@@ -1,133 +1,535 @@
 #include "Model.h"
 
+bool Model::lodEnabled = true;
+float Model::lodPixelErrors[LOD_PASS_COUNT] = { MODEL_LOD_PIXEL_ERROR_MAIN, MODEL_LOD_PIXEL_ERROR_SHADOW };
+bool Model::clusterCullingEnabled = true;
+
 /*
-	Helper global function to load Texture using SOIL
-	from a given file in a directory and set the
-	appropriate parameters.
+	Helper global function to load a Texture from a given
+	file in a directory. The image is streamed in by the
+	TextureStreamer, the texture holds a placeholder until
+	it has arrived. Files that are already loaded are
+	shared through the TextureCache.
 
 	path		-	path to the file in memory.
 	directory	-	directory in which the texture file is located.
 */
 GLint TextureFromFile(const char* path, string directory)
 {
-	//Generate texture ID and load texture data 
-	string filename = string(path);
-	filename = directory + '/' + filename;
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-	int width, height;
-	unsigned char* image = SOIL_load_image(filename.c_str(), &width, &height, 0, SOIL_LOAD_RGB);
-
-	// Assign texture to ID
-	glBindTexture(GL_TEXTURE_2D, textureID);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	// Parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	SOIL_free_image_data(image);
-
-	log("Texture Loaded.");
+	string filename = directory + '/' + string(path);
+	return TextureCache::Acquire2D(filename.c_str(), MODEL_TEXTURE_FORMAT);
+}
 
-	return textureID;
+/*
+	Default constructor, the model has no meshes until
+	Upload().
+*/
+Model::Model()
+{
+	this->computeBoundingSphere();
 }
 
 /*
 	Constructor, expects a filepath to a 3D Wavefront's .obj model.
 
 	path	-	path to the model that is to be loaded.
+	pool	-	Threads to import on, NULL to import on this one.
 */
-Model::Model(GLchar* path)
+Model::Model(GLchar* path, ThreadPool* pool)
 {
-	this->loadModel(path);
+	ModelLoad load;
+	Prepare(path, load, pool);
+	this->Upload(load);
 }
 
 /*
-	Renders the model by iteratively going through
-	all of its meshes' Draw() function.
+	Destructor, gives the meshes' geometry back to the
+	GeometryPool and their textures to the TextureCache,
+	which deletes the ones nobody else holds. Needs the
+	context.
+*/
+Model::~Model()
+{
+	for (GLuint i = 0; i < this->meshes.size(); i++)
+	{
+		this->meshes[i].Release();
+		for (GLuint t = 0; t < this->meshes[i].textures.size(); t++)
+			TextureCache::Release(this->meshes[i].textures[t].id);
+	}
+}
+
+/*
+	Renders the model by going through its meshes in
+	order, drawing every run of meshes that can be batched
+	(see Mesh::CanBatchWith()) with one Mesh::DrawBatch().
+	Afterwards the geometry pool is unbound and the
+	shader's vertex decode is reset, so it can draw
+	unquantized geometry again.
 
 	shader	-	Shader that is used to render the mesh.
+	pass	-	Pass whose selected LODs are drawn.
+*/
+void Model::Draw(Shader& shader, LodPass pass)
+{
+	GLuint first = 0;
+	while (first < this->meshes.size())
+	{
+		GLuint last = first + 1;
+		while (last < this->meshes.size() && this->meshes[first].CanBatchWith(this->meshes[last], pass))
+			++last;
+
+		Mesh::DrawBatch(shader, pass, &this->meshes[first], last - first);
+		first = last;
+	}
+
+	GeometryPool::Unbind();
+	Mesh::ResetVertexDecode(shader);
+}
+
+/*
+	Selects the LOD every mesh is drawn with in a pass,
+	from how large its error appears on screen at the
+	nearest point of the model's bounding sphere. A mesh
+	only switches to a coarser LOD once its error is
+	MODEL_LOD_HYSTERESIS below the pass' pixel error, so
+	it doesn't flicker between two LODs at the threshold.
+
+	pass			-	Pass the LODs are selected for.
+	model			-	Model matrix it is drawn with.
+	view			-	View matrix of the pass.
+	projection		-	Projection matrix of the pass, perspective
+						or orthographic.
+	viewportHeight	-	Height of the pass' viewport in pixels.
+*/
+void Model::SelectLod(LodPass pass, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, float viewportHeight)
+{
+	// Errors are in object units, the largest axis scale makes them world units.
+	float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+
+	// Pixels per world unit : constant for orthographic projections, falling with the distance for perspective ones.
+	float pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f;
+	if (projection[3][3] != 1.0f)
+	{
+		glm::vec4 center = view * model * glm::vec4(this->boundsCenter, 1.0f);
+		pixelsPerUnit /= std::max(-center.z - this->boundsRadius * scale, MODEL_LOD_MIN_DISTANCE);
+	}
+
+	float pixelError = lodPixelErrors[pass];
+	for (GLuint i = 0; i < this->meshes.size(); i++)
+	{
+		Mesh& mesh = this->meshes[i];
+		unsigned int current = mesh.GetLod(pass);
+		unsigned int lod = 0;
+
+		if (lodEnabled)
+		{
+			for (lod = (unsigned int)mesh.lods.size() - 1; lod > 0; --lod)
+			{
+				float pixels = mesh.lods[lod].error * scale * pixelsPerUnit;
+				if (pixels <= (lod > current ? pixelError * (1.0f - MODEL_LOD_HYSTERESIS) : pixelError))
+					break;
+			}
+		}
+
+		mesh.SetLod(pass, lod);
+	}
+}
+
+/*
+	Turns the LODs of all models on or off. While off,
+	SelectLod() selects the full meshes.
+
+	enabled	-	Whether SelectLod() may pick coarser LODs.
+*/
+void Model::SetLodEnabled(bool enabled)
+{
+	lodEnabled = enabled;
+}
+
+/*
+	Whether SelectLod() may pick coarser LODs.
+*/
+bool Model::IsLodEnabled(void)
+{
+	return lodEnabled;
+}
+
+/*
+	Sets the largest error a pass' LODs may show.
+
+	pass	-	Pass to set it for.
+	pixels	-	Error on screen, in pixels.
+*/
+void Model::SetLodPixelError(LodPass pass, float pixels)
+{
+	lodPixelErrors[pass] = pixels;
+}
+
+/*
+	Culls the meshlets of every mesh for the next Draw()
+	of the main pass, and counts the clusters and triangles
+	culled in the Telemetry. Call it after SelectLod() :
+	only meshes drawn at LOD 0 are culled.
+
+	model			-	Model matrix it is drawn with.
+	view			-	View matrix of the camera.
+	projection		-	Perspective projection of the camera.
+	cameraPosition	-	Camera position in world space.
 */
-void Model::Draw(Shader shader)
+void Model::CullClusters(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition)
 {
+	if (!clusterCullingEnabled)
+		return;
+
+	PROFILE_SCOPE("Model::CullClusters");
+
+	glm::mat4 modelViewProjection = projection * view * model;
+	glm::vec3 viewer = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+
 	for (GLuint i = 0; i < this->meshes.size(); i++)
-		this->meshes[i].Draw(shader);
+	{
+		ClusterCullStats stats;
+		this->meshes[i].CullClusters(modelViewProjection, viewer, stats);
+		Telemetry::CountClusters(stats.clusters, stats.clustersCulled, stats.trianglesCulled);
+	}
 }
 
 /*
-	Loads a model with supported ASSIMP extensions from file
-	and stores the resulting meshes in the meshes vector.
+	Turns the cluster culling of all models on or off.
+	While off, CullClusters() does nothing.
 
-	path	-	complete path to the texture file.
+	enabled	-	Whether CullClusters() culls.
 */
-void Model::loadModel(string path)
+void Model::SetClusterCullingEnabled(bool enabled)
 {
-	// Read file via ASSIMP
+	clusterCullingEnabled = enabled;
+}
+
+/*
+	Whether CullClusters() culls.
+*/
+bool Model::IsClusterCullingEnabled(void)
+{
+	return clusterCullingEnabled;
+}
+
+/*
+	Bounding sphere around the bounding boxes of all
+	meshes, which SelectLod() measures the distance to.
+*/
+void Model::computeBoundingSphere(void)
+{
+	if (this->meshes.empty())
+	{
+		this->boundsCenter = glm::vec3(0.0f);
+		this->boundsRadius = 0.0f;
+		return;
+	}
+
+	glm::vec3 boundsMin = this->meshes[0].boundsMin, boundsMax = this->meshes[0].boundsMax;
+	for (GLuint i = 1; i < this->meshes.size(); i++)
+	{
+		boundsMin = glm::min(boundsMin, this->meshes[i].boundsMin);
+		boundsMax = glm::max(boundsMax, this->meshes[i].boundsMax);
+	}
+
+	this->boundsCenter = (boundsMin + boundsMax) * 0.5f;
+	this->boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+}
+
+/*
+	Loads everything of a model that doesn't need OpenGL,
+	so it can run on any thread. A fresh mesh cache is
+	mapped instead of reading the file itself, otherwise
+	the model is imported and the cache rebuilt. Returns
+	false if the import failed.
+
+	path	-	complete path to the model file.
+	load	-	Receives what Upload() needs.
+	pool	-	Threads to import on, may be NULL. Not the
+				pool this runs on, if it runs on one.
+*/
+bool Model::Prepare(const string& path, ModelLoad& load, ThreadPool* pool)
+{
+	PROFILE_SCOPE_DETAIL("Model::Prepare", path.c_str());
+
+	double start = getTimeElapsed();
+
+	load.path = path;
+	load.sources.clear();
+	load.threads = pool != NULL ? pool->GetThreadCount() : 1;
+
+	string cachePath = GetCachePath(path);
+	load.cached = MeshCache::IsFresh(cachePath.c_str(), path.c_str()) && load.cache.Open(cachePath.c_str());
+	if (load.cached)
+	{
+		load.prepareTime = getTimeElapsed() - start;
+		return true;
+	}
+
+	bool imported = Import(path, load.sources, pool);
+	if (imported)
+		MeshCache::Write(cachePath.c_str(), load.sources);
+
+	load.prepareTime = getTimeElapsed() - start;
+	return imported;
+}
+
+/*
+	Creates the meshes of a prepared model, on the thread
+	that owns the context. The load's CPU-side data is
+	released afterwards.
+
+	load	-	Filled by Prepare().
+*/
+void Model::Upload(ModelLoad& load)
+{
+	PROFILE_SCOPE_DETAIL("Model::Upload", load.path.c_str());
+
+	double start = getTimeElapsed();
+
+	// Retrieve the directory path of the filepath
+	this->directory = load.path.substr(0, load.path.find_last_of('/'));
+
+	if (load.cached)
+		this->loadFromCache(load.cache);
+	else
+		this->loadFromSources(load.sources);
+
+	this->computeBoundingSphere();
+
+	double uploadTime = getTimeElapsed() - start;
+	if (load.cached)
+	{
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "Model loaded from mesh cache in %.1f ms (upload %.1f ms): %s",
+			(load.prepareTime + uploadTime) * 1000.0, uploadTime * 1000.0, load.path.c_str());
+	}
+	else if (!this->meshes.empty())
+	{
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "Model loaded with Assimp in %.1f ms (import %.1f ms on %u thread(s), upload %.1f ms): %s",
+			(load.prepareTime + uploadTime) * 1000.0, load.prepareTime * 1000.0, load.threads, uploadTime * 1000.0, load.path.c_str());
+	}
+
+	load.cache.Close();
+	vector<MeshSource>().swap(load.sources);
+}
+
+/*
+	Creates the meshes from imported mesh data.
+
+	sources	-	Meshes imported by Import(), in scene graph order.
+*/
+void Model::loadFromSources(const vector<MeshSource>& sources)
+{
+	// Upload queue : GL objects can only be created on the context's thread, in scene graph order.
+	for (GLuint i = 0; i < sources.size(); i++)
+	{
+		const MeshSource& source = sources[i];
+		GLuint vertexCount = (GLuint)source.vertices.size();
+		const void* vertexData = source.packedVertices.empty() ? NULL : &source.packedVertices[0];
+
+		glm::vec3 boundsMin, boundsMax;
+		Mesh::ComputeBounds(source.vertices.empty() ? NULL : &source.vertices[0], vertexCount, boundsMin, boundsMax);
+
+		if (Mesh::GetIndexType(vertexCount) == GL_UNSIGNED_SHORT)
+		{
+			vector<GLushort> shortIndices(source.indices.begin(), source.indices.end());
+			this->meshes.push_back(Mesh(vertexData, source.vertexFormat, vertexCount, shortIndices.empty() ? NULL : &shortIndices[0], GL_UNSIGNED_SHORT, (GLuint)shortIndices.size(),
+				this->loadTextures(source.textures), source.decode, boundsMin, boundsMax, source.lods, source.meshlets));
+		}
+		else
+		{
+			this->meshes.push_back(Mesh(vertexData, source.vertexFormat, vertexCount, source.indices.empty() ? NULL : &source.indices[0], GL_UNSIGNED_INT, (GLuint)source.indices.size(),
+				this->loadTextures(source.textures), source.decode, boundsMin, boundsMax, source.lods, source.meshlets));
+		}
+	}
+}
+
+/*
+	Imports a model with Assimp into CPU-side meshes,
+	without touching OpenGL, so it can also run without
+	a context. Assimp reads the file through the
+	FileSystem on this thread, then every mesh is
+	converted and run through the MeshOptimizer as its
+	own task on the pool. Vertices are quantized within
+	VertexQuantizer::GetErrorBounds().
+
+	path	-	complete path to the model file.
+	meshes	-	Receives the meshes in scene graph order.
+	pool	-	Threads to convert the meshes on, NULL to
+				convert them on this one.
+*/
+bool Model::Import(const string& path, vector<MeshSource>& meshes, ThreadPool* pool)
+{
+	PROFILE_SCOPE_DETAIL("Model::Import", path.c_str());
+
+	// Read file via ASSIMP, from the pack if it holds the model
 	Assimp::Importer importer;
+	importer.SetIOHandler(new AssimpIOSystem(pool));
 	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
 	// Check for errors
 	if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
 	{
-		cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-		return;
+		LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_ASSET, "Assimp: %s", importer.GetErrorString());
+		return false;
 	}
-	// Retrieve the directory path of the filepath
-	this->directory = path.substr(0, path.find_last_of('/'));
 
-	// Process ASSIMP's root node recursively
-	this->processNode(scene->mRootNode, scene);
+	// Gather the meshes of ASSIMP's root node recursively
+	vector<aiMesh*> sceneMeshes;
+	processNode(scene->mRootNode, scene, sceneMeshes);
+
+	// The scene is only read from here on, so the meshes can be converted and optimized concurrently.
+	size_t first = meshes.size();
+	meshes.resize(first + sceneMeshes.size());
+	vector<MeshOptimizeStats> stats(sceneMeshes.size());
+	VertexErrorBounds errorBounds = VertexQuantizer::GetErrorBounds();
+
+	std::function<void(unsigned int)> convert = [&](unsigned int i)
+	{
+		processMesh(sceneMeshes[i], scene, meshes[first + i]);
+		MeshOptimizer::Optimize(meshes[first + i], errorBounds, stats[i]);
+	};
+
+	if (pool != NULL)
+		pool->ParallelFor((unsigned int)sceneMeshes.size(), convert);
+	else
+		for (unsigned int i = 0; i < sceneMeshes.size(); i++)
+			convert(i);
 
-	log("Model loaded successfully.");
+	logOptimizeStats(path, stats);
+	return true;
+}
+
+/*
+	Logs what MeshOptimizer did to every mesh of a model,
+	and the totals at info level.
+
+	path	-	complete path to the model file.
+	stats	-	Stats of the model's meshes.
+*/
+void Model::logOptimizeStats(const string& path, const vector<MeshOptimizeStats>& stats)
+{
+	double triangles = 0.0, verticesBefore = 0.0, verticesAfter = 0.0;
+	double missesBefore = 0.0, missesAfter = 0.0;
+	double bytesBefore = 0.0, bytesAfter = 0.0;
+	double lodTriangles[MESH_MAX_LODS] = { 0.0 };
+
+	for (GLuint i = 0; i < stats.size(); i++)
+	{
+		const MeshOptimizeStats& mesh = stats[i];
+		LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_ASSET, "Mesh %u : %u triangles, %u -> %u vertices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %.1f -> %.1f KB (%s, %u bytes per vertex).",
+			i, mesh.triangleCount, mesh.verticesBefore, mesh.verticesAfter, mesh.acmrBefore, mesh.acmrAfter, mesh.atvrBefore, mesh.atvrAfter,
+			mesh.gpuBytesBefore / 1024.0, mesh.gpuBytesAfter / 1024.0, GetVertexFormatName(mesh.vertexFormat), (unsigned int)GetVertexFormatStride(mesh.vertexFormat));
+		LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_ASSET, "Mesh %u : %u LOD(s), down to %u triangles, %u meshlets.", i, mesh.lodCount, mesh.lodTriangles[mesh.lodCount - 1], mesh.meshletCount);
+
+		// Meshes with fewer LODs count their coarsest one in the coarser totals.
+		for (unsigned int l = 0; l < MESH_MAX_LODS; l++)
+			lodTriangles[l] += mesh.lodTriangles[std::min(l, mesh.lodCount - 1)];
+
+		triangles += mesh.triangleCount;
+		verticesBefore += mesh.verticesBefore;
+		verticesAfter += mesh.verticesAfter;
+		missesBefore += mesh.acmrBefore * mesh.triangleCount;
+		missesAfter += mesh.acmrAfter * mesh.triangleCount;
+		bytesBefore += (double)mesh.gpuBytesBefore;
+		bytesAfter += (double)mesh.gpuBytesAfter;
+	}
+
+	if (triangles == 0.0)
+		return;
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "Optimized %s : %.0f -> %.0f vertices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, GPU memory %.1f -> %.1f KB.",
+		path.c_str(), verticesBefore, verticesAfter, missesBefore / triangles, missesAfter / triangles,
+		missesBefore / verticesBefore, missesAfter / verticesAfter, bytesBefore / 1024.0, bytesAfter / 1024.0);
+
+	stringstream lods;
+	for (unsigned int l = 0; l < MESH_MAX_LODS; l++)
+		lods << (l > 0 ? " / " : "") << (unsigned int)lodTriangles[l];
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "LODs of %s : %s triangles.", path.c_str(), lods.str().c_str());
+}
+
+/*
+	Path of the mesh cache that belongs to a model.
+
+	path	-	complete path to the model file.
+*/
+string Model::GetCachePath(const string& path)
+{
+	return path + ".lemc";
+}
+
+/*
+	Creates the meshes from a mesh cache. The vertex and
+	index data is uploaded straight from the mapped file.
+
+	cache	-	Opened mesh cache of the model.
+*/
+void Model::loadFromCache(const MeshCache& cache)
+{
+	for (GLuint i = 0; i < cache.GetMeshCount(); i++)
+	{
+		const MeshCacheMesh& mesh = cache.GetMesh(i);
+
+		vector<MeshTextureRef> refs(mesh.textureCount);
+		for (GLuint t = 0; t < mesh.textureCount; t++)
+		{
+			refs[t].path = cache.GetTexture(mesh.firstTexture + t).path;
+			refs[t].type = cache.GetTexture(mesh.firstTexture + t).type;
+		}
+
+		this->meshes.push_back(Mesh(cache.GetVertices(mesh), MeshCache::GetVertexFormat(mesh), mesh.vertexCount, cache.GetIndices(mesh), MeshCache::GetIndexType(mesh), mesh.indexCount,
+			this->loadTextures(refs), MeshCache::GetVertexDecode(mesh),
+			glm::vec3(mesh.boundsMin[0], mesh.boundsMin[1], mesh.boundsMin[2]),
+			glm::vec3(mesh.boundsMax[0], mesh.boundsMax[1], mesh.boundsMax[2]),
+			MeshCache::GetLods(mesh), vector<Meshlet>(cache.GetMeshlets(mesh), cache.GetMeshlets(mesh) + mesh.meshletCount)));
+	}
 }
 
 /*
 	Recursive function that processes a node in a recursive fashion.
-	Processes each individual mesh located at the node and repeats
+	Collects each individual mesh located at the node and repeats
 	this process on its children nodes (if any).
 
 	node	-	one node belonging to the ASSIMP's scenegraph.
 	scene	-	scene that is loaded by ASSIMP.
+	meshes	-	Receives the meshes in scene graph order.
 */
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::processNode(aiNode* node, const aiScene* scene, vector<aiMesh*>& meshes)
 {
 	// Process each mesh located at the current node
 	for (GLuint i = 0; i < node->mNumMeshes; i++)
 	{
 		// The node object only contains indices to index the actual objects in the scene. 
 		// The scene contains all the data, node is just to keep stuff organized.
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		this->meshes.push_back(this->processMesh(mesh, scene));
+		meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
 	}
 	// After we've processed all of the meshes (if any) we then recursively process each of the children nodes
 	for (GLuint i = 0; i < node->mNumChildren; i++)
 	{
 		// Child nodes are actually stored in the node, not in the scene (which makes sense since nodes only contain
 		// links and indices, nothing more, so why store that in the scene)
-		this->processNode(node->mChildren[i], scene);
+		processNode(node->mChildren[i], scene, meshes);
 	}
 
 }
 
 /*
-	Creates a Mesh object from a loaded aiMesh object.
-	Extracts vertices, normals, indices ,texture co-ordinates
-	and the textures from the aiMesh object and instantiates
-	a Mesh object constructed from the above loaded data.
+	Extracts vertices, normals, indices, texture co-ordinates
+	and the texture references from a loaded aiMesh object.
+	Runs on the import's worker threads, so it must only
+	read the scene.
 
 	mesh	-	mesh object which is under processing.
 	scene	-	the scene which is currently being described.
+	source	-	Receives the extracted mesh data.
 */
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+void Model::processMesh(aiMesh* mesh, const aiScene* scene, MeshSource& source)
 {
 	// Data to fill
-	vector<Vertex> vertices;
-	vector<GLuint> indices;
-	vector<Texture> textures;
-
+	vector<Vertex>& vertices = source.vertices;
+	vector<GLuint>& indices = source.indices;
+	vertices.reserve(mesh->mNumVertices);
+	indices.reserve(mesh->mNumFaces * 3);
 	// Walk through each of the mesh's vertices
 	for (GLuint i = 0; i < mesh->mNumVertices; i++)
 	{
@@ -178,59 +580,59 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 		// Reflection	: texture_reflectionN
 
 		// 1. Diffuse maps
-		vector<Texture> diffuseMaps = this->loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+		getMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", source.textures);
 
 		// 2. Specular maps
-		vector<Texture> specularMaps = this->loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+		getMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", source.textures);
 
 		// 3. Reflection maps (Note that ASSIMP doesn't load reflection maps properly from wavefront objects, so we'll cheat a little by defining the reflection maps as ambient maps in the .obj file, which ASSIMP is able to load)
-		vector<Texture> reflectionMaps = this->loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_reflection");
-		textures.insert(textures.end(), reflectionMaps.begin(), reflectionMaps.end());
+		getMaterialTextures(material, aiTextureType_AMBIENT, "texture_reflection", source.textures);
 	}
-
-	// Return a mesh object created from the extracted mesh data
-	return Mesh(vertices, indices, textures);
 }
 
 /*
-	Checks all material textures of a given type and
-	loads the textures if they're not loaded yet.
-	The required info is returned as a Texture struct.
+	Appends the paths of all material textures of a
+	given type.
 
 	mat				-	ASSIMP's data structure to hold information
 						about the materials used in the scene.
 	aiTextureType	-	refer to the type of texture involved : 
 						diffuse, normal, environmental and specular maps.
+	typeName		-	Sampler prefix stored with each texture.
+	refs			-	Receives the texture references.
 */
-vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
+void Model::getMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName, vector<MeshTextureRef>& refs)
 {
-	vector<Texture> textures;
 	for (GLuint i = 0; i < mat->GetTextureCount(type); i++)
 	{
 		aiString str;
 		mat->GetTexture(type, i, &str);
-		// Check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-		GLboolean skip = false;
-		for (GLuint j = 0; j < textures_loaded.size(); j++)
-		{
-			if (textures_loaded[j].path == str)
-			{
-				textures.push_back(textures_loaded[j]);
-				skip = true; // A texture with the same filepath has already been loaded, continue to next one. (optimization)
-				break;
-			}
-		}
-		if (!skip)
-		{   // If texture hasn't been loaded already, load it
-			Texture texture;
-			texture.id = TextureFromFile(str.C_Str(), this->directory);
-			texture.type = typeName;
-			texture.path = str;
-			textures.push_back(texture);
-			this->textures_loaded.push_back(texture);  // Store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-		}
+
+		MeshTextureRef ref;
+		ref.path = str.C_Str();
+		ref.type = typeName;
+		refs.push_back(ref);
+	}
+}
+
+/*
+	Loads the textures of a mesh. Textures that are used
+	more than once, in this model or anywhere else, are
+	shared by the TextureCache.
+	The required info is returned as Texture structs.
+
+	refs	-	Texture references of the mesh.
+*/
+vector<Texture> Model::loadTextures(const vector<MeshTextureRef>& refs)
+{
+	vector<Texture> textures;
+	for (GLuint i = 0; i < refs.size(); i++)
+	{
+		Texture texture;
+		texture.id = TextureFromFile(refs[i].path.c_str(), this->directory);
+		texture.type = refs[i].type;
+		texture.path = aiString(refs[i].path);
+		textures.push_back(texture);
 	}
 	return textures;
 }
\ No newline at end of file
@@ -13,25 +13,88 @@ using namespace std;
 #include "..\Contrib\Include\gl\glew.h"
 #include "..\Contrib\Include\glm\glm.hpp"
 #include "..\Contrib\Include\glm\gtc\matrix_transform.hpp"
-#include "..\Contrib\Include\SOIL.h"
 #include "..\Contrib\Include\assimp\Importer.hpp"
 #include "..\Contrib\Include\assimp\scene.h"
 #include "..\Contrib\Include\assimp\postprocess.h"
 
 #include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "AssimpIOSystem.h"
+#include "..\Util\ThreadPool.h"
+#include "..\Util\TextureCache.h"
+
+// Largest error of a selected LOD on screen, in pixels, per LodPass.
+const float MODEL_LOD_PIXEL_ERROR_MAIN = 1.0f;
+const float MODEL_LOD_PIXEL_ERROR_SHADOW = 4.0f;
+
+// How far below the pixel error a coarser LOD has to be before it is selected.
+const float MODEL_LOD_HYSTERESIS = 0.2f;
+
+// Closest the bounding sphere is treated as to the camera, in world units.
+const float MODEL_LOD_MIN_DISTANCE = 0.01f;
+
+// Format the textures of the materials are asked for in.
+const GLint MODEL_TEXTURE_FORMAT = GL_RGB;
 
 // Function prototypes.
 GLint TextureFromFile(const char* path, string directory);
 
+/*
+	CPU side of loading a model : filled by Model::Prepare()
+	on any thread, turned into meshes by Model::Upload() on
+	the thread that owns the context.
+
+	path		-	Model file.
+	cached		-	Whether the meshes are read from cache,
+					otherwise they are in sources.
+	cache		-	Mapped mesh cache of the model.
+	sources		-	Meshes imported with Assimp.
+	prepareTime	-	Seconds Prepare() took.
+	threads		-	Threads the meshes were converted on.
+*/
+struct ModelLoad
+{
+	string				path;
+	bool				cached;
+	MeshCache			cache;
+	vector<MeshSource>	sources;
+	double				prepareTime;
+	unsigned int		threads;
+};
+
 /*
 	Model class that holds all the model data
 	loaded using Assimp's Scene Importer. This
 	class holds a vector of all the meshes that
-	compose the model, the directory where the
-	model is stored and a vector of all the
-	textures that have been loaded so far so as
-	to optimize the model loading function by not
-	loading the same texture more than once.
+	compose the model and the directory where the
+	model is stored. Textures are shared through
+	the TextureCache, so the same texture is never
+	loaded more than once.
+
+	The imported meshes are saved to a MeshCache next
+	to the model (see GetCachePath()), which is used
+	instead of Assimp as long as it is newer than the
+	model file.
+
+	Imports convert their meshes in parallel on a
+	ThreadPool; the GL objects are created afterwards on
+	the calling thread, which must own the context. To
+	load without blocking that thread, run Prepare() on
+	another one and Upload() the result into a default
+	constructed model.
+
+	Every mesh has a chain of LODs. SelectLod() picks for
+	each pass the coarsest one whose error projects to
+	less than the pass' pixel error, so shadow maps can
+	use coarser LODs than the camera view. CullClusters()
+	then rejects the meshlets of meshes drawn at LOD 0
+	that are off-screen or facing away.
+
+	The meshes' geometry lives in the shared GeometryPool,
+	so drawing the model doesn't switch buffers and draws
+	meshes with the same textures and vertex decode in a
+	single call.
 */
 class Model
 {
@@ -39,8 +102,21 @@ public:
 
 // Functions
 
-	Model(GLchar* path);
-	void Draw(Shader shader);
+	Model();
+	Model(GLchar* path, ThreadPool* pool = NULL);
+	static bool Prepare(const string& path, ModelLoad& load, ThreadPool* pool = NULL);
+	void Upload(ModelLoad& load);
+	~Model();
+	void Draw(Shader& shader, LodPass pass = LOD_PASS_MAIN);
+	void SelectLod(LodPass pass, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, float viewportHeight);
+	static void SetLodEnabled(bool enabled);
+	static bool IsLodEnabled(void);
+	static void SetLodPixelError(LodPass pass, float pixels);
+	void CullClusters(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition);
+	static void SetClusterCullingEnabled(bool enabled);
+	static bool IsClusterCullingEnabled(void);
+	static bool Import(const string& path, vector<MeshSource>& meshes, ThreadPool* pool = NULL);
+	static string GetCachePath(const string& path);
 
 private:
 
@@ -48,13 +124,24 @@ private:
 
 	vector<Mesh> meshes;
 	string directory;
-	vector<Texture> textures_loaded;
+
+	// Object-space bounding sphere of all meshes.
+	glm::vec3 boundsCenter;
+	float boundsRadius;
+
+	static bool lodEnabled;
+	static float lodPixelErrors[LOD_PASS_COUNT];
+	static bool clusterCullingEnabled;
 
 // Functions
 
-	void loadModel(string path);
-	void processNode(aiNode* node, const aiScene* scene);
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene);
-	vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName);
+	void loadFromCache(const MeshCache& cache);
+	void loadFromSources(const vector<MeshSource>& sources);
+	void computeBoundingSphere(void);
+	vector<Texture> loadTextures(const vector<MeshTextureRef>& refs);
+	static void processNode(aiNode* node, const aiScene* scene, vector<aiMesh*>& meshes);
+	static void processMesh(aiMesh* mesh, const aiScene* scene, MeshSource& source);
+	static void logOptimizeStats(const string& path, const vector<MeshOptimizeStats>& stats);
+	static void getMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName, vector<MeshTextureRef>& refs);
 
 };
\ No newline at end of file
@@ -2,6 +2,11 @@
 
 const float slowdown = 1.0f;			// Slow Down Particles
 
+// Name hashes of the uniforms set while rendering.
+const unsigned int VISIBILITY_UNIFORM = Shader::HashName("visibility");
+const unsigned int TEXTURE_UNIFORM = Shader::HashName("particleTexture");
+const unsigned int MODEL_UNIFORM = Shader::HashName("model");
+
 // Vertex data for all the particles (Rendered as textured quads).
 GLfloat particleVertices[] = {
 	// Positions   // TexCoords
@@ -97,40 +102,23 @@ void ParticleSystem::InitParticleSystem(bool fixedPosition, glm::vec3 position,
 		particles[loop].zg = gravity.z;
 	}
 
-	log("Particle System initiailized successfully.");
+	LOG_DEBUG(LOG_CATEGORY_RENDER, "Particle System initiailized successfully.");
 }
 
 /*
-	Function to generate the particle's texture
-	and load it into the binded texture. It also
-	sets the appropriate filtering parameters.
+	Function to generate the particle's texture.
+	The image is streamed in by the TextureStreamer,
+	which also sets the filtering parameters, and shared
+	with other particle systems by the TextureCache.
 
 	texturePath		-	Path to the image that is to
 						be mapped to the particle quads.
 */
 void ParticleSystem::LoadParticleTexture(const char* texturePath)
 {
-	// Load texture for particle system.
-	glGenTextures(1, &particleTexture);
-	glBindTexture(GL_TEXTURE_2D, particleTexture);
-
-	// Set our texture parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// Set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	particleTexture = TextureCache::Acquire2D(texturePath, GL_RGBA);
 
-	// Load, create texture and generate mipmaps
-	int width, height;
-	unsigned char * image = SOIL_load_image(texturePath, &width, &height, 0, SOIL_LOAD_RGB);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(image);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	log("Particle Texture loaded successfully.");
+	LOG_DEBUG(LOG_CATEGORY_ASSET, "Particle Texture queued successfully.");
 }
 
 /*
@@ -162,18 +150,20 @@ void ParticleSystem::SetupParticles(void)
 		(Required for billboarding)
 		particleScale	-	To scale the particles as per User's wish.
 */
-void ParticleSystem::Render(Shader particleShader, glm::vec3 viewDir, glm::vec3 particleScale)
+void ParticleSystem::Render(Shader& particleShader, glm::vec3 viewDir, glm::vec3 particleScale)
 {
+	PROFILE_SCOPE("ParticleSystem::Render");
+
 	// Set the visibility for alpha blending.
-	glUniform1f(glGetUniformLocation(particleShader.program, "visibility"), visibility);
+	UniformFloat(particleShader.GetUniform(VISIBILITY_UNIFORM)).Set(visibility);
 
 	// Bind the particle texture.
-	glUniform1i(glGetUniformLocation(particleShader.program, "particleTexture"), 0);
+	UniformSampler(particleShader.GetUniform(TEXTURE_UNIFORM)).Set(0);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, particleTexture);
 
-	// Find out the model matrix location.
-	GLint modelLocation = glGetUniformLocation(particleShader.program, "model");
+	// Find out the model matrix uniform.
+	UniformMat4 modelUniform = particleShader.GetUniform(MODEL_UNIFORM);
 	float angle = 0.0f;
 
 	// Iterate through all the particles.
@@ -200,11 +190,12 @@ void ParticleSystem::Render(Shader particleShader, glm::vec3 viewDir, glm::vec3
 				model = glm::rotate(model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
 			}
 
-			glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+			modelUniform.Set(model);
 
 			// Render the particle using glDrawArrays().
 			glBindVertexArray(particleQuadVAO);
 			glDrawArrays(GL_TRIANGLES, 0, 6);
+			Telemetry::CountDraw(2);
 			glBindVertexArray(0);
 		}
 	}
@@ -216,6 +207,8 @@ void ParticleSystem::Render(Shader particleShader, glm::vec3 viewDir, glm::vec3
 */
 void ParticleSystem::Update(void)
 {
+	PROFILE_SCOPE("ParticleSystem::Update");
+
 	// Iterate through all the particles.
 	for (GLint loop = 0; loop < particleCount; loop++)
 	{
@@ -265,11 +258,13 @@ void ParticleSystem::Update(void)
 }
 
 /*
-	Destructor to clear memory occupied by the particles array.
+	Destructor to clear memory occupied by the particles array
+	and give the texture back to the TextureCache.
 */
 ParticleSystem::~ParticleSystem()
 {
 	delete[] particles;
+	TextureCache::Release(particleTexture);
 
-	log("Particle System destructed.");
+	LOG_DEBUG(LOG_CATEGORY_RENDER, "Particle System destructed.");
 }
\ No newline at end of file
@@ -6,8 +6,9 @@
 #include "..\Contrib\Include\glm\glm.hpp"
 #include "..\Contrib\Include\glm\gtc\matrix_transform.hpp"
 #include "..\Contrib\Include\glm\gtc\type_ptr.hpp"
-#include "..\Contrib\Include\SOIL.h"
+#include "..\Util\TextureCache.h"
 #include "..\Util\Shader.h"
+#include "..\Util\Telemetry.h"
 #include "Particle.h"
 
 /*
@@ -38,7 +39,7 @@ public:
 	void InitParticleSystem(bool fixedPosition, glm::vec3 position, glm::vec3 offsets);
 	void LoadParticleTexture(const char* texturePath);
 	void SetupParticles(void);
-	void Render(Shader particleShader, glm::vec3 viewDir, glm::vec3 particleScale = glm::vec3(1.0f));
+	void Render(Shader& particleShader, glm::vec3 viewDir, glm::vec3 particleScale = glm::vec3(1.0f));
 	void Update(void);
 	~ParticleSystem();
 
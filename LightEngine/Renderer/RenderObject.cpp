@@ -23,7 +23,7 @@ RenderObject::RenderObject(const char* diffusePath, const char* normalPath, cons
 
 	triangles = numOfTriangles;
 
-	log("RenderObject created successfully.");
+	LOG_DEBUG(LOG_CATEGORY_RENDER, "RenderObject created successfully.");
 }
 
 /*
@@ -39,8 +39,10 @@ void RenderObject::SetupBuffers(GLuint objectVAO, GLuint objectVBO)
 }
 
 /*
-	Generates and loads all the textures
-	associated with the RenderObject.
+	Generates all the textures associated with the
+	RenderObject. Their images are streamed in by the
+	TextureStreamer, objects with the same textures share
+	them through the TextureCache.
 
 	diffusePath		-	Path to the diffuse texture in memory.
 	normalPath		-	Path to the normal texture in memory.
@@ -48,66 +50,12 @@ void RenderObject::SetupBuffers(GLuint objectVAO, GLuint objectVBO)
 */
 void RenderObject::SetupTextures(const char* diffusePath, const char* normalPath, const char* specularPath)
 {
-	int width, height;
-
-	// Generating diffuse map for wall.
-	glGenTextures(1, &diffuse);
-	glBindTexture(GL_TEXTURE_2D, diffuse);
-
-	// Set our texture parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// Set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Load, create texture and generate mipmaps
-	unsigned char * image = SOIL_load_image(diffusePath, &width, &height, 0, SOIL_LOAD_RGB);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(image);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	// Generating specular map for wall.
-	glGenTextures(1, &specular);
-	glBindTexture(GL_TEXTURE_2D, specular);
-
-	// Set our texture parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// Set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Load, create texture and generate mipmaps
-	image = SOIL_load_image(specularPath, &width, &height, 0, SOIL_LOAD_RGB);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(image);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	// Generating normal map for wall.
-	glGenTextures(1, &normal);
-	glBindTexture(GL_TEXTURE_2D, normal);
-
-	// Set our texture parameters
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// Set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Load, create texture and generate mipmaps
-	image = SOIL_load_image(normalPath, &width, &height, 0, SOIL_LOAD_RGB);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	SOIL_free_image_data(image);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	log("Textures loaded and set successfully.");
+	diffuse = TextureCache::Acquire2D(diffusePath, GL_SRGB);
+	specular = TextureCache::Acquire2D(specularPath, GL_RGB);
+	// Only X and Y of the normals are kept, Z is rebuilt by the shader.
+	normal = TextureCache::Acquire2D(normalPath, GL_RG, TEXTURE_PLACEHOLDER_NORMAL);
+
+	LOG_DEBUG(LOG_CATEGORY_ASSET, "Textures queued successfully.");
 }
 
 /*
@@ -124,7 +72,7 @@ void RenderObject::SetupVertexData(GLfloat objectVertexData[])
 		vertexData[i] = objectVertexData[i];
 	}
 
-	log("Vertex data loaded.");
+	LOG_DEBUG(LOG_CATEGORY_RENDER, "Vertex data loaded.");
 }
 
 /*
@@ -134,7 +82,7 @@ void RenderObject::SetupVertexData(GLfloat objectVertexData[])
 	shader			-	Shader used in rendering the object.
 	renderTextures	-	Flag to set whether to render textures or not.
 */
-void RenderObject::Render(Shader shader, bool renderTextures)
+void RenderObject::Render(Shader& shader, bool renderTextures)
 {
 	if (renderTextures)
 	{
@@ -152,12 +100,15 @@ void RenderObject::Render(Shader shader, bool renderTextures)
 	}
 
 	glDrawArrays(GL_TRIANGLES, 0, 3 * triangles);
+	Telemetry::CountDraw(triangles);
 }
 
 /*
-	Destructor to free memory held for vertex data.
+	Destructor, gives the textures back to the TextureCache.
 */
 RenderObject::~RenderObject()
 {
-
+	TextureCache::Release(diffuse);
+	TextureCache::Release(specular);
+	TextureCache::Release(normal);
 }
\ No newline at end of file
@@ -2,8 +2,9 @@
 
 // Includes
 #include "..\Contrib\Include\gl\glew.h"
-#include "..\Contrib\Include\SOIL.h"
+#include "..\Util\TextureCache.h"
 #include "..\Util\Shader.h"
+#include "..\Util\Telemetry.h"
 
 /*
 	Class to enable rendering of custom
@@ -27,7 +28,7 @@ public:
 	void SetupBuffers(GLuint objectVAO, GLuint objectVBO);
 	void SetupTextures(const char* diffusePath, const char* normalPath, const char* specularPath);
 	void SetupVertexData(GLfloat objectVertexData[]);
-	void RenderObject::Render(Shader shader, bool renderTextures = true);
+	void RenderObject::Render(Shader& shader, bool renderTextures = true);
 	~RenderObject();
 
 // Variables
@@ -1,5 +1,8 @@
 #include "Skybox.h"
 
+// Name hash of the cubemap sampler, so rendering does no string work.
+const unsigned int SKYBOX_SAMPLER = Shader::HashName("skybox");
+
 // Vertex data for the skybox cube.
 GLfloat skyboxVertices[] = {
 	// Positions          
@@ -51,6 +54,8 @@ GLfloat skyboxVertices[] = {
 */
 Skybox::Skybox()
 {
+	cubemapTexture = 0;
+
 	log("");
 	log("===Skybox===");
 }
@@ -73,7 +78,7 @@ void Skybox::SetupSkybox(void)
 
 	glDisableVertexAttribArray(0);
 
-	log("Skybox setup complete.");
+	LOG_DEBUG(LOG_CATEGORY_RENDER, "Skybox setup complete.");
 }
 
 /*
@@ -86,31 +91,17 @@ void Skybox::SetupSkybox(void)
 	+Z (front)
 	-Z (back)
 
+	The faces are streamed in by the TextureStreamer,
+	through the TextureCache.
+
 	faces	-	vector containing paths to all the six
 	textures that are to be mapped on the cube.
 */
 void Skybox::LoadCubemap(std::vector<const GLchar*> faces)
 {
-	glGenTextures(1, &cubemapTexture);
+	cubemapTexture = TextureCache::AcquireCubemap(&faces[0]);
 
-	int width, height;
-	unsigned char* image;
-
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-	for (GLuint i = 0; i < faces.size(); i++)
-	{
-		image = SOIL_load_image(faces[i], &width, &height, 0, SOIL_LOAD_RGB);
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		SOIL_free_image_data(image);
-	}
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-	log("Skybox cubemap generated successfully.");
+	LOG_DEBUG(LOG_CATEGORY_ASSET, "Skybox cubemap queued successfully.");
 }
 
 /*
@@ -120,25 +111,28 @@ void Skybox::LoadCubemap(std::vector<const GLchar*> faces)
 
 	shader	-	Shader object used to render the skybox cube.
 */
-void Skybox::Render(Shader shader)
+void Skybox::Render(Shader& shader)
 {
 	glDepthMask(GL_FALSE);// To turn depth writing off
 
 	// Skybox cube
 	glBindVertexArray(skyboxVAO);
 	glActiveTexture(GL_TEXTURE0);
-	glUniform1i(glGetUniformLocation(shader.program, "skybox"), 0);
+	UniformSampler(shader.GetUniform(SKYBOX_SAMPLER)).Set(0);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
 	glDrawArrays(GL_TRIANGLES, 0, 36);
+	Telemetry::CountDraw(12);
 	glBindVertexArray(0);
 	glDisableVertexAttribArray(0);
 	glDepthMask(GL_TRUE);
 }
 
 /*
-	Destructor for the skybox.
+	Destructor for the skybox, gives the cubemap back to
+	the TextureCache.
 */
 Skybox::~Skybox()
 {
-
+	if (cubemapTexture != 0)
+		TextureCache::Release(cubemapTexture);
 }
\ No newline at end of file
@@ -2,9 +2,10 @@
 
 // Includes.
 #include "..\Contrib\Include\gl\glew.h"
-#include "..\Contrib\Include\SOIL.h"
+#include "..\Util\TextureCache.h"
 #include "..\Util\Utility.h"
 #include "..\Util\Shader.h"
+#include "..\Util\Telemetry.h"
 #include <vector>
 
 /*
@@ -21,7 +22,7 @@ public:
 	Skybox();
 	void SetupSkybox(void);
 	void LoadCubemap(std::vector<const GLchar*> faces);
-	void Render(Shader shader);
+	void Render(Shader& shader);
 	~Skybox();
 
 // Variables
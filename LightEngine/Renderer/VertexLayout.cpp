@@ -0,0 +1,67 @@
+#include "VertexLayout.h"
+
+/*
+	Size of one vertex of a format in bytes.
+
+	format	-	Vertex format.
+*/
+size_t GetVertexFormatStride(VertexFormat format)
+{
+	switch (format)
+	{
+	case VERTEX_FORMAT_PACKED_FLOAT_POSITION:
+		return sizeof(PackedVertex<glm::vec3>);
+	case VERTEX_FORMAT_PACKED_HALF_POSITION:
+		return sizeof(PackedVertex<Half4>);
+	case VERTEX_FORMAT_PACKED_UNORM_POSITION:
+		return sizeof(PackedVertex<Unorm16x4>);
+	default:
+		return sizeof(Vertex);
+	}
+}
+
+/*
+	Short name of a format for the log.
+
+	format	-	Vertex format.
+*/
+const char* GetVertexFormatName(VertexFormat format)
+{
+	switch (format)
+	{
+	case VERTEX_FORMAT_PACKED_FLOAT_POSITION:
+		return "float position";
+	case VERTEX_FORMAT_PACKED_HALF_POSITION:
+		return "half position";
+	case VERTEX_FORMAT_PACKED_UNORM_POSITION:
+		return "unorm16 position";
+	default:
+		return "float";
+	}
+}
+
+/*
+	Sets the attribute pointers of a format on the bound
+	VAO, for the bound GL_ARRAY_BUFFER.
+
+	format	-	Vertex format of the buffer.
+	offset	-	Byte offset of the first vertex in the buffer.
+*/
+void SetupVertexFormat(VertexFormat format, size_t offset)
+{
+	switch (format)
+	{
+	case VERTEX_FORMAT_PACKED_FLOAT_POSITION:
+		SetupVertexAttributes<PackedVertex<glm::vec3> >(offset);
+		break;
+	case VERTEX_FORMAT_PACKED_HALF_POSITION:
+		SetupVertexAttributes<PackedVertex<Half4> >(offset);
+		break;
+	case VERTEX_FORMAT_PACKED_UNORM_POSITION:
+		SetupVertexAttributes<PackedVertex<Unorm16x4> >(offset);
+		break;
+	default:
+		SetupVertexAttributes<Vertex>(offset);
+		break;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+#pragma once
+
+// Includes.
+#include <cstddef>
+#include "..\Contrib\Include\gl\glew.h"
+#include "..\Contrib\Include\glm\glm.hpp"
+
+/*
+	Component types of the quantized vertex formats.
+	Each is one vertex attribute and lines up to 4 bytes.
+*/
+
+// Four half floats, the fourth is padding.
+struct Half4
+{
+	GLushort v[4];
+};
+
+// Two 16-bit values read as [0, 1].
+struct Unorm16x2
+{
+	GLushort v[2];
+};
+
+// Four 16-bit values read as [0, 1], the fourth is padding.
+struct Unorm16x4
+{
+	GLushort v[4];
+};
+
+/*
+	How a component type is given to glVertexAttribPointer().
+	Only the types below can be used in a vertex.
+*/
+template <typename T> struct VertexComponent;
+
+template <> struct VertexComponent<GLfloat>		{ static const GLint SIZE = 1; static const GLenum TYPE = GL_FLOAT; static const GLboolean NORMALIZED = GL_FALSE; };
+template <> struct VertexComponent<glm::vec2>	{ static const GLint SIZE = 2; static const GLenum TYPE = GL_FLOAT; static const GLboolean NORMALIZED = GL_FALSE; };
+template <> struct VertexComponent<glm::vec3>	{ static const GLint SIZE = 3; static const GLenum TYPE = GL_FLOAT; static const GLboolean NORMALIZED = GL_FALSE; };
+template <> struct VertexComponent<glm::vec4>	{ static const GLint SIZE = 4; static const GLenum TYPE = GL_FLOAT; static const GLboolean NORMALIZED = GL_FALSE; };
+template <> struct VertexComponent<Half4>		{ static const GLint SIZE = 4; static const GLenum TYPE = GL_HALF_FLOAT; static const GLboolean NORMALIZED = GL_FALSE; };
+template <> struct VertexComponent<Unorm16x2>	{ static const GLint SIZE = 2; static const GLenum TYPE = GL_UNSIGNED_SHORT; static const GLboolean NORMALIZED = GL_TRUE; };
+template <> struct VertexComponent<Unorm16x4>	{ static const GLint SIZE = 4; static const GLenum TYPE = GL_UNSIGNED_SHORT; static const GLboolean NORMALIZED = GL_TRUE; };
+
+/*
+	One row of a vertex layout, the arguments of
+	glVertexAttribPointer() without the stride.
+*/
+struct VertexAttribute
+{
+	GLuint		location;
+	GLint		size;
+	GLenum		type;
+	GLboolean	normalized;
+	size_t		offset;
+};
+
+// Layout row of a member, its size and type follow from the member's type.
+#define VERTEX_ATTRIBUTE(location, vertex, member) \
+	{ location, VertexComponent<decltype(((vertex*)0)->member)>::SIZE, VertexComponent<decltype(((vertex*)0)->member)>::TYPE, \
+	  VertexComponent<decltype(((vertex*)0)->member)>::NORMALIZED, offsetof(vertex, member) }
+
+/*
+	Attributes of a vertex type. Every vertex type
+	specializes this with a GetAttributes() that returns
+	a static table built with VERTEX_ATTRIBUTE(), so the
+	table is filled in by the compiler.
+*/
+template <typename VertexType> struct VertexLayout;
+
+/*
+	Sets the attribute pointers of a vertex type on the
+	bound VAO, for the bound GL_ARRAY_BUFFER.
+
+	offset	-	Byte offset of the first vertex in the buffer.
+*/
+template <typename VertexType>
+void SetupVertexAttributes(size_t offset = 0)
+{
+	unsigned int count = 0;
+	const VertexAttribute* attributes = VertexLayout<VertexType>::GetAttributes(count);
+
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		const VertexAttribute& attribute = attributes[i];
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized, sizeof(VertexType), (GLvoid*)(offset + attribute.offset));
+	}
+}
+
+/*
+	Structure to hold vertex data
+	for all the vertices in the mesh.
+*/
+struct Vertex {
+	// Position
+	glm::vec3 Position;
+	// Normal
+	glm::vec3 Normal;
+	// TexCoords
+	glm::vec2 TexCoords;
+};
+
+template <>
+struct VertexLayout<Vertex>
+{
+	static const VertexAttribute* GetAttributes(unsigned int& count)
+	{
+		static const VertexAttribute attributes[] =
+		{
+			VERTEX_ATTRIBUTE(0, Vertex, Position),
+			VERTEX_ATTRIBUTE(1, Vertex, Normal),
+			VERTEX_ATTRIBUTE(2, Vertex, TexCoords)
+		};
+		count = sizeof(attributes) / sizeof(attributes[0]);
+		return attributes;
+	}
+};
+
+/*
+	Quantized mesh vertex. The normal is octahedral
+	encoded and the texture coordinates are relative to
+	the mesh's UV range, see VertexDecode. The position
+	is one of glm::vec3, Half4 or Unorm16x4 (relative to
+	the bounding box).
+*/
+template <typename PositionType>
+struct PackedVertex
+{
+	PositionType	Position;
+	Unorm16x2		Normal;
+	Unorm16x2		TexCoords;
+};
+
+template <typename PositionType>
+struct VertexLayout<PackedVertex<PositionType> >
+{
+	static const VertexAttribute* GetAttributes(unsigned int& count)
+	{
+		typedef PackedVertex<PositionType> Packed;
+		static const VertexAttribute attributes[] =
+		{
+			VERTEX_ATTRIBUTE(0, Packed, Position),
+			VERTEX_ATTRIBUTE(1, Packed, Normal),
+			VERTEX_ATTRIBUTE(2, Packed, TexCoords)
+		};
+		count = sizeof(attributes) / sizeof(attributes[0]);
+		return attributes;
+	}
+};
+
+/*
+	Vertex of the normal mapped walls and floor.
+*/
+struct TangentVertex
+{
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::vec2 TexCoords;
+	glm::vec3 Tangent;
+	glm::vec3 Bitangent;
+};
+
+// The wall and floor vertices are written as plain float arrays.
+static_assert(sizeof(TangentVertex) == 14 * sizeof(GLfloat), "TangentVertex must be tightly packed.");
+
+template <>
+struct VertexLayout<TangentVertex>
+{
+	static const VertexAttribute* GetAttributes(unsigned int& count)
+	{
+		static const VertexAttribute attributes[] =
+		{
+			VERTEX_ATTRIBUTE(0, TangentVertex, Position),
+			VERTEX_ATTRIBUTE(1, TangentVertex, Normal),
+			VERTEX_ATTRIBUTE(2, TangentVertex, TexCoords),
+			VERTEX_ATTRIBUTE(3, TangentVertex, Tangent),
+			VERTEX_ATTRIBUTE(4, TangentVertex, Bitangent)
+		};
+		count = sizeof(attributes) / sizeof(attributes[0]);
+		return attributes;
+	}
+};
+
+/*
+	Vertex formats a mesh can be stored and drawn in,
+	from the largest to the smallest. Stored in mesh
+	cache files, so only append.
+*/
+enum VertexFormat
+{
+	VERTEX_FORMAT_FLOAT,					// Vertex, 32 bytes.
+	VERTEX_FORMAT_PACKED_FLOAT_POSITION,	// PackedVertex<glm::vec3>, 20 bytes.
+	VERTEX_FORMAT_PACKED_HALF_POSITION,		// PackedVertex<Half4>, 16 bytes.
+	VERTEX_FORMAT_PACKED_UNORM_POSITION,	// PackedVertex<Unorm16x4>, 16 bytes.
+	VERTEX_FORMAT_COUNT
+};
+
+/*
+	What the vertex shader does to turn the attributes of
+	a format back into object space, set as uniforms by
+	Mesh::Draw() :
+
+		position	= position * positionScale + positionOffset
+		texCoords	= texCoords * texCoordScale + texCoordOffset
+		normal		= octahedral ? decode(normal.xy) : normal
+
+	The default is the identity, for VERTEX_FORMAT_FLOAT.
+*/
+struct VertexDecode
+{
+	glm::vec3	positionScale;
+	glm::vec3	positionOffset;
+	glm::vec2	texCoordScale;
+	glm::vec2	texCoordOffset;
+	bool		octahedral;
+
+	VertexDecode() : positionScale(1.0f), positionOffset(0.0f), texCoordScale(1.0f), texCoordOffset(0.0f), octahedral(false) {}
+};
+
+// Function prototypes.
+size_t GetVertexFormatStride(VertexFormat format);
+const char* GetVertexFormatName(VertexFormat format);
+void SetupVertexFormat(VertexFormat format, size_t offset = 0);
\ No newline at end of file
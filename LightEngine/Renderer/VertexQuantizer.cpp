@@ -0,0 +1,312 @@
+#include "VertexQuantizer.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const float UNORM16_MAX = 65535.0f;
+
+	/*
+		Nearest unorm16 of a value within a range.
+
+		value	-	Value between start and start + extent.
+		start	-	Start of the range.
+		extent	-	Length of the range, may be 0.
+	*/
+	GLushort EncodeUnorm(float value, float start, float extent)
+	{
+		if (extent <= 0.0f)
+			return 0;
+
+		float normalized = (value - start) / extent;
+		normalized = normalized < 0.0f ? 0.0f : (normalized > 1.0f ? 1.0f : normalized);
+		return (GLushort)floorf(normalized * UNORM16_MAX + 0.5f);
+	}
+
+	/*
+		Value of a unorm16 within a range, computed like the
+		vertex shader does.
+	*/
+	float DecodeUnorm(GLushort value, float start, float extent)
+	{
+		return (float)value / UNORM16_MAX * extent + start;
+	}
+
+	/*
+		Sign that is 1 for zero, as octahedral encoding needs.
+	*/
+	float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+VertexErrorBounds	VertexQuantizer::errorBounds = VERTEX_ERROR_BOUNDS_DEFAULT;
+
+/*
+	Encodes a mesh's vertices in the most compact format
+	that stays within the error bounds.
+
+	vertices	-	Vertices as imported.
+	bounds		-	Largest error allowed per attribute.
+	packed		-	Receives the vertices in the returned format.
+	decode		-	Receives how the shaders decode them.
+*/
+VertexFormat VertexQuantizer::Quantize(const std::vector<Vertex>& vertices, const VertexErrorBounds& bounds, std::vector<unsigned char>& packed, VertexDecode& decode)
+{
+	decode = VertexDecode();
+	size_t count = vertices.size();
+
+	packed.assign((const unsigned char*)(count > 0 ? &vertices[0] : NULL), (const unsigned char*)(count > 0 ? &vertices[0] + count : NULL));
+	if (count == 0)
+		return VERTEX_FORMAT_FLOAT;
+
+	glm::vec3 positionMin = vertices[0].Position, positionMax = vertices[0].Position;
+	glm::vec2 texCoordMin = vertices[0].TexCoords, texCoordMax = vertices[0].TexCoords;
+	for (size_t i = 1; i < count; ++i)
+	{
+		positionMin = glm::min(positionMin, vertices[i].Position);
+		positionMax = glm::max(positionMax, vertices[i].Position);
+		texCoordMin = glm::min(texCoordMin, vertices[i].TexCoords);
+		texCoordMax = glm::max(texCoordMax, vertices[i].TexCoords);
+	}
+	glm::vec3 positionExtent = positionMax - positionMin;
+	glm::vec2 texCoordExtent = texCoordMax - texCoordMin;
+
+	std::vector<Unorm16x2> normals(count), texCoords(count);
+	std::vector<Half4> halfPositions(count);
+	std::vector<Unorm16x4> unormPositions(count);
+	float normalError = 0.0f, texCoordError = 0.0f, halfError = 0.0f, unormError = 0.0f;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Vertex& vertex = vertices[i];
+
+		// Zero normals of degenerate triangles have no direction to lose.
+		EncodeOctahedral(vertex.Normal, normals[i]);
+		float length = glm::length(vertex.Normal);
+		if (length > 0.0f)
+			normalError = glm::max(normalError, glm::length(DecodeOctahedral(normals[i]) - vertex.Normal / length));
+
+		glm::vec2 texCoord;
+		for (int axis = 0; axis < 2; ++axis)
+		{
+			texCoords[i].v[axis] = EncodeUnorm(vertex.TexCoords[axis], texCoordMin[axis], texCoordExtent[axis]);
+			texCoord[axis] = DecodeUnorm(texCoords[i].v[axis], texCoordMin[axis], texCoordExtent[axis]);
+		}
+		texCoordError = glm::max(texCoordError, glm::length(texCoord - vertex.TexCoords));
+
+		glm::vec3 halfPosition, unormPosition;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			halfPositions[i].v[axis] = FloatToHalf(vertex.Position[axis]);
+			halfPosition[axis] = HalfToFloat(halfPositions[i].v[axis]);
+
+			unormPositions[i].v[axis] = EncodeUnorm(vertex.Position[axis], positionMin[axis], positionExtent[axis]);
+			unormPosition[axis] = DecodeUnorm(unormPositions[i].v[axis], positionMin[axis], positionExtent[axis]);
+		}
+		halfPositions[i].v[3] = FloatToHalf(1.0f);
+		unormPositions[i].v[3] = 0;
+
+		halfError = glm::max(halfError, glm::length(halfPosition - vertex.Position));
+		unormError = glm::max(unormError, glm::length(unormPosition - vertex.Position));
+	}
+
+	if (!(normalError <= bounds.normal && texCoordError <= bounds.texCoord))
+		return VERTEX_FORMAT_FLOAT;
+
+	decode.octahedral = true;
+	decode.texCoordScale = texCoordExtent;
+	decode.texCoordOffset = texCoordMin;
+
+	float positionTolerance = bounds.position * glm::length(positionExtent);
+	if (unormError <= positionTolerance && !(halfError < unormError))
+	{
+		decode.positionScale = positionExtent;
+		decode.positionOffset = positionMin;
+		pack(unormPositions, normals, texCoords, packed);
+		return VERTEX_FORMAT_PACKED_UNORM_POSITION;
+	}
+	if (halfError <= positionTolerance)
+	{
+		pack(halfPositions, normals, texCoords, packed);
+		return VERTEX_FORMAT_PACKED_HALF_POSITION;
+	}
+
+	std::vector<glm::vec3> positions(count);
+	for (size_t i = 0; i < count; ++i)
+		positions[i] = vertices[i].Position;
+	pack(positions, normals, texCoords, packed);
+	return VERTEX_FORMAT_PACKED_FLOAT_POSITION;
+}
+
+/*
+	Sets the error bounds that models are imported with.
+	Mesh caches written with other bounds are rebuilt.
+	Call before loading models.
+
+	bounds	-	Largest error allowed per attribute.
+*/
+void VertexQuantizer::SetErrorBounds(const VertexErrorBounds& bounds)
+{
+	errorBounds = bounds;
+}
+
+/*
+	Error bounds that models are imported with,
+	VERTEX_ERROR_BOUNDS_DEFAULT unless set.
+*/
+const VertexErrorBounds& VertexQuantizer::GetErrorBounds(void)
+{
+	return errorBounds;
+}
+
+/*
+	Nearest half float of a float, rounding ties to even.
+	Values beyond the half range become infinite.
+
+	value	-	Float to convert.
+*/
+GLushort VertexQuantizer::FloatToHalf(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	unsigned int sign = (bits >> 16) & 0x8000;
+	unsigned int exponent = (bits >> 23) & 0xFF;
+	unsigned int mantissa = bits & 0x7FFFFF;
+
+	// Infinity and NaN.
+	if (exponent == 0xFF)
+		return (GLushort)(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+
+	int halfExponent = (int)exponent - 127 + 15;
+	if (halfExponent >= 31)
+		return (GLushort)(sign | 0x7C00);
+
+	unsigned int shift = 13;
+	if (halfExponent <= 0)
+	{
+		// Denormal half, or zero below half of the smallest one.
+		if (halfExponent < -10)
+			return (GLushort)sign;
+		mantissa |= 0x800000;
+		shift = 14 - halfExponent;
+		halfExponent = 0;
+	}
+
+	unsigned int half = ((unsigned int)halfExponent << 10) + (mantissa >> shift);
+	unsigned int remainder = mantissa & ((1u << shift) - 1);
+	unsigned int halfway = 1u << (shift - 1);
+
+	// A carry out of the mantissa correctly moves on to the next exponent.
+	if (remainder > halfway || (remainder == halfway && (half & 1) != 0))
+		++half;
+
+	return (GLushort)(sign | half);
+}
+
+/*
+	Float of a half float.
+
+	value	-	Half float to convert.
+*/
+float VertexQuantizer::HalfToFloat(GLushort value)
+{
+	unsigned int sign = (value & 0x8000u) << 16;
+	unsigned int exponent = (value >> 10) & 0x1F;
+	unsigned int mantissa = value & 0x3FF;
+
+	if (exponent == 0)
+	{
+		float denormal = ldexpf((float)mantissa, -24);
+		return sign != 0 ? -denormal : denormal;
+	}
+
+	unsigned int bits;
+	if (exponent == 31)
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+/*
+	Octahedral encoding of a direction : the unit octahedron
+	is unfolded onto a square and stored as two unorm16. Of
+	the four nearest codes, the one that decodes closest to
+	the direction is picked.
+
+	normal	-	Direction, needs not be normalized.
+	encoded	-	Receives the code.
+*/
+void VertexQuantizer::EncodeOctahedral(const glm::vec3& normal, Unorm16x2& encoded)
+{
+	float sum = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	glm::vec3 direction = sum > 0.0f ? normal / sum : glm::vec3(0.0f, 0.0f, 1.0f);
+
+	glm::vec2 square(direction.x, direction.y);
+	if (direction.z < 0.0f)
+		square = glm::vec2((1.0f - fabsf(direction.y)) * SignNotZero(direction.x), (1.0f - fabsf(direction.x)) * SignNotZero(direction.y));
+
+	glm::vec2 scaled = (square * 0.5f + 0.5f) * UNORM16_MAX;
+	glm::vec3 target = glm::normalize(direction);
+	float bestError = -1.0f;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		Unorm16x2 candidate;
+		candidate.v[0] = (GLushort)glm::clamp((i & 1) != 0 ? ceilf(scaled.x) : floorf(scaled.x), 0.0f, UNORM16_MAX);
+		candidate.v[1] = (GLushort)glm::clamp((i & 2) != 0 ? ceilf(scaled.y) : floorf(scaled.y), 0.0f, UNORM16_MAX);
+
+		float error = glm::length(DecodeOctahedral(candidate) - target);
+		if (bestError < 0.0f || error < bestError)
+		{
+			bestError = error;
+			encoded = candidate;
+		}
+	}
+}
+
+/*
+	Direction of an octahedral code, computed like the
+	vertex shaders do.
+
+	encoded	-	Code from EncodeOctahedral().
+*/
+glm::vec3 VertexQuantizer::DecodeOctahedral(const Unorm16x2& encoded)
+{
+	glm::vec2 square((float)encoded.v[0] / UNORM16_MAX * 2.0f - 1.0f, (float)encoded.v[1] / UNORM16_MAX * 2.0f - 1.0f);
+	glm::vec3 direction(square.x, square.y, 1.0f - fabsf(square.x) - fabsf(square.y));
+
+	float fold = glm::max(-direction.z, 0.0f);
+	direction.x += direction.x >= 0.0f ? -fold : fold;
+	direction.y += direction.y >= 0.0f ? -fold : fold;
+	return glm::normalize(direction);
+}
+
+/*
+	Interleaves encoded attributes into PackedVertex<PositionType>.
+
+	positions	-	Encoded positions.
+	normals		-	Encoded normals.
+	texCoords	-	Encoded texture coordinates.
+	packed		-	Receives the packed vertices.
+*/
+template <typename PositionType>
+void VertexQuantizer::pack(const std::vector<PositionType>& positions, const std::vector<Unorm16x2>& normals, const std::vector<Unorm16x2>& texCoords,
+	std::vector<unsigned char>& packed)
+{
+	packed.assign(positions.size() * sizeof(PackedVertex<PositionType>), 0);
+	PackedVertex<PositionType>* output = (PackedVertex<PositionType>*)&packed[0];
+
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		output[i].Position = positions[i];
+		output[i].Normal = normals[i];
+		output[i].TexCoords = texCoords[i];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+// Includes.
+#include <vector>
+#include "VertexLayout.h"
+
+/*
+	Largest error a quantized vertex format may introduce.
+
+	position	-	Distance from the imported position, as a
+					fraction of the mesh's bounding box diagonal.
+	normal		-	Distance from the normalized imported normal.
+	texCoord	-	Distance from the imported coordinate, in UV units.
+*/
+struct VertexErrorBounds
+{
+	float	position;
+	float	normal;
+	float	texCoord;
+};
+
+// About 1/2000 of the mesh's size, 1/20 of a degree and 1/8 texel of a 1024 texture.
+const VertexErrorBounds VERTEX_ERROR_BOUNDS_DEFAULT = { 0.0005f, 0.001f, 0.000122f };
+
+/*
+	Picks the most compact VertexFormat for a mesh whose
+	error stays within the VertexErrorBounds, and encodes
+	the vertices in it :
+
+	-	Normals are octahedral encoded into two unorm16.
+	-	Texture coordinates become unorm16 over the mesh's
+		UV range.
+	-	Positions become unorm16 over the bounding box or
+		half floats, whichever is closer, or stay floats.
+
+	If normals or texture coordinates don't fit, the mesh
+	stays in VERTEX_FORMAT_FLOAT. The errors are measured
+	by decoding every vertex like the shaders do.
+*/
+class VertexQuantizer
+{
+public:
+
+// Functions
+
+	static VertexFormat Quantize(const std::vector<Vertex>& vertices, const VertexErrorBounds& bounds, std::vector<unsigned char>& packed, VertexDecode& decode);
+	static void SetErrorBounds(const VertexErrorBounds& bounds);
+	static const VertexErrorBounds& GetErrorBounds(void);
+	static GLushort FloatToHalf(float value);
+	static float HalfToFloat(GLushort value);
+	static void EncodeOctahedral(const glm::vec3& normal, Unorm16x2& encoded);
+	static glm::vec3 DecodeOctahedral(const Unorm16x2& encoded);
+
+private:
+
+// Functions
+
+	template <typename PositionType>
+	static void pack(const std::vector<PositionType>& positions, const std::vector<Unorm16x2>& normals, const std::vector<Unorm16x2>& texCoords,
+		std::vector<unsigned char>& packed);
+
+// Variables
+
+	static VertexErrorBounds errorBounds;
+};
\ No newline at end of file
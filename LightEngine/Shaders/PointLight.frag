@@ -2,7 +2,12 @@
 
 out vec3 color;
 
-uniform int pointLightOn;
+layout (std140) uniform LightConstants
+{
+    vec3 lightPos;
+    int pointLightOn;
+    int flashLight;
+};
 
 void main()
 {
@@ -2,9 +2,15 @@
 
 layout (location = 0) in vec3 position;
 
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec3 cameraDir;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
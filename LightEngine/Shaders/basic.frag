@@ -6,8 +6,9 @@ uniform sampler2D normalMap;
 uniform sampler2D shadowMap;
 uniform sampler2D pointShadowMap;
 
-uniform int flashLight;
-uniform int pointLightOn;
+// Variant keywords (see ShaderPermutations) :
+// POINT_LIGHT - adds the shadowed point light.
+// FLASH_LIGHT - adds the spot light attached to the camera.
 
 const float shininess = 64.0;
 const float exposure = 0.1;
@@ -88,6 +89,7 @@ float DirecShadowCalculation(vec4 fragPosLightSpace)
     return shadow;
 }
 
+#ifdef POINT_LIGHT
 float PointShadowCalculation(vec4 fragPosLightSpace)
 {
     // perform perspective divide
@@ -115,6 +117,7 @@ float PointShadowCalculation(vec4 fragPosLightSpace)
 
     return shadow;
 }
+#endif
 
 void main()
 {
@@ -148,11 +151,11 @@ void main()
     spotLight.diffuse = vec3(10.0, 10.0, 10.0);
     spotLight.specular = vec3(10.0, 10.0, 10.0);
 
-    // Obtain normal from normal map in range [0,1]
-    vec3 normal = texture(normalMap, fs_in.TexCoord).rgb;
+    // Obtain normal from normal map in range [0,1], only X and Y are stored (BC5)
+    vec2 normalXY = texture(normalMap, fs_in.TexCoord).rg * 2.0 - 1.0;
 
-    // Transform normal vector to range [-1,1]
-    normal = normalize(normal * 2.0 - 1.0);  // this normal is in tangent space
+    // Rebuild Z from the unit length, this normal is in tangent space
+    vec3 normal = normalize(vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0))));
 
     vec3 viewDir = normalize(fs_in.TangentViewPos - fs_in.TangentFragPos);
 
@@ -181,70 +184,76 @@ void main()
 
     vec3 result = ambient + diffuse + specular;
 
+#ifdef POINT_LIGHT
     // Calculate Point Lighting.
+    {
+        // Calculate shadow
+        float pointShadow = PointShadowCalculation(fs_in.FragPosLightSpacePoint);
 
-    // Calculate shadow
-    float pointShadow = PointShadowCalculation(fs_in.FragPosLightSpacePoint);
+        lightDir = normalize(fs_in.TangentLightPos - fs_in.TangentFragPos);
 
-    lightDir = normalize(fs_in.TangentLightPos - fs_in.TangentFragPos);
-    
-    // Diffuse shading
-    diff = max(dot(normal, lightDir), 0.0);
+        // Diffuse shading
+        diff = max(dot(normal, lightDir), 0.0);
 
-    // Specular shading
-    halfwayDir = normalize(lightDir + viewDir);
-    spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
+        // Specular shading
+        halfwayDir = normalize(lightDir + viewDir);
+        spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
 
-    // Attenuation
-    float distance = length(fs_in.TangentLightPos - fs_in.TangentFragPos);
-    float attenuation = 1.0f / (pointLight.constant + pointLight.linear * distance + pointLight.quadratic * (distance * distance));
+        // Attenuation
+        float distance = length(fs_in.TangentLightPos - fs_in.TangentFragPos);
+        float attenuation = 1.0f / (pointLight.constant + pointLight.linear * distance + pointLight.quadratic * (distance * distance));
 
-    // Combine results
-    ambient = pointLight.ambient * vec3(texture(diffuseMap, fs_in.TexCoord));
-    ambient = pow(ambient, vec3(gamma));
+        // Combine results
+        ambient = pointLight.ambient * vec3(texture(diffuseMap, fs_in.TexCoord));
+        ambient = pow(ambient, vec3(gamma));
 
-    diffuse = pointLight.diffuse * diff * vec3(texture(diffuseMap, fs_in.TexCoord));
-    diffuse = pow(diffuse, vec3(gamma));
+        diffuse = pointLight.diffuse * diff * vec3(texture(diffuseMap, fs_in.TexCoord));
+        diffuse = pow(diffuse, vec3(gamma));
 
-    specular = pointLight.specular * spec * vec3(texture(specularMap, fs_in.TexCoord));
-    specular = pow(specular, vec3(gamma));
+        specular = pointLight.specular * spec * vec3(texture(specularMap, fs_in.TexCoord));
+        specular = pow(specular, vec3(gamma));
 
-    ambient *= attenuation;
-    diffuse *= attenuation;
-    specular *= attenuation;
+        ambient *= attenuation;
+        diffuse *= attenuation;
+        specular *= attenuation;
 
-    ambient = ambient * (1.0 - pointShadow);
-    diffuse = diffuse * (1.0 - pointShadow);
-    specular = specular * (1.0 - pointShadow);
+        ambient = ambient * (1.0 - pointShadow);
+        diffuse = diffuse * (1.0 - pointShadow);
+        specular = specular * (1.0 - pointShadow);
 
-    if(pointLightOn == 1)
         result = result + (ambient + diffuse + specular);
+    }
+#endif
 
+#ifdef FLASH_LIGHT
     // Calculate Spot Lighting.
-    lightDir = normalize(spotLight.position - fs_in.TangentFragPos);
-    // Diffuse shading
-    diff = max(dot(normal, lightDir), 0.0);
-    // Specular shading
-    halfwayDir = normalize(lightDir + viewDir);
-    spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
-    // Attenuation
-    distance = length(spotLight.position - fs_in.TangentFragPos);
-    attenuation = 1.0f / (spotLight.constant + spotLight.linear * distance + spotLight.quadratic * (distance * distance));
-    // Spotlight intensity
-    float theta = dot(lightDir, normalize(-spotLight.direction));
-    float epsilon = spotLight.cutOff - spotLight.outerCutOff;
-    float intensity = clamp((theta - spotLight.outerCutOff) / epsilon, 0.0, 1.0);
-    // Combine results
-    ambient = spotLight.ambient * vec3(texture(diffuseMap, fs_in.TexCoord));
-    ambient = pow(ambient, vec3(gamma));
-    diffuse = spotLight.diffuse * diff * vec3(texture(diffuseMap, fs_in.TexCoord));
-    diffuse = pow(diffuse, vec3(gamma));
-    specular = spotLight.specular * spec * vec3(texture(specularMap, fs_in.TexCoord));
-    specular = pow(specular, vec3(gamma));
-    ambient *= attenuation * intensity;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
-    result = result + (vec3(flashLight, flashLight, flashLight) * (ambient + diffuse + specular));
+    {
+        lightDir = normalize(spotLight.position - fs_in.TangentFragPos);
+        // Diffuse shading
+        diff = max(dot(normal, lightDir), 0.0);
+        // Specular shading
+        halfwayDir = normalize(lightDir + viewDir);
+        spec = pow(max(dot(normal, halfwayDir), 0.0), shininess);
+        // Attenuation
+        float distance = length(spotLight.position - fs_in.TangentFragPos);
+        float attenuation = 1.0f / (spotLight.constant + spotLight.linear * distance + spotLight.quadratic * (distance * distance));
+        // Spotlight intensity
+        float theta = dot(lightDir, normalize(-spotLight.direction));
+        float epsilon = spotLight.cutOff - spotLight.outerCutOff;
+        float intensity = clamp((theta - spotLight.outerCutOff) / epsilon, 0.0, 1.0);
+        // Combine results
+        ambient = spotLight.ambient * vec3(texture(diffuseMap, fs_in.TexCoord));
+        ambient = pow(ambient, vec3(gamma));
+        diffuse = spotLight.diffuse * diff * vec3(texture(diffuseMap, fs_in.TexCoord));
+        diffuse = pow(diffuse, vec3(gamma));
+        specular = spotLight.specular * spec * vec3(texture(specularMap, fs_in.TexCoord));
+        specular = pow(specular, vec3(gamma));
+        ambient *= attenuation * intensity;
+        diffuse *= attenuation * intensity;
+        specular *= attenuation * intensity;
+        result = result + (ambient + diffuse + specular);
+    }
+#endif
 
     // apply exposure tone-mapping
     result = vec3(1.0) - exp(-result * exposure);
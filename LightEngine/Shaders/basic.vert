@@ -16,15 +16,28 @@ out VS_OUT {
     vec4 FragPosLightSpacePoint;
 } vs_out;
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
-uniform vec3 cameraDir;
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec3 cameraDir;
+};
+
+layout (std140) uniform LightConstants
+{
+    vec3 lightPos;
+    int pointLightOn;
+    int flashLight;
+};
+
+layout (std140) uniform ShadowConstants
+{
+    mat4 direcLightSpaceMatrix;
+    mat4 pointLightSpaceMatrix;
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat4 direcLightSpaceMatrix;
-uniform mat4 pointLightSpaceMatrix;
 
 void main()
 {
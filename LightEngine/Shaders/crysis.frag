@@ -7,12 +7,18 @@ uniform samplerCube skybox;
 uniform sampler2D shadowMap;
 uniform sampler2D pointShadowMap;
 
-uniform int flashLight;
-uniform int pointLightOn;
-uniform vec3 viewPos;
-uniform vec3 cameraDir;
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec3 cameraDir;
+};
 
-uniform int reflectionMap;
+// Variant keywords (see ShaderPermutations) :
+// POINT_LIGHT    - adds the shadowed point light.
+// FLASH_LIGHT    - adds the spot light attached to the camera.
+// REFLECTION_MAP - adds skybox reflections where texture_reflection1 is bright.
 
 const float shininess = 16.0;
 const float exposure = 0.1;
@@ -88,6 +94,7 @@ float DirecShadowCalculation(vec4 fragPosLightSpace)
     return shadow;
 }
 
+#ifdef POINT_LIGHT
 float PointShadowCalculation(vec4 fragPosLightSpace)
 {
     // perform perspective divide
@@ -115,6 +122,7 @@ float PointShadowCalculation(vec4 fragPosLightSpace)
 
     return shadow;
 }
+#endif
 
 void main()
 {
@@ -148,111 +156,114 @@ void main()
     spotLight.diffuse = vec3(10.0, 10.0, 10.0);
     spotLight.specular = vec3(10.0, 10.0, 10.0);
 
-    vec3 result;
     vec3 viewDir = normalize(viewPos - fragPosition);
     vec3 norm = normalize(Normal);
 
     float gamma = 2.2;
 
-    // Point Lighting.
+    // Directional Lighting.
 
     // Calculate shadow
-    float pointShadow = PointShadowCalculation(FragPosLightSpacePoint);
+    float shadow = DirecShadowCalculation(FragPosLightSpaceDirec);
 
-    vec3 lightDir = normalize(pointLight.position - fragPosition);
+    vec3 lightDir = normalize(-dirLight.direction);
     // Diffuse shading
     float diff = max(dot(norm, lightDir), 0.0);
     // Specular shading
     vec3 halfwayDir = normalize(lightDir + viewDir);
     float spec = pow(max(dot(norm, halfwayDir), 0.0), shininess);
-    // Attenuation
-    float distance = length(pointLight.position - fragPosition);
-    float attenuation = 1.0f / (pointLight.constant + pointLight.linear * distance + pointLight.quadratic * (distance * distance));
-    // Combine results
-    vec3 ambient = pointLight.ambient * vec3(texture(texture_diffuse1, TexCoords));
-    ambient = pow(ambient, vec3(gamma));
-
-    vec3 diffuse = pointLight.diffuse * diff * vec3(texture(texture_diffuse1, TexCoords));
-    diffuse = pow(diffuse, vec3(gamma));
-
-    vec3 specular = pointLight.specular * spec * vec3(texture(texture_specular1, TexCoords));
-    specular = pow(specular, vec3(gamma));
-
-    ambient *= attenuation;
-    diffuse *= attenuation;
-    specular *= attenuation;
-
-    ambient = ambient * (1.0 - pointShadow);
-    diffuse = diffuse * (1.0 - pointShadow);
-    specular = specular * (1.0 - pointShadow);
-
-    if(pointLightOn == 1)
-        result = (ambient + diffuse + specular);
-    else
-        result = vec3(0.0, 0.0, 0.0);
-
-    // Directional Lighting.
-
-    // Calculate shadow
-    float shadow = DirecShadowCalculation(FragPosLightSpaceDirec);
-
-    lightDir = normalize(-dirLight.direction);
-    // Diffuse shading
-    diff = max(dot(norm, lightDir), 0.0);
-    // Specular shading
-    halfwayDir = normalize(lightDir + viewDir);
-    spec = pow(max(dot(norm, halfwayDir), 0.0), shininess);
     // Combine results
-    ambient = dirLight.ambient * vec3(texture(texture_diffuse1, TexCoords));
+    vec3 ambient = dirLight.ambient * vec3(texture(texture_diffuse1, TexCoords));
     ambient = pow(ambient, vec3(gamma));
     ambient = ambient * (1.0 - shadow);
 
-    diffuse = dirLight.diffuse * diff * vec3(texture(texture_diffuse1, TexCoords));
+    vec3 diffuse = dirLight.diffuse * diff * vec3(texture(texture_diffuse1, TexCoords));
     diffuse = pow(diffuse, vec3(gamma));
     diffuse = diffuse * (1.0 - shadow);
 
-    specular = dirLight.specular * spec * vec3(texture(texture_specular1, TexCoords));
+    vec3 specular = dirLight.specular * spec * vec3(texture(texture_specular1, TexCoords));
     specular = pow(specular, vec3(gamma));
     specular = specular * (1.0 - shadow);
 
-    result = result + (ambient + diffuse + specular);
+    vec3 result = ambient + diffuse + specular;
+
+#ifdef POINT_LIGHT
+    // Point Lighting.
+    {
+        // Calculate shadow
+        float pointShadow = PointShadowCalculation(FragPosLightSpacePoint);
+
+        lightDir = normalize(pointLight.position - fragPosition);
+        // Diffuse shading
+        diff = max(dot(norm, lightDir), 0.0);
+        // Specular shading
+        halfwayDir = normalize(lightDir + viewDir);
+        spec = pow(max(dot(norm, halfwayDir), 0.0), shininess);
+        // Attenuation
+        float distance = length(pointLight.position - fragPosition);
+        float attenuation = 1.0f / (pointLight.constant + pointLight.linear * distance + pointLight.quadratic * (distance * distance));
+        // Combine results
+        ambient = pointLight.ambient * vec3(texture(texture_diffuse1, TexCoords));
+        ambient = pow(ambient, vec3(gamma));
+
+        diffuse = pointLight.diffuse * diff * vec3(texture(texture_diffuse1, TexCoords));
+        diffuse = pow(diffuse, vec3(gamma));
+
+        specular = pointLight.specular * spec * vec3(texture(texture_specular1, TexCoords));
+        specular = pow(specular, vec3(gamma));
+
+        ambient *= attenuation;
+        diffuse *= attenuation;
+        specular *= attenuation;
+
+        ambient = ambient * (1.0 - pointShadow);
+        diffuse = diffuse * (1.0 - pointShadow);
+        specular = specular * (1.0 - pointShadow);
+
+        result = result + (ambient + diffuse + specular);
+    }
+#endif
 
+#ifdef FLASH_LIGHT
     // Spot Lighting.
-    lightDir = normalize(spotLight.position - fragPosition);
-    // Diffuse shading
-    diff = max(dot(norm, lightDir), 0.0);
+    {
+        lightDir = normalize(spotLight.position - fragPosition);
+        // Diffuse shading
+        diff = max(dot(norm, lightDir), 0.0);
 
-    // Specular shading
-    halfwayDir = normalize(lightDir + viewDir);
-    spec = pow(max(dot(norm, halfwayDir), 0.0), shininess);
+        // Specular shading
+        halfwayDir = normalize(lightDir + viewDir);
+        spec = pow(max(dot(norm, halfwayDir), 0.0), shininess);
 
-    // Attenuation
-    distance = length(spotLight.position - fragPosition);
-    attenuation = 1.0f / (spotLight.constant + spotLight.linear * distance + spotLight.quadratic * (distance * distance));
+        // Attenuation
+        float distance = length(spotLight.position - fragPosition);
+        float attenuation = 1.0f / (spotLight.constant + spotLight.linear * distance + spotLight.quadratic * (distance * distance));
 
-    // Spotlight intensity
-    float theta = dot(lightDir, normalize(-spotLight.direction));
-    float epsilon = spotLight.cutOff - spotLight.outerCutOff;
-    float intensity = clamp((theta - spotLight.outerCutOff) / epsilon, 0.0, 1.0);
+        // Spotlight intensity
+        float theta = dot(lightDir, normalize(-spotLight.direction));
+        float epsilon = spotLight.cutOff - spotLight.outerCutOff;
+        float intensity = clamp((theta - spotLight.outerCutOff) / epsilon, 0.0, 1.0);
 
-    // Combine results
-    ambient = spotLight.ambient * vec3(texture(texture_diffuse1, TexCoords));
-    ambient = pow(ambient, vec3(gamma));
+        // Combine results
+        ambient = spotLight.ambient * vec3(texture(texture_diffuse1, TexCoords));
+        ambient = pow(ambient, vec3(gamma));
 
-    diffuse = spotLight.diffuse * diff * vec3(texture(texture_diffuse1, TexCoords));
-    diffuse = pow(diffuse, vec3(gamma));
+        diffuse = spotLight.diffuse * diff * vec3(texture(texture_diffuse1, TexCoords));
+        diffuse = pow(diffuse, vec3(gamma));
 
-    specular = spotLight.specular * spec * vec3(texture(texture_specular1, TexCoords));
-    specular = pow(specular, vec3(gamma));
+        specular = spotLight.specular * spec * vec3(texture(texture_specular1, TexCoords));
+        specular = pow(specular, vec3(gamma));
 
-    ambient *= attenuation * intensity;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
+        ambient *= attenuation * intensity;
+        diffuse *= attenuation * intensity;
+        specular *= attenuation * intensity;
 
-    result = result + (vec3(flashLight, flashLight, flashLight) * (ambient + diffuse + specular));
+        result = result + (ambient + diffuse + specular);
+    }
+#endif
 
+#ifdef REFLECTION_MAP
     // Reflection mapping.
-    if(reflectionMap == 1)
     {
          // Reflection
          vec3 I = normalize(fragPosition - viewPos);
@@ -260,8 +271,9 @@ void main()
          float reflect_intensity = texture(texture_reflection1, TexCoords).r;
 
          if(reflect_intensity > 0.1) // Only sample reflections when above a certain treshold
-              result = result + (texture(skybox, R) * reflect_intensity);
+              result = result + (texture(skybox, R).rgb * reflect_intensity);
     }
+#endif
 
     // apply exposure tone-mapping
     result = vec3(1.0) - exp(-result * exposure);
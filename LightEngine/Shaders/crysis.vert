@@ -9,18 +9,48 @@ out vec3 Normal;
 out vec4 FragPosLightSpaceDirec;
 out vec4 FragPosLightSpacePoint;
 
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec3 cameraDir;
+};
+
+layout (std140) uniform ShadowConstants
+{
+    mat4 direcLightSpaceMatrix;
+    mat4 pointLightSpaceMatrix;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat4 direcLightSpaceMatrix;
-uniform mat4 pointLightSpaceMatrix;
+
+// Vertex decode of quantized meshes, set by Mesh::Draw(). The defaults are for float vertices.
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec4 texCoordDecode = vec4(1.0, 1.0, 0.0, 0.0);
+uniform bool octahedralNormals = false;
+
+vec3 DecodeNormal(vec3 encoded)
+{
+    if (!octahedralNormals)
+        return encoded;
+
+    vec2 square = encoded.xy * 2.0 - 1.0;
+    vec3 n = vec3(square, 1.0 - abs(square.x) - abs(square.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0f);
-    fragPosition = vec3(model * vec4(position, 1.0f));
-    Normal = mat3(transpose(inverse(model))) * normal;
-    TexCoords = texCoords;
+    vec3 objectPosition = position * positionScale + positionOffset;
+    gl_Position = projection * view * model * vec4(objectPosition, 1.0f);
+    fragPosition = vec3(model * vec4(objectPosition, 1.0f));
+    Normal = mat3(transpose(inverse(model))) * DecodeNormal(normal);
+    TexCoords = texCoords * texCoordDecode.xy + texCoordDecode.zw;
     FragPosLightSpaceDirec = direcLightSpaceMatrix * vec4(fragPosition, 1.0);
     FragPosLightSpacePoint = pointLightSpaceMatrix * vec4(fragPosition, 1.0);
 }
\ No newline at end of file
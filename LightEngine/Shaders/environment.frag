@@ -5,12 +5,19 @@ in vec3 Position;
 
 out vec4 color;
 
-uniform vec3 cameraPos;
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec3 cameraDir;
+};
+
 uniform samplerCube skybox;
 
 void main()
 {
-     vec3 I = normalize(Position - cameraPos);
+     vec3 I = normalize(Position - viewPos);
      vec3 R = reflect(I, normalize(Normal));
      color = texture(skybox, R);
 }
\ No newline at end of file
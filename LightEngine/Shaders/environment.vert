@@ -6,9 +6,15 @@ layout (location = 1) in vec3 normal;
 out vec3 Normal;
 out vec3 Position;
 
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec3 cameraDir;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
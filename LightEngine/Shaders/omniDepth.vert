@@ -6,8 +6,13 @@ uniform mat4 model;
 
 out vec4 FragPos;
 
+// Vertex decode of quantized meshes, set by Mesh::Draw(). The defaults are for float vertices.
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
+
 void main()
 {
-     gl_Position = lightSpaceMatrix * model * vec4(position, 1.0);
-     FragPos = model * vec4(position, 1.0);
+     vec3 objectPosition = position * positionScale + positionOffset;
+     gl_Position = lightSpaceMatrix * model * vec4(objectPosition, 1.0);
+     FragPos = model * vec4(objectPosition, 1.0);
 }
\ No newline at end of file
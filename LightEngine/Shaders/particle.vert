@@ -5,9 +5,15 @@ layout (location = 1) in vec2 texCoord;
 
 out vec2 TexCoord;
 
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec3 cameraDir;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
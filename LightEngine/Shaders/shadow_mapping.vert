@@ -4,7 +4,11 @@ layout (location = 0) in vec3 position;
 uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
 
+// Vertex decode of quantized meshes, set by Mesh::Draw(). The defaults are for float vertices.
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
+
 void main()
 {
-    gl_Position = lightSpaceMatrix * model * vec4(position, 1.0f);
+    gl_Position = lightSpaceMatrix * model * vec4(position * positionScale + positionOffset, 1.0f);
 }
\ No newline at end of file
@@ -1,11 +1,17 @@
 #version 330 core
 layout (location = 0) in vec3 position;
 out vec3 TexCoords;
-uniform mat4 projection;
-uniform mat4 view;
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    vec3 cameraDir;
+};
 void main()
 {
-position = 20.0 * position;
-gl_Position = projection * view * vec4(position, 1.0);
-TexCoords = position;
+vec3 scaled = 20.0 * position;
+// Remove any translation component of the view matrix
+gl_Position = projection * mat4(mat3(view)) * vec4(scaled, 1.0);
+TexCoords = scaled;
 }
\ No newline at end of file
@@ -0,0 +1,808 @@
+#include "Benchmark.h"
+#include "..\Renderer\Model.h"
+#include "BufferAllocator.h"
+#include "BlockCompressor.h"
+#include "MipGenerator.h"
+#include "FileSystem.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+	/*
+		The logger this subsystem replaced: open, append
+		and close the file for every single message.
+	*/
+	void LogOpenAppendClose(const char* path, const char* message)
+	{
+		std::ofstream outFile;
+		outFile.open(path, std::ios::app);
+		outFile << message;
+		outFile << "\n";
+		outFile.close();
+	}
+
+	/*
+		Peak signal to noise ratio of the first channels of
+		two RGBA images, in dB.
+	*/
+	double Psnr(const unsigned char* a, const unsigned char* b, size_t pixels, unsigned int channels)
+	{
+		double error = 0.0;
+		for (size_t i = 0; i < pixels; ++i)
+		{
+			for (unsigned int c = 0; c < channels; ++c)
+			{
+				double d = (double)a[i * 4 + c] - (double)b[i * 4 + c];
+				error += d * d;
+			}
+		}
+		error /= (double)pixels * channels;
+		return (error > 0.0) ? 10.0 * log10(255.0 * 255.0 / error) : 99.0;
+	}
+}
+
+/*
+	Measures the throughput of the asynchronous logger with
+	several threads logging at the same time. Reports the
+	rate at which producers can queue messages and the rate
+	at which they actually end up on disk, and compares both
+	against the old open/append/close logger.
+
+	producerCount		-	Number of threads logging concurrently.
+	messagesPerProducer	-	Number of messages each thread logs.
+*/
+int RunLoggerBenchmark(int producerCount, int messagesPerProducer)
+{
+	const char* asyncPath = "log_benchmark.log";
+	const char* syncPath = "log_benchmark_sync.log";
+
+	if (producerCount < 1)
+		producerCount = 1;
+	if (messagesPerProducer < 1)
+		messagesPerProducer = 1;
+
+	if (!Logger::Init(asyncPath))
+	{
+		std::cout << "Could not open " << asyncPath << std::endl;
+		return 1;
+	}
+
+	std::atomic<bool> go(false);
+	std::vector<std::thread> producers;
+
+	for (int t = 0; t < producerCount; ++t)
+	{
+		producers.push_back(std::thread([&go, t, messagesPerProducer]()
+		{
+			while (!go.load())
+				std::this_thread::yield();
+
+			for (int i = 0; i < messagesPerProducer; ++i)
+				LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Producer %d message %d: Vertex Shader Compilation Successful.", t, i);
+		}));
+	}
+
+	__int64 start = getTimeNanoseconds();
+
+	go.store(true);
+	for (size_t t = 0; t < producers.size(); ++t)
+		producers[t].join();
+
+	double queueSeconds = (getTimeNanoseconds() - start) * 1e-9;
+
+	Logger::Flush();
+
+	double flushSeconds = (getTimeNanoseconds() - start) * 1e-9;
+
+	unsigned int stalls = Logger::GetStallCount();
+	Logger::Shutdown();
+
+	double total = (double)producerCount * (double)messagesPerProducer;
+
+	// The old logger is much slower, so only time a slice of the workload.
+	int syncMessages = messagesPerProducer < 2000 ? messagesPerProducer : 2000;
+
+	std::ofstream truncate(syncPath, std::ios::out | std::ios::trunc);
+	truncate.close();
+
+	start = getTimeNanoseconds();
+	for (int i = 0; i < syncMessages; ++i)
+		LogOpenAppendClose(syncPath, "Producer 0: Vertex Shader Compilation Successful.");
+	double syncSeconds = (getTimeNanoseconds() - start) * 1e-9;
+
+	printf("Logger benchmark: %d producer thread(s), %d messages each\n", producerCount, messagesPerProducer);
+	printf("  async, queued     : %12.0f msg/s (%.3f s)\n", total / queueSeconds, queueSeconds);
+	printf("  async, on disk    : %12.0f msg/s (%.3f s)\n", total / flushSeconds, flushSeconds);
+	printf("  producer stalls   : %u\n", stalls);
+	printf("  open/append/close : %12.0f msg/s (%d messages, 1 thread)\n", syncMessages / syncSeconds, syncMessages);
+
+	return 0;
+}
+
+/*
+	Compares loading the bundled models with Assimp (cold)
+	against loading them from their mesh cache (warm). Both
+	produce the vertex and index data ready for upload;
+	textures and the upload itself are left out because
+	they need a context and cost the same either way. The
+	warm path reads every byte of the mapped data, as
+	glBufferData() would.
+
+	iterations	-	Number of loads of each kind per model.
+*/
+int RunModelLoadBenchmark(int iterations)
+{
+	const char* models[] = {
+		"Models/LibertyStatue/LibertStatue.obj",
+		"Models/Nanosuit/nanosuit.obj"
+	};
+
+	if (iterations < 1)
+		iterations = 1;
+
+	printf("Model load benchmark: %d load(s) of each kind\n", iterations);
+
+	for (unsigned int m = 0; m < sizeof(models) / sizeof(models[0]); ++m)
+	{
+		string path = models[m];
+		string cachePath = Model::GetCachePath(path);
+
+		vector<MeshSource> sources;
+		double coldSeconds = 0.0;
+		for (int i = 0; i < iterations; ++i)
+		{
+			sources.clear();
+
+			__int64 start = getTimeNanoseconds();
+			bool imported = Model::Import(path, sources);
+			__int64 end = getTimeNanoseconds();
+
+			if (!imported)
+			{
+				printf("  %s : could not be imported\n", path.c_str());
+				return 1;
+			}
+			coldSeconds += (end - start) * 1e-9;
+		}
+
+		if (!MeshCache::Write(cachePath.c_str(), sources))
+		{
+			printf("  %s : could not write %s\n", path.c_str(), cachePath.c_str());
+			return 1;
+		}
+
+		size_t vertexCount = 0, indexCount = 0, cacheSize = 0;
+		unsigned int checksum = 0;
+		double warmSeconds = 0.0;
+		for (int i = 0; i < iterations; ++i)
+		{
+			__int64 start = getTimeNanoseconds();
+
+			MeshCache cache;
+			if (!cache.Open(cachePath.c_str()))
+			{
+				printf("  %s : could not open %s\n", path.c_str(), cachePath.c_str());
+				return 1;
+			}
+
+			vertexCount = indexCount = 0;
+			for (unsigned int j = 0; j < cache.GetMeshCount(); ++j)
+			{
+				const MeshCacheMesh& mesh = cache.GetMesh(j);
+				const unsigned int* data = (const unsigned int*)cache.GetVertices(mesh);
+				size_t words = mesh.vertexCount * GetVertexFormatStride(MeshCache::GetVertexFormat(mesh)) / sizeof(unsigned int);
+				for (size_t w = 0; w < words; ++w)
+					checksum += data[w];
+
+				if (MeshCache::GetIndexType(mesh) == GL_UNSIGNED_SHORT)
+				{
+					const GLushort* indices = (const GLushort*)cache.GetIndices(mesh);
+					for (unsigned int w = 0; w < mesh.indexCount; ++w)
+						checksum += indices[w];
+				}
+				else
+				{
+					const GLuint* indices = (const GLuint*)cache.GetIndices(mesh);
+					for (unsigned int w = 0; w < mesh.indexCount; ++w)
+						checksum += indices[w];
+				}
+
+				vertexCount += mesh.vertexCount;
+				indexCount += mesh.indexCount;
+			}
+			cacheSize = cache.GetFileSize();
+			cache.Close();
+
+			__int64 end = getTimeNanoseconds();
+			warmSeconds += (end - start) * 1e-9;
+		}
+
+		double coldMs = coldSeconds * 1000.0 / iterations;
+		double warmMs = warmSeconds * 1000.0 / iterations;
+
+		printf("  %s\n", path.c_str());
+		printf("    meshes / vertices / triangles : %u / %u / %u\n", (unsigned int)sources.size(), (unsigned int)vertexCount, (unsigned int)(indexCount / 3));
+		printf("    cold (Assimp)                 : %10.2f ms\n", coldMs);
+		printf("    warm (mapped mesh cache)      : %10.2f ms (%.1fx, %u KB, checksum %08x)\n", warmMs, coldMs / warmMs, (unsigned int)(cacheSize / 1024), checksum);
+	}
+
+	return 0;
+}
+
+/*
+	Times Model::Import() of the bundled models with the
+	mesh conversion spread over 1, 2, 4 and 8 threads.
+	Assimp's own parsing is single-threaded and included,
+	as it is part of every cold load.
+
+	iterations	-	Number of imports per model and thread count.
+*/
+int RunImportBenchmark(int iterations)
+{
+	const char* models[] = {
+		"Models/LibertyStatue/LibertStatue.obj",
+		"Models/Nanosuit/nanosuit.obj"
+	};
+	const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+
+	if (iterations < 1)
+		iterations = 1;
+
+	printf("Import benchmark: %d import(s) per model and thread count, %u hardware thread(s)\n", iterations, ThreadPool::GetDefaultThreadCount());
+
+	for (unsigned int m = 0; m < sizeof(models) / sizeof(models[0]); ++m)
+	{
+		printf("  %s\n", models[m]);
+
+		double baseMs = 0.0;
+		for (unsigned int t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+		{
+			ThreadPool pool(threadCounts[t]);
+
+			double seconds = 0.0;
+			size_t meshCount = 0;
+			for (int i = 0; i < iterations; ++i)
+			{
+				vector<MeshSource> sources;
+
+				__int64 start = getTimeNanoseconds();
+				bool imported = Model::Import(models[m], sources, &pool);
+				__int64 end = getTimeNanoseconds();
+
+				if (!imported)
+				{
+					printf("    could not be imported\n");
+					return 1;
+				}
+				seconds += (end - start) * 1e-9;
+				meshCount = sources.size();
+			}
+
+			double ms = seconds * 1000.0 / iterations;
+			if (t == 0)
+				baseMs = ms;
+
+			printf("    %u thread(s) : %10.2f ms (%.2fx, %u meshes)\n", threadCounts[t], ms, baseMs / ms, (unsigned int)meshCount);
+		}
+	}
+
+	return 0;
+}
+
+/*
+	Culls the meshlets of the bundled models from cameras
+	circling them at three distances, and reports the
+	clusters and triangles culled per frame and the time
+	the SSE and scalar culling take. Both have to agree on
+	every cluster.
+
+	iterations	-	Number of times every view is culled for the timing.
+*/
+int RunClusterCullingBenchmark(int iterations)
+{
+	const char* models[] = {
+		"Models/LibertyStatue/LibertStatue.obj",
+		"Models/Nanosuit/nanosuit.obj"
+	};
+	const unsigned int VIEWS_PER_ORBIT = 32;
+	const float ORBIT_DISTANCES[] = { 1.5f, 3.0f, 6.0f };	// In bounding sphere radii.
+
+	if (iterations < 1)
+		iterations = 1;
+
+	printf("Cluster culling benchmark: %u views per model, each culled %d time(s)\n", VIEWS_PER_ORBIT * 3, iterations);
+
+	ThreadPool pool(ThreadPool::GetDefaultThreadCount());
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 1000.0f);
+
+	for (unsigned int m = 0; m < sizeof(models) / sizeof(models[0]); ++m)
+	{
+		vector<MeshSource> sources;
+		if (!Model::Import(models[m], sources, &pool))
+		{
+			printf("  %s : could not be imported\n", models[m]);
+			return 1;
+		}
+
+		vector<ClusterBounds> bounds(sources.size());
+		glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+		unsigned int clusters = 0, triangles = 0;
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			ClusterCuller::BuildBounds(sources[i].meshlets, bounds[i]);
+			clusters += bounds[i].count;
+			triangles += sources[i].lods[0].indexCount / 3;
+			for (size_t v = 0; v < sources[i].vertices.size(); ++v)
+			{
+				boundsMin = glm::min(boundsMin, sources[i].vertices[v].Position);
+				boundsMax = glm::max(boundsMax, sources[i].vertices[v].Position);
+			}
+		}
+
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		float radius = glm::length(boundsMax - boundsMin) * 0.5f;
+
+		double clustersCulled = 0.0, trianglesCulled = 0.0, sseSeconds = 0.0, scalarSeconds = 0.0;
+		unsigned int mismatches = 0, views = 0;
+		vector<unsigned char> visible, reference;
+
+		for (unsigned int d = 0; d < sizeof(ORBIT_DISTANCES) / sizeof(ORBIT_DISTANCES[0]); ++d)
+		{
+			for (unsigned int v = 0; v < VIEWS_PER_ORBIT; ++v, ++views)
+			{
+				float angle = v * 6.2831853f / VIEWS_PER_ORBIT;
+				glm::vec3 eye = center + glm::vec3(cosf(angle), 0.25f, sinf(angle)) * radius * ORBIT_DISTANCES[d];
+				glm::mat4 viewProjection = projection * glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+
+				for (size_t i = 0; i < bounds.size(); ++i)
+				{
+					visible.resize(bounds[i].radius.size());
+					reference.resize(bounds[i].radius.size());
+					if (visible.empty())
+						continue;
+
+					__int64 start = getTimeNanoseconds();
+					for (int r = 0; r < iterations; ++r)
+						ClusterCuller::Cull(bounds[i], viewProjection, eye, &visible[0]);
+					__int64 middle = getTimeNanoseconds();
+					for (int r = 0; r < iterations; ++r)
+						ClusterCuller::CullScalar(bounds[i], viewProjection, eye, &reference[0]);
+					__int64 end = getTimeNanoseconds();
+
+					sseSeconds += (middle - start) * 1e-9;
+					scalarSeconds += (end - middle) * 1e-9;
+
+					for (unsigned int c = 0; c < bounds[i].count; ++c)
+					{
+						if (visible[c] != reference[c])
+							++mismatches;
+						if (!visible[c])
+						{
+							clustersCulled += 1.0;
+							trianglesCulled += sources[i].meshlets[c].indexCount / 3;
+						}
+					}
+				}
+			}
+		}
+
+		double culls = (double)views * iterations;
+		printf("  %s : %u clusters, %u triangles\n", models[m], clusters, triangles);
+		printf("    culled per frame : %.1f clusters (%.1f%%), %.0f triangles (%.1f%%)\n",
+			clustersCulled / views, 100.0 * clustersCulled / views / clusters, trianglesCulled / views, 100.0 * trianglesCulled / views / triangles);
+		printf("    SSE : %.2f us per frame, scalar : %.2f us per frame (%.2fx), %u mismatch(es)\n",
+			sseSeconds * 1e6 / culls, scalarSeconds * 1e6 / culls, scalarSeconds / sseSeconds, mismatches);
+
+		if (mismatches > 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+	Churns a BufferAllocator the size of a geometry pool
+	like a streaming scene would : it is filled with
+	mesh-sized allocations, then a random one is freed and
+	a new one of random size allocated, over and over.
+	Reports the time per operation, how often an
+	allocation didn't fit (the pool would have grown) and
+	the fragmentation left. Fails if the bookkeeping loses
+	or overlaps a range.
+
+	iterations	-	Number of free and allocate pairs.
+*/
+int RunAllocatorBenchmark(int iterations)
+{
+	const unsigned int CAPACITY = GEOMETRY_POOL_INITIAL_VERTICES * 16;
+	const unsigned int MIN_SIZE = 64;
+	const unsigned int MAX_SIZE = 16384;
+	const float FILL = 0.75f;
+
+	if (iterations < 1)
+		iterations = 1;
+
+	printf("Allocator benchmark: %u vertices, %d free/allocate pair(s) at %.0f%% fill\n", CAPACITY, iterations, FILL * 100.0f);
+
+	// Fixed seed, so every run churns the same way.
+	unsigned int seed = 12345;
+	struct Range { unsigned int offset, size; };
+	vector<Range> live;
+	BufferAllocator allocator;
+	allocator.Reset(CAPACITY);
+
+	unsigned int liveSize = 0, failures = 0;
+	__int64 start = getTimeNanoseconds();
+	for (int i = -1; i < iterations; ++i)
+	{
+		// The first pass fills the allocator, the others replace one range.
+		if (i >= 0 && !live.empty())
+		{
+			seed = seed * 1664525u + 1013904223u;
+			size_t victim = (seed >> 8) % live.size();
+			allocator.Free(live[victim].offset, live[victim].size);
+			liveSize -= live[victim].size;
+			live[victim] = live.back();
+			live.pop_back();
+		}
+
+		while (liveSize < CAPACITY * FILL)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			Range range;
+			range.size = MIN_SIZE + (seed >> 8) % (MAX_SIZE - MIN_SIZE);
+			if (!allocator.Allocate(range.size, range.offset))
+			{
+				++failures;
+				break;
+			}
+			live.push_back(range);
+			liveSize += range.size;
+		}
+	}
+	__int64 end = getTimeNanoseconds();
+
+	BufferAllocatorStats stats;
+	allocator.GetStats(stats);
+
+	// The live ranges have to be what the allocator counts as used, without overlapping.
+	bool consistent = stats.used == liveSize && stats.allocations == live.size();
+	std::sort(live.begin(), live.end(), [](const Range& a, const Range& b) { return a.offset < b.offset; });
+	for (size_t i = 1; i < live.size(); ++i)
+		consistent = consistent && live[i - 1].offset + live[i - 1].size <= live[i].offset;
+
+	printf("  %.1f ns per free/allocate pair, %u allocation(s) didn't fit (%.2f%%)\n",
+		(double)(end - start) / iterations, failures, 100.0 * failures / iterations);
+	printf("  %u live allocations, %u / %u used, %u free block(s), largest %u, fragmentation %.1f%%\n",
+		stats.allocations, stats.used, stats.capacity, stats.freeBlocks, stats.largestFree, stats.fragmentation * 100.0f);
+	printf("  bookkeeping %s\n", consistent ? "consistent" : "INCONSISTENT");
+
+	return consistent ? 0 : 1;
+}
+
+/*
+	Compares what the CPU does per mesh draw to bind the
+	textures of the bundled models : building and hashing
+	the sampler names on every draw, like Mesh::Draw()
+	used to, against walking the binding tables interned
+	at load time. The GL calls are the same either way
+	and left out, as is the driver's own name lookup the
+	old path paid on top.
+
+	iterations	-	Number of times every mesh is "drawn".
+*/
+int RunMaterialBenchmark(int iterations)
+{
+	const char* models[] = {
+		"Models/LibertyStatue/LibertStatue.obj",
+		"Models/Nanosuit/nanosuit.obj"
+	};
+
+	if (iterations < 1)
+		iterations = 1;
+
+	printf("Material benchmark: every mesh bound %d time(s)\n", iterations);
+
+	for (unsigned int m = 0; m < sizeof(models) / sizeof(models[0]); ++m)
+	{
+		vector<MeshSource> sources;
+		if (!Model::Import(models[m], sources))
+		{
+			printf("  %s : could not be imported\n", models[m]);
+			return 1;
+		}
+
+		// Stand-in texture objects, one per distinct path.
+		vector<vector<Texture> > meshTextures(sources.size());
+		vector<MaterialId> materials(sources.size());
+		vector<string> paths;
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			for (size_t t = 0; t < sources[i].textures.size(); ++t)
+			{
+				Texture texture;
+				texture.type = sources[i].textures[t].type;
+				texture.path = aiString(sources[i].textures[t].path);
+				texture.id = (GLuint)(std::find(paths.begin(), paths.end(), sources[i].textures[t].path) - paths.begin()) + 1;
+				if (texture.id > paths.size())
+					paths.push_back(sources[i].textures[t].path);
+				meshTextures[i].push_back(texture);
+			}
+			materials[i] = MaterialLibrary::Intern(meshTextures[i]);
+		}
+
+		unsigned int oldChecksum = 0, newChecksum = 0;
+		__int64 start = getTimeNanoseconds();
+		for (int r = 0; r < iterations; ++r)
+		{
+			for (size_t i = 0; i < meshTextures.size(); ++i)
+			{
+				const vector<Texture>& textures = meshTextures[i];
+				GLuint diffuseNr = 1;
+				GLuint specularNr = 1;
+				GLuint reflectionNr = 1;
+				for (GLuint t = 0; t < textures.size(); t++)
+				{
+					stringstream ss;
+					string name = textures[t].type;
+					if (name == "texture_diffuse")
+						ss << diffuseNr++;
+					else if (name == "texture_specular")
+						ss << specularNr++;
+					else if (name == "texture_reflection")
+						ss << reflectionNr++;
+					oldChecksum += Shader::HashName((name + ss.str()).c_str()) + t + textures[t].id;
+				}
+			}
+		}
+		__int64 middle = getTimeNanoseconds();
+		for (int r = 0; r < iterations; ++r)
+		{
+			for (size_t i = 0; i < materials.size(); ++i)
+			{
+				unsigned int count;
+				const MaterialBinding* bindings = MaterialLibrary::GetBindings(materials[i], count);
+				for (unsigned int b = 0; b < count; ++b)
+					newChecksum += bindings[b].samplerHash + bindings[b].unit + bindings[b].texture;
+			}
+		}
+		__int64 end = getTimeNanoseconds();
+
+		double draws = (double)iterations * sources.size();
+		double oldNs = (double)(middle - start) / draws;
+		double newNs = (double)(end - middle) / draws;
+		printf("  %s : %u meshes, %u material(s) interned so far\n", models[m], (unsigned int)sources.size(), MaterialLibrary::GetMaterialCount());
+		printf("    names per draw : %8.1f ns, binding table : %6.1f ns (%.0fx), checksums %s\n",
+			oldNs, newNs, oldNs / newNs, oldChecksum == newChecksum ? "match" : "DIFFER");
+
+		if (oldChecksum != newChecksum)
+			return 1;
+	}
+
+	MaterialLibrary::Shutdown();
+	return 0;
+}
+
+/*
+	Encodes the bundled textures to the block format they
+	are cooked to and decodes them back : encoding speed
+	on one thread and on the pool, compression ratio and
+	quality (PSNR of the channels the format keeps).
+
+	iterations	-	Number of times every texture is encoded.
+*/
+int RunBlockCompressionBenchmark(int iterations)
+{
+	struct BenchTexture { const char* path; GLenum format; unsigned int channels; };
+	const BenchTexture textures[] = {
+		{ "Textures/wall_diffuse.bmp", GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 3 },
+		{ "Textures/floor_diffuse.bmp", GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 3 },
+		{ "Textures/wall_normal.bmp", GL_COMPRESSED_RG_RGTC2, 2 },
+		{ "Textures/floor_normal.bmp", GL_COMPRESSED_RG_RGTC2, 2 },
+		{ "Textures/Particle.bmp", GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4 }
+	};
+
+	if (iterations < 1)
+		iterations = 1;
+
+	ThreadPool pool(ThreadPool::GetDefaultThreadCount());
+	printf("Block compression benchmark: every texture encoded %d time(s), %u pool thread(s)\n", iterations, pool.GetThreadCount());
+
+	for (unsigned int t = 0; t < sizeof(textures) / sizeof(textures[0]); ++t)
+	{
+		int width, height;
+		unsigned char* pixels = SOIL_load_image(textures[t].path, &width, &height, 0, SOIL_LOAD_RGBA);
+		if (pixels == NULL)
+		{
+			printf("  %s : could not be loaded\n", textures[t].path);
+			return 1;
+		}
+
+		vector<unsigned char> blocks(BlockCompressor::GetImageSize(textures[t].format, width, height));
+		vector<unsigned char> decoded((size_t)width * height * 4);
+
+		__int64 start = getTimeNanoseconds();
+		for (int i = 0; i < iterations; ++i)
+			BlockCompressor::Encode(pixels, width, height, textures[t].format, &blocks[0]);
+		__int64 middle = getTimeNanoseconds();
+		for (int i = 0; i < iterations; ++i)
+			BlockCompressor::Encode(pixels, width, height, textures[t].format, &blocks[0], &pool);
+		__int64 end = getTimeNanoseconds();
+
+		BlockCompressor::Decode(&blocks[0], width, height, textures[t].format, &decoded[0]);
+
+		double megapixels = (double)width * height * iterations / 1e6;
+		printf("  %s : %dx%d, %.0f:1 against RGBA8, %.2f dB\n", textures[t].path, width, height,
+			(double)width * height * 4.0 / blocks.size(), Psnr(pixels, &decoded[0], (size_t)width * height, textures[t].channels));
+		printf("    encode : %7.1f Mpix/s on one thread, %7.1f Mpix/s on the pool\n",
+			megapixels / ((middle - start) * 1e-9), megapixels / ((end - middle) * 1e-9));
+
+		SOIL_free_image_data(pixels);
+	}
+
+	return 0;
+}
+
+/*
+	Builds the mip chains of the bundled textures with
+	every filter, on one thread and on a pool, and reports
+	the source megapixels per second per core. Diffuse
+	maps are filtered as sRGB, normal maps renormalized.
+
+	iterations	-	Number of times every chain is built.
+*/
+int RunMipBenchmark(int iterations)
+{
+	struct BenchTexture { const char* path; MipContent content; };
+	const BenchTexture textures[] = {
+		{ "Textures/wall_diffuse.bmp", MIP_CONTENT_SRGB },
+		{ "Textures/floor_diffuse.bmp", MIP_CONTENT_SRGB },
+		{ "Textures/wall_normal.bmp", MIP_CONTENT_NORMAL },
+		{ "Textures/wall_specular.bmp", MIP_CONTENT_LINEAR }
+	};
+
+	if (iterations < 1)
+		iterations = 1;
+
+	ThreadPool pool(ThreadPool::GetDefaultThreadCount());
+	unsigned int cores = pool.GetThreadCount();
+	printf("Mip benchmark: every chain built %d time(s), %u pool thread(s)\n", iterations, cores);
+
+	for (unsigned int t = 0; t < sizeof(textures) / sizeof(textures[0]); ++t)
+	{
+		int width, height;
+		unsigned char* pixels = SOIL_load_image(textures[t].path, &width, &height, 0, SOIL_LOAD_RGB);
+		if (pixels == NULL)
+		{
+			printf("  %s : could not be loaded\n", textures[t].path);
+			return 1;
+		}
+
+		printf("  %s : %dx%d, %u levels\n", textures[t].path, width, height, MipGenerator::GetLevelCount(width, height));
+		for (unsigned int f = 0; f < MIP_FILTER_COUNT; ++f)
+		{
+			vector<MipLevel> levels;
+			__int64 start = getTimeNanoseconds();
+			for (int i = 0; i < iterations; ++i)
+				MipGenerator::Generate(pixels, width, height, 3, textures[t].content, (MipFilter)f, levels);
+			__int64 middle = getTimeNanoseconds();
+			for (int i = 0; i < iterations; ++i)
+				MipGenerator::Generate(pixels, width, height, 3, textures[t].content, (MipFilter)f, levels, &pool);
+			__int64 end = getTimeNanoseconds();
+
+			double megapixels = (double)width * height * iterations / 1e6;
+			double single = megapixels / ((middle - start) * 1e-9);
+			double parallel = megapixels / ((end - middle) * 1e-9);
+			printf("    %-8s : %7.1f Mpix/s on one thread, %7.1f Mpix/s on the pool (%.1f per core, %.1fx)\n",
+				MipGenerator::GetFilterName((MipFilter)f), single, parallel, parallel / cores, parallel / single);
+		}
+
+		SOIL_free_image_data(pixels);
+	}
+
+	return 0;
+}
+
+/*
+	Packs the assets for --pack and reports how much
+	the compression saved.
+
+	packPath	-	Pack file to write.
+*/
+int RunPackBuild(const char* packPath)
+{
+	ThreadPool pool(ThreadPool::GetDefaultThreadCount());
+
+	__int64 start = getTimeNanoseconds();
+	bool built = FileSystem::BuildPack(packPath, true, &pool);
+	__int64 end = getTimeNanoseconds();
+
+	PackFile pack;
+	if (!built || !pack.Open(packPath))
+	{
+		printf("Could not build pack %s\n", packPath);
+		return 1;
+	}
+
+	double size = 0.0, stored = 0.0;
+	unsigned int compressed = 0;
+	for (unsigned int i = 0; i < pack.GetEntryCount(); ++i)
+	{
+		const PackEntry& entry = pack.GetEntry(i);
+		size += (double)entry.size;
+		stored += (double)entry.storedSize;
+		if (entry.codec != PACK_CODEC_NONE)
+			++compressed;
+	}
+
+	printf("Pack %s : %u files (%u compressed), %.2f MB stored for %.2f MB (%.0f%%), built in %.1f ms on %u thread(s)\n",
+		packPath, pack.GetEntryCount(), compressed, stored / (1024.0 * 1024.0), size / (1024.0 * 1024.0),
+		size > 0.0 ? 100.0 * stored / size : 100.0, (end - start) * 1e-6, pool.GetThreadCount());
+
+	return 0;
+}
+
+/*
+	Reads every file of the default pack through the
+	FileSystem, from the loose files and then from the
+	pack, mount included, and compares the time and the
+	files opened. The OS file cache is warm after the
+	first iteration for both.
+
+	iterations	-	Number of times every file is read.
+*/
+int RunFileSystemBenchmark(int iterations)
+{
+	vector<string> names;
+	{
+		PackFile pack;
+		if (!pack.Open(FILE_SYSTEM_DEFAULT_PACK))
+		{
+			printf("Could not open %s, build it with --build-pack first\n", FILE_SYSTEM_DEFAULT_PACK);
+			return 1;
+		}
+
+		for (unsigned int i = 0; i < pack.GetEntryCount(); ++i)
+			names.push_back(pack.GetName(pack.GetEntry(i)));
+	}
+
+	if (iterations < 1)
+		iterations = 1;
+
+	ThreadPool pool(ThreadPool::GetDefaultThreadCount());
+	printf("File system benchmark: %u files read %d time(s), %u pool thread(s)\n", (unsigned int)names.size(), iterations, pool.GetThreadCount());
+
+	const char* modes[] = { "loose files", "pack", "pack + pool" };
+	for (unsigned int m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m)
+	{
+		FileSystem::ResetStats();
+
+		__int64 start = getTimeNanoseconds();
+		for (int i = 0; i < iterations; ++i)
+		{
+			if (m > 0)
+				FileSystem::Mount(FILE_SYSTEM_DEFAULT_PACK);
+
+			FileData data;
+			for (size_t n = 0; n < names.size(); ++n)
+				FileSystem::ReadFile(names[n].c_str(), data, m == 2 ? &pool : NULL);
+
+			FileSystem::Unmount();
+		}
+		__int64 end = getTimeNanoseconds();
+
+		FileSystemStats stats;
+		FileSystem::GetStats(stats);
+		printf("  %-12s : %8.3f ms per pass, %4u files opened per pass, %.2f MB read, %u failed\n", modes[m],
+			(end - start) * 1e-6 / iterations, stats.filesOpened / iterations,
+			stats.bytesRead / (1024.0 * 1024.0 * iterations), stats.failedReads);
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+// Includes.
+#include "Utility.h"
+
+/*
+	Stand-alone microbenchmarks that don't need a window
+	or an OpenGL context. They are started from the command
+	line (see Demo.cpp) and print their results to stdout.
+*/
+
+// Function prototypes.
+int RunLoggerBenchmark(int producerCount, int messagesPerProducer);
+int RunModelLoadBenchmark(int iterations);
+int RunImportBenchmark(int iterations);
+int RunClusterCullingBenchmark(int iterations);
+int RunAllocatorBenchmark(int iterations);
+int RunMaterialBenchmark(int iterations);
+int RunBlockCompressionBenchmark(int iterations);
+int RunMipBenchmark(int iterations);
+int RunPackBuild(const char* packPath);
+int RunFileSystemBenchmark(int iterations);
\ No newline at end of file
@@ -0,0 +1,542 @@
+#include "BlockCompressor.h"
+#include <emmintrin.h>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	// Pixels in a block.
+	const unsigned int BLOCK_PIXELS = BLOCK_DIMENSION * BLOCK_DIMENSION;
+
+	/*
+		RGB565 of a color in [0, 255], rounded to the nearest.
+	*/
+	unsigned short PackRgb565(const float* color)
+	{
+		int r = (int)(std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+		int g = (int)(std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+		int b = (int)(std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+		return (unsigned short)((r << 11) | (g << 5) | b);
+	}
+
+	/*
+		Color of an RGB565 value in [0, 255], expanded the
+		way the GPU does it.
+	*/
+	void UnpackRgb565(unsigned short packed, int* color)
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	/*
+		Picks the closest entry of the four color palette of
+		two endpoints for every pixel of a block, four pixels
+		at a time. Returns the summed squared error.
+
+		r, g, b	-	Channels of the 16 pixels.
+		c0, c1	-	Endpoints, drawn in four color mode.
+		indices	-	Receives 2 bits per pixel, pixel 0 lowest.
+	*/
+	float FitColorIndices(const float* r, const float* g, const float* b, unsigned short c0, unsigned short c1, unsigned int& indices)
+	{
+		int e0[3], e1[3];
+		UnpackRgb565(c0, e0);
+		UnpackRgb565(c1, e1);
+
+		float palette[4][3];
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[0][c] = (float)e0[c];
+			palette[1][c] = (float)e1[c];
+			palette[2][c] = (2.0f * e0[c] + e1[c]) / 3.0f;
+			palette[3][c] = (e0[c] + 2.0f * e1[c]) / 3.0f;
+		}
+
+		__m128 total = _mm_setzero_ps();
+		indices = 0;
+		for (unsigned int i = 0; i < BLOCK_PIXELS; i += 4)
+		{
+			__m128 pr = _mm_loadu_ps(r + i);
+			__m128 pg = _mm_loadu_ps(g + i);
+			__m128 pb = _mm_loadu_ps(b + i);
+
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (int k = 0; k < 4; ++k)
+			{
+				__m128 dr = _mm_sub_ps(pr, _mm_set1_ps(palette[k][0]));
+				__m128 dg = _mm_sub_ps(pg, _mm_set1_ps(palette[k][1]));
+				__m128 db = _mm_sub_ps(pb, _mm_set1_ps(palette[k][2]));
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+
+				__m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+				best = _mm_min_ps(best, distance);
+				bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex), _mm_and_si128(closer, _mm_set1_epi32(k)));
+			}
+			total = _mm_add_ps(total, best);
+
+			int lanes[4];
+			_mm_storeu_si128((__m128i*)lanes, bestIndex);
+			for (unsigned int j = 0; j < 4; ++j)
+				indices |= (unsigned int)lanes[j] << (2 * (i + j));
+		}
+
+		float sums[4];
+		_mm_storeu_ps(sums, total);
+		return sums[0] + sums[1] + sums[2] + sums[3];
+	}
+
+	/*
+		Endpoints that fit the pixels best for the given
+		indices, by least squares. Returns false if the
+		indices don't determine two endpoints.
+	*/
+	bool RefineEndpoints(const float* r, const float* g, const float* b, unsigned int indices, float* e0, float* e1)
+	{
+		// Weight of the first endpoint for every index.
+		static const float WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+		for (unsigned int i = 0; i < BLOCK_PIXELS; ++i)
+		{
+			float wa = WEIGHTS[(indices >> (2 * i)) & 3];
+			float wb = 1.0f - wa;
+			aa += wa * wa;
+			ab += wa * wb;
+			bb += wb * wb;
+			ax[0] += wa * r[i]; ax[1] += wa * g[i]; ax[2] += wa * b[i];
+			bx[0] += wb * r[i]; bx[1] += wb * g[i]; bx[2] += wb * b[i];
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (fabsf(determinant) < 1e-6f)
+			return false;
+
+		for (int c = 0; c < 3; ++c)
+		{
+			e0[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+			e1[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+		}
+		return true;
+	}
+}
+
+/*
+	Whether a format is one the compressor encodes.
+
+	format	-	Compressed internal format.
+*/
+bool BlockCompressor::IsSupported(GLenum format)
+{
+	switch (format)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RG_RGTC2:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+	Bytes of one 4x4 block : 8 for BC1, 16 otherwise.
+
+	format	-	A supported compressed format.
+*/
+unsigned int BlockCompressor::GetBlockSize(GLenum format)
+{
+	return (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT) ? 8 : 16;
+}
+
+/*
+	Bytes of an encoded image, the size of a mip level
+	given to glCompressedTexImage2D(). Partial blocks at the
+	right and bottom edges count as whole ones.
+
+	format	-	A supported compressed format.
+	width	-	Width of the image in pixels.
+	height	-	Height of the image in pixels.
+*/
+size_t BlockCompressor::GetImageSize(GLenum format, unsigned int width, unsigned int height)
+{
+	size_t blocksX = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	size_t blocksY = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	return std::max<size_t>(blocksX, 1) * std::max<size_t>(blocksY, 1) * GetBlockSize(format);
+}
+
+/*
+	Encodes an image. Blocks that reach past the right or
+	bottom edge repeat the last column or row.
+
+	rgba	-	Pixels, 4 bytes each, rows tightly packed.
+	width	-	Width of the image in pixels.
+	height	-	Height of the image in pixels.
+	format	-	A supported compressed format.
+	blocks	-	Receives GetImageSize() bytes.
+	pool	-	Threads to encode rows of blocks on, may be NULL.
+				Not the pool of the calling task.
+*/
+void BlockCompressor::Encode(const unsigned char* rgba, unsigned int width, unsigned int height, GLenum format, unsigned char* blocks, ThreadPool* pool)
+{
+	unsigned int blocksX = std::max((width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION, 1u);
+	unsigned int blocksY = std::max((height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION, 1u);
+	unsigned int blockSize = GetBlockSize(format);
+
+	std::function<void(unsigned int)> encodeRow = [=](unsigned int by)
+	{
+		unsigned char pixels[BLOCK_PIXELS * 4];
+		for (unsigned int bx = 0; bx < blocksX; ++bx)
+		{
+			for (unsigned int y = 0; y < BLOCK_DIMENSION; ++y)
+			{
+				unsigned int sourceY = std::min(by * BLOCK_DIMENSION + y, height - 1);
+				for (unsigned int x = 0; x < BLOCK_DIMENSION; ++x)
+				{
+					unsigned int sourceX = std::min(bx * BLOCK_DIMENSION + x, width - 1);
+					memcpy(&pixels[(y * BLOCK_DIMENSION + x) * 4], &rgba[((size_t)sourceY * width + sourceX) * 4], 4);
+				}
+			}
+
+			unsigned char* block = &blocks[((size_t)by * blocksX + bx) * blockSize];
+			switch (format)
+			{
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+				encodeChannel(pixels, 3, block);
+				encodeColor(pixels, block + 8);
+				break;
+			case GL_COMPRESSED_RG_RGTC2:
+				encodeChannel(pixels, 0, block);
+				encodeChannel(pixels, 1, block + 8);
+				break;
+			default:
+				encodeColor(pixels, block);
+				break;
+			}
+		}
+	};
+
+	if (pool != NULL && blocksY > 1)
+	{
+		pool->ParallelFor(blocksY, encodeRow);
+	}
+	else
+	{
+		for (unsigned int by = 0; by < blocksY; ++by)
+			encodeRow(by);
+	}
+}
+
+/*
+	Decodes an image, to measure the encoding error.
+	Channels a format doesn't store are 0, alpha is 255.
+
+	blocks	-	Encoded image, GetImageSize() bytes.
+	width	-	Width of the image in pixels.
+	height	-	Height of the image in pixels.
+	format	-	A supported compressed format.
+	rgba	-	Receives the pixels, 4 bytes each.
+*/
+void BlockCompressor::Decode(const unsigned char* blocks, unsigned int width, unsigned int height, GLenum format, unsigned char* rgba)
+{
+	unsigned int blocksX = std::max((width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION, 1u);
+	unsigned int blocksY = std::max((height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION, 1u);
+	unsigned int blockSize = GetBlockSize(format);
+
+	for (unsigned int by = 0; by < blocksY; ++by)
+	{
+		for (unsigned int bx = 0; bx < blocksX; ++bx)
+		{
+			unsigned char pixels[BLOCK_PIXELS * 4];
+			memset(pixels, 0, sizeof(pixels));
+			for (unsigned int i = 0; i < BLOCK_PIXELS; ++i)
+				pixels[i * 4 + 3] = 255;
+
+			const unsigned char* block = &blocks[((size_t)by * blocksX + bx) * blockSize];
+			switch (format)
+			{
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+				decodeColor(block + 8, true, pixels);
+				decodeChannel(block, 3, pixels);
+				break;
+			case GL_COMPRESSED_RG_RGTC2:
+				decodeChannel(block, 0, pixels);
+				decodeChannel(block + 8, 1, pixels);
+				break;
+			default:
+				decodeColor(block, false, pixels);
+				break;
+			}
+
+			for (unsigned int y = 0; y < BLOCK_DIMENSION && by * BLOCK_DIMENSION + y < height; ++y)
+			{
+				for (unsigned int x = 0; x < BLOCK_DIMENSION && bx * BLOCK_DIMENSION + x < width; ++x)
+				{
+					size_t target = ((size_t)(by * BLOCK_DIMENSION + y) * width + bx * BLOCK_DIMENSION + x) * 4;
+					memcpy(&rgba[target], &pixels[(y * BLOCK_DIMENSION + x) * 4], 4);
+				}
+			}
+		}
+	}
+}
+
+/*
+	Encodes the colors of a block as BC1, always in four
+	color mode. The endpoints start at the extremes of the
+	colors along their principal axis (found by power
+	iteration on the covariance) and are refined once by
+	least squares if that lowers the error.
+
+	pixels	-	16 RGBA pixels, row by row.
+	block	-	Receives 8 bytes.
+*/
+void BlockCompressor::encodeColor(const unsigned char* pixels, unsigned char* block)
+{
+	float r[BLOCK_PIXELS], g[BLOCK_PIXELS], b[BLOCK_PIXELS];
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	float low[3] = { 255.0f, 255.0f, 255.0f }, high[3] = { 0.0f, 0.0f, 0.0f };
+	for (unsigned int i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		r[i] = pixels[i * 4 + 0];
+		g[i] = pixels[i * 4 + 1];
+		b[i] = pixels[i * 4 + 2];
+
+		float color[3] = { r[i], g[i], b[i] };
+		for (int c = 0; c < 3; ++c)
+		{
+			mean[c] += color[c];
+			low[c] = std::min(low[c], color[c]);
+			high[c] = std::max(high[c], color[c]);
+		}
+	}
+	for (int c = 0; c < 3; ++c)
+		mean[c] /= BLOCK_PIXELS;
+
+	// Covariance : rr, rg, rb, gg, gb, bb.
+	float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for (unsigned int i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		float dr = r[i] - mean[0], dg = g[i] - mean[1], db = b[i] - mean[2];
+		covariance[0] += dr * dr;
+		covariance[1] += dr * dg;
+		covariance[2] += dr * db;
+		covariance[3] += dg * dg;
+		covariance[4] += dg * db;
+		covariance[5] += db * db;
+	}
+
+	// Principal axis, starting from the diagonal of the bounding box.
+	float axis[3] = { high[0] - low[0], high[1] - low[1], high[2] - low[2] };
+	for (int iteration = 0; iteration < 4; ++iteration)
+	{
+		float next[3] = {
+			covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+			covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+			covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+		};
+		float largest = std::max(fabsf(next[0]), std::max(fabsf(next[1]), fabsf(next[2])));
+		if (largest < 1e-6f)
+			break;
+		for (int c = 0; c < 3; ++c)
+			axis[c] = next[c] / largest;
+	}
+
+	float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	for (int c = 0; c < 3; ++c)
+		axis[c] = (length > 1e-6f) ? axis[c] / length : 0.0f;
+
+	float minimum = FLT_MAX, maximum = -FLT_MAX;
+	for (unsigned int i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		float t = (r[i] - mean[0]) * axis[0] + (g[i] - mean[1]) * axis[1] + (b[i] - mean[2]) * axis[2];
+		minimum = std::min(minimum, t);
+		maximum = std::max(maximum, t);
+	}
+
+	float e0[3], e1[3];
+	for (int c = 0; c < 3; ++c)
+	{
+		e0[c] = mean[c] + axis[c] * maximum;
+		e1[c] = mean[c] + axis[c] * minimum;
+	}
+
+	unsigned short c0 = PackRgb565(e0), c1 = PackRgb565(e1);
+	unsigned int indices;
+	float error = FitColorIndices(r, g, b, c0, c1, indices);
+
+	if (c0 != c1 && RefineEndpoints(r, g, b, indices, e0, e1))
+	{
+		unsigned short refined0 = PackRgb565(e0), refined1 = PackRgb565(e1);
+		unsigned int refinedIndices;
+		if (refined0 != refined1 && FitColorIndices(r, g, b, refined0, refined1, refinedIndices) < error)
+		{
+			c0 = refined0;
+			c1 = refined1;
+			indices = refinedIndices;
+		}
+	}
+
+	// Four color mode needs c0 > c1; swapping the endpoints swaps indices 0 and 1, and 2 and 3.
+	if (c0 < c1)
+	{
+		std::swap(c0, c1);
+		indices ^= 0x55555555;
+	}
+	else if (c0 == c1)
+	{
+		indices = 0;
+	}
+
+	block[0] = (unsigned char)(c0 & 0xFF);
+	block[1] = (unsigned char)(c0 >> 8);
+	block[2] = (unsigned char)(c1 & 0xFF);
+	block[3] = (unsigned char)(c1 >> 8);
+	block[4] = (unsigned char)(indices & 0xFF);
+	block[5] = (unsigned char)((indices >> 8) & 0xFF);
+	block[6] = (unsigned char)((indices >> 16) & 0xFF);
+	block[7] = (unsigned char)(indices >> 24);
+}
+
+/*
+	Encodes one channel of a block as a BC4 block (the
+	alpha of BC3, each half of BC5), in eight value mode
+	over the channel's range. The index of every pixel is
+	its rounded position in the range, four at a time.
+
+	pixels	-	16 RGBA pixels, row by row.
+	channel	-	0 to 3 for red to alpha.
+	block	-	Receives 8 bytes.
+*/
+void BlockCompressor::encodeChannel(const unsigned char* pixels, unsigned int channel, unsigned char* block)
+{
+	float values[BLOCK_PIXELS];
+	unsigned char low = 255, high = 0;
+	for (unsigned int i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		unsigned char value = pixels[i * 4 + channel];
+		values[i] = value;
+		low = std::min(low, value);
+		high = std::max(high, value);
+	}
+
+	block[0] = high;
+	block[1] = low;
+	if (low == high)
+	{
+		memset(block + 2, 0, 6);
+		return;
+	}
+
+	__m128 offset = _mm_set1_ps(low);
+	__m128 scale = _mm_set1_ps(7.0f / (high - low));
+	__m128 half = _mm_set1_ps(0.5f);
+
+	unsigned long long indices = 0;
+	for (unsigned int i = 0; i < BLOCK_PIXELS; i += 4)
+	{
+		// Steps from low (0) to high (7).
+		__m128i steps = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), offset), scale), half));
+
+		int lanes[4];
+		_mm_storeu_si128((__m128i*)lanes, steps);
+		for (unsigned int j = 0; j < 4; ++j)
+		{
+			// Index 0 is high, 1 is low, 2 to 7 go from high to low.
+			unsigned int index = (8 - lanes[j]) & 7;
+			if (index < 2)
+				index ^= 1;
+			indices |= (unsigned long long)index << (3 * (i + j));
+		}
+	}
+
+	for (unsigned int b = 0; b < 6; ++b)
+		block[2 + b] = (unsigned char)((indices >> (8 * b)) & 0xFF);
+}
+
+/*
+	Decodes a BC1 color block.
+
+	block		-	8 bytes.
+	fourColors	-	Whether the block is always in four color
+					mode, as in BC3, instead of depending on
+					the order of the endpoints.
+	pixels		-	Receives the RGB of 16 pixels, 4 bytes each;
+					alpha is only written for transparent texels.
+*/
+void BlockCompressor::decodeColor(const unsigned char* block, bool fourColors, unsigned char* pixels)
+{
+	unsigned short c0 = (unsigned short)(block[0] | (block[1] << 8));
+	unsigned short c1 = (unsigned short)(block[2] | (block[3] << 8));
+	unsigned int indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+
+	int palette[4][3];
+	UnpackRgb565(c0, palette[0]);
+	UnpackRgb565(c1, palette[1]);
+	bool opaque = fourColors || c0 > c1;
+	for (int c = 0; c < 3; ++c)
+	{
+		if (opaque)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	for (unsigned int i = 0; i < BLOCK_PIXELS; ++i)
+	{
+		unsigned int index = (indices >> (2 * i)) & 3;
+		for (int c = 0; c < 3; ++c)
+			pixels[i * 4 + c] = (unsigned char)palette[index][c];
+		if (!opaque && index == 3)
+			pixels[i * 4 + 3] = 0;
+	}
+}
+
+/*
+	Decodes a BC4 block into one channel.
+
+	block	-	8 bytes.
+	channel	-	0 to 3 for red to alpha.
+	pixels	-	16 RGBA pixels, only the channel is written.
+*/
+void BlockCompressor::decodeChannel(const unsigned char* block, unsigned int channel, unsigned char* pixels)
+{
+	int a0 = block[0], a1 = block[1];
+	int values[8] = { a0, a1 };
+	if (a0 > a1)
+	{
+		for (int i = 2; i < 8; ++i)
+			values[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+	}
+	else
+	{
+		for (int i = 2; i < 6; ++i)
+			values[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+		values[6] = 0;
+		values[7] = 255;
+	}
+
+	unsigned long long indices = 0;
+	for (unsigned int b = 0; b < 6; ++b)
+		indices |= (unsigned long long)block[2 + b] << (8 * b);
+
+	for (unsigned int i = 0; i < BLOCK_PIXELS; ++i)
+		pixels[i * 4 + channel] = (unsigned char)values[(indices >> (3 * i)) & 7];
+}
\ No newline at end of file
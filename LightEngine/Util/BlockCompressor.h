@@ -0,0 +1,49 @@
+#pragma once
+
+// Includes.
+#include <cstddef>
+#include "..\Contrib\Include\gl\glew.h"
+#include "ThreadPool.h"
+
+// Pixels along each side of a block.
+const unsigned int BLOCK_DIMENSION = 4;
+
+/*
+	Encoder and decoder of the block compressed formats
+	the textures are cooked to :
+
+		BC1	-	GL_COMPRESSED_(S)RGB_S3TC_DXT1_EXT, opaque color.
+		BC3	-	GL_COMPRESSED_(S)RGB(_ALPHA)_S3TC_DXT5_EXT,
+				color and alpha.
+		BC5	-	GL_COMPRESSED_RG_RGTC2, two channels, used for
+				normal maps.
+
+	Images are RGBA, 4 bytes per pixel. Every 4x4 block is
+	encoded on its own : the color endpoints are fitted
+	along the principal axis of the block's colors and
+	refined by least squares, the single channels (alpha,
+	red, green) use their range. The palette indices are
+	picked with SSE, four pixels at a time. Rows of blocks
+	can be spread over a ThreadPool.
+*/
+class BlockCompressor
+{
+public:
+
+// Functions
+
+	static bool IsSupported(GLenum format);
+	static unsigned int GetBlockSize(GLenum format);
+	static size_t GetImageSize(GLenum format, unsigned int width, unsigned int height);
+	static void Encode(const unsigned char* rgba, unsigned int width, unsigned int height, GLenum format, unsigned char* blocks, ThreadPool* pool = NULL);
+	static void Decode(const unsigned char* blocks, unsigned int width, unsigned int height, GLenum format, unsigned char* rgba);
+
+private:
+
+// Functions
+
+	static void encodeColor(const unsigned char* pixels, unsigned char* block);
+	static void encodeChannel(const unsigned char* pixels, unsigned int channel, unsigned char* block);
+	static void decodeColor(const unsigned char* block, bool fourColors, unsigned char* pixels);
+	static void decodeChannel(const unsigned char* block, unsigned int channel, unsigned char* pixels);
+};
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "BufferAllocator.h"
+
+/*
+	Default constructor, the allocator is empty.
+*/
+BufferAllocator::BufferAllocator()
+{
+	capacity = used = allocations = 0;
+}
+
+/*
+	Frees everything and sets the capacity.
+
+	capacity	-	Number of elements in the buffer.
+*/
+void BufferAllocator::Reset(unsigned int capacity)
+{
+	this->capacity = capacity;
+	used = allocations = 0;
+
+	freeBlocks.clear();
+	if (capacity > 0)
+	{
+		Block block = { 0, capacity };
+		freeBlocks.push_back(block);
+	}
+}
+
+/*
+	Allocates a range from the smallest free block it fits
+	in. Returns false if no block is large enough; the
+	caller may Grow() the buffer and try again.
+
+	size	-	Number of elements, more than 0.
+	offset	-	Receives the first element of the range.
+*/
+bool BufferAllocator::Allocate(unsigned int size, unsigned int& offset)
+{
+	size_t best = freeBlocks.size();
+	for (size_t i = 0; i < freeBlocks.size(); ++i)
+	{
+		if (freeBlocks[i].size >= size && (best == freeBlocks.size() || freeBlocks[i].size < freeBlocks[best].size))
+			best = i;
+	}
+
+	if (best == freeBlocks.size() || size == 0)
+		return false;
+
+	offset = freeBlocks[best].offset;
+	freeBlocks[best].offset += size;
+	freeBlocks[best].size -= size;
+	if (freeBlocks[best].size == 0)
+		freeBlocks.erase(freeBlocks.begin() + best);
+
+	used += size;
+	++allocations;
+	return true;
+}
+
+/*
+	Returns a range to the free list, merging it with the
+	free blocks right before and after it.
+
+	offset	-	First element, as returned by Allocate().
+	size	-	Number of elements it was allocated with.
+*/
+void BufferAllocator::Free(unsigned int offset, unsigned int size)
+{
+	if (size == 0)
+		return;
+
+	size_t next = 0;
+	while (next < freeBlocks.size() && freeBlocks[next].offset < offset)
+		++next;
+
+	bool joinsPrevious = next > 0 && freeBlocks[next - 1].offset + freeBlocks[next - 1].size == offset;
+	bool joinsNext = next < freeBlocks.size() && offset + size == freeBlocks[next].offset;
+
+	if (joinsPrevious && joinsNext)
+	{
+		freeBlocks[next - 1].size += size + freeBlocks[next].size;
+		freeBlocks.erase(freeBlocks.begin() + next);
+	}
+	else if (joinsPrevious)
+	{
+		freeBlocks[next - 1].size += size;
+	}
+	else if (joinsNext)
+	{
+		freeBlocks[next].offset = offset;
+		freeBlocks[next].size += size;
+	}
+	else
+	{
+		Block block = { offset, size };
+		freeBlocks.insert(freeBlocks.begin() + next, block);
+	}
+
+	used -= size;
+	--allocations;
+}
+
+/*
+	Adds elements at the end of the buffer, after the
+	caller has made it larger.
+
+	capacity	-	New number of elements, at least the current one.
+*/
+void BufferAllocator::Grow(unsigned int capacity)
+{
+	if (capacity <= this->capacity)
+		return;
+
+	unsigned int added = capacity - this->capacity;
+	if (!freeBlocks.empty() && freeBlocks.back().offset + freeBlocks.back().size == this->capacity)
+	{
+		freeBlocks.back().size += added;
+	}
+	else
+	{
+		Block block = { this->capacity, added };
+		freeBlocks.push_back(block);
+	}
+
+	this->capacity = capacity;
+}
+
+/*
+	Number of elements in the buffer.
+*/
+unsigned int BufferAllocator::GetCapacity(void) const
+{
+	return capacity;
+}
+
+/*
+	Fills in the usage and fragmentation of the buffer.
+*/
+void BufferAllocator::GetStats(BufferAllocatorStats& stats) const
+{
+	stats.capacity = capacity;
+	stats.used = used;
+	stats.free = capacity - used;
+	stats.allocations = allocations;
+	stats.freeBlocks = (unsigned int)freeBlocks.size();
+
+	stats.largestFree = 0;
+	for (size_t i = 0; i < freeBlocks.size(); ++i)
+	{
+		if (freeBlocks[i].size > stats.largestFree)
+			stats.largestFree = freeBlocks[i].size;
+	}
+
+	stats.fragmentation = stats.free > 0 ? 1.0f - (float)stats.largestFree / (float)stats.free : 0.0f;
+}
\ No newline at end of file
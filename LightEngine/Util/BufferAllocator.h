@@ -0,0 +1,69 @@
+#pragma once
+
+// Includes.
+#include <cstddef>
+#include <vector>
+
+/*
+	State of a BufferAllocator, in units of its elements.
+
+	largestFree		-	Size of the largest free block, the most
+						that can be allocated at once.
+	fragmentation	-	1 - largestFree / free : 0 if all free
+						space is one block, close to 1 if it is
+						scattered over many small ones.
+*/
+struct BufferAllocatorStats
+{
+	unsigned int	capacity;
+	unsigned int	used;
+	unsigned int	free;
+	unsigned int	allocations;
+	unsigned int	freeBlocks;
+	unsigned int	largestFree;
+	float			fragmentation;
+};
+
+/*
+	Free-list allocator for sub-allocating a buffer. It only
+	keeps the bookkeeping : ranges are handed out in
+	elements (e.g. vertices or indices) and the caller owns
+	the memory they refer to.
+
+	Free blocks are kept sorted by offset and merged with
+	their neighbours when a range is freed. Allocations
+	take the smallest free block that fits (best fit),
+	which keeps the large blocks for large meshes.
+*/
+class BufferAllocator
+{
+public:
+
+// Functions
+
+	BufferAllocator();
+	void Reset(unsigned int capacity);
+	bool Allocate(unsigned int size, unsigned int& offset);
+	void Free(unsigned int offset, unsigned int size);
+	void Grow(unsigned int capacity);
+	unsigned int GetCapacity(void) const;
+	void GetStats(BufferAllocatorStats& stats) const;
+
+private:
+
+	/*
+		Range of free elements.
+	*/
+	struct Block
+	{
+		unsigned int	offset;
+		unsigned int	size;
+	};
+
+// Variables
+
+	std::vector<Block>	freeBlocks;		// Sorted by offset, never adjacent.
+	unsigned int		capacity;
+	unsigned int		used;
+	unsigned int		allocations;
+};
\ No newline at end of file
@@ -26,6 +26,10 @@ const GLfloat SPEED = 3.0f;
 const GLfloat SENSITIVTY = 0.25f;
 const GLfloat ZOOM = 45.0f;
 
+// Clip planes of the projection shared by all scene passes.
+const GLfloat CAMERA_NEAR_PLANE = 0.1f;
+const GLfloat CAMERA_FAR_PLANE = 1000.0f;
+
 /*
 	An abstract camera class that processes	input
 	and calculates the corresponding Eular Angles,
@@ -128,7 +132,7 @@ public:
 	*/
 	void ProcessKeyboard(Camera_Movement direction, GLfloat deltaTime)
 	{
-		GLfloat velocity = this->MovementSpeed * deltaTime * 0.0005f;
+		GLfloat velocity = this->MovementSpeed * deltaTime;
 		if (direction == FORWARD)
 		{
 			this->Position += this->Front * velocity;
@@ -195,6 +199,22 @@ public:
 			this->Zoom = 45.0f;
 	}
 
+	/*
+		Places the camera at the given position and
+		orientation, e.g. when following a CameraPath.
+
+		position	-	World-space position of the camera.
+		yaw			-	Rotation about the vertical axis.
+		pitch		-	Rotation about the side-to-side axis.
+	*/
+	void SetPose(glm::vec3 position, GLfloat yaw, GLfloat pitch)
+	{
+		this->Position = position;
+		this->Yaw = yaw;
+		this->Pitch = pitch;
+		this->updateCameraVectors();
+	}
+
 private:
 	
 	/*
@@ -0,0 +1,199 @@
+#include "CameraPath.h"
+
+namespace
+{
+	/*
+		Uniform Catmull-Rom interpolation between p1 and p2.
+	*/
+	template <typename T>
+	T CatmullRom(const T& p0, const T& p1, const T& p2, const T& p3, GLfloat t)
+	{
+		GLfloat t2 = t * t;
+		GLfloat t3 = t2 * t;
+
+		return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+			+ (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+	}
+}
+
+/*
+	Creates an empty path.
+*/
+CameraPath::CameraPath()
+{
+}
+
+/*
+	Reads the keys of a path from a text file.
+	Returns false if the file can't be read or
+	contains less than two keys.
+
+	path	-	Path of the file.
+*/
+bool CameraPath::Load(const char* path)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_CORE, "Could not open camera path %s.", path);
+		return false;
+	}
+
+	keys.clear();
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		CameraKey key;
+		if (sscanf_s(line.c_str(), "%f %f %f %f %f %f", &key.time, &key.position.x, &key.position.y, &key.position.z,
+			&key.yaw, &key.pitch) == 6)
+		{
+			keys.push_back(key);
+		}
+	}
+
+	if (keys.size() < 2)
+	{
+		LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_CORE, "Camera path %s needs at least two keys.", path);
+		return false;
+	}
+
+	LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_CORE, "Camera path %s loaded, %u keys.", path, (unsigned int)keys.size());
+
+	return true;
+}
+
+/*
+	Writes the keys of the path to a text file.
+
+	path	-	Path of the file.
+*/
+bool CameraPath::Save(const char* path) const
+{
+	FILE* file = NULL;
+	if (fopen_s(&file, path, "w") != 0 || file == NULL)
+	{
+		LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_CORE, "Could not write camera path %s.", path);
+		return false;
+	}
+
+	fprintf(file, "# time x y z yaw pitch\n");
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		const CameraKey& key = keys[i];
+		fprintf(file, "%.3f %.4f %.4f %.4f %.3f %.3f\n", key.time, key.position.x, key.position.y, key.position.z,
+			key.yaw, key.pitch);
+	}
+
+	fclose(file);
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Camera path with %u keys written to %s.", (unsigned int)keys.size(), path);
+
+	return true;
+}
+
+/*
+	Replaces the keys with a lap around the demo room,
+	looking ahead along the walls.
+*/
+void CameraPath::CreateDefault(void)
+{
+	keys.clear();
+
+	AddKey(0.0f, glm::vec3(1.0f, 0.0f, -2.0f), 0.0f, 0.0f);
+	AddKey(4.0f, glm::vec3(19.0f, 0.0f, -3.0f), -90.0f, -5.0f);
+	AddKey(8.0f, glm::vec3(19.0f, 0.5f, -22.0f), -180.0f, 0.0f);
+	AddKey(12.0f, glm::vec3(2.0f, 0.0f, -22.0f), -270.0f, 5.0f);
+	AddKey(16.0f, glm::vec3(1.0f, 0.0f, -2.0f), -360.0f, 0.0f);
+}
+
+/*
+	Removes all keys.
+*/
+void CameraPath::Clear(void)
+{
+	keys.clear();
+}
+
+/*
+	Appends a key. Keys have to be added in time order.
+
+	time		-	Time of the key in seconds.
+	position	-	World-space position of the camera.
+	yaw, pitch	-	Orientation of the camera in degrees.
+*/
+void CameraPath::AddKey(GLfloat time, glm::vec3 position, GLfloat yaw, GLfloat pitch)
+{
+	CameraKey key;
+	key.time = time;
+	key.position = position;
+	key.yaw = yaw;
+	key.pitch = pitch;
+	keys.push_back(key);
+}
+
+/*
+	Samples the path. Times before the first key and
+	after the last key are clamped.
+
+	time		-	Time in seconds from the start of the path.
+	position	-	Receives the interpolated position.
+	yaw, pitch	-	Receive the interpolated orientation.
+*/
+void CameraPath::Evaluate(GLfloat time, glm::vec3& position, GLfloat& yaw, GLfloat& pitch) const
+{
+	if (keys.empty())
+		return;
+
+	if (keys.size() == 1 || time <= keys.front().time)
+	{
+		position = keys.front().position;
+		yaw = keys.front().yaw;
+		pitch = keys.front().pitch;
+		return;
+	}
+
+	if (time >= keys.back().time)
+	{
+		position = keys.back().position;
+		yaw = keys.back().yaw;
+		pitch = keys.back().pitch;
+		return;
+	}
+
+	// Segment that contains the time.
+	size_t i = 0;
+	while (i + 2 < keys.size() && keys[i + 1].time <= time)
+		++i;
+
+	const CameraKey& k0 = keys[i > 0 ? i - 1 : i];
+	const CameraKey& k1 = keys[i];
+	const CameraKey& k2 = keys[i + 1];
+	const CameraKey& k3 = keys[i + 2 < keys.size() ? i + 2 : i + 1];
+
+	GLfloat span = k2.time - k1.time;
+	GLfloat t = (span > 0.0f) ? (time - k1.time) / span : 0.0f;
+
+	position = CatmullRom(k0.position, k1.position, k2.position, k3.position, t);
+	yaw = CatmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+	pitch = CatmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t);
+}
+
+/*
+	Time of the last key in seconds.
+*/
+GLfloat CameraPath::GetDuration(void) const
+{
+	return keys.empty() ? 0.0f : keys.back().time;
+}
+
+/*
+	Number of keys in the path.
+*/
+unsigned int CameraPath::GetKeyCount(void) const
+{
+	return (unsigned int)keys.size();
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+// Includes.
+#include <vector>
+#include <string>
+#include "..\Contrib\Include\gl\glew.h"
+#include "..\Contrib\Include\glm\glm.hpp"
+#include "Utility.h"
+
+/*
+	One key of a camera path.
+
+	time		-	Time of the key in seconds from the start of the path.
+	position	-	World-space position of the camera.
+	yaw, pitch	-	Orientation of the camera in degrees (see Camera).
+*/
+struct CameraKey
+{
+	GLfloat		time;
+	glm::vec3	position;
+	GLfloat		yaw;
+	GLfloat		pitch;
+};
+
+/*
+	A recorded camera flight. Position, yaw and pitch are
+	interpolated between the keys with a Catmull-Rom spline,
+	so the camera moves smoothly through every key.
+
+	Paths are stored as text, one key per line :
+
+		time x y z yaw pitch
+
+	Lines starting with '#' are comments.
+*/
+class CameraPath
+{
+public:
+
+// Functions
+
+	CameraPath();
+	bool Load(const char* path);
+	bool Save(const char* path) const;
+	void CreateDefault(void);
+	void Clear(void);
+	void AddKey(GLfloat time, glm::vec3 position, GLfloat yaw, GLfloat pitch);
+	void Evaluate(GLfloat time, glm::vec3& position, GLfloat& yaw, GLfloat& pitch) const;
+	GLfloat GetDuration(void) const;
+	unsigned int GetKeyCount(void) const;
+
+private:
+
+// Variables
+
+	std::vector<CameraKey>	keys;
+};
\ No newline at end of file
@@ -4,8 +4,18 @@
 #include "..\Contrib\Include\gl\glew.h"
 #include "..\Contrib\Include\GLFW\glfw3.h"
 #include "Utility.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "Telemetry.h"
 #include "Shader.h"
+#include "ShaderPermutations.h"
+#include "ThreadPool.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
+#include "FileSystem.h"
+#include "LoadGraph.h"
 #include "Camera.h"
+#include "CameraPath.h"
 #include "..\Contrib\Include\SOIL.h"
 #include "..\Contrib\Include\assimp\Importer.hpp"
 #include "..\Renderer\Mesh.h"
@@ -14,6 +24,7 @@
 #include "..\Renderer\ParticleSystem.h"
 #include "..\Renderer\Skybox.h"
 #include "..\Renderer\RenderObject.h"
+#include "..\Renderer\LoadingScreen.h"
 
 // Linking libraries
 #pragma comment(lib, "opengl32.lib")
@@ -25,7 +36,7 @@
 #pragma comment(lib, "freetype26d.lib")
 
 // #defines for conditional compiling
-#define DEBUG
+// (log levels and categories are filtered with LOG_MIN_LEVEL / LOG_CATEGORY_MASK, see Logger.h)
 //#define RENDER_MODELS
 #define RENDER_PARTICLES
 #define RENDER_ENVIRONMENT_CUBE
\ No newline at end of file
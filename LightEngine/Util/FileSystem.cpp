@@ -0,0 +1,395 @@
+#include "FileSystem.h"
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+PackFile*			FileSystem::pack = NULL;
+bool				FileSystem::looseFiles = true;
+std::mutex			FileSystem::mutex;
+FileSystemStats		FileSystem::stats = { 0, 0, 0, 0, 0.0, 0.0, 0.0 };
+
+/*
+	Default constructor, the file is empty.
+*/
+FileData::FileData()
+{
+	data = NULL;
+	size = 0;
+}
+
+/*
+	First byte of the file, NULL if it is empty.
+*/
+const unsigned char* FileData::GetData(void) const
+{
+	return data;
+}
+
+/*
+	Size of the file in bytes.
+*/
+size_t FileData::GetSize(void) const
+{
+	return size;
+}
+
+/*
+	Makes the file a view of memory owned by someone else.
+
+	data	-	First byte of the file.
+	size	-	Size of the file.
+*/
+void FileData::Reference(const unsigned char* data, size_t size)
+{
+	buffer.clear();
+	this->data = data;
+	this->size = size;
+}
+
+/*
+	Gives the file a buffer of its own and returns it, to
+	be filled by the caller.
+
+	size	-	Size of the file.
+*/
+unsigned char* FileData::Allocate(size_t size)
+{
+	buffer.resize(size);
+	this->data = buffer.empty() ? NULL : &buffer[0];
+	this->size = size;
+	return buffer.empty() ? NULL : &buffer[0];
+}
+
+/*
+	Empties the file and frees its buffer.
+*/
+void FileData::Clear(void)
+{
+	std::vector<unsigned char>().swap(buffer);
+	data = NULL;
+	size = 0;
+}
+
+/*
+	Maps a pack file, replacing the mounted one. Returns
+	false if it can't be opened, reads then only go to
+	loose files.
+
+	packPath	-	Path to the pack file.
+*/
+bool FileSystem::Mount(const char* packPath)
+{
+	Unmount();
+
+	pack = new PackFile();
+	if (!pack->Open(packPath))
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Could not mount pack %s, reading loose files.", packPath);
+		Unmount();
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		++stats.filesOpened;
+	}
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "Pack mounted: %s (%u files)", packPath, pack->GetEntryCount());
+	return true;
+}
+
+/*
+	Unmounts the pack. Views into it are invalid
+	afterwards, so no reads may be running.
+*/
+void FileSystem::Unmount(void)
+{
+	delete pack;
+	pack = NULL;
+}
+
+/*
+	Whether a pack is mounted.
+*/
+bool FileSystem::IsMounted(void)
+{
+	return pack != NULL;
+}
+
+/*
+	Turns reading files the pack doesn't hold from loose
+	files on or off, to check that a pack is complete.
+
+	enabled	-	Whether loose files are read.
+*/
+void FileSystem::SetLooseFiles(bool enabled)
+{
+	looseFiles = enabled;
+}
+
+/*
+	Whether loose files are read.
+*/
+bool FileSystem::IsLooseFilesEnabled(void)
+{
+	return looseFiles;
+}
+
+/*
+	Reads a whole file from the pack or, if the pack
+	doesn't hold it, from a loose file.
+
+	path	-	Relative path to the file, as on disk.
+	data	-	Receives the contents.
+	pool	-	Threads to decompress on, may be NULL. Not the
+				pool of the calling task.
+*/
+bool FileSystem::ReadFile(const char* path, FileData& data, ThreadPool* pool)
+{
+	double start = getTimeElapsed();
+	double decompressTime = 0.0;
+	bool read = false, packed = false, opened = false;
+
+	data.Clear();
+
+	const PackEntry* entry = (pack != NULL) ? pack->Find(NormalizePath(path).c_str()) : NULL;
+	if (entry != NULL)
+	{
+		packed = true;
+		if (entry->codec == PACK_CODEC_NONE)
+		{
+			data.Reference(pack->GetStoredData(*entry), entry->size);
+			read = true;
+		}
+		else
+		{
+			read = pack->Extract(*entry, data.Allocate(entry->size), pool);
+			decompressTime = getTimeElapsed() - start;
+			if (!read)
+			{
+				LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Packed file %s is corrupt.", path);
+				data.Clear();
+			}
+		}
+	}
+	else if (looseFiles)
+	{
+		opened = readLooseFile(path, data);
+		read = opened;
+	}
+
+	double readTime = getTimeElapsed() - start;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!read)
+		++stats.failedReads;
+	else if (packed)
+		++stats.packReads;
+	else
+		++stats.looseReads;
+	if (opened)
+		++stats.filesOpened;
+	stats.bytesRead += (double)data.GetSize();
+	stats.readTime += readTime;
+	stats.decompressTime += decompressTime;
+
+	return read;
+}
+
+/*
+	Whether a file is in the pack or, with loose files
+	on, on disk.
+
+	path	-	Relative path to the file.
+*/
+bool FileSystem::Exists(const char* path)
+{
+	if (pack != NULL && pack->Find(NormalizePath(path).c_str()) != NULL)
+		return true;
+
+	return looseFiles && GetFileAttributesA(path) != INVALID_FILE_ATTRIBUTES;
+}
+
+/*
+	Last write time of a file (see getFileWriteTime()). For
+	packed files, that of the file they were packed from.
+
+	path		-	Relative path to the file.
+	writeTime	-	Receives the last write time.
+*/
+bool FileSystem::GetWriteTime(const char* path, unsigned long long& writeTime)
+{
+	const PackEntry* entry = (pack != NULL) ? pack->Find(NormalizePath(path).c_str()) : NULL;
+	if (entry != NULL)
+	{
+		writeTime = entry->writeTime;
+		return true;
+	}
+
+	return looseFiles && getFileWriteTime(path, writeTime);
+}
+
+/*
+	Path in the form used as key in packs and caches :
+	forward slashes, lower case (Windows paths ignore
+	case), without "." and with ".." resolved where
+	possible.
+
+	path	-	Relative or absolute file path.
+*/
+std::string FileSystem::NormalizePath(const char* path)
+{
+	std::vector<std::string> parts;
+	std::string part;
+
+	for (const char* c = path; ; ++c)
+	{
+		if (*c == '/' || *c == '\\' || *c == '\0')
+		{
+			if (part == "..")
+			{
+				if (!parts.empty() && parts.back() != "..")
+					parts.pop_back();
+				else
+					parts.push_back(part);
+			}
+			else if (!part.empty() && part != ".")
+			{
+				parts.push_back(part);
+			}
+
+			part.clear();
+			if (*c == '\0')
+				break;
+		}
+		else
+		{
+			part += (char)tolower((unsigned char)*c);
+		}
+	}
+
+	std::string normalized = (path[0] == '/' || path[0] == '\\') ? "/" : "";
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		if (i > 0)
+			normalized += '/';
+		normalized += parts[i];
+	}
+	return normalized;
+}
+
+/*
+	Appends the paths of the loose files in a directory
+	and its subdirectories.
+
+	directory	-	Directory to search.
+	files		-	Receives the paths, starting with directory.
+*/
+void FileSystem::ListFiles(const char* directory, std::vector<std::string>& files)
+{
+	WIN32_FIND_DATAA found;
+	HANDLE search = FindFirstFileA((std::string(directory) + "/*").c_str(), &found);
+	if (search == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		if (strcmp(found.cFileName, ".") == 0 || strcmp(found.cFileName, "..") == 0)
+			continue;
+
+		std::string path = std::string(directory) + "/" + found.cFileName;
+		if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			ListFiles(path.c_str(), files);
+		else
+			files.push_back(path);
+	} while (FindNextFileA(search, &found));
+
+	FindClose(search);
+}
+
+/*
+	Packs the loose files of FILE_SYSTEM_ASSET_DIRECTORIES,
+	leaving out the caches the engine writes next to them.
+
+	packPath	-	Pack file to write.
+	compress	-	Whether entries are compressed with LZ4.
+	pool		-	Threads to compress on, may be NULL. Not the
+					pool of the calling task.
+*/
+bool FileSystem::BuildPack(const char* packPath, bool compress, ThreadPool* pool)
+{
+	std::vector<std::string> found, files;
+	for (unsigned int i = 0; i < sizeof(FILE_SYSTEM_ASSET_DIRECTORIES) / sizeof(FILE_SYSTEM_ASSET_DIRECTORIES[0]); ++i)
+		ListFiles(FILE_SYSTEM_ASSET_DIRECTORIES[i], found);
+
+	for (size_t i = 0; i < found.size(); ++i)
+	{
+		std::string name = NormalizePath(found[i].c_str());
+		bool generated = false;
+		for (unsigned int e = 0; e < sizeof(FILE_SYSTEM_GENERATED_EXTENSIONS) / sizeof(FILE_SYSTEM_GENERATED_EXTENSIONS[0]); ++e)
+		{
+			size_t length = strlen(FILE_SYSTEM_GENERATED_EXTENSIONS[e]);
+			generated = generated || (name.size() >= length && name.compare(name.size() - length, length, FILE_SYSTEM_GENERATED_EXTENSIONS[e]) == 0);
+		}
+
+		if (!generated)
+			files.push_back(found[i]);
+	}
+
+	return PackFile::Build(packPath, files, compress, pool);
+}
+
+/*
+	Current counters.
+*/
+void FileSystem::GetStats(FileSystemStats& stats)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stats = FileSystem::stats;
+}
+
+/*
+	Sets every counter back to 0.
+*/
+void FileSystem::ResetStats(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	memset(&stats, 0, sizeof(stats));
+}
+
+/*
+	Logs the counters.
+*/
+void FileSystem::LogReport(void)
+{
+	FileSystemStats current;
+	GetStats(current);
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "File system (%s) : %u files opened, %u packed and %u loose reads, %u failed, %.1f MB in %.1f ms (%.1f ms decompressing).",
+		IsMounted() ? "pack" : "loose files", current.filesOpened, current.packReads, current.looseReads, current.failedReads,
+		current.bytesRead / (1024.0 * 1024.0), current.readTime * 1000.0, current.decompressTime * 1000.0);
+}
+
+/*
+	Reads a loose file into a buffer of its own. Returns
+	false if it can't be opened or read.
+*/
+bool FileSystem::readLooseFile(const char* path, FileData& data)
+{
+	FILE* file = NULL;
+	if (fopen_s(&file, path, "rb") != 0 || file == NULL)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	bool read = size >= 0;
+	if (read && size > 0)
+		read = fread(data.Allocate((size_t)size), 1, (size_t)size, file) == (size_t)size;
+	fclose(file);
+
+	if (!read)
+		data.Clear();
+	return read;
+}
\ No newline at end of file
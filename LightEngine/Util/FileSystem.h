@@ -0,0 +1,123 @@
+#pragma once
+
+// Includes.
+#include <string>
+#include <vector>
+#include <mutex>
+#include "Utility.h"
+#include "ThreadPool.h"
+#include "PackFile.h"
+
+// Pack mounted by --pack and written by --build-pack when no file is given.
+const char* const FILE_SYSTEM_DEFAULT_PACK = "LightEngine.pak";
+
+// Directories whose files BuildPack() packs.
+const char* const FILE_SYSTEM_ASSET_DIRECTORIES[] = { "Shaders", "Textures", "Models", "Fonts" };
+
+// Files the engine writes next to the assets, left out of packs.
+const char* const FILE_SYSTEM_GENERATED_EXTENSIONS[] = { ".lemc", ".ktx", ".pak" };
+
+/*
+	Counters of the file system.
+
+	packReads		-	Files read from the pack.
+	looseReads		-	Files read from loose files.
+	failedReads		-	Files that were found nowhere.
+	filesOpened		-	Files opened through the OS, the pack
+						counting once.
+	bytesRead		-	Bytes of the files read.
+	readTime		-	Seconds spent in ReadFile().
+	decompressTime	-	Part of readTime spent decompressing.
+*/
+struct FileSystemStats
+{
+	unsigned int	packReads;
+	unsigned int	looseReads;
+	unsigned int	failedReads;
+	unsigned int	filesOpened;
+	double			bytesRead;
+	double			readTime;
+	double			decompressTime;
+};
+
+/*
+	Contents of a file read through the FileSystem : a
+	view into the mapped pack, or a buffer of its own.
+	Views stay valid until the pack is unmounted.
+*/
+class FileData
+{
+public:
+
+// Functions
+
+	FileData();
+	const unsigned char* GetData(void) const;
+	size_t GetSize(void) const;
+	void Reference(const unsigned char* data, size_t size);
+	unsigned char* Allocate(size_t size);
+	void Clear(void);
+
+private:
+
+// Functions
+
+	// A copy could outlive the buffer it points into.
+	FileData(const FileData&);
+	FileData& operator=(const FileData&);
+
+// Variables
+
+	const unsigned char*		data;
+	size_t						size;
+	std::vector<unsigned char>	buffer;
+};
+
+/*
+	Virtual file system the assets are read through, by
+	the relative paths they have always had. Files are
+	looked up in the mounted PackFile first and, unless
+	turned off, read as loose files if the pack doesn't
+	hold them, so development needs no pack at all.
+
+	Files in the pack that are stored as they are come
+	back as views into its mapping without a copy. The
+	counters (see GetStats()) compare the I/O of packed
+	and loose runs : files opened, bytes and time.
+
+	Reads may come from any thread.
+*/
+class FileSystem
+{
+public:
+
+// Functions
+
+	static bool Mount(const char* packPath);
+	static void Unmount(void);
+	static bool IsMounted(void);
+	static void SetLooseFiles(bool enabled);
+	static bool IsLooseFilesEnabled(void);
+	static bool ReadFile(const char* path, FileData& data, ThreadPool* pool = NULL);
+	static bool Exists(const char* path);
+	static bool GetWriteTime(const char* path, unsigned long long& writeTime);
+	static std::string NormalizePath(const char* path);
+	static void ListFiles(const char* directory, std::vector<std::string>& files);
+	static bool BuildPack(const char* packPath, bool compress, ThreadPool* pool = NULL);
+	static void GetStats(FileSystemStats& stats);
+	static void ResetStats(void);
+	static void LogReport(void);
+
+private:
+
+// Functions
+
+	static bool readLooseFile(const char* path, FileData& data);
+
+// Variables
+
+	static PackFile*		pack;
+	static bool				looseFiles;
+	static std::mutex		mutex;
+	static FileSystemStats	stats;
+};
\ No newline at end of file
@@ -0,0 +1,405 @@
+#include "GifDecoder.h"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	// Block introducers of the GIF stream.
+	const unsigned char GIF_EXTENSION = 0x21;
+	const unsigned char GIF_IMAGE = 0x2C;
+	const unsigned char GIF_GRAPHIC_CONTROL = 0xF9;
+
+	// Transparent index of frames without one, no palette index matches it.
+	const unsigned int GIF_NO_TRANSPARENCY = 256;
+
+	// Disposal methods of the graphic control extension.
+	const unsigned int GIF_DISPOSE_BACKGROUND = 2;
+	const unsigned int GIF_DISPOSE_PREVIOUS = 3;
+
+	// First row and row step of the four passes of an interlaced image.
+	const unsigned int GIF_INTERLACE_START[4] = { 0, 4, 2, 1 };
+	const unsigned int GIF_INTERLACE_STEP[4] = { 8, 8, 4, 2 };
+
+	/*
+		Reads a little-endian 16 bit value.
+	*/
+	unsigned int readShort(const unsigned char* data)
+	{
+		return data[0] | (data[1] << 8);
+	}
+}
+
+/*
+	Default constructor, no image is open.
+*/
+GifDecoder::GifDecoder()
+{
+	data = NULL;
+	size = position = firstFrame = 0;
+	width = height = 0;
+	globalColors = 0;
+	disposal = 0;
+	frameLeft = frameTop = frameWidth = frameHeight = 0;
+}
+
+/*
+	Reads the header and the global palette, and clears
+	the canvas. NextFrame() decodes the first frame.
+
+	data	-	Contents of the .gif file, kept by the caller.
+	size	-	Bytes of data.
+*/
+bool GifDecoder::Open(const unsigned char* data, size_t size)
+{
+	this->data = NULL;
+
+	// Signature, logical screen descriptor.
+	if (data == NULL || size < 13 || (memcmp(data, "GIF87a", 6) != 0 && memcmp(data, "GIF89a", 6) != 0))
+		return false;
+
+	width = readShort(data + 6);
+	height = readShort(data + 8);
+	if (width == 0 || height == 0 || width > GIF_MAX_SIZE || height > GIF_MAX_SIZE)
+		return false;
+
+	unsigned char flags = data[10];
+	position = 13;
+	globalColors = 0;
+	if (flags & 0x80)
+	{
+		globalColors = 2 << (flags & 0x07);
+		if (position + globalColors * 3 > size)
+			return false;
+
+		memcpy(globalPalette, data + position, globalColors * 3);
+		position += globalColors * 3;
+	}
+
+	this->data = data;
+	this->size = size;
+	firstFrame = position;
+	disposal = 0;
+	canvas.assign(width * height * 4, 0);
+	return true;
+}
+
+/*
+	Width of the canvas in pixels.
+*/
+unsigned int GifDecoder::GetWidth(void) const
+{
+	return width;
+}
+
+/*
+	Height of the canvas in pixels.
+*/
+unsigned int GifDecoder::GetHeight(void) const
+{
+	return height;
+}
+
+/*
+	Composes the next frame onto the canvas. Extensions
+	other than the graphic control are skipped, and at the
+	end of the stream it starts over at the first frame on
+	a clear canvas. Returns false if the image is broken or
+	has no frame at all.
+
+	delay	-	Receives how long the frame is shown, in
+				milliseconds.
+*/
+bool GifDecoder::NextFrame(unsigned int& delay)
+{
+	if (data == NULL)
+		return false;
+
+	// Undo the last frame as it asked for.
+	if (disposal == GIF_DISPOSE_BACKGROUND)
+		clearRect(frameLeft, frameTop, frameWidth, frameHeight);
+	else if (disposal == GIF_DISPOSE_PREVIOUS && previous.size() == canvas.size())
+		canvas = previous;
+	disposal = 0;
+
+	unsigned int transparent = GIF_NO_TRANSPARENCY;
+	unsigned int frameDisposal = 0;
+	unsigned int frameDelay = 0;
+	bool restarted = false;
+
+	for (;;)
+	{
+		unsigned char block = position < size ? data[position++] : 0;
+
+		if (block == GIF_EXTENSION && position < size)
+		{
+			unsigned char label = data[position++];
+			if (label == GIF_GRAPHIC_CONTROL && position + 5 <= size && data[position] >= 4)
+			{
+				unsigned char flags = data[position + 1];
+				frameDisposal = (flags >> 2) & 0x07;
+				frameDelay = readShort(data + position + 2);
+				transparent = (flags & 0x01) ? data[position + 4] : GIF_NO_TRANSPARENCY;
+			}
+
+			if (!readSubBlocks(NULL))
+				return false;
+		}
+		else if (block == GIF_IMAGE)
+		{
+			if (!readImage(transparent, frameDisposal))
+				return false;
+
+			delay = frameDelay == 0 ? GIF_DEFAULT_DELAY : std::max(frameDelay * 10, GIF_MIN_DELAY);
+			return true;
+		}
+		else
+		{
+			// Trailer, or whatever follows a truncated stream : loop, unless there was nothing to show.
+			if (restarted)
+				return false;
+
+			restarted = true;
+			position = firstFrame;
+			transparent = GIF_NO_TRANSPARENCY;
+			frameDisposal = frameDelay = 0;
+			std::fill(canvas.begin(), canvas.end(), (unsigned char)0);
+		}
+	}
+}
+
+/*
+	RGBA pixels of the canvas, top row first.
+*/
+const unsigned char* GifDecoder::GetPixels(void) const
+{
+	return canvas.empty() ? NULL : &canvas[0];
+}
+
+/*
+	Reads an image descriptor and its data, and draws the
+	image onto the canvas. Pixels outside the canvas are
+	dropped.
+
+	transparent	-	Palette index that isn't drawn.
+	disposal	-	What happens to the image before the next one.
+*/
+bool GifDecoder::readImage(unsigned int transparent, unsigned int disposal)
+{
+	if (position + 9 > size)
+		return false;
+
+	unsigned int left = readShort(data + position);
+	unsigned int top = readShort(data + position + 2);
+	unsigned int imageWidth = readShort(data + position + 4);
+	unsigned int imageHeight = readShort(data + position + 6);
+	unsigned char flags = data[position + 8];
+	position += 9;
+
+	const unsigned char* palette = globalPalette;
+	unsigned int colors = globalColors;
+	if (flags & 0x80)
+	{
+		colors = 2 << (flags & 0x07);
+		if (position + colors * 3 > size)
+			return false;
+
+		palette = data + position;
+		position += colors * 3;
+	}
+
+	if (position >= size)
+		return false;
+
+	unsigned int minCodeSize = data[position++];
+	codes.clear();
+	if (!readSubBlocks(&codes))
+		return false;
+
+	size_t count = (size_t)imageWidth * imageHeight;
+	if (count == 0)
+		return true;
+
+	indices.assign(count, 0);
+	if (!decodeLzw(codes, minCodeSize, &indices[0], count))
+		return false;
+
+	if (disposal == GIF_DISPOSE_PREVIOUS)
+		previous = canvas;
+
+	// Interlaced images store every 8th row first, then the rows in between.
+	rows.resize(imageHeight);
+	if (flags & 0x40)
+	{
+		unsigned int row = 0;
+		for (unsigned int pass = 0; pass < 4; ++pass)
+			for (unsigned int y = GIF_INTERLACE_START[pass]; y < imageHeight; y += GIF_INTERLACE_STEP[pass])
+				rows[row++] = y;
+	}
+	else
+	{
+		for (unsigned int row = 0; row < imageHeight; ++row)
+			rows[row] = row;
+	}
+
+	for (unsigned int row = 0; row < imageHeight; ++row)
+	{
+		unsigned int canvasY = top + rows[row];
+		if (canvasY >= height)
+			continue;
+
+		const unsigned char* source = &indices[(size_t)row * imageWidth];
+		for (unsigned int x = 0; x < imageWidth && left + x < width; ++x)
+		{
+			unsigned int index = source[x];
+			if (index == transparent || index >= colors)
+				continue;
+
+			unsigned char* pixel = &canvas[((size_t)canvasY * width + left + x) * 4];
+			pixel[0] = palette[index * 3];
+			pixel[1] = palette[index * 3 + 1];
+			pixel[2] = palette[index * 3 + 2];
+			pixel[3] = 255;
+		}
+	}
+
+	this->disposal = disposal;
+	frameLeft = left;
+	frameTop = top;
+	frameWidth = imageWidth;
+	frameHeight = imageHeight;
+	return true;
+}
+
+/*
+	Reads a chain of data sub-blocks up to its terminator.
+
+	out	-	Receives the data of the blocks, NULL to skip them.
+*/
+bool GifDecoder::readSubBlocks(std::vector<unsigned char>* out)
+{
+	while (position < size)
+	{
+		unsigned int length = data[position++];
+		if (length == 0)
+			return true;
+		if (position + length > size)
+			return false;
+
+		if (out != NULL)
+			out->insert(out->end(), data + position, data + position + length);
+		position += length;
+	}
+
+	return false;
+}
+
+/*
+	Decodes the variable-length LZW codes of an image into
+	palette indices. Codes past the end of the image are
+	ignored, indices the data stops short of stay 0.
+
+	codes		-	Data of the image's sub-blocks.
+	minCodeSize	-	Bits of the palette indices, from the image data.
+	out			-	Receives the indices.
+	count		-	Pixels of the image.
+*/
+bool GifDecoder::decodeLzw(const std::vector<unsigned char>& codes, unsigned int minCodeSize, unsigned char* out, size_t count)
+{
+	if (minCodeSize < 1 || minCodeSize > 8)
+		return false;
+
+	// Every entry is its prefix entry followed by one index; length and first index let it be written back to front.
+	static const unsigned int NO_CODE = GIF_LZW_CODES;
+	unsigned short prefix[GIF_LZW_CODES];
+	unsigned char suffix[GIF_LZW_CODES];
+	unsigned char first[GIF_LZW_CODES];
+	unsigned short length[GIF_LZW_CODES];
+
+	unsigned int clear = 1 << minCodeSize;
+	for (unsigned int i = 0; i < clear; ++i)
+	{
+		prefix[i] = (unsigned short)NO_CODE;
+		suffix[i] = first[i] = (unsigned char)i;
+		length[i] = 1;
+	}
+
+	unsigned int end = clear + 1;
+	unsigned int codeSize = minCodeSize + 1;
+	unsigned int next = clear + 2;
+	unsigned int last = NO_CODE;
+
+	unsigned int bits = 0, bitCount = 0;
+	size_t read = 0, written = 0;
+
+	while (written < count)
+	{
+		while (bitCount < codeSize && read < codes.size())
+		{
+			bits |= (unsigned int)codes[read++] << bitCount;
+			bitCount += 8;
+		}
+		if (bitCount < codeSize)
+			break;
+
+		unsigned int code = bits & ((1 << codeSize) - 1);
+		bits >>= codeSize;
+		bitCount -= codeSize;
+
+		if (code == clear)
+		{
+			codeSize = minCodeSize + 1;
+			next = clear + 2;
+			last = NO_CODE;
+			continue;
+		}
+		if (code == end)
+			break;
+
+		if (last != NO_CODE)
+		{
+			// A code one past the table is the last string followed by its own first index.
+			if (code > next)
+				return false;
+
+			if (next < GIF_LZW_CODES)
+			{
+				prefix[next] = (unsigned short)last;
+				suffix[next] = code < next ? first[code] : first[last];
+				first[next] = first[last];
+				length[next] = length[last] + 1;
+
+				if (++next == (1u << codeSize) && codeSize < 12)
+					++codeSize;
+			}
+		}
+		else if (code >= clear)
+		{
+			return false;
+		}
+
+		// Walk the string back to front, clipped to the image.
+		unsigned int entry = code;
+		for (size_t i = length[code]; i > 0; --i)
+		{
+			if (written + i - 1 < count)
+				out[written + i - 1] = suffix[entry];
+			entry = prefix[entry];
+		}
+
+		written += length[code];
+		last = code;
+	}
+
+	return true;
+}
+
+/*
+	Clears a rectangle of the canvas to transparent black,
+	clipped to the canvas.
+*/
+void GifDecoder::clearRect(unsigned int left, unsigned int top, unsigned int width, unsigned int height)
+{
+	for (unsigned int y = top; y < top + height && y < this->height; ++y)
+		for (unsigned int x = left; x < left + width && x < this->width; ++x)
+			memset(&canvas[((size_t)y * this->width + x) * 4], 0, 4);
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+// Includes.
+#include <cstddef>
+#include <vector>
+
+// Frame delay of GIFs that give none, and the shortest delay shown, in milliseconds.
+const unsigned int GIF_DEFAULT_DELAY = 100;
+const unsigned int GIF_MIN_DELAY = 20;
+
+// Largest canvas accepted, in pixels per side.
+const unsigned int GIF_MAX_SIZE = 4096;
+
+// Codes of the LZW dictionary, as limited by the 12 bit code size.
+const unsigned int GIF_LZW_CODES = 4096;
+
+/*
+	Decoder for (animated) GIF images, which SOIL can't
+	read. The frames are composed onto an RGBA canvas one
+	at a time, the way a browser plays them : with their
+	palettes, transparency, interlacing and disposal. After
+	the last frame it starts over at the first one.
+
+	The file's data is read in place, so it has to outlive
+	the decoder.
+*/
+class GifDecoder
+{
+public:
+
+// Functions
+
+	GifDecoder();
+	bool Open(const unsigned char* data, size_t size);
+	unsigned int GetWidth(void) const;
+	unsigned int GetHeight(void) const;
+	bool NextFrame(unsigned int& delay);
+	const unsigned char* GetPixels(void) const;
+
+private:
+
+// Functions
+
+	bool readImage(unsigned int transparent, unsigned int disposal);
+	bool readSubBlocks(std::vector<unsigned char>* out);
+	static bool decodeLzw(const std::vector<unsigned char>& codes, unsigned int minCodeSize, unsigned char* out, size_t count);
+	void clearRect(unsigned int left, unsigned int top, unsigned int width, unsigned int height);
+
+// Variables
+
+	const unsigned char*		data;
+	size_t						size;
+	size_t						position;
+	size_t						firstFrame;		// Offset of the block after the header.
+	unsigned int				width;
+	unsigned int				height;
+	unsigned char				globalPalette[256 * 3];
+	unsigned int				globalColors;
+	std::vector<unsigned char>	canvas;
+	std::vector<unsigned char>	previous;		// Canvas restored after a frame with disposal 3.
+	std::vector<unsigned char>	indices;
+	std::vector<unsigned int>	rows;			// Canvas row of every row of the image.
+	std::vector<unsigned char>	codes;
+
+	// Disposal of the last frame and the rectangle it covered.
+	unsigned int				disposal;
+	unsigned int				frameLeft;
+	unsigned int				frameTop;
+	unsigned int				frameWidth;
+	unsigned int				frameHeight;
+};
\ No newline at end of file
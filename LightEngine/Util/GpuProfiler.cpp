@@ -0,0 +1,353 @@
+#include "GpuProfiler.h"
+#include <cstring>
+#include <string>
+
+namespace
+{
+	/*
+		Timing data of a single named pass.
+
+		history	-	Ring buffer of results in nanoseconds.
+	*/
+	struct GpuPass
+	{
+		const char*		name;
+		unsigned int	depth;
+		GLuint64		history[GPU_PROFILER_HISTORY];
+		unsigned int	head;
+		unsigned int	count;
+	};
+
+	/*
+		One set of queries, used by one frame in flight.
+		Query pair i holds the begin and end timestamps of
+		the i-th pass opened in that frame.
+	*/
+	struct GpuFrameSlot
+	{
+		GLuint			queries[GPU_PROFILER_MAX_PASSES * 2];
+		unsigned int	pass[GPU_PROFILER_MAX_PASSES];
+		bool			closed[GPU_PROFILER_MAX_PASSES];
+		unsigned int	used;
+	};
+
+	GpuPass			passes[GPU_PROFILER_MAX_PASSES];
+	unsigned int	passCount;
+
+	GpuFrameSlot	slots[GPU_PROFILER_FRAMES];
+}
+
+bool			GpuProfiler::enabled = false;
+unsigned int	GpuProfiler::currentSlot = 0;
+unsigned int	GpuProfiler::openDepth = 0;
+int				GpuProfiler::frameQuery = -1;
+int				GpuProfiler::framePass = -1;
+double			GpuProfiler::lastFrameTime = 0.0;
+unsigned int	GpuProfiler::droppedCount = 0;
+
+/*
+	Creates the query objects. Has to be called with a
+	current OpenGL context. Returns false (and leaves the
+	profiler disabled) if timer queries aren't supported.
+*/
+bool GpuProfiler::Init(void)
+{
+	enabled = false;
+	passCount = 0;
+	currentSlot = 0;
+	openDepth = 0;
+	frameQuery = -1;
+	framePass = -1;
+	lastFrameTime = 0.0;
+	droppedCount = 0;
+
+	if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query)
+	{
+		LOG_WARNING(LOG_CATEGORY_RENDER, "Timer queries not supported, GPU profiling disabled.");
+		return false;
+	}
+
+	for (unsigned int i = 0; i < GPU_PROFILER_FRAMES; ++i)
+	{
+		glGenQueries(GPU_PROFILER_MAX_PASSES * 2, slots[i].queries);
+		slots[i].used = 0;
+	}
+
+	enabled = true;
+
+	LOG_DEBUG(LOG_CATEGORY_RENDER, "GPU profiler initialized.");
+
+	return true;
+}
+
+/*
+	Reads back every result that is still in flight
+	(waiting for the GPU, which is fine at shutdown)
+	and deletes the query objects.
+*/
+void GpuProfiler::Shutdown(void)
+{
+	if (!enabled)
+		return;
+
+	// Oldest frame first, so the history stays in order.
+	for (unsigned int i = 1; i <= GPU_PROFILER_FRAMES; ++i)
+		Collect((currentSlot + i) % GPU_PROFILER_FRAMES, true);
+
+	for (unsigned int i = 0; i < GPU_PROFILER_FRAMES; ++i)
+		glDeleteQueries(GPU_PROFILER_MAX_PASSES * 2, slots[i].queries);
+
+	enabled = false;
+}
+
+/*
+	Opens the "Frame" pass that encloses all passes of the frame.
+*/
+void GpuProfiler::BeginFrame(void)
+{
+	frameQuery = BeginPass("Frame");
+	if (frameQuery >= 0)
+		framePass = (int)slots[currentSlot].pass[frameQuery];
+}
+
+/*
+	Closes the "Frame" pass and moves on to the next set of
+	queries, reading back the results it held from
+	GPU_PROFILER_FRAMES frames ago.
+*/
+void GpuProfiler::EndFrame(void)
+{
+	if (!enabled)
+		return;
+
+	EndPass(frameQuery);
+	frameQuery = -1;
+
+	currentSlot = (currentSlot + 1) % GPU_PROFILER_FRAMES;
+	Collect(currentSlot, false);
+}
+
+/*
+	Writes the begin timestamp of a pass and returns the
+	handle to pass to EndPass(), or -1 if the pass isn't
+	profiled (profiler disabled or out of queries).
+
+	name	-	Name of the pass. Must outlive the profiler,
+				string literals are expected.
+*/
+int GpuProfiler::BeginPass(const char* name)
+{
+	if (!enabled)
+		return -1;
+
+	GpuFrameSlot& slot = slots[currentSlot];
+	if (slot.used >= GPU_PROFILER_MAX_PASSES)
+		return -1;
+
+	unsigned int pass = passCount;
+	for (unsigned int i = 0; i < passCount; ++i)
+	{
+		if (passes[i].name == name || strcmp(passes[i].name, name) == 0)
+		{
+			pass = i;
+			break;
+		}
+	}
+
+	if (pass == passCount)
+	{
+		if (passCount >= GPU_PROFILER_MAX_PASSES)
+			return -1;
+
+		passes[pass].name = name;
+		passes[pass].depth = openDepth;
+		passes[pass].head = 0;
+		passes[pass].count = 0;
+		++passCount;
+	}
+
+	int query = (int)slot.used++;
+	slot.pass[query] = pass;
+	slot.closed[query] = false;
+
+	glQueryCounter(slot.queries[query * 2], GL_TIMESTAMP);
+	++openDepth;
+
+	return query;
+}
+
+/*
+	Writes the end timestamp of a pass.
+
+	query	-	Handle returned by BeginPass().
+*/
+void GpuProfiler::EndPass(int query)
+{
+	if (!enabled || query < 0)
+		return;
+
+	GpuFrameSlot& slot = slots[currentSlot];
+
+	glQueryCounter(slot.queries[query * 2 + 1], GL_TIMESTAMP);
+	slot.closed[query] = true;
+
+	if (openDepth > 0)
+		--openDepth;
+}
+
+/*
+	Reads the results of a set of queries into the pass
+	histories and frees the set for reuse.
+
+	slot	-	Index of the set.
+	wait	-	Whether to wait for results that aren't
+				available yet instead of dropping them.
+*/
+void GpuProfiler::Collect(unsigned int slot, bool wait)
+{
+	GpuFrameSlot& frame = slots[slot];
+
+	for (unsigned int i = 0; i < frame.used; ++i)
+	{
+		if (!frame.closed[i])
+			continue;
+
+		GLuint endQuery = frame.queries[i * 2 + 1];
+
+		if (!wait)
+		{
+			// The end timestamp is written last, so once it is
+			// available the begin timestamp is as well.
+			GLint available = 0;
+			glGetQueryObjectiv(endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				++droppedCount;
+				continue;
+			}
+		}
+
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(endQuery, GL_QUERY_RESULT, &end);
+
+		GLuint64 elapsed = (end > begin) ? end - begin : 0;
+		if ((int)frame.pass[i] == framePass)
+			lastFrameTime = elapsed / 1000000.0;
+
+		GpuPass& pass = passes[frame.pass[i]];
+		pass.history[pass.head] = elapsed;
+		pass.head = (pass.head + 1) % GPU_PROFILER_HISTORY;
+		if (pass.count < GPU_PROFILER_HISTORY)
+			++pass.count;
+	}
+
+	frame.used = 0;
+}
+
+/*
+	Whether timer queries are available and being issued.
+*/
+bool GpuProfiler::IsEnabled(void)
+{
+	return enabled;
+}
+
+/*
+	Number of distinct passes seen so far.
+*/
+unsigned int GpuProfiler::GetPassCount(void)
+{
+	return passCount;
+}
+
+/*
+	Computes the statistics of a pass over its history.
+	Returns false if the pass doesn't exist.
+
+	pass	-	Index of the pass, 0 to GetPassCount() - 1.
+	stats	-	Receives the statistics.
+*/
+bool GpuProfiler::GetPassStats(unsigned int pass, GpuPassStats& stats)
+{
+	if (pass >= passCount)
+		return false;
+
+	const GpuPass& p = passes[pass];
+
+	stats.name = p.name;
+	stats.depth = p.depth;
+	stats.samples = p.count;
+	stats.last = stats.avg = stats.max = 0.0;
+
+	if (p.count == 0)
+		return true;
+
+	GLuint64 sum = 0, max = 0;
+	for (unsigned int i = 0; i < p.count; ++i)
+	{
+		sum += p.history[i];
+		if (p.history[i] > max)
+			max = p.history[i];
+	}
+
+	stats.last = p.history[(p.head + GPU_PROFILER_HISTORY - 1) % GPU_PROFILER_HISTORY] / 1000000.0;
+	stats.avg = (double)sum / p.count / 1000000.0;
+	stats.max = max / 1000000.0;
+
+	return true;
+}
+
+/*
+	GPU time in ms of the most recent frame whose
+	queries have been read back.
+*/
+double GpuProfiler::GetFrameTime(void)
+{
+	return lastFrameTime;
+}
+
+/*
+	Writes a table with the GPU time of every pass to the log.
+*/
+void GpuProfiler::LogReport(void)
+{
+	if (passCount == 0)
+		return;
+
+	LOG_INFO(LOG_CATEGORY_RENDER, "");
+	LOG_INFO(LOG_CATEGORY_RENDER, "===GPU Profile (ms)===");
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_RENDER, "%-36s %8s %8s %8s %7s", "Pass", "last", "avg", "max", "samples");
+
+	for (unsigned int i = 0; i < passCount; ++i)
+	{
+		GpuPassStats stats;
+		GetPassStats(i, stats);
+
+		std::string label(2 * stats.depth, ' ');
+		label += stats.name;
+
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_RENDER, "%-36s %8.3f %8.3f %8.3f %7u",
+			label.c_str(), stats.last, stats.avg, stats.max, stats.samples);
+	}
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_RENDER, "Dropped results: %u", droppedCount);
+}
+
+/*
+	Opens a GPU pass for the lifetime of the object.
+
+	name	-	Name of the pass (string literal).
+*/
+GpuScope::GpuScope(const char* name)
+{
+	query = GpuProfiler::BeginPass(name);
+}
+
+/*
+	Closes the pass opened by the constructor.
+*/
+GpuScope::~GpuScope()
+{
+	GpuProfiler::EndPass(query);
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+// Includes.
+#include "..\Contrib\Include\gl\glew.h"
+#include "Utility.h"
+#include "Profiler.h"
+
+// Limits of the GPU profiler.
+const unsigned int GPU_PROFILER_FRAMES = 3;			// Frames in flight before a result is read back.
+const unsigned int GPU_PROFILER_MAX_PASSES = 32;	// Passes per frame, and distinct pass names.
+const unsigned int GPU_PROFILER_HISTORY = 64;		// Frames the average is taken over.
+
+/*
+	GPU time of one named pass. All times are in milliseconds.
+
+	name	-	Name the pass was opened with.
+	depth	-	Nesting depth, 0 for top level passes.
+	samples	-	Number of results in the history.
+	last	-	Most recent result (GPU_PROFILER_FRAMES old).
+*/
+struct GpuPassStats
+{
+	const char*		name;
+	unsigned int	depth;
+	unsigned int	samples;
+	double			last;
+	double			avg;
+	double			max;
+};
+
+/*
+	GPU profiler built on GL_TIMESTAMP queries. Every pass
+	writes a timestamp when it begins and one when it ends,
+	so passes can be nested. Queries are cycled through
+	GPU_PROFILER_FRAMES sets and a set is only read back
+	when it comes around again, by which time the GPU has
+	finished with it and reading never stalls the pipeline.
+	Results that still aren't available are dropped rather
+	than waited for.
+
+	Timer queries are core in OpenGL 3.3 (and exposed by
+	Mesa's llvmpipe). Without them every call is a no-op.
+*/
+class GpuProfiler
+{
+public:
+
+// Functions
+
+	static bool Init(void);
+	static void Shutdown(void);
+	static void BeginFrame(void);
+	static void EndFrame(void);
+	static int BeginPass(const char* name);
+	static void EndPass(int query);
+
+	static bool IsEnabled(void);
+	static unsigned int GetPassCount(void);
+	static bool GetPassStats(unsigned int pass, GpuPassStats& stats);
+	static double GetFrameTime(void);
+	static void LogReport(void);
+
+private:
+
+// Functions
+
+	static void Collect(unsigned int slot, bool wait);
+
+// Variables
+
+	static bool				enabled;
+	static unsigned int		currentSlot;
+	static unsigned int		openDepth;
+	static int				frameQuery;
+	static int				framePass;
+	static double			lastFrameTime;
+	static unsigned int		droppedCount;	// Results still unavailable after GPU_PROFILER_FRAMES frames.
+};
+
+/*
+	RAII marker that times the enclosing scope as a GPU pass.
+*/
+class GpuScope
+{
+public:
+
+// Functions
+
+	GpuScope(const char* name);
+	~GpuScope();
+
+private:
+
+// Variables
+
+	int	query;
+};
+
+#define GPU_SCOPE(name)	GpuScope PROFILE_CONCAT(gpuScope, __LINE__)(name)
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "KtxFile.h"
+#include "BlockCompressor.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+/*
+	Default constructor, the file is empty.
+*/
+KtxFile::KtxFile()
+{
+	internalFormat = 0;
+}
+
+/*
+	Reads a file and checks that its header and every
+	level match the format and lie within the file.
+
+	path	-	Path to the .ktx file.
+*/
+bool KtxFile::Read(const char* path)
+{
+	data.clear();
+	levels.clear();
+
+	FILE* file = NULL;
+	if (fopen_s(&file, path, "rb") != 0 || file == NULL)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size > (long)sizeof(KtxHeader))
+	{
+		data.resize((size_t)size);
+		if (fread(&data[0], 1, data.size(), file) != data.size())
+			data.clear();
+	}
+	fclose(file);
+
+	if (data.empty())
+		return false;
+
+	KtxHeader header;
+	memcpy(&header, &data[0], sizeof(header));
+	if (memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0 || header.endianness != KTX_ENDIANNESS ||
+		header.glType != 0 || !BlockCompressor::IsSupported(header.glInternalFormat) || header.pixelWidth == 0 || header.pixelHeight == 0 ||
+		header.pixelDepth != 0 || header.numberOfArrayElements != 0 || header.numberOfFaces != 1 || header.numberOfMipmapLevels == 0)
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Unsupported KTX file %s.", path);
+		data.clear();
+		return false;
+	}
+
+	internalFormat = header.glInternalFormat;
+	size_t offset = sizeof(KtxHeader) + header.bytesOfKeyValueData;
+	unsigned int width = header.pixelWidth, height = header.pixelHeight;
+	for (unsigned int i = 0; i < header.numberOfMipmapLevels; ++i)
+	{
+		unsigned int imageSize;
+		if (offset + sizeof(imageSize) > data.size())
+			break;
+		memcpy(&imageSize, &data[offset], sizeof(imageSize));
+		offset += sizeof(imageSize);
+
+		KtxLevel level = { width, height, offset, imageSize };
+		if (imageSize != BlockCompressor::GetImageSize(internalFormat, width, height) || offset + imageSize > data.size())
+			break;
+		levels.push_back(level);
+
+		// Levels are padded to 4 bytes, which block sizes already are.
+		offset += (imageSize + 3) & ~3u;
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+
+	if (levels.size() != header.numberOfMipmapLevels)
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "KTX file %s is truncated.", path);
+		data.clear();
+		levels.clear();
+		return false;
+	}
+	return true;
+}
+
+/*
+	Writes a block compressed texture and its mip chain.
+
+	path				-	Path to the .ktx file.
+	internalFormat		-	Compressed format of the levels.
+	baseInternalFormat	-	GL_RGB, GL_RGBA or GL_RG.
+	width, height		-	Size of level 0 in pixels.
+	levels				-	Encoded images, from level 0 down, each
+							half the size of the one before.
+*/
+bool KtxFile::Write(const char* path, GLenum internalFormat, GLenum baseInternalFormat, unsigned int width, unsigned int height,
+	const std::vector<std::vector<unsigned char> >& levels)
+{
+	FILE* file = NULL;
+	if (fopen_s(&file, path, "wb") != 0 || file == NULL)
+		return false;
+
+	KtxHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+	header.endianness = KTX_ENDIANNESS;
+	header.glTypeSize = 1;
+	header.glInternalFormat = internalFormat;
+	header.glBaseInternalFormat = baseInternalFormat;
+	header.pixelWidth = width;
+	header.pixelHeight = height;
+	header.numberOfFaces = 1;
+	header.numberOfMipmapLevels = (unsigned int)levels.size();
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (size_t i = 0; written && i < levels.size(); ++i)
+	{
+		unsigned int imageSize = (unsigned int)levels[i].size();
+		written = fwrite(&imageSize, sizeof(imageSize), 1, file) == 1 && fwrite(&levels[i][0], 1, imageSize, file) == imageSize;
+	}
+
+	written = fclose(file) == 0 && written;
+	if (!written)
+		remove(path);
+	return written;
+}
+
+/*
+	Compressed format of the levels.
+*/
+GLenum KtxFile::GetInternalFormat(void) const
+{
+	return internalFormat;
+}
+
+/*
+	Width of level 0 in pixels.
+*/
+unsigned int KtxFile::GetWidth(void) const
+{
+	return levels.empty() ? 0 : levels[0].width;
+}
+
+/*
+	Height of level 0 in pixels.
+*/
+unsigned int KtxFile::GetHeight(void) const
+{
+	return levels.empty() ? 0 : levels[0].height;
+}
+
+/*
+	Number of mip levels, 0 if nothing was read.
+*/
+unsigned int KtxFile::GetLevelCount(void) const
+{
+	return (unsigned int)levels.size();
+}
+
+/*
+	Size and position of a mip level.
+
+	level	-	Less than GetLevelCount().
+*/
+const KtxLevel& KtxFile::GetLevel(unsigned int level) const
+{
+	return levels[level];
+}
+
+/*
+	Contents of the whole file.
+*/
+const unsigned char* KtxFile::GetData(void) const
+{
+	return data.empty() ? NULL : &data[0];
+}
+
+/*
+	Size of the whole file in bytes.
+*/
+size_t KtxFile::GetDataSize(void) const
+{
+	return data.size();
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+// Includes.
+#include <vector>
+#include "..\Contrib\Include\gl\glew.h"
+#include "Utility.h"
+
+// KTX 1.1 file identifier.
+const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// Written by the file's author, read back as such if the byte order matches.
+const unsigned int KTX_ENDIANNESS = 0x04030201;
+
+/*
+	Header of a KTX 1.1 file. The key/value data follows,
+	then every mip level : its size in bytes and its image.
+*/
+struct KtxHeader
+{
+	unsigned char	identifier[12];
+	unsigned int	endianness;
+	unsigned int	glType;
+	unsigned int	glTypeSize;
+	unsigned int	glFormat;
+	unsigned int	glInternalFormat;
+	unsigned int	glBaseInternalFormat;
+	unsigned int	pixelWidth;
+	unsigned int	pixelHeight;
+	unsigned int	pixelDepth;
+	unsigned int	numberOfArrayElements;
+	unsigned int	numberOfFaces;
+	unsigned int	numberOfMipmapLevels;
+	unsigned int	bytesOfKeyValueData;
+};
+
+static_assert(sizeof(KtxHeader) == 64, "KtxHeader must match the file layout.");
+
+/*
+	One mip level of a KtxFile.
+
+	offset	-	Offset of the image in the file's data.
+	size	-	Bytes of the image.
+*/
+struct KtxLevel
+{
+	unsigned int	width;
+	unsigned int	height;
+	size_t			offset;
+	size_t			size;
+};
+
+/*
+	Block compressed 2D texture in a KTX 1.1 file, with
+	its mip chain. Only what the texture cooker writes is
+	read back : one face, no arrays, a compressed format.
+
+	Read() keeps the whole file in memory, so the levels
+	can be uploaded from one buffer : every level's image
+	is at its offset into GetData().
+*/
+class KtxFile
+{
+public:
+
+// Functions
+
+	KtxFile();
+	bool Read(const char* path);
+	static bool Write(const char* path, GLenum internalFormat, GLenum baseInternalFormat, unsigned int width, unsigned int height,
+		const std::vector<std::vector<unsigned char> >& levels);
+	GLenum GetInternalFormat(void) const;
+	unsigned int GetWidth(void) const;
+	unsigned int GetHeight(void) const;
+	unsigned int GetLevelCount(void) const;
+	const KtxLevel& GetLevel(unsigned int level) const;
+	const unsigned char* GetData(void) const;
+	size_t GetDataSize(void) const;
+
+private:
+
+// Variables
+
+	std::vector<unsigned char>	data;
+	std::vector<KtxLevel>		levels;
+	GLenum						internalFormat;
+};
\ No newline at end of file
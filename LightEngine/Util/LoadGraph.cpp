@@ -0,0 +1,303 @@
+#include "LoadGraph.h"
+
+/*
+	Constructor, the graph is empty.
+
+	pool	-	Threads the worker tasks run on.
+*/
+LoadGraph::LoadGraph(ThreadPool* pool)
+{
+	this->pool = pool;
+	workersInFlight = 0;
+	finished = 0;
+	totalWeight = finishedWeight = 0.0f;
+	startTime = finishTime = 0.0;
+	started = false;
+}
+
+/*
+	Adds a task, before Start(). Returns its index for
+	AddDependency().
+
+	name	-	Shown on the loading screen and in the report.
+	thread	-	Where it runs.
+	weight	-	Share of the progress it stands for, e.g. a
+				rough estimate of its time.
+	run		-	The work.
+*/
+unsigned int LoadGraph::Add(const char* name, LoadTaskThread thread, float weight, const std::function<void()>& run)
+{
+	LoadTask task;
+	task.name = name;
+	task.thread = thread;
+	task.weight = weight;
+	task.run = run;
+	task.pending = 0;
+	task.state = LOAD_TASK_WAITING;
+	task.start = task.time = 0.0;
+
+	tasks.push_back(task);
+	totalWeight += weight;
+	return (unsigned int)tasks.size() - 1;
+}
+
+/*
+	Makes a task wait for another one, before Start().
+
+	task		-	Index of the waiting task.
+	dependency	-	Index of the task it waits for.
+*/
+void LoadGraph::AddDependency(unsigned int task, unsigned int dependency)
+{
+	tasks[dependency].dependents.push_back(task);
+	++tasks[task].pending;
+}
+
+/*
+	Starts every task that has no dependencies : worker
+	tasks are submitted to the pool, main thread tasks
+	wait for Update().
+*/
+void LoadGraph::Start(void)
+{
+	std::vector<unsigned int> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		started = true;
+		startTime = getTimeElapsed();
+
+		for (unsigned int i = 0; i < tasks.size(); ++i)
+		{
+			if (tasks[i].pending > 0)
+				continue;
+
+			tasks[i].state = LOAD_TASK_READY;
+			if (tasks[i].thread == LOAD_TASK_WORKER)
+			{
+				ready.push_back(i);
+				++workersInFlight;
+			}
+			else
+			{
+				mainQueue.push_back(i);
+			}
+		}
+
+		if (tasks.empty())
+			finishTime = startTime;
+	}
+
+	// A pool of 1 runs jobs inline, so nothing may be locked here.
+	submit(ready);
+}
+
+/*
+	Runs the main thread tasks that are ready, at least
+	one if there is any, until the budget is used up.
+	Call it once per frame on the thread that owns the
+	context.
+
+	budget	-	Seconds the tasks may take.
+*/
+void LoadGraph::Update(double budget)
+{
+	double start = getTimeElapsed();
+	do
+	{
+		unsigned int index;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (mainQueue.empty())
+				return;
+
+			index = mainQueue.front();
+			mainQueue.pop_front();
+		}
+
+		run(index);
+	} while (getTimeElapsed() - start < budget);
+}
+
+/*
+	Whether every task has finished.
+*/
+bool LoadGraph::IsFinished(void) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return started && finished == tasks.size();
+}
+
+/*
+	Weight of the finished tasks over the total, from 0 to 1.
+*/
+float LoadGraph::GetProgress(void) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return totalWeight > 0.0f ? finishedWeight / totalWeight : (started ? 1.0f : 0.0f);
+}
+
+/*
+	Names of the tasks that are running, or queued if none
+	is, separated by commas.
+*/
+std::string LoadGraph::GetStatus(void) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::string status;
+	for (int pass = 0; pass < 2 && status.empty(); ++pass)
+	{
+		LoadTaskState state = pass == 0 ? LOAD_TASK_RUNNING : LOAD_TASK_READY;
+		for (unsigned int i = 0; i < tasks.size(); ++i)
+		{
+			if (tasks[i].state != state)
+				continue;
+
+			if (!status.empty())
+				status += ", ";
+			status += tasks[i].name;
+		}
+	}
+
+	return status;
+}
+
+/*
+	Logs when every task started and how long it ran, and
+	how much of the load ran in parallel.
+*/
+void LoadGraph::LogReport(void) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	double workerTime = 0.0, mainTime = 0.0;
+	for (unsigned int i = 0; i < tasks.size(); ++i)
+	{
+		const LoadTask& task = tasks[i];
+		if (task.state != LOAD_TASK_DONE)
+		{
+			LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Load task %s (%s) : not finished.", task.name.c_str(),
+				task.thread == LOAD_TASK_WORKER ? "worker" : "main");
+			continue;
+		}
+
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Load task %s (%s) : started at %.1f ms, ran %.1f ms.", task.name.c_str(),
+			task.thread == LOAD_TASK_WORKER ? "worker" : "main", task.start * 1000.0, task.time * 1000.0);
+
+		if (task.thread == LOAD_TASK_WORKER)
+			workerTime += task.time;
+		else
+			mainTime += task.time;
+	}
+
+	if (finished == tasks.size() && started)
+	{
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Load graph : %u tasks in %.1f ms, %.1f ms on workers, %.1f ms on the main thread.",
+			(unsigned int)tasks.size(), (finishTime - startTime) * 1000.0, workerTime * 1000.0, mainTime * 1000.0);
+	}
+}
+
+/*
+	Destructor, waits for the worker tasks that are still
+	running. Tasks that haven't started never will.
+*/
+LoadGraph::~LoadGraph()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this]() { return workersInFlight == 0; });
+}
+
+/*
+	Job of a worker task on the pool.
+
+	index	-	Index of the task.
+*/
+void LoadGraph::runWorker(unsigned int index)
+{
+	run(index);
+
+	// Notified under the lock : the destructor may return as soon as it can take it.
+	std::lock_guard<std::mutex> lock(mutex);
+	if (--workersInFlight == 0)
+		idle.notify_all();
+}
+
+/*
+	Runs a task on the calling thread and starts the
+	dependents it was the last dependency of.
+
+	index	-	Index of the task.
+*/
+void LoadGraph::run(unsigned int index)
+{
+	LoadTask& task = tasks[index];
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		task.state = LOAD_TASK_RUNNING;
+		task.start = getTimeElapsed() - startTime;
+	}
+
+	{
+		PROFILE_SCOPE_DETAIL("LoadGraph::Task", task.name.c_str());
+		task.run();
+	}
+
+	std::vector<unsigned int> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finish(index, ready);
+	}
+	submit(ready);
+}
+
+/*
+	Marks a task as done and queues the dependents that
+	don't wait for anything else. Called with the mutex
+	locked.
+
+	index	-	Index of the task.
+	ready	-	Receives the worker tasks to submit.
+*/
+void LoadGraph::finish(unsigned int index, std::vector<unsigned int>& ready)
+{
+	LoadTask& task = tasks[index];
+	task.state = LOAD_TASK_DONE;
+	task.time = getTimeElapsed() - startTime - task.start;
+	finishedWeight += task.weight;
+
+	if (++finished == tasks.size())
+		finishTime = getTimeElapsed();
+
+	for (unsigned int i = 0; i < task.dependents.size(); ++i)
+	{
+		LoadTask& dependent = tasks[task.dependents[i]];
+		if (--dependent.pending > 0)
+			continue;
+
+		dependent.state = LOAD_TASK_READY;
+		if (dependent.thread == LOAD_TASK_WORKER)
+		{
+			ready.push_back(task.dependents[i]);
+			++workersInFlight;
+		}
+		else
+		{
+			mainQueue.push_back(task.dependents[i]);
+		}
+	}
+}
+
+/*
+	Submits worker tasks to the pool. Called without the
+	mutex locked.
+
+	ready	-	Indices of the tasks.
+*/
+void LoadGraph::submit(const std::vector<unsigned int>& ready)
+{
+	for (unsigned int i = 0; i < ready.size(); ++i)
+	{
+		unsigned int index = ready[i];
+		pool->Submit([this, index]() { runWorker(index); });
+	}
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+// Includes.
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "Utility.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+enum LoadTaskThread
+{
+	LOAD_TASK_WORKER,	// Runs as a job on the pool, must not touch OpenGL.
+	LOAD_TASK_MAIN		// Runs in Update(), on the thread that owns the context.
+};
+
+enum LoadTaskState
+{
+	LOAD_TASK_WAITING,	// Some dependency hasn't finished.
+	LOAD_TASK_READY,	// Queued on its thread.
+	LOAD_TASK_RUNNING,
+	LOAD_TASK_DONE
+};
+
+/*
+	One task of a LoadGraph.
+
+	name		-	Shown on the loading screen and in the report.
+	thread		-	Where it runs.
+	weight		-	Share of the progress it stands for.
+	run			-	The work.
+	dependents	-	Tasks waiting for this one.
+	pending		-	Dependencies that haven't finished.
+	start		-	Seconds from Start() to when it began.
+	time		-	Seconds it ran.
+*/
+struct LoadTask
+{
+	std::string					name;
+	LoadTaskThread				thread;
+	float						weight;
+	std::function<void()>		run;
+	std::vector<unsigned int>	dependents;
+	unsigned int				pending;
+	LoadTaskState				state;
+	double						start;
+	double						time;
+};
+
+/*
+	Dependency graph of loading tasks. CPU work (reading
+	and importing files) runs on the ThreadPool, while the
+	GL objects are created by Update() on the main thread,
+	a few at a time, so it can keep presenting frames
+	during the load.
+
+	A task is started as soon as all of its dependencies
+	have finished. Tasks and dependencies are added before
+	Start(), after that the graph only runs. The progress
+	is the weight of the finished tasks over the total.
+
+	The graph waits for its tasks on the pool when it is
+	destroyed, so declare it after anything they write to.
+*/
+class LoadGraph
+{
+public:
+
+// Functions
+
+	LoadGraph(ThreadPool* pool);
+	unsigned int Add(const char* name, LoadTaskThread thread, float weight, const std::function<void()>& run);
+	void AddDependency(unsigned int task, unsigned int dependency);
+	void Start(void);
+	void Update(double budget);
+	bool IsFinished(void) const;
+	float GetProgress(void) const;
+	std::string GetStatus(void) const;
+	void LogReport(void) const;
+	~LoadGraph();
+
+private:
+
+// Functions
+
+	// Tasks refer to it, so it can't be copied.
+	LoadGraph(const LoadGraph&);
+	LoadGraph& operator=(const LoadGraph&);
+
+	void runWorker(unsigned int index);
+	void run(unsigned int index);
+	void finish(unsigned int index, std::vector<unsigned int>& ready);
+	void submit(const std::vector<unsigned int>& ready);
+
+// Variables
+
+	ThreadPool*					pool;
+	std::vector<LoadTask>		tasks;
+	std::deque<unsigned int>	mainQueue;
+	mutable std::mutex			mutex;
+	std::condition_variable		idle;				// Signals the last worker task in flight finishing.
+	unsigned int				workersInFlight;	// Submitted worker tasks that haven't finished.
+	unsigned int				finished;
+	float						totalWeight;
+	float						finishedWeight;
+	double						startTime;
+	double						finishTime;
+	bool						started;
+};
\ No newline at end of file
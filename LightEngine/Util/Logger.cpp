@@ -0,0 +1,364 @@
+#include "Logger.h"
+#include <cstdarg>
+#include <cstring>
+#include <chrono>
+
+namespace
+{
+	// Number of slots in the ring. Must be a power of two.
+	const unsigned int LOG_QUEUE_SIZE = 1024;
+	const unsigned int LOG_QUEUE_MASK = LOG_QUEUE_SIZE - 1;
+
+	// Longest message that is stored, longer ones are truncated.
+	// Large enough to hold a full shader info log.
+	const unsigned int LOG_MESSAGE_LENGTH = 1024;
+
+	// Size of the buffer the writer thread fills before each fwrite.
+	const unsigned int LOG_BATCH_SIZE = 64 * 1024;
+
+	/*
+		One message in the ring. The sequence number tells
+		producers and the consumer who owns the slot.
+	*/
+	struct LogSlot
+	{
+		std::atomic<unsigned int>	sequence;
+		__int64						timestamp;
+		unsigned short				level;
+		unsigned short				category;
+		char						text[LOG_MESSAGE_LENGTH];
+	};
+
+	/*
+		Queue cursor padded to its own cache line so that the
+		producers and the consumer don't false-share.
+	*/
+	struct LogCursor
+	{
+		std::atomic<unsigned int>	value;
+		char						padding[64 - sizeof(std::atomic<unsigned int>)];
+	};
+
+	LogSlot*	slots;
+	LogCursor	enqueuePos;
+	LogCursor	dequeuePos;
+
+	__int64		startCount;
+	double		secondsPerCount;
+
+	char*		batch;
+
+	const char* LevelName(unsigned short level)
+	{
+		switch (level)
+		{
+		case LOG_LEVEL_TRACE:	return "TRACE";
+		case LOG_LEVEL_DEBUG:	return "DEBUG";
+		case LOG_LEVEL_INFO:	return "INFO ";
+		case LOG_LEVEL_WARNING:	return "WARN ";
+		case LOG_LEVEL_ERROR:	return "ERROR";
+		}
+		return "?????";
+	}
+
+	const char* CategoryName(unsigned short category)
+	{
+		if (category & LOG_CATEGORY_CORE)	return "Core  ";
+		if (category & LOG_CATEGORY_RENDER)	return "Render";
+		if (category & LOG_CATEGORY_SHADER)	return "Shader";
+		if (category & LOG_CATEGORY_ASSET)	return "Asset ";
+		return "------";
+	}
+}
+
+std::atomic<bool>			Logger::initialized(false);
+FILE*						Logger::file = NULL;
+std::thread					Logger::writer;
+std::mutex					Logger::wakeMutex;
+std::condition_variable		Logger::wakeCondition;
+std::atomic<bool>			Logger::running;
+std::atomic<unsigned int>	Logger::producers;
+std::atomic<unsigned int>	Logger::writtenPos;
+std::atomic<unsigned int>	Logger::stallCount;
+
+/*
+	Opens (and truncates) the log file, allocates the
+	ring buffer and starts the background writer thread.
+
+	path	-	Path of the log file.
+*/
+bool Logger::Init(const char* path)
+{
+	if (initialized)
+		return true;
+
+	if (fopen_s(&file, path, "w") != 0 || file == NULL)
+		return false;
+
+	slots = new LogSlot[LOG_QUEUE_SIZE];
+	for (unsigned int i = 0; i < LOG_QUEUE_SIZE; ++i)
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+
+	batch = new char[LOG_BATCH_SIZE];
+
+	enqueuePos.value.store(0, std::memory_order_relaxed);
+	dequeuePos.value.store(0, std::memory_order_relaxed);
+	writtenPos.store(0, std::memory_order_relaxed);
+	stallCount.store(0, std::memory_order_relaxed);
+
+	__int64 countsPerSec;
+	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
+	QueryPerformanceCounter((LARGE_INTEGER*)&startCount);
+	secondsPerCount = 1.0 / (double)countsPerSec;
+
+	running.store(true);
+	writer = std::thread(&Logger::WriterLoop);
+
+	initialized.store(true, std::memory_order_release);
+
+	return true;
+}
+
+/*
+	Queues a message for the writer thread. Never touches
+	the file system. If the ring is full the caller yields
+	until the writer has made room, so no message is lost.
+
+	level		-	Severity of the message.
+	category	-	Subsystem the message belongs to.
+	message		-	Null-terminated message text.
+*/
+void Logger::Write(LogLevel level, LogCategory category, const char* message)
+{
+	// Counted before the check, so that Shutdown() can't free the ring under us.
+	producers.fetch_add(1);
+
+	// Messages logged before Init() (e.g. from global constructors) or after
+	// Shutdown() are dropped, the log file is truncated by Init() anyway.
+	if (!initialized.load())
+	{
+		producers.fetch_sub(1);
+		return;
+	}
+
+	while (!TryEnqueue(level, category, message))
+	{
+		stallCount.fetch_add(1, std::memory_order_relaxed);
+		wakeCondition.notify_one();
+		std::this_thread::yield();
+	}
+
+	// Errors are written out right away instead of waiting for the next batch.
+	if (level >= LOG_LEVEL_ERROR)
+		wakeCondition.notify_one();
+
+	producers.fetch_sub(1);
+}
+
+/*
+	printf-style variant of Write().
+
+	level		-	Severity of the message.
+	category	-	Subsystem the message belongs to.
+	format		-	printf format string followed by its arguments.
+*/
+void Logger::WriteFormat(LogLevel level, LogCategory category, const char* format, ...)
+{
+	if (!initialized)
+		return;
+
+	char buffer[LOG_MESSAGE_LENGTH];
+
+	va_list args;
+	va_start(args, format);
+	_vsnprintf_s(buffer, sizeof(buffer), _TRUNCATE, format, args);
+	va_end(args);
+
+	Write(level, category, buffer);
+}
+
+/*
+	Claims a slot in the ring with a CAS on the enqueue
+	cursor, fills it and publishes it to the consumer.
+	Returns false if the ring is full.
+*/
+bool Logger::TryEnqueue(LogLevel level, LogCategory category, const char* message)
+{
+	LogSlot* slot;
+	unsigned int pos = enqueuePos.value.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		slot = &slots[pos & LOG_QUEUE_MASK];
+		unsigned int sequence = slot->sequence.load(std::memory_order_acquire);
+		int difference = (int)(sequence - pos);
+
+		if (difference == 0)
+		{
+			if (enqueuePos.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			// The writer hasn't consumed this slot yet.
+			return false;
+		}
+		else
+		{
+			pos = enqueuePos.value.load(std::memory_order_relaxed);
+		}
+	}
+
+	QueryPerformanceCounter((LARGE_INTEGER*)&slot->timestamp);
+	slot->level = (unsigned short)level;
+	slot->category = (unsigned short)category;
+	strncpy_s(slot->text, sizeof(slot->text), message, _TRUNCATE);
+
+	slot->sequence.store(pos + 1, std::memory_order_release);
+
+	return true;
+}
+
+/*
+	Consumes the messages published before the call, formats
+	them into the batch buffer and writes the buffer to the
+	file whenever it fills up. Returns the number of consumed
+	messages. Only ever called from the writer thread.
+*/
+unsigned int Logger::Drain(void)
+{
+	unsigned int count = 0;
+	unsigned int used = 0;
+	unsigned int pos = dequeuePos.value.load(std::memory_order_relaxed);
+
+	// Stop at the messages queued so far, so that the progress is published
+	// (and Flush() returns) even while other threads keep logging.
+	unsigned int end = enqueuePos.value.load(std::memory_order_acquire);
+
+	while (pos != end)
+	{
+		LogSlot* slot = &slots[pos & LOG_QUEUE_MASK];
+		unsigned int sequence = slot->sequence.load(std::memory_order_acquire);
+
+		if ((int)(sequence - (pos + 1)) < 0)
+			break;
+
+		// Make sure a complete line always fits into the batch.
+		if (LOG_BATCH_SIZE - used < LOG_MESSAGE_LENGTH + 64)
+		{
+			fwrite(batch, 1, used, file);
+			used = 0;
+		}
+
+		if (slot->text[0] == '\0')
+		{
+			// Empty messages are used as section separators, keep them blank.
+			batch[used++] = '\n';
+		}
+		else
+		{
+			double seconds = (slot->timestamp - startCount) * secondsPerCount;
+			int written = _snprintf_s(batch + used, LOG_BATCH_SIZE - used, _TRUNCATE, "[%10.4f] [%s] [%s] %s\n",
+				seconds, LevelName(slot->level), CategoryName(slot->category), slot->text);
+			if (written > 0)
+				used += written;
+		}
+
+		// Hand the slot back to the producers for the next lap.
+		slot->sequence.store(pos + LOG_QUEUE_SIZE, std::memory_order_release);
+		++pos;
+		++count;
+	}
+
+	if (count > 0)
+	{
+		if (used > 0)
+			fwrite(batch, 1, used, file);
+		fflush(file);
+
+		dequeuePos.value.store(pos, std::memory_order_relaxed);
+		writtenPos.store(pos, std::memory_order_release);
+	}
+
+	return count;
+}
+
+/*
+	Body of the writer thread. Drains the ring and sleeps
+	for a few milliseconds whenever there is nothing to do.
+*/
+void Logger::WriterLoop(void)
+{
+	for (;;)
+	{
+		// Read the flag before draining so that the last drain after
+		// Shutdown() is guaranteed to see every queued message.
+		bool stopping = !running.load(std::memory_order_acquire);
+
+		if (Drain() > 0)
+			continue;
+
+		if (stopping)
+			break;
+
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		wakeCondition.wait_for(lock, std::chrono::milliseconds(5));
+	}
+}
+
+/*
+	Blocks until every message queued before the call
+	has been written and flushed to the log file.
+*/
+void Logger::Flush(void)
+{
+	if (!initialized)
+		return;
+
+	unsigned int target = enqueuePos.value.load(std::memory_order_acquire);
+
+	while ((int)(writtenPos.load(std::memory_order_acquire) - target) < 0)
+	{
+		wakeCondition.notify_one();
+		std::this_thread::yield();
+	}
+}
+
+/*
+	Stops taking messages, waits for the threads that are
+	still queueing one, then lets the writer thread write
+	out everything and stop, and closes the log file.
+*/
+void Logger::Shutdown(void)
+{
+	if (!initialized)
+		return;
+
+	// From here on Write() drops messages. Threads that got past its check
+	// still hold the ring, so it is only freed once they are done.
+	initialized.store(false);
+	while (producers.load() != 0)
+		std::this_thread::yield();
+
+	// The writer drains the ring once more after it sees the flag.
+	running.store(false, std::memory_order_release);
+	wakeCondition.notify_one();
+	writer.join();
+
+	fclose(file);
+	file = NULL;
+
+	delete[] slots;
+	slots = NULL;
+	delete[] batch;
+	batch = NULL;
+}
+
+/*
+	Number of times a producer found the ring full and
+	had to wait for the writer thread.
+*/
+unsigned int Logger::GetStallCount(void)
+{
+	return stallCount.load(std::memory_order_relaxed);
+}
\ No newline at end of file
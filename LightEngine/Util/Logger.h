@@ -0,0 +1,104 @@
+#pragma once
+
+// Includes.
+#include <Windows.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+/*
+	Severity of a log message. The values are explicit
+	so that they can be used from the project settings
+	(e.g. /DLOG_MIN_LEVEL=2 to compile out debug messages).
+*/
+enum LogLevel
+{
+	LOG_LEVEL_TRACE		= 0,
+	LOG_LEVEL_DEBUG		= 1,
+	LOG_LEVEL_INFO		= 2,
+	LOG_LEVEL_WARNING	= 3,
+	LOG_LEVEL_ERROR		= 4
+};
+
+/*
+	Subsystem a log message belongs to. Categories are
+	bit flags so that a mask of enabled categories can
+	be chosen at compile time.
+*/
+enum LogCategory
+{
+	LOG_CATEGORY_CORE	= 1 << 0,
+	LOG_CATEGORY_RENDER	= 1 << 1,
+	LOG_CATEGORY_SHADER	= 1 << 2,
+	LOG_CATEGORY_ASSET	= 1 << 3,
+	LOG_CATEGORY_ALL	= 0xFFFF
+};
+
+// Compile-time filtering. Messages below LOG_MIN_LEVEL or outside
+// LOG_CATEGORY_MASK are removed by the compiler as dead code.
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL		LOG_LEVEL_DEBUG
+#endif
+
+#ifndef LOG_CATEGORY_MASK
+#define LOG_CATEGORY_MASK	LOG_CATEGORY_ALL
+#endif
+
+#define LOG_ENABLED(level, category)	((level) >= LOG_MIN_LEVEL && ((category) & LOG_CATEGORY_MASK) != 0)
+
+#define LOG_MESSAGE(level, category, message) \
+	do { if (LOG_ENABLED(level, category)) Logger::Write((level), (category), (message)); } while (0)
+
+#define LOG_FORMAT(level, category, format, ...) \
+	do { if (LOG_ENABLED(level, category)) Logger::WriteFormat((level), (category), (format), __VA_ARGS__); } while (0)
+
+#define LOG_TRACE(category, message)	LOG_MESSAGE(LOG_LEVEL_TRACE, category, message)
+#define LOG_DEBUG(category, message)	LOG_MESSAGE(LOG_LEVEL_DEBUG, category, message)
+#define LOG_INFO(category, message)		LOG_MESSAGE(LOG_LEVEL_INFO, category, message)
+#define LOG_WARNING(category, message)	LOG_MESSAGE(LOG_LEVEL_WARNING, category, message)
+#define LOG_ERROR(category, message)	LOG_MESSAGE(LOG_LEVEL_ERROR, category, message)
+
+/*
+	Asynchronous logger. Producers on any thread copy their
+	message into a fixed-size lock-free ring buffer (bounded
+	multi-producer/single-consumer queue), and a background
+	writer thread drains the ring and writes the messages to
+	the log file in batches, so logging never touches the file
+	system on the calling thread.
+*/
+class Logger
+{
+public:
+
+// Functions
+
+	static bool Init(const char* path);
+	static void Write(LogLevel level, LogCategory category, const char* message);
+	static void WriteFormat(LogLevel level, LogCategory category, const char* format, ...);
+	static void Flush(void);
+	static void Shutdown(void);
+
+	static unsigned int GetStallCount(void);
+
+private:
+
+// Functions
+
+	static bool TryEnqueue(LogLevel level, LogCategory category, const char* message);
+	static void WriterLoop(void);
+	static unsigned int Drain(void);
+
+// Variables
+
+	static std::atomic<bool>		initialized;
+	static FILE*					file;
+	static std::thread				writer;
+	static std::mutex				wakeMutex;
+	static std::condition_variable	wakeCondition;
+	static std::atomic<bool>		running;
+	static std::atomic<unsigned int>	producers;		// Threads inside Write(), Shutdown() waits for them.
+	static std::atomic<unsigned int>	writtenPos;
+	static std::atomic<unsigned int>	stallCount;
+};
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "Lz4.h"
+#include <cstring>
+
+namespace
+{
+	// Shortest match the format can encode.
+	const size_t LZ4_MIN_MATCH = 4;
+
+	// Bytes at the end of a block that are always literals.
+	const size_t LZ4_LAST_LITERALS = 5;
+
+	// No match starts in the last bytes of a block.
+	const size_t LZ4_MATCH_FIND_LIMIT = 12;
+
+	// Farthest a match can reach back.
+	const size_t LZ4_MAX_OFFSET = 65535;
+
+	// Bits of the hash table index.
+	const unsigned int LZ4_HASH_BITS = 12;
+
+	/*
+		Four bytes, in any byte order as long as it is the
+		same for every call.
+	*/
+	unsigned int Read32(const unsigned char* bytes)
+	{
+		unsigned int value;
+		memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	/*
+		Hash table slot of four bytes.
+	*/
+	unsigned int Hash(unsigned int sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+	}
+
+	/*
+		Appends the 255-byte extension of a length that
+		didn't fit its 4 bits.
+	*/
+	void WriteLength(unsigned char*& output, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+			*output++ = 255;
+		*output++ = (unsigned char)length;
+	}
+
+	/*
+		Reads the extension of a length whose 4 bits were
+		all set. Returns false past the end of the block.
+	*/
+	bool ReadLength(const unsigned char*& input, const unsigned char* inputEnd, size_t& length)
+	{
+		unsigned char byte;
+		do
+		{
+			if (input >= inputEnd)
+				return false;
+			byte = *input++;
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+}
+
+/*
+	Largest block Compress() can produce for a size,
+	reached when nothing compresses.
+*/
+size_t Lz4::GetMaxCompressedSize(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+/*
+	Compresses bytes into one block. Returns the size of
+	the block, 0 if it doesn't fit the capacity.
+
+	source		-	Bytes to compress.
+	size		-	Number of bytes.
+	target		-	Receives the block.
+	capacity	-	Size of target, GetMaxCompressedSize() always fits.
+*/
+size_t Lz4::Compress(const unsigned char* source, size_t size, unsigned char* target, size_t capacity)
+{
+	unsigned char* output = target;
+	const unsigned char* outputEnd = target + capacity;
+	size_t anchor = 0;
+
+	if (size > LZ4_MATCH_FIND_LIMIT)
+	{
+		// Positions are stored + 1, so 0 is an empty slot.
+		unsigned int table[1 << LZ4_HASH_BITS];
+		memset(table, 0, sizeof(table));
+
+		size_t findLimit = size - LZ4_MATCH_FIND_LIMIT;
+		size_t matchLimit = size - LZ4_LAST_LITERALS;
+		size_t position = 0;
+		while (position < findLimit)
+		{
+			unsigned int sequence = Read32(source + position);
+			unsigned int& slot = table[Hash(sequence)];
+			size_t candidate = slot;
+			slot = (unsigned int)(position + 1);
+
+			if (candidate == 0 || position - (candidate - 1) > LZ4_MAX_OFFSET || Read32(source + candidate - 1) != sequence)
+			{
+				++position;
+				continue;
+			}
+
+			// Grow the match backwards into the pending literals, then forwards.
+			size_t match = candidate - 1;
+			while (position > anchor && match > 0 && source[position - 1] == source[match - 1])
+			{
+				--position;
+				--match;
+			}
+
+			size_t length = LZ4_MIN_MATCH;
+			while (position + length < matchLimit && source[position + length] == source[match + length])
+				++length;
+
+			if (!writeSequence(output, outputEnd, source + anchor, position - anchor, position - match, length))
+				return 0;
+
+			position += length;
+			anchor = position;
+		}
+	}
+
+	// The rest of the block is a run of literals without a match.
+	size_t literalCount = size - anchor;
+	if ((size_t)(outputEnd - output) < 1 + literalCount / 255 + 1 + literalCount)
+		return 0;
+
+	unsigned char* token = output++;
+	*token = (unsigned char)((literalCount < 15 ? literalCount : 15) << 4);
+	if (literalCount >= 15)
+		WriteLength(output, literalCount - 15);
+	memcpy(output, source + anchor, literalCount);
+	output += literalCount;
+
+	return (size_t)(output - target);
+}
+
+/*
+	Decompresses one block. Returns false if the block is
+	corrupt or doesn't decompress to exactly targetSize
+	bytes.
+
+	source		-	The block.
+	size		-	Size of the block.
+	target		-	Receives the bytes.
+	targetSize	-	Number of bytes the block holds.
+*/
+bool Lz4::Decompress(const unsigned char* source, size_t size, unsigned char* target, size_t targetSize)
+{
+	const unsigned char* input = source;
+	const unsigned char* inputEnd = source + size;
+	unsigned char* output = target;
+	unsigned char* outputEnd = target + targetSize;
+
+	while (input < inputEnd)
+	{
+		unsigned char token = *input++;
+
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !ReadLength(input, inputEnd, literalCount))
+			return false;
+		if (literalCount > (size_t)(inputEnd - input) || literalCount > (size_t)(outputEnd - output))
+			return false;
+
+		memcpy(output, input, literalCount);
+		input += literalCount;
+		output += literalCount;
+
+		// The last sequence has no match.
+		if (input == inputEnd)
+			break;
+
+		if (inputEnd - input < 2)
+			return false;
+		size_t offset = input[0] | (input[1] << 8);
+		input += 2;
+		if (offset == 0 || offset > (size_t)(output - target))
+			return false;
+
+		size_t length = token & 15;
+		if (length == 15 && !ReadLength(input, inputEnd, length))
+			return false;
+		length += LZ4_MIN_MATCH;
+		if (length > (size_t)(outputEnd - output))
+			return false;
+
+		// Matches may overlap what they write, e.g. a run of one byte has offset 1.
+		const unsigned char* match = output - offset;
+		if (offset >= length)
+		{
+			memcpy(output, match, length);
+			output += length;
+		}
+		else
+		{
+			for (size_t i = 0; i < length; ++i)
+				*output++ = *match++;
+		}
+	}
+
+	return output == outputEnd;
+}
+
+/*
+	Appends a sequence : a token, the literals before a
+	match and the match. Returns false if it doesn't fit.
+*/
+bool Lz4::writeSequence(unsigned char*& output, const unsigned char* outputEnd, const unsigned char* literals, size_t literalCount,
+	size_t offset, size_t matchLength)
+{
+	size_t extra = matchLength - LZ4_MIN_MATCH;
+	if ((size_t)(outputEnd - output) < 1 + literalCount / 255 + 1 + literalCount + 2 + extra / 255 + 1)
+		return false;
+
+	unsigned char* token = output++;
+	*token = (unsigned char)(((literalCount < 15 ? literalCount : 15) << 4) | (extra < 15 ? extra : 15));
+	if (literalCount >= 15)
+		WriteLength(output, literalCount - 15);
+	memcpy(output, literals, literalCount);
+	output += literalCount;
+
+	*output++ = (unsigned char)(offset & 0xFF);
+	*output++ = (unsigned char)(offset >> 8);
+
+	if (extra >= 15)
+		WriteLength(output, extra - 15);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+// Includes.
+#include <cstddef>
+
+/*
+	Compressor and decompressor of the LZ4 block format :
+	runs of literals followed by matches of at least 4
+	bytes up to 64 KB back, with the last 5 bytes always
+	literal. Blocks are interchangeable with the reference
+	LZ4 library's, the compressor is its plain greedy one
+	(a hash table of the last position of every 4 bytes).
+
+	Decompression checks every length and offset against
+	the buffers, so a corrupt block fails instead of
+	reading or writing out of bounds.
+*/
+class Lz4
+{
+public:
+
+// Functions
+
+	static size_t GetMaxCompressedSize(size_t size);
+	static size_t Compress(const unsigned char* source, size_t size, unsigned char* target, size_t capacity);
+	static bool Decompress(const unsigned char* source, size_t size, unsigned char* target, size_t targetSize);
+
+private:
+
+// Functions
+
+	static bool writeSequence(unsigned char*& output, const unsigned char* outputEnd, const unsigned char* literals, size_t literalCount,
+		size_t offset, size_t matchLength);
+};
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "MappedFile.h"
+
+/*
+	Default constructor, nothing is mapped.
+*/
+MappedFile::MappedFile()
+{
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+	data = NULL;
+	size = 0;
+}
+
+/*
+	Maps the whole file for reading, closing whatever was
+	mapped before. Returns false if the file doesn't exist
+	or is empty.
+
+	path	-	Path to the file.
+*/
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+/*
+	Unmaps the file. Pointers into the data are invalid
+	afterwards.
+*/
+void MappedFile::Close(void)
+{
+	if (data != NULL)
+		UnmapViewOfFile(data);
+	if (mapping != NULL)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+	data = NULL;
+	size = 0;
+}
+
+/*
+	Whether a file is currently mapped.
+*/
+bool MappedFile::IsOpen(void) const
+{
+	return data != NULL;
+}
+
+/*
+	First byte of the mapped file, NULL if nothing is mapped.
+*/
+const unsigned char* MappedFile::GetData(void) const
+{
+	return data;
+}
+
+/*
+	Size of the mapped file in bytes.
+*/
+size_t MappedFile::GetSize(void) const
+{
+	return size;
+}
+
+/*
+	Destructor, unmaps the file.
+*/
+MappedFile::~MappedFile()
+{
+	Close();
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+// Includes.
+#include <Windows.h>
+#include "Utility.h"
+
+/*
+	Read-only memory mapping of a whole file. The
+	contents are paged in by the OS on first access, so
+	data can be handed straight to e.g. glBufferData()
+	without being read into a buffer first.
+*/
+class MappedFile
+{
+public:
+
+// Functions
+
+	MappedFile();
+	bool Open(const char* path);
+	void Close(void);
+	bool IsOpen(void) const;
+	const unsigned char* GetData(void) const;
+	size_t GetSize(void) const;
+	~MappedFile();
+
+private:
+
+// Functions
+
+	// Owns the OS handles, so it can't be copied.
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+// Variables
+
+	HANDLE					file;
+	HANDLE					mapping;
+	const unsigned char*	data;
+	size_t					size;
+};
\ No newline at end of file
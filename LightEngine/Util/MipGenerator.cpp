@@ -0,0 +1,391 @@
+#include "MipGenerator.h"
+#include <emmintrin.h>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+	// Rows in a band handed to one thread.
+	const unsigned int MIP_ROWS_PER_BAND = 16;
+
+	// Levels with fewer texels are filtered on the calling thread.
+	const unsigned int MIP_PARALLEL_TEXELS = 128 * 128;
+
+	// Steps of the linear to sRGB table.
+	const unsigned int MIP_SRGB_STEPS = 4096;
+
+	// Shape of the Kaiser window, larger is smoother.
+	const float KAISER_ALPHA = 4.0f;
+
+	const float PI = 3.14159265358979f;
+
+	/*
+		Lookup tables between 8-bit texels and the floats
+		they are filtered as. Built before main(), so every
+		thread can read them.
+	*/
+	struct MipTables
+	{
+		float			decode[3][256];						// Texel to float, per MipContent.
+		unsigned char	encodeSrgb[MIP_SRGB_STEPS + 1];		// Linear float to sRGB texel.
+
+		MipTables()
+		{
+			for (unsigned int i = 0; i < 256; ++i)
+			{
+				float value = i / 255.0f;
+				decode[MIP_CONTENT_LINEAR][i] = value;
+				decode[MIP_CONTENT_SRGB][i] = (value <= 0.04045f) ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+				decode[MIP_CONTENT_NORMAL][i] = value * 2.0f - 1.0f;
+			}
+
+			for (unsigned int i = 0; i <= MIP_SRGB_STEPS; ++i)
+			{
+				float value = (float)i / MIP_SRGB_STEPS;
+				float srgb = (value <= 0.0031308f) ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+				encodeSrgb[i] = (unsigned char)(std::min(std::max(srgb, 0.0f), 1.0f) * 255.0f + 0.5f);
+			}
+		}
+	};
+
+	const MipTables tables;
+
+	/*
+		sin(pi x) / (pi x).
+	*/
+	float Sinc(float x)
+	{
+		if (fabsf(x) < 1e-5f)
+			return 1.0f;
+
+		return sinf(PI * x) / (PI * x);
+	}
+
+	/*
+		Modified Bessel function of the first kind, order 0,
+		from its power series.
+	*/
+	float BesselI0(float x)
+	{
+		float sum = 1.0f, term = 1.0f, quarter = x * x * 0.25f;
+		for (unsigned int k = 1; k < 32 && term > sum * 1e-7f; ++k)
+		{
+			term *= quarter / (float)(k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	/*
+		Calls band() for every band of rows of a level, on
+		the pool if there is one and the level is large
+		enough to be worth it.
+	*/
+	void ForEachBand(ThreadPool* pool, unsigned int rows, unsigned int width, const std::function<void(unsigned int, unsigned int)>& band)
+	{
+		if (pool == NULL || (size_t)rows * width < MIP_PARALLEL_TEXELS)
+		{
+			band(0, rows);
+			return;
+		}
+
+		unsigned int bands = (rows + MIP_ROWS_PER_BAND - 1) / MIP_ROWS_PER_BAND;
+		pool->ParallelFor(bands, [&](unsigned int i)
+		{
+			band(i * MIP_ROWS_PER_BAND, std::min((i + 1) * MIP_ROWS_PER_BAND, rows));
+		});
+	}
+}
+
+/*
+	How the images of a texture format are filtered : sRGB
+	formats as colors, two-channel ones as normal maps.
+
+	internalFormat	-	Format the texture is asked for in.
+*/
+MipContent MipGenerator::GetContent(GLint internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_SRGB:
+	case GL_SRGB8:
+	case GL_SRGB_ALPHA:
+	case GL_SRGB8_ALPHA8:
+		return MIP_CONTENT_SRGB;
+	case GL_RG:
+	case GL_RG8:
+		return MIP_CONTENT_NORMAL;
+	default:
+		return MIP_CONTENT_LINEAR;
+	}
+}
+
+/*
+	Name of a filter, for logs and benchmarks.
+*/
+const char* MipGenerator::GetFilterName(MipFilter filter)
+{
+	switch (filter)
+	{
+	case MIP_FILTER_BOX:
+		return "box";
+	case MIP_FILTER_KAISER:
+		return "kaiser";
+	case MIP_FILTER_LANCZOS:
+		return "lanczos";
+	default:
+		return "unknown";
+	}
+}
+
+/*
+	Number of levels of a full mip chain, the image
+	included.
+*/
+unsigned int MipGenerator::GetLevelCount(unsigned int width, unsigned int height)
+{
+	unsigned int count = 1;
+	for (unsigned int size = std::max(width, height); size > 1; size /= 2)
+		++count;
+	return count;
+}
+
+/*
+	Builds the mip levels of an image, from half its size
+	down to 1x1. The image itself isn't copied into levels.
+
+	pixels		-	Texels of the image, rows tightly packed.
+	width		-	Width of the image.
+	height		-	Height of the image.
+	channels	-	3 (RGB) or 4 (RGBA) bytes per texel, for
+					the levels too.
+	content		-	How the texels are filtered.
+	filter		-	Filter the levels are resampled with.
+	levels		-	Receives the levels.
+	pool		-	Threads to filter on, may be NULL. Not the
+					pool of the calling task.
+*/
+void MipGenerator::Generate(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int channels, MipContent content, MipFilter filter,
+	std::vector<MipLevel>& levels, ThreadPool* pool)
+{
+	levels.clear();
+	if (width == 0 || height == 0)
+		return;
+
+	unsigned int levelCount = GetLevelCount(width, height);
+	levels.reserve(levelCount - 1);
+
+	// Four floats per texel, whatever the channel count.
+	std::vector<float> source((size_t)width * height * 4), rows, target;
+	ForEachBand(pool, height, width, [&](unsigned int first, unsigned int last)
+	{
+		for (unsigned int y = first; y < last; ++y)
+			readLevel(pixels + (size_t)y * width * channels, width, channels, content, &source[(size_t)y * width * 4]);
+	});
+
+	std::vector<unsigned int> columnIndices, rowIndices;
+	std::vector<float> columnWeights, rowWeights;
+	unsigned int sourceWidth = width, sourceHeight = height;
+	for (unsigned int level = 1; level < levelCount; ++level)
+	{
+		unsigned int targetWidth = std::max(sourceWidth / 2, 1u);
+		unsigned int targetHeight = std::max(sourceHeight / 2, 1u);
+		unsigned int columnTaps = buildTaps(filter, sourceWidth, targetWidth, columnIndices, columnWeights);
+		unsigned int rowTaps = buildTaps(filter, sourceHeight, targetHeight, rowIndices, rowWeights);
+
+		// Rows first : every source row is narrowed to the target width.
+		rows.resize((size_t)targetWidth * sourceHeight * 4);
+		ForEachBand(pool, sourceHeight, targetWidth, [&](unsigned int first, unsigned int last)
+		{
+			for (unsigned int y = first; y < last; ++y)
+			{
+				const float* in = &source[(size_t)y * sourceWidth * 4];
+				float* out = &rows[(size_t)y * targetWidth * 4];
+				const unsigned int* indices = &columnIndices[0];
+				const float* weights = &columnWeights[0];
+				for (unsigned int x = 0; x < targetWidth; ++x, indices += columnTaps, weights += columnTaps)
+				{
+					__m128 sum = _mm_setzero_ps();
+					for (unsigned int k = 0; k < columnTaps; ++k)
+						sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(in + indices[k] * 4), _mm_set1_ps(weights[k])));
+					_mm_storeu_ps(out + x * 4, sum);
+				}
+			}
+		});
+
+		// Then columns : every target row is a weighted sum of whole rows.
+		levels.push_back(MipLevel());
+		MipLevel& mip = levels.back();
+		mip.width = targetWidth;
+		mip.height = targetHeight;
+		mip.pixels.resize((size_t)targetWidth * targetHeight * channels);
+
+		target.resize((size_t)targetWidth * targetHeight * 4);
+		ForEachBand(pool, targetHeight, targetWidth, [&](unsigned int first, unsigned int last)
+		{
+			for (unsigned int y = first; y < last; ++y)
+			{
+				float* out = &target[(size_t)y * targetWidth * 4];
+				std::fill(out, out + targetWidth * 4, 0.0f);
+				for (unsigned int k = 0; k < rowTaps; ++k)
+				{
+					const float* in = &rows[(size_t)rowIndices[y * rowTaps + k] * targetWidth * 4];
+					__m128 weight = _mm_set1_ps(rowWeights[y * rowTaps + k]);
+					for (unsigned int x = 0; x < targetWidth * 4; x += 4)
+						_mm_storeu_ps(out + x, _mm_add_ps(_mm_loadu_ps(out + x), _mm_mul_ps(_mm_loadu_ps(in + x), weight)));
+				}
+				writeLevel(out, targetWidth, channels, content, &mip.pixels[(size_t)y * targetWidth * channels]);
+			}
+		});
+
+		source.swap(target);
+		sourceWidth = targetWidth;
+		sourceHeight = targetHeight;
+	}
+}
+
+/*
+	Value of a filter at a distance, in target texels.
+*/
+float MipGenerator::evaluate(MipFilter filter, float x)
+{
+	float distance = fabsf(x);
+	float radius = getRadius(filter);
+	if (distance > radius)
+		return 0.0f;
+
+	switch (filter)
+	{
+	case MIP_FILTER_BOX:
+		// Texels on the edge are shared by both neighbours.
+		return (distance < radius) ? 1.0f : 0.5f;
+	case MIP_FILTER_KAISER:
+	{
+		float t = distance / radius;
+		return Sinc(x) * BesselI0(KAISER_ALPHA * sqrtf(1.0f - t * t)) / BesselI0(KAISER_ALPHA);
+	}
+	case MIP_FILTER_LANCZOS:
+		return Sinc(x) * Sinc(x / radius);
+	default:
+		return 0.0f;
+	}
+}
+
+/*
+	Distance past which a filter is 0, in target texels.
+*/
+float MipGenerator::getRadius(MipFilter filter)
+{
+	return (filter == MIP_FILTER_BOX) ? 0.5f : 3.0f;
+}
+
+/*
+	Source texels and normalized weights of every target
+	texel along one axis. Returns the number of taps per
+	target texel; texels that need fewer have 0 weights.
+	Indices wrap around the edges.
+
+	filter		-	Filter to resample with.
+	sourceSize	-	Texels along the axis in the larger level.
+	targetSize	-	Texels along the axis in the smaller level.
+	indices		-	Receives the source texel of every tap.
+	weights		-	Receives the weight of every tap.
+*/
+unsigned int MipGenerator::buildTaps(MipFilter filter, unsigned int sourceSize, unsigned int targetSize, std::vector<unsigned int>& indices, std::vector<float>& weights)
+{
+	float scale = (float)sourceSize / (float)targetSize;
+	float support = getRadius(filter) * scale;
+	unsigned int tapCount = (unsigned int)ceilf(support * 2.0f) + 1;
+
+	indices.resize((size_t)targetSize * tapCount);
+	weights.resize((size_t)targetSize * tapCount);
+
+	for (unsigned int t = 0; t < targetSize; ++t)
+	{
+		float center = (t + 0.5f) * scale;
+		int first = (int)floorf(center - support + 0.5f);
+
+		float sum = 0.0f;
+		for (unsigned int k = 0; k < tapCount; ++k)
+		{
+			int index = first + (int)k;
+			float weight = evaluate(filter, (index + 0.5f - center) / scale);
+			indices[t * tapCount + k] = (unsigned int)(((index % (int)sourceSize) + (int)sourceSize) % (int)sourceSize);
+			weights[t * tapCount + k] = weight;
+			sum += weight;
+		}
+
+		for (unsigned int k = 0; k < tapCount; ++k)
+			weights[t * tapCount + k] /= sum;
+	}
+
+	return tapCount;
+}
+
+/*
+	Converts a row of texels to the floats they are
+	filtered as.
+
+	pixels		-	Texels of the row.
+	width		-	Texels in the row.
+	channels	-	Bytes per texel, 3 or 4.
+	content		-	How the texels are filtered.
+	texels		-	Receives four floats per texel.
+*/
+void MipGenerator::readLevel(const unsigned char* pixels, unsigned int width, unsigned int channels, MipContent content, float* texels)
+{
+	const float* decode = tables.decode[content];
+	for (unsigned int x = 0; x < width; ++x, pixels += channels, texels += 4)
+	{
+		texels[0] = decode[pixels[0]];
+		texels[1] = decode[pixels[1]];
+		texels[2] = decode[pixels[2]];
+		texels[3] = (channels == 4) ? tables.decode[MIP_CONTENT_LINEAR][pixels[3]] : 1.0f;
+	}
+}
+
+/*
+	Converts a row of filtered floats back to texels,
+	renormalizing normals and clamping the overshoot of
+	the sharper filters.
+
+	texels		-	Four floats per texel.
+	width		-	Texels in the row.
+	channels	-	Bytes per texel, 3 or 4.
+	content		-	How the texels were filtered.
+	pixels		-	Receives the texels of the row.
+*/
+void MipGenerator::writeLevel(const float* texels, unsigned int width, unsigned int channels, MipContent content, unsigned char* pixels)
+{
+	// sRGB colors index the encode table, everything else is scaled to a byte.
+	const __m128 scale = (content == MIP_CONTENT_SRGB) ? _mm_setr_ps((float)MIP_SRGB_STEPS, (float)MIP_SRGB_STEPS, (float)MIP_SRGB_STEPS, 255.0f) : _mm_set1_ps(255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (unsigned int x = 0; x < width; ++x, texels += 4, pixels += channels)
+	{
+		__m128 value = _mm_loadu_ps(texels);
+		if (content == MIP_CONTENT_NORMAL)
+		{
+			float n[4];
+			_mm_storeu_ps(n, value);
+			float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (length > 1e-6f)
+				value = _mm_setr_ps(n[0] / length, n[1] / length, n[2] / length, n[3]);
+			else
+				value = _mm_setr_ps(0.0f, 0.0f, 1.0f, n[3]);
+
+			// Back to [0, 1], alpha is left as it is.
+			value = _mm_add_ps(_mm_mul_ps(value, _mm_setr_ps(0.5f, 0.5f, 0.5f, 1.0f)), _mm_setr_ps(0.5f, 0.5f, 0.5f, 0.0f));
+		}
+
+		value = _mm_min_ps(_mm_max_ps(value, zero), one);
+
+		int quantized[4];
+		_mm_storeu_si128((__m128i*)quantized, _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half)));
+		for (unsigned int c = 0; c < channels; ++c)
+			pixels[c] = (content == MIP_CONTENT_SRGB && c < 3) ? tables.encodeSrgb[quantized[c]] : (unsigned char)quantized[c];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+// Includes.
+#include <vector>
+#include "..\Contrib\Include\gl\glew.h"
+#include "ThreadPool.h"
+
+/*
+	Filters a mip level can be resampled with, from the
+	cheapest to the sharpest.
+
+	MIP_FILTER_BOX		-	Average of the texels under the new texel.
+	MIP_FILTER_KAISER	-	Sinc with a Kaiser window, 3 texels wide.
+	MIP_FILTER_LANCZOS	-	Lanczos, 3 lobes.
+*/
+enum MipFilter
+{
+	MIP_FILTER_BOX,
+	MIP_FILTER_KAISER,
+	MIP_FILTER_LANCZOS,
+	MIP_FILTER_COUNT
+};
+
+/*
+	How the texels of an image are filtered.
+
+	MIP_CONTENT_LINEAR	-	Plain values, e.g. specular maps.
+	MIP_CONTENT_SRGB	-	sRGB colors, filtered in linear space.
+	MIP_CONTENT_NORMAL	-	Tangent space normals, renormalized.
+*/
+enum MipContent
+{
+	MIP_CONTENT_LINEAR,
+	MIP_CONTENT_SRGB,
+	MIP_CONTENT_NORMAL
+};
+
+/*
+	One generated mip level.
+
+	width, height	-	Size of the level.
+	pixels			-	Texels, with as many channels as the image.
+*/
+struct MipLevel
+{
+	unsigned int				width;
+	unsigned int				height;
+	std::vector<unsigned char>	pixels;
+};
+
+/*
+	Builds the mip chain of an image on the CPU instead of
+	leaving it to glGenerateMipmap().
+
+	Every level is resampled from the one above it with a
+	separable filter, rows first and columns second, in
+	floating point : the texels of a level stay in linear
+	space until they are written out, so sRGB colors are
+	averaged as light and normals keep their direction
+	(they are renormalized when written). The image wraps
+	around its edges like the repeating textures do.
+
+	The filter loops work on whole RGBA texels with SSE.
+	Bands of rows of the larger levels are spread over a
+	ThreadPool.
+*/
+class MipGenerator
+{
+public:
+
+// Functions
+
+	static MipContent GetContent(GLint internalFormat);
+	static const char* GetFilterName(MipFilter filter);
+	static unsigned int GetLevelCount(unsigned int width, unsigned int height);
+	static void Generate(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int channels, MipContent content, MipFilter filter,
+		std::vector<MipLevel>& levels, ThreadPool* pool = NULL);
+
+private:
+
+// Functions
+
+	static float evaluate(MipFilter filter, float x);
+	static float getRadius(MipFilter filter);
+	static unsigned int buildTaps(MipFilter filter, unsigned int sourceSize, unsigned int targetSize, std::vector<unsigned int>& indices, std::vector<float>& weights);
+	static void readLevel(const unsigned char* pixels, unsigned int width, unsigned int channels, MipContent content, float* texels);
+	static void writeLevel(const float* texels, unsigned int width, unsigned int channels, MipContent content, unsigned char* pixels);
+};
\ No newline at end of file
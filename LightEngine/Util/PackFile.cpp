@@ -0,0 +1,445 @@
+#include "PackFile.h"
+#include "FileSystem.h"
+#include "Lz4.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	/*
+		A file on its way into a pack.
+	*/
+	struct PackSource
+	{
+		std::string					name;
+		unsigned long long			hash;
+		unsigned long long			writeTime;
+		unsigned int				size;
+		PackCodec					codec;
+		std::vector<unsigned char>	stored;
+		bool						loaded;
+	};
+
+	/*
+		Reads a whole file into memory.
+	*/
+	bool ReadWholeFile(const char* path, std::vector<unsigned char>& data)
+	{
+		FILE* file = NULL;
+		if (fopen_s(&file, path, "rb") != 0 || file == NULL)
+			return false;
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		bool read = size >= 0;
+		data.resize(read ? (size_t)size : 0);
+		if (read && size > 0)
+			read = fread(&data[0], 1, data.size(), file) == data.size();
+		fclose(file);
+		return read;
+	}
+
+	/*
+		Writes zeros up to the next multiple of alignment.
+	*/
+	void Pad(FILE* file, unsigned long long& offset, unsigned int alignment)
+	{
+		static const unsigned char zeros[PACK_ALIGNMENT] = { 0 };
+		unsigned int padding = (unsigned int)((alignment - offset % alignment) % alignment);
+		fwrite(zeros, 1, padding, file);
+		offset += padding;
+	}
+}
+
+/*
+	Default constructor, no pack is open.
+*/
+PackFile::PackFile()
+{
+	header = NULL;
+	entries = NULL;
+	names = NULL;
+}
+
+/*
+	Maps a pack and checks its header and entry table,
+	closing whatever was open before.
+
+	path	-	Path to the pack file.
+*/
+bool PackFile::Open(const char* path)
+{
+	Close();
+
+	if (!file.Open(path))
+		return false;
+
+	if (file.GetSize() < sizeof(PackHeader))
+	{
+		Close();
+		return false;
+	}
+
+	header = (const PackHeader*)file.GetData();
+	if (!validate())
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Pack file %s is corrupt or of another version.", path);
+		Close();
+		return false;
+	}
+
+	entries = (const PackEntry*)(file.GetData() + header->indexOffset);
+	names = (const char*)(file.GetData() + header->namesOffset);
+	return true;
+}
+
+/*
+	Unmaps the pack. Pointers into it are invalid
+	afterwards.
+*/
+void PackFile::Close(void)
+{
+	file.Close();
+	header = NULL;
+	entries = NULL;
+	names = NULL;
+}
+
+/*
+	Whether a pack is open.
+*/
+bool PackFile::IsOpen(void) const
+{
+	return header != NULL;
+}
+
+/*
+	Entry of a file, NULL if the pack doesn't hold it.
+
+	name	-	Normalized path of the file.
+*/
+const PackEntry* PackFile::Find(const char* name) const
+{
+	if (header == NULL)
+		return NULL;
+
+	unsigned long long hash = HashName(name);
+	const PackEntry* end = entries + header->entryCount;
+	const PackEntry* entry = std::lower_bound(entries, end, hash, [](const PackEntry& e, unsigned long long h) { return e.hash < h; });
+
+	// Names of entries whose hashes collide are told apart by comparing them.
+	for (; entry != end && entry->hash == hash; ++entry)
+	{
+		if (strcmp(names + entry->nameOffset, name) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+	Number of files in the pack.
+*/
+unsigned int PackFile::GetEntryCount(void) const
+{
+	return (header != NULL) ? header->entryCount : 0;
+}
+
+/*
+	Entry of a file, in hash order.
+*/
+const PackEntry& PackFile::GetEntry(unsigned int index) const
+{
+	return entries[index];
+}
+
+/*
+	Normalized path of an entry's file.
+*/
+const char* PackFile::GetName(const PackEntry& entry) const
+{
+	return names + entry.nameOffset;
+}
+
+/*
+	Bytes of an entry as stored in the pack. They are the
+	file itself if the entry isn't compressed.
+*/
+const unsigned char* PackFile::GetStoredData(const PackEntry& entry) const
+{
+	return file.GetData() + entry.offset;
+}
+
+/*
+	Copies or decompresses the file of an entry. Returns
+	false if the stored bytes are corrupt.
+
+	entry	-	Entry of the file.
+	target	-	Receives the entry's size bytes.
+	pool	-	Threads to decompress the chunks on, may be
+				NULL. Not the pool of the calling task.
+*/
+bool PackFile::Extract(const PackEntry& entry, unsigned char* target, ThreadPool* pool) const
+{
+	const unsigned char* stored = GetStoredData(entry);
+	if (entry.codec == PACK_CODEC_NONE)
+	{
+		memcpy(target, stored, entry.size);
+		return true;
+	}
+
+	unsigned int chunkCount = (entry.size + PACK_CHUNK_SIZE - 1) / PACK_CHUNK_SIZE;
+	size_t tableSize = chunkCount * sizeof(unsigned int);
+	if (entry.storedSize < tableSize)
+		return false;
+
+	// Where every chunk starts, after the table of their stored sizes.
+	std::vector<size_t> offsets(chunkCount + 1);
+	offsets[0] = tableSize;
+	for (unsigned int i = 0; i < chunkCount; ++i)
+	{
+		unsigned int chunkSize;
+		memcpy(&chunkSize, stored + i * sizeof(unsigned int), sizeof(chunkSize));
+		offsets[i + 1] = offsets[i] + (chunkSize & ~PACK_CHUNK_RAW);
+	}
+	if (offsets[chunkCount] != entry.storedSize)
+		return false;
+
+	std::vector<unsigned char> valid(chunkCount, 0);
+	std::function<void(unsigned int)> extractChunk = [&](unsigned int i)
+	{
+		unsigned int chunkSize;
+		memcpy(&chunkSize, stored + i * sizeof(unsigned int), sizeof(chunkSize));
+
+		size_t size = std::min((size_t)PACK_CHUNK_SIZE, (size_t)entry.size - (size_t)i * PACK_CHUNK_SIZE);
+		const unsigned char* source = stored + offsets[i];
+		size_t sourceSize = offsets[i + 1] - offsets[i];
+		if (chunkSize & PACK_CHUNK_RAW)
+		{
+			if (sourceSize == size)
+			{
+				memcpy(target + (size_t)i * PACK_CHUNK_SIZE, source, size);
+				valid[i] = 1;
+			}
+		}
+		else
+		{
+			valid[i] = Lz4::Decompress(source, sourceSize, target + (size_t)i * PACK_CHUNK_SIZE, size) ? 1 : 0;
+		}
+	};
+
+	if (pool != NULL && chunkCount > 1)
+		pool->ParallelFor(chunkCount, extractChunk);
+	else
+		for (unsigned int i = 0; i < chunkCount; ++i)
+			extractChunk(i);
+
+	return std::find(valid.begin(), valid.end(), 0) == valid.end();
+}
+
+/*
+	64-bit FNV-1a hash of a normalized path, the key of
+	the entry table.
+*/
+unsigned long long PackFile::HashName(const char* name)
+{
+	return hashBytes(name, strlen(name));
+}
+
+/*
+	Writes a pack of loose files, named by their
+	normalized paths.
+
+	path		-	Pack file to write.
+	files		-	Paths of the files to pack.
+	compress	-	Whether entries are compressed with LZ4.
+	pool		-	Threads to read and compress the files on,
+					may be NULL. Not the pool of the calling task.
+*/
+bool PackFile::Build(const char* path, const std::vector<std::string>& files, bool compress, ThreadPool* pool)
+{
+	double start = getTimeElapsed();
+
+	std::vector<PackSource> sources(files.size());
+	std::function<void(unsigned int)> load = [&](unsigned int i)
+	{
+		PackSource& source = sources[i];
+		source.name = FileSystem::NormalizePath(files[i].c_str());
+		source.hash = HashName(source.name.c_str());
+		source.writeTime = 0;
+		source.codec = PACK_CODEC_NONE;
+		source.loaded = ReadWholeFile(files[i].c_str(), source.stored) && getFileWriteTime(files[i].c_str(), source.writeTime);
+		source.size = (unsigned int)source.stored.size();
+
+		if (source.loaded && compress && source.size > 0)
+		{
+			std::vector<unsigned char> compressed;
+			compressChunks(source.stored, compressed);
+			if (compressed.size() <= source.size * (1.0f - PACK_MIN_SAVING))
+			{
+				source.stored.swap(compressed);
+				source.codec = PACK_CODEC_LZ4;
+			}
+		}
+	};
+
+	if (pool != NULL)
+		pool->ParallelFor((unsigned int)sources.size(), load);
+	else
+		for (unsigned int i = 0; i < sources.size(); ++i)
+			load(i);
+
+	for (size_t i = 0; i < sources.size(); ++i)
+	{
+		if (!sources[i].loaded)
+		{
+			LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_ASSET, "Could not pack %s", files[i].c_str());
+			return false;
+		}
+	}
+
+	std::vector<unsigned int> order(sources.size());
+	for (unsigned int i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+	{
+		return sources[a].hash != sources[b].hash ? sources[a].hash < sources[b].hash : sources[a].name < sources[b].name;
+	});
+
+	FILE* file = NULL;
+	if (fopen_s(&file, path, "wb") != 0 || file == NULL)
+	{
+		LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_ASSET, "Could not write pack file %s", path);
+		return false;
+	}
+
+	// The header is written again once the offsets are known.
+	PackHeader packHeader;
+	memset(&packHeader, 0, sizeof(packHeader));
+	fwrite(&packHeader, sizeof(packHeader), 1, file);
+	unsigned long long offset = sizeof(packHeader);
+
+	std::vector<PackEntry> table(sources.size());
+	std::string packNames;
+	unsigned long long size = 0, storedSize = 0;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const PackSource& source = sources[order[i]];
+		Pad(file, offset, PACK_ALIGNMENT);
+
+		PackEntry& entry = table[i];
+		entry.hash = source.hash;
+		entry.writeTime = source.writeTime;
+		entry.offset = offset;
+		entry.storedSize = (unsigned int)source.stored.size();
+		entry.size = source.size;
+		entry.codec = source.codec;
+		entry.nameOffset = (unsigned int)packNames.size();
+		packNames.append(source.name.c_str(), source.name.size() + 1);
+
+		if (!source.stored.empty())
+			fwrite(&source.stored[0], 1, source.stored.size(), file);
+		offset += source.stored.size();
+		size += source.size;
+		storedSize += source.stored.size();
+	}
+
+	Pad(file, offset, sizeof(unsigned long long));
+	packHeader.magic = PACK_MAGIC;
+	packHeader.version = PACK_VERSION;
+	packHeader.entryCount = (unsigned int)table.size();
+	packHeader.namesSize = (unsigned int)packNames.size();
+	packHeader.indexOffset = offset;
+	packHeader.namesOffset = offset + table.size() * sizeof(PackEntry);
+
+	if (!table.empty())
+		fwrite(&table[0], sizeof(PackEntry), table.size(), file);
+	fwrite(packNames.data(), 1, packNames.size(), file);
+
+	fseek(file, 0, SEEK_SET);
+	fwrite(&packHeader, sizeof(packHeader), 1, file);
+	bool written = ferror(file) == 0;
+	fclose(file);
+
+	if (!written)
+	{
+		LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_ASSET, "Could not write pack file %s", path);
+		return false;
+	}
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "Pack written in %.1f ms: %s (%u files, %.1f MB stored, %.1f MB unpacked)", (getTimeElapsed() - start) * 1000.0,
+		path, (unsigned int)table.size(), storedSize / (1024.0 * 1024.0), size / (1024.0 * 1024.0));
+	return true;
+}
+
+/*
+	Destructor, unmaps the pack.
+*/
+PackFile::~PackFile()
+{
+	Close();
+}
+
+/*
+	Whether the header, the entry table and the names lie
+	within the file and every entry within the data.
+*/
+bool PackFile::validate(void) const
+{
+	unsigned long long size = file.GetSize();
+	if (header->magic != PACK_MAGIC || header->version != PACK_VERSION)
+		return false;
+	if (header->indexOffset > size || header->entryCount > (size - header->indexOffset) / sizeof(PackEntry))
+		return false;
+	if (header->namesOffset > size || header->namesSize > size - header->namesOffset)
+		return false;
+	if (header->namesSize > 0 && file.GetData()[header->namesOffset + header->namesSize - 1] != '\0')
+		return false;
+
+	const PackEntry* table = (const PackEntry*)(file.GetData() + header->indexOffset);
+	for (unsigned int i = 0; i < header->entryCount; ++i)
+	{
+		const PackEntry& entry = table[i];
+		if (entry.offset > header->indexOffset || entry.storedSize > header->indexOffset - entry.offset || entry.nameOffset >= header->namesSize)
+			return false;
+		if (entry.codec != PACK_CODEC_NONE && entry.codec != PACK_CODEC_LZ4)
+			return false;
+		if (entry.codec == PACK_CODEC_NONE && entry.storedSize != entry.size)
+			return false;
+	}
+	return true;
+}
+
+/*
+	LZ4 chunks of a file, after the table of their stored
+	sizes. Chunks that don't shrink are stored raw.
+
+	data	-	Bytes of the file.
+	stored	-	Receives the table and the chunks.
+*/
+void PackFile::compressChunks(const std::vector<unsigned char>& data, std::vector<unsigned char>& stored)
+{
+	unsigned int chunkCount = (unsigned int)((data.size() + PACK_CHUNK_SIZE - 1) / PACK_CHUNK_SIZE);
+	stored.assign(chunkCount * sizeof(unsigned int), 0);
+
+	std::vector<unsigned char> block(Lz4::GetMaxCompressedSize(PACK_CHUNK_SIZE));
+	for (unsigned int i = 0; i < chunkCount; ++i)
+	{
+		const unsigned char* chunk = &data[(size_t)i * PACK_CHUNK_SIZE];
+		size_t size = std::min((size_t)PACK_CHUNK_SIZE, data.size() - (size_t)i * PACK_CHUNK_SIZE);
+
+		unsigned int chunkSize = (unsigned int)Lz4::Compress(chunk, size, &block[0], block.size());
+		if (chunkSize == 0 || chunkSize >= size)
+		{
+			stored.insert(stored.end(), chunk, chunk + size);
+			chunkSize = (unsigned int)size | PACK_CHUNK_RAW;
+		}
+		else
+		{
+			stored.insert(stored.end(), block.begin(), block.begin() + chunkSize);
+		}
+		memcpy(&stored[i * sizeof(unsigned int)], &chunkSize, sizeof(chunkSize));
+	}
+}
\ No newline at end of file
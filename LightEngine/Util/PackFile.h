@@ -0,0 +1,132 @@
+#pragma once
+
+// Includes.
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+// "LEPK" read as a little endian integer.
+const unsigned int PACK_MAGIC = 0x4B50454C;
+const unsigned int PACK_VERSION = 1;
+
+// Every entry starts at a multiple of this many bytes.
+const unsigned int PACK_ALIGNMENT = 64;
+
+// Compressed entries are split into chunks of this size, decompressed independently.
+const unsigned int PACK_CHUNK_SIZE = 256 * 1024;
+
+// Set in a chunk's stored size if the chunk is stored uncompressed.
+const unsigned int PACK_CHUNK_RAW = 0x80000000;
+
+// Entries stay uncompressed unless compression saves at least this share of them.
+const float PACK_MIN_SAVING = 0.1f;
+
+/*
+	How the bytes of an entry are stored.
+
+	PACK_CODEC_NONE	-	As they are.
+	PACK_CODEC_LZ4	-	A table of the stored size of every chunk,
+						then the chunks as LZ4 blocks.
+*/
+enum PackCodec
+{
+	PACK_CODEC_NONE,
+	PACK_CODEC_LZ4
+};
+
+/*
+	Header at the start of a pack file.
+
+	indexOffset	-	Offset of the entry table.
+	namesOffset	-	Offset of the names, NUL terminated.
+*/
+struct PackHeader
+{
+	unsigned int		magic;
+	unsigned int		version;
+	unsigned int		entryCount;
+	unsigned int		namesSize;
+	unsigned long long	indexOffset;
+	unsigned long long	namesOffset;
+};
+
+static_assert(sizeof(PackHeader) == 32, "PackHeader must match the file layout.");
+
+/*
+	One file in a pack. The entry table is sorted by hash.
+
+	hash		-	HashName() of the name.
+	writeTime	-	Last write time of the file it was packed from.
+	offset		-	Offset of the stored bytes, aligned to PACK_ALIGNMENT.
+	storedSize	-	Bytes stored in the pack.
+	size		-	Bytes of the file.
+	codec		-	PackCodec of the stored bytes.
+	nameOffset	-	Offset of the name in the names.
+*/
+struct PackEntry
+{
+	unsigned long long	hash;
+	unsigned long long	writeTime;
+	unsigned long long	offset;
+	unsigned int		storedSize;
+	unsigned int		size;
+	unsigned int		codec;
+	unsigned int		nameOffset;
+};
+
+static_assert(sizeof(PackEntry) == 40, "PackEntry must match the file layout.");
+
+/*
+	Archive of asset files, read through a memory mapping.
+
+	Files are found by a binary search of the hash of
+	their normalized path (see FileSystem::NormalizePath())
+	in the entry table, so a lookup touches a handful of
+	pages of the index. Uncompressed entries are used in
+	place, compressed ones are decompressed chunk by chunk,
+	the chunks in parallel if a ThreadPool is given.
+
+	Build() writes a pack from loose files; entries only
+	stay compressed if that saves PACK_MIN_SAVING of them,
+	so images that are compressed already are stored as
+	they are.
+*/
+class PackFile
+{
+public:
+
+// Functions
+
+	PackFile();
+	bool Open(const char* path);
+	void Close(void);
+	bool IsOpen(void) const;
+	const PackEntry* Find(const char* name) const;
+	unsigned int GetEntryCount(void) const;
+	const PackEntry& GetEntry(unsigned int index) const;
+	const char* GetName(const PackEntry& entry) const;
+	const unsigned char* GetStoredData(const PackEntry& entry) const;
+	bool Extract(const PackEntry& entry, unsigned char* target, ThreadPool* pool = NULL) const;
+	static unsigned long long HashName(const char* name);
+	static bool Build(const char* path, const std::vector<std::string>& files, bool compress, ThreadPool* pool = NULL);
+	~PackFile();
+
+private:
+
+// Functions
+
+	// Owns the mapping, so it can't be copied.
+	PackFile(const PackFile&);
+	PackFile& operator=(const PackFile&);
+
+	bool validate(void) const;
+	static void compressChunks(const std::vector<unsigned char>& data, std::vector<unsigned char>& stored);
+
+// Variables
+
+	MappedFile			file;
+	const PackHeader*	header;
+	const PackEntry*	entries;
+	const char*			names;
+};
\ No newline at end of file
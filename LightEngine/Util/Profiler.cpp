@@ -0,0 +1,484 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	/*
+		Timing data of a single zone.
+
+		frameTime	-	Time accumulated in the current frame.
+		hit			-	Whether the zone ran in the current frame.
+		history		-	Ring buffer of per-frame times in nanoseconds.
+	*/
+	struct ProfilerZone
+	{
+		const char*		name;
+		int				parent;
+		unsigned int	depth;
+		__int64			frameTime;
+		bool			hit;
+		__int64			history[PROFILER_HISTORY];
+		unsigned int	head;
+		unsigned int	count;
+	};
+
+	ProfilerZone	zones[PROFILER_MAX_ZONES];
+	unsigned int	zoneCount;
+
+	// Zones that are currently open, innermost last.
+	int				stack[PROFILER_MAX_DEPTH];
+	unsigned int	stackDepth;
+
+	/*
+		One complete ("X") event of a trace capture.
+		Times are in nanoseconds since InitUtility().
+	*/
+	struct TraceEvent
+	{
+		const char*		name;
+		std::string		detail;
+		unsigned long	thread;
+		__int64			start;
+		__int64			end;
+	};
+
+	// Events of the running capture, guarded by Profiler::traceMutex.
+	std::vector<TraceEvent>	traceEvents;
+
+	// Events reserved up front so that recording doesn't reallocate every few frames.
+	const size_t TRACE_RESERVE = 64 * 1024;
+
+	/*
+		Value below which the given fraction of the
+		(sorted) samples lie.
+	*/
+	double Percentile(const std::vector<__int64>& sorted, double fraction)
+	{
+		size_t index = (size_t)ceil(fraction * sorted.size());
+		if (index > 0)
+			--index;
+		if (index >= sorted.size())
+			index = sorted.size() - 1;
+		return sorted[index] / 1000000.0;
+	}
+}
+
+bool			Profiler::inFrame = false;
+int				Profiler::frameZone = -1;
+__int64			Profiler::frameStart = 0;
+double			Profiler::lastFrameTime = 0.0;
+unsigned long	Profiler::mainThread = 0;
+
+std::atomic<bool>	Profiler::tracing(false);
+std::mutex			Profiler::traceMutex;
+std::string			Profiler::tracePath;
+unsigned int		Profiler::traceFramesLeft = 0;
+
+/*
+	Resets all zones and makes the calling
+	thread the one that is profiled.
+*/
+void Profiler::Init(void)
+{
+	zoneCount = 0;
+	stackDepth = 0;
+	inFrame = false;
+	mainThread = GetCurrentThreadId();
+}
+
+/*
+	Marks the start of a frame and opens the root "Frame" zone.
+*/
+void Profiler::BeginFrame(void)
+{
+	frameZone = BeginZone("Frame");
+	frameStart = getTimeNanoseconds();
+	inFrame = true;
+}
+
+/*
+	Closes the "Frame" zone and pushes the time that every
+	zone accumulated during the frame into its history.
+	Ends a trace capture once its frame count is reached.
+*/
+void Profiler::EndFrame(void)
+{
+	__int64 frameEnd = getTimeNanoseconds();
+	lastFrameTime = (frameEnd - frameStart) / 1000000.0;
+
+	if (IsTracing())
+		RecordTraceEvent("Frame", NULL, frameStart, frameEnd);
+
+	EndZone(frameZone, frameStart);
+	inFrame = false;
+
+	for (unsigned int i = 0; i < zoneCount; ++i)
+	{
+		if (zones[i].hit)
+		{
+			PushSample(i, zones[i].frameTime);
+			zones[i].frameTime = 0;
+			zones[i].hit = false;
+		}
+	}
+
+	if (traceFramesLeft > 0 && IsTracing())
+	{
+		if (--traceFramesLeft == 0)
+			StopTrace();
+	}
+}
+
+/*
+	Opens a zone nested in the currently open zone and
+	returns its index, or -1 if the zone isn't profiled
+	(wrong thread, too deep or too many zones).
+
+	name	-	Name of the zone. Must outlive the profiler,
+				string literals are expected.
+*/
+int Profiler::BeginZone(const char* name)
+{
+	if (GetCurrentThreadId() != mainThread || stackDepth >= PROFILER_MAX_DEPTH)
+		return -1;
+
+	int parent = (stackDepth > 0) ? stack[stackDepth - 1] : -1;
+
+	int zone = -1;
+	for (unsigned int i = 0; i < zoneCount; ++i)
+	{
+		if (zones[i].parent == parent && (zones[i].name == name || strcmp(zones[i].name, name) == 0))
+		{
+			zone = (int)i;
+			break;
+		}
+	}
+
+	if (zone < 0)
+	{
+		if (zoneCount >= PROFILER_MAX_ZONES)
+			return -1;
+
+		zone = (int)zoneCount++;
+		zones[zone].name = name;
+		zones[zone].parent = parent;
+		zones[zone].depth = stackDepth;
+		zones[zone].frameTime = 0;
+		zones[zone].hit = false;
+		zones[zone].head = 0;
+		zones[zone].count = 0;
+	}
+
+	stack[stackDepth++] = zone;
+	return zone;
+}
+
+/*
+	Closes a zone opened with BeginZone().
+
+	zone		-	Index returned by BeginZone().
+	startTime	-	getTimeNanoseconds() when the zone was opened.
+*/
+void Profiler::EndZone(int zone, __int64 startTime)
+{
+	if (zone < 0)
+		return;
+
+	__int64 elapsed = getTimeNanoseconds() - startTime;
+
+	if (stackDepth > 0)
+		--stackDepth;
+
+	if (inFrame)
+	{
+		zones[zone].frameTime += elapsed;
+		zones[zone].hit = true;
+	}
+	else
+	{
+		PushSample(zone, elapsed);
+	}
+}
+
+/*
+	Stores one per-frame time in the zone's ring buffer.
+*/
+void Profiler::PushSample(unsigned int zone, __int64 nanoseconds)
+{
+	ProfilerZone& z = zones[zone];
+	z.history[z.head] = nanoseconds;
+	z.head = (z.head + 1) % PROFILER_HISTORY;
+	if (z.count < PROFILER_HISTORY)
+		++z.count;
+}
+
+/*
+	Number of zones seen so far.
+*/
+unsigned int Profiler::GetZoneCount(void)
+{
+	return zoneCount;
+}
+
+/*
+	Computes the statistics of a zone over its history.
+	Returns false if the zone doesn't exist.
+
+	zone	-	Index of the zone, 0 to GetZoneCount() - 1.
+	stats	-	Receives the statistics.
+*/
+bool Profiler::GetZoneStats(unsigned int zone, ProfilerZoneStats& stats)
+{
+	if (zone >= zoneCount)
+		return false;
+
+	const ProfilerZone& z = zones[zone];
+
+	stats.name = z.name;
+	stats.parent = z.parent;
+	stats.depth = z.depth;
+	stats.samples = z.count;
+	stats.last = stats.min = stats.avg = stats.p95 = stats.p99 = 0.0;
+
+	if (z.count == 0)
+		return true;
+
+	std::vector<__int64> sorted(z.history, z.history + z.count);
+	std::sort(sorted.begin(), sorted.end());
+
+	__int64 sum = 0;
+	for (size_t i = 0; i < sorted.size(); ++i)
+		sum += sorted[i];
+
+	stats.last = z.history[(z.head + PROFILER_HISTORY - 1) % PROFILER_HISTORY] / 1000000.0;
+	stats.min = sorted.front() / 1000000.0;
+	stats.avg = (double)sum / sorted.size() / 1000000.0;
+	stats.p95 = Percentile(sorted, 0.95);
+	stats.p99 = Percentile(sorted, 0.99);
+
+	return true;
+}
+
+/*
+	Returns the index of the first zone with the
+	given name, regardless of its parent, or -1.
+*/
+int Profiler::FindZone(const char* name)
+{
+	for (unsigned int i = 0; i < zoneCount; ++i)
+	{
+		if (strcmp(zones[i].name, name) == 0)
+			return (int)i;
+	}
+	return -1;
+}
+
+/*
+	Time in ms between the last BeginFrame()/EndFrame() pair.
+*/
+double Profiler::GetFrameTime(void)
+{
+	return lastFrameTime;
+}
+
+/*
+	Writes a table with the statistics of every zone
+	to the log, children indented below their parent.
+*/
+void Profiler::LogReport(void)
+{
+	LOG_INFO(LOG_CATEGORY_CORE, "");
+	LOG_INFO(LOG_CATEGORY_CORE, "===CPU Profile (ms per frame)===");
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "%-36s %8s %8s %8s %8s %8s %6s",
+		"Zone", "last", "min", "avg", "p95", "p99", "frames");
+
+	// Print in depth-first order so children follow their parent.
+	std::vector<int> order;
+	std::vector<int> pending;
+	for (int i = (int)zoneCount - 1; i >= 0; --i)
+	{
+		if (zones[i].parent < 0)
+			pending.push_back(i);
+	}
+	while (!pending.empty())
+	{
+		int zone = pending.back();
+		pending.pop_back();
+		order.push_back(zone);
+		for (int i = (int)zoneCount - 1; i >= 0; --i)
+		{
+			if (zones[i].parent == zone)
+				pending.push_back(i);
+		}
+	}
+
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		ProfilerZoneStats stats;
+		GetZoneStats(order[i], stats);
+
+		std::string label(2 * stats.depth, ' ');
+		label += stats.name;
+
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "%-36s %8.3f %8.3f %8.3f %8.3f %8.3f %6u",
+			label.c_str(), stats.last, stats.min, stats.avg, stats.p95, stats.p99, stats.samples);
+	}
+}
+
+/*
+	Starts recording every zone into a trace capture.
+	A capture that is already running is discarded.
+
+	path	-	File the capture is written to when it stops.
+	frames	-	Number of frames to record before the capture
+				stops by itself, 0 to record until StopTrace().
+*/
+void Profiler::StartTrace(const char* path, unsigned int frames)
+{
+	{
+		std::lock_guard<std::mutex> lock(traceMutex);
+
+		traceEvents.clear();
+		traceEvents.reserve(TRACE_RESERVE);
+		tracePath = path;
+		traceFramesLeft = frames;
+
+		tracing.store(true, std::memory_order_release);
+	}
+
+	if (frames > 0)
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Trace capture started, recording %u frames to %s.", frames, path);
+	else
+		LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Trace capture started, recording to %s until stopped.", path);
+}
+
+/*
+	Stops the running trace capture and writes it to disk.
+	Returns false if no capture was running or the file
+	couldn't be written.
+*/
+bool Profiler::StopTrace(void)
+{
+	if (!tracing.exchange(false))
+		return false;
+
+	return WriteTrace();
+}
+
+/*
+	Whether a trace capture is running.
+*/
+bool Profiler::IsTracing(void)
+{
+	return tracing.load(std::memory_order_relaxed);
+}
+
+/*
+	Adds one event to the running trace capture. Can be
+	called from any thread, does nothing while idle.
+
+	name		-	Name of the event (string literal).
+	detail		-	Optional text shown with the event, or NULL.
+	startTime	-	getTimeNanoseconds() at the start of the event.
+	endTime		-	getTimeNanoseconds() at the end of the event.
+*/
+void Profiler::RecordTraceEvent(const char* name, const char* detail, __int64 startTime, __int64 endTime)
+{
+	if (!tracing.load(std::memory_order_acquire))
+		return;
+
+	TraceEvent traceEvent;
+	traceEvent.name = name;
+	if (detail != NULL)
+		traceEvent.detail = detail;
+	traceEvent.thread = GetCurrentThreadId();
+	traceEvent.start = startTime;
+	traceEvent.end = endTime;
+
+	std::lock_guard<std::mutex> lock(traceMutex);
+	traceEvents.push_back(traceEvent);
+}
+
+/*
+	Writes the events of the capture that just stopped
+	in the Chrome trace event format.
+*/
+bool Profiler::WriteTrace(void)
+{
+	std::vector<TraceEvent> events;
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(traceMutex);
+		events.swap(traceEvents);
+		path = tracePath;
+	}
+
+	FILE* file = NULL;
+	if (fopen_s(&file, path.c_str(), "w") != 0 || file == NULL)
+	{
+		LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_CORE, "Could not write trace capture to %s.", path.c_str());
+		return false;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"LightEngine\"}},\n", mainThread);
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"Main Thread\"}}", mainThread);
+
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		const TraceEvent& e = events[i];
+
+		fprintf(file, ",\n{\"name\":");
+		writeJsonString(file, e.name);
+		fprintf(file, ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f",
+			e.thread, e.start / 1000.0, (e.end - e.start) / 1000.0);
+
+		if (!e.detail.empty())
+		{
+			fprintf(file, ",\"args\":{\"detail\":");
+			writeJsonString(file, e.detail.c_str());
+			fputc('}', file);
+		}
+
+		fputc('}', file);
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Trace capture with %u events written to %s.", (unsigned int)events.size(), path.c_str());
+
+	return true;
+}
+
+/*
+	Opens a zone for the lifetime of the object.
+
+	name	-	Name of the zone (string literal).
+	detail	-	Optional text shown with the event in trace
+				captures (e.g. a file name), or NULL.
+*/
+ProfileScope::ProfileScope(const char* name, const char* detail)
+{
+	this->name = name;
+	this->detail = detail;
+
+	zone = Profiler::BeginZone(name);
+	traced = Profiler::IsTracing();
+	start = (zone >= 0 || traced) ? getTimeNanoseconds() : 0;
+}
+
+/*
+	Closes the zone opened by the constructor.
+*/
+ProfileScope::~ProfileScope()
+{
+	if (traced)
+		Profiler::RecordTraceEvent(name, detail, start, getTimeNanoseconds());
+
+	Profiler::EndZone(zone, start);
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+// Includes.
+#include "Utility.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+
+// Limits of the profiler. Zones are identified by name and parent,
+// so the same name under two different parents counts as two zones.
+const unsigned int PROFILER_MAX_ZONES = 64;
+const unsigned int PROFILER_MAX_DEPTH = 16;
+const unsigned int PROFILER_HISTORY = 256;	// Frames kept per zone.
+
+/*
+	Statistics of one zone over the frames in its history.
+	All times are in milliseconds.
+
+	name	-	Name the zone was opened with.
+	parent	-	Index of the enclosing zone, -1 for root zones.
+	depth	-	Nesting depth, 0 for root zones.
+	samples	-	Number of frames in the history.
+	last	-	Time spent in the zone in the most recent frame.
+*/
+struct ProfilerZoneStats
+{
+	const char*		name;
+	int				parent;
+	unsigned int	depth;
+	unsigned int	samples;
+	double			last;
+	double			min;
+	double			avg;
+	double			p95;
+	double			p99;
+};
+
+/*
+	Hierarchical CPU frame profiler. Zones are opened and
+	closed through ProfileScope (see PROFILE_SCOPE) and can
+	be nested. Time spent in a zone is accumulated over the
+	frame and pushed into the zone's ring buffer when the
+	frame ends, so that min/avg/p95/p99 per frame can be
+	computed over the last PROFILER_HISTORY frames.
+
+	Zones that are closed outside BeginFrame()/EndFrame()
+	(e.g. during loading) record a single sample right away.
+	Only the thread that called Init() is profiled.
+
+	Between StartTrace() and StopTrace() every zone, on any
+	thread, is also recorded as a Chrome trace event and the
+	capture is written as JSON that chrome://tracing and
+	Perfetto can open. When no trace is running the only
+	cost per zone is one atomic load.
+*/
+class Profiler
+{
+public:
+
+// Functions
+
+	static void Init(void);
+	static void BeginFrame(void);
+	static void EndFrame(void);
+	static int BeginZone(const char* name);
+	static void EndZone(int zone, __int64 startTime);
+
+	static unsigned int GetZoneCount(void);
+	static bool GetZoneStats(unsigned int zone, ProfilerZoneStats& stats);
+	static int FindZone(const char* name);
+	static double GetFrameTime(void);
+	static void LogReport(void);
+
+	static void StartTrace(const char* path, unsigned int frames);
+	static bool StopTrace(void);
+	static bool IsTracing(void);
+	static void RecordTraceEvent(const char* name, const char* detail, __int64 startTime, __int64 endTime);
+
+private:
+
+// Functions
+
+	static void PushSample(unsigned int zone, __int64 nanoseconds);
+	static bool WriteTrace(void);
+
+// Variables
+
+	static bool				inFrame;
+	static int				frameZone;
+	static __int64			frameStart;
+	static double			lastFrameTime;
+	static unsigned long	mainThread;
+
+	static std::atomic<bool>	tracing;
+	static std::mutex			traceMutex;
+	static std::string			tracePath;
+	static unsigned int			traceFramesLeft;
+};
+
+/*
+	RAII marker that times the enclosing scope as a zone.
+*/
+class ProfileScope
+{
+public:
+
+// Functions
+
+	ProfileScope(const char* name, const char* detail = NULL);
+	~ProfileScope();
+
+private:
+
+// Variables
+
+	const char*	name;
+	const char*	detail;
+	int			zone;
+	bool		traced;
+	__int64		start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b)	a##b
+#define PROFILE_CONCAT(a, b)		PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)			ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+// Same as PROFILE_SCOPE, detail (e.g. a file name) is shown
+// with the event in trace captures. It is copied only while
+// a trace is running.
+#define PROFILE_SCOPE_DETAIL(name, detail)	ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, detail)
\ No newline at end of file
@@ -1,5 +1,19 @@
 #include "Shader.h"
 
+namespace
+{
+	// Name of a stage for the compile log.
+	const char* StageName(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_VERTEX_SHADER:		return "Vertex";
+		case GL_GEOMETRY_SHADER:	return "Geometry";
+		default:					return "Fragment";
+		}
+	}
+}
+
 /*
 	Default constructor.
 */
@@ -18,90 +32,161 @@ Shader::Shader()
 */
 Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
 {
-	// 1. Retrieve the vertex/fragment source code from filePath
-	std::string vertexCode;
-	std::string fragmentCode;
+	PROFILE_SCOPE_DETAIL("Shader Compile", vertexPath);
 
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
+	const GLchar* paths[] = { vertexPath, fragmentPath };
+	const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
 
-	// ensures ifstream objects can throw exceptions:
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+	Build(paths, types, 2, std::string());
+}
 
-	try
-	{
-		// Open files
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		std::stringstream vShaderStream, fShaderStream;
-
-		// Read file's buffer contents into streams
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
-
-		// close file handlers
-		vShaderFile.close();
-		fShaderFile.close();
-
-		// Convert stream into string
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
-	}
-	catch (std::ifstream::failure e)
-	{
-		log("Shader file not read successfully.");
-	}
+/*
+	Constructor that takes in the shader codes for
+	vertex shader, goemetry shader and fragment shader,
+	compiles the code and generates a program object.
+
+	vertexPath		-	Path to the .vert file containing vertex shader code.
+	geometryPath	-	Path to the .gs file containing geometry shader code.
+	fragmentPath	-	Path to the .frag file containing fragment shader code.
+*/
+Shader::Shader(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath)
+{
+	PROFILE_SCOPE_DETAIL("Shader Compile", vertexPath);
 
-	const GLchar* vShaderCode = vertexCode.c_str();
-	const GLchar * fShaderCode = fragmentCode.c_str();
+	const GLchar* paths[] = { vertexPath, geometryPath, fragmentPath };
+	const GLenum types[] = { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER };
 
-	// 2. Compile shaders
-	GLuint vertex, fragment;
-	GLint success;
+	Build(paths, types, 3, std::string());
+}
 
-	GLchar infoLog[1024];
+/*
+	Constructor for a variant of a vertex/fragment
+	shader pair : the given #define lines are inserted
+	into both stages right after their #version line.
 
-	// Vertex Shader
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
+	vertexPath		-	Path to the .vert file containing vertex shader code.
+	fragmentPath	-	Path to the .frag file containing fragment shader code.
+	defines			-	"#define NAME" lines, one per enabled keyword.
+*/
+Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const std::string& defines)
+{
+	PROFILE_SCOPE_DETAIL("Shader Compile", fragmentPath);
 
-	// Print compile errors if any
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-	if (!success)
+	const GLchar* paths[] = { vertexPath, fragmentPath };
+	const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+
+	Build(paths, types, 2, defines);
+}
+
+/*
+	Sets the current program in the OpenGL state machine.
+*/
+void Shader::Use(void)
+{
+	glUseProgram(program);
+}
+
+/*
+	Delete the program once the shader is used.
+*/
+Shader::~Shader()
+{
+}
+
+/*
+	Reads the sources of all stages and creates the
+	program, from the shader cache if it holds an entry
+	for these sources, otherwise by compiling and linking
+	them (and storing the result in the cache).
+
+	paths	-	Paths to the source files, one per stage.
+	types	-	Type of each stage.
+	count	-	Number of stages.
+	defines	-	Lines inserted after the #version line of every stage.
+*/
+void Shader::Build(const GLchar* paths[], const GLenum types[], unsigned int count, const std::string& defines)
+{
+	__int64 start = getTimeNanoseconds();
+
+	// 1. Retrieve the source code of every stage
+	std::string code[SHADER_MAX_STAGES];
+
+	for (unsigned int i = 0; i < count; ++i)
 	{
-		glGetShaderInfoLog(vertex, 1024, NULL, infoLog);
-		log("Vertex Shader Compilation Failed.");
-		log(infoLog);
+		// From the pack or the loose file
+		FileData shaderFile;
+		if (FileSystem::ReadFile(paths[i], shaderFile))
+			code[i].assign((const char*)shaderFile.GetData(), shaderFile.GetSize());
+		else
+			LOG_ERROR(LOG_CATEGORY_SHADER, "Shader file not read successfully.");
 	}
-	else
+
+	// #version has to stay the first line, the defines go right after it.
+	if (!defines.empty())
 	{
-		log("Vertex Shader Compilation Successful.");
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			size_t lineEnd = (code[i].compare(0, 8, "#version") == 0) ? code[i].find('\n') : std::string::npos;
+			if (lineEnd == std::string::npos)
+				code[i].insert(0, defines);
+			else
+				code[i].insert(lineEnd + 1, defines);
+		}
 	}
 
-	// Fragment Shader
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
+	// 2. Try the shader cache
+	unsigned long long hash = ShaderCache::Hash(code, count);
+	double coldTime = 0.0;
 
-	// Print compile errors if any
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-	if (!success)
+	program = ShaderCache::Load(hash, coldTime);
+	if (program != 0)
 	{
-		glGetShaderInfoLog(fragment, 1024, NULL, infoLog);
-		log("Fragment Shader Compilation Failed.");
-		log(infoLog);
+		double buildTime = (getTimeNanoseconds() - start) / 1000000.0;
+		ShaderCache::RecordBuild(true, buildTime, coldTime);
+
+		LOG_DEBUG(LOG_CATEGORY_SHADER, "Shader Program Loaded From Cache.");
+		Reflect();
+		return;
 	}
-	else
+
+	// 3. Compile shaders
+	GLuint shaders[SHADER_MAX_STAGES];
+	GLint success;
+
+	GLchar infoLog[1024];
+
+	for (unsigned int i = 0; i < count; ++i)
 	{
-		log("Fragment Shader Compilation Successful.");
+		const GLchar* shaderCode = code[i].c_str();
+
+		shaders[i] = glCreateShader(types[i]);
+		glShaderSource(shaders[i], 1, &shaderCode, NULL);
+		glCompileShader(shaders[i]);
+
+		// Print compile errors if any
+		glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(shaders[i], 1024, NULL, infoLog);
+			LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_SHADER, "%s Shader Compilation Failed.", StageName(types[i]));
+			LOG_ERROR(LOG_CATEGORY_SHADER, infoLog);
+		}
+		else
+		{
+			LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_SHADER, "%s Shader Compilation Successful.", StageName(types[i]));
+		}
 	}
-	// Shader program
 
+	// Shader program
 	program = glCreateProgram();
-	glAttachShader(program, vertex);
-	glAttachShader(program, fragment);
+
+	for (unsigned int i = 0; i < count; ++i)
+		glAttachShader(program, shaders[i]);
+
+	// Ask the driver to keep the binary around for the cache.
+	if (ShaderCache::IsEnabled())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	glLinkProgram(program);
 
 	// Print linking errors if any
@@ -110,178 +195,198 @@ Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
 	if (!success)
 	{
 		glGetProgramInfoLog(program, 1024, NULL, infoLog);
-		log("Shader Program Linking Failed.");
-		log(infoLog);
+		LOG_ERROR(LOG_CATEGORY_SHADER, "Shader Program Linking Failed.");
+		LOG_ERROR(LOG_CATEGORY_SHADER, infoLog);
 	}
 	else
 	{
-		log("Shader Program Linking Successful.");
+		LOG_DEBUG(LOG_CATEGORY_SHADER, "Shader Program Linking Successful.");
 	}
 
 	// Delete the shaders as they're linked into our program now and no longer necessery
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
+	for (unsigned int i = 0; i < count; ++i)
+		glDeleteShader(shaders[i]);
+
+	double buildTime = (getTimeNanoseconds() - start) / 1000000.0;
+
+	// Broken programs are not cached, so that fixing the source is all it takes.
+	if (success)
+		ShaderCache::Store(program, hash, buildTime);
+
+	ShaderCache::RecordBuild(false, buildTime, buildTime);
+
+	if (success)
+		Reflect();
 }
 
 /*
-	Constructor that takes in the shader codes for
-	vertex shader, goemetry shader and fragment shader,
-	compiles the code and generates a program object.
-
-	vertexPath		-	Path to the .vert file containing vertex shader code.
-	geometryPath	-	Path to the .gs file containing geometry shader code.
-	fragmentPath	-	Path to the .frag file containing fragment shader code.
+	Binds the uniform blocks of the linked program to
+	their shared binding points, then queries all other
+	active uniforms and fills the uniform table. Table size is a power
+	of two at least twice the uniform count, so probe
+	sequences stay short.
 */
-Shader::Shader(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath)
+void Shader::Reflect(void)
 {
-	// 1. Retrieve the vertex/fragment source code from filePath
-	std::string vertexCode;
-	std::string geometryCode;
-	std::string fragmentCode;
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
 
-	std::ifstream vShaderFile;
-	std::ifstream gShaderFile;
-	std::ifstream fShaderFile;
+	std::vector<GLchar> blockName(maxLength + 1);
 
-	// ensures ifstream objects can throw exceptions:
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-	try
-	{
-		// Open files
-		vShaderFile.open(vertexPath);
-		gShaderFile.open(geometryPath);
-		fShaderFile.open(fragmentPath);
-		std::stringstream vShaderStream, gShaderStream, fShaderStream;
-
-		// Read file's buffer contents into streams
-		vShaderStream << vShaderFile.rdbuf();
-		gShaderStream << gShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
-
-		// close file handlers
-		vShaderFile.close();
-		gShaderFile.close();
-		fShaderFile.close();
-
-		// Convert stream into string
-		vertexCode = vShaderStream.str();
-		geometryCode = gShaderStream.str();
-		fragmentCode = fShaderStream.str();
-	}
-	catch (std::ifstream::failure e)
+	for (GLint i = 0; i < count; ++i)
 	{
-		log("Shader file not read successfully.");
+		glGetActiveUniformBlockName(program, i, (GLsizei)blockName.size(), NULL, &blockName[0]);
+
+		GLint binding = UniformBuffer::GetBlockBinding(&blockName[0]);
+		if (binding >= 0)
+			glUniformBlockBinding(program, i, binding);
+		else
+			LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_SHADER, "Uniform block %s has no binding point.", &blockName[0]);
 	}
 
-	const GLchar* vShaderCode = vertexCode.c_str();
-	const GLchar * gShaderCode = geometryCode.c_str();
-	const GLchar * fShaderCode = fragmentCode.c_str();
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
 
-	// 2. Compile shaders
-	GLuint vertex, geometry, fragment;
-	GLint success;
+	uniforms.clear();
+	uniforms.reserve(count);
 
-	GLchar infoLog[1024];
+	std::vector<GLchar> name(maxLength + 1);
 
-	// Vertex Shader
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
+	for (GLint i = 0; i < count; ++i)
+	{
+		ShaderUniform uniform;
+		GLsizei length = 0;
+		glGetActiveUniform(program, i, (GLsizei)name.size(), &length, &uniform.size, &uniform.type, &name[0]);
 
-	// Print compile errors if any
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+		uniform.location = glGetUniformLocation(program, &name[0]);
 
-	if (!success)
-	{
-		glGetShaderInfoLog(vertex, 1024, NULL, infoLog);
-		log("Vertex Shader Compilation Failed.");
-		log(infoLog);
-	}
-	else
-	{
-		log("Vertex Shader Compilation Successful.");
-	}
+		// Uniforms in blocks have no location.
+		if (uniform.location < 0)
+			continue;
 
-	// Geometry Shader
-	geometry = glCreateShader(GL_GEOMETRY_SHADER);
-	glShaderSource(geometry, 1, &gShaderCode, NULL);
-	glCompileShader(geometry);
+		// Arrays are reported as "name[0]", look them up by "name".
+		if (length > 3 && strcmp(&name[length - 3], "[0]") == 0)
+			name[length - 3] = '\0';
 
-	// Print compile errors if any
-	glGetShaderiv(geometry, GL_COMPILE_STATUS, &success);
+		uniform.name = &name[0];
+		uniform.hash = HashName(&name[0]);
+		uniform.uploaded = false;
+		memset(uniform.value, 0, sizeof(uniform.value));
 
-	if (!success)
-	{
-		glGetShaderInfoLog(geometry, 1024, NULL, infoLog);
-		log("Geometry Shader Compilation Failed.");
-		log(infoLog);
-	}
-	else
-	{
-		log("Geometry Shader Compilation Successful.");
+		uniforms.push_back(uniform);
 	}
 
-	// Fragment Shader
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
+	unsigned int tableSize = 8;
+	while (tableSize < uniforms.size() * 2)
+		tableSize *= 2;
 
-	// Print compile errors if any
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+	uniformTable.assign(tableSize, -1);
 
-	if (!success)
-	{
-		glGetShaderInfoLog(fragment, 1024, NULL, infoLog);
-		log("Fragment Shader Compilation Failed.");
-		log(infoLog);
-	}
-	else
+	for (unsigned int i = 0; i < uniforms.size(); ++i)
 	{
-		log("Fragment Shader Compilation Successful.");
+		unsigned int slot = uniforms[i].hash & (tableSize - 1);
+		while (uniformTable[slot] >= 0)
+		{
+			// Lookups by hash would alias the two, only lookups by name tell them apart.
+			if (uniforms[uniformTable[slot]].hash == uniforms[i].hash)
+				LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_SHADER, "Uniforms \"%s\" and \"%s\" share a name hash, rename one of them.",
+					uniforms[uniformTable[slot]].name.c_str(), uniforms[i].name.c_str());
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		uniformTable[slot] = i;
 	}
 
-	// Shader program
-	program = glCreateProgram();
+	LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_SHADER, "%u active uniforms reflected.", (unsigned int)uniforms.size());
+}
 
-	glAttachShader(program, vertex);
-	glAttachShader(program, geometry);
-	glAttachShader(program, fragment);
-	glLinkProgram(program);
+/*
+	Uniform with the given name, or NULL if it is not
+	active in the program. Meant to be called once, the
+	result is kept in a UniformHandle. Names are compared
+	too, so this finds uniforms whose hashes collide.
 
-	// Print linking errors if any
-	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	name	-	Name of the uniform as written in the shader.
+*/
+ShaderUniform* Shader::GetUniform(const char* name)
+{
+	if (uniformTable.empty())
+		return NULL;
 
-	if (!success)
+	unsigned int hash = HashName(name);
+	unsigned int mask = (unsigned int)uniformTable.size() - 1;
+	for (unsigned int slot = hash & mask; uniformTable[slot] >= 0; slot = (slot + 1) & mask)
 	{
-		glGetProgramInfoLog(program, 1024, NULL, infoLog);
-		log("Shader Program Linking Failed.");
-		log(infoLog);
+		ShaderUniform& uniform = uniforms[uniformTable[slot]];
+		if (uniform.hash == hash && uniform.name == name)
+			return &uniform;
 	}
-	else
+
+	return NULL;
+}
+
+/*
+	Uniform with the given name hash, or NULL if it is
+	not active in the program. Reflect() reports hashes
+	that collide, this returns the first of them.
+
+	hash	-	HashName() of the uniform's name.
+*/
+ShaderUniform* Shader::GetUniform(unsigned int hash)
+{
+	if (uniformTable.empty())
+		return NULL;
+
+	unsigned int mask = (unsigned int)uniformTable.size() - 1;
+	for (unsigned int slot = hash & mask; uniformTable[slot] >= 0; slot = (slot + 1) & mask)
 	{
-		log("Shader Program Linking Successful.");
+		if (uniforms[uniformTable[slot]].hash == hash)
+			return &uniforms[uniformTable[slot]];
 	}
 
-	// Delete the shaders as they're linked into our program now and no longer necessery
-	glDeleteShader(vertex);
-	glDeleteShader(geometry);
-	glDeleteShader(fragment);
+	return NULL;
 }
 
 /*
-	Sets the current program in the OpenGL state machine.
+	32-bit FNV-1a hash of a uniform name. Code that looks
+	uniforms up per frame hashes its names once up front.
 */
-void Shader::Use(void)
+unsigned int Shader::HashName(const char* name)
 {
-	glUseProgram(program);
+	return hashBytes32(name, strlen(name));
 }
 
 /*
-	Delete the program once the shader is used.
+	Logs that a handle was made for a uniform of another
+	type. Int handles also set bools and sampler handles
+	set samplers of any kind, those aren't reported.
+
+	type	-	GL type the handle sets.
 */
-Shader::~Shader()
+void UniformHandle::WarnType(GLenum type) const
 {
+	if (type == GL_INT && uniform->type == GL_BOOL)
+		return;
+
+	if (type == GL_SAMPLER_2D)
+	{
+		switch (uniform->type)
+		{
+		case GL_SAMPLER_1D:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_1D_SHADOW:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_1D_ARRAY:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_CUBE_SHADOW:
+		case GL_SAMPLER_2D_MULTISAMPLE:
+		case GL_SAMPLER_BUFFER:
+			return;
+		}
+	}
+
+	LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_SHADER, "Uniform \"%s\" has GL type 0x%04X, its handle sets 0x%04X.",
+		uniform->name.c_str(), (unsigned int)uniform->type, (unsigned int)type);
 }
\ No newline at end of file
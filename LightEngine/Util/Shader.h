@@ -2,14 +2,203 @@
 
 // Includes.
 #include "..\Contrib\Include\gl\glew.h"
+#include "..\Contrib\Include\glm\glm.hpp"
+#include "..\Contrib\Include\glm\gtc\type_ptr.hpp"
 #include "Utility.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "UniformBuffer.h"
+#include "FileSystem.h"
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+
+// Most stages a program is built from (vertex, geometry, fragment).
+const unsigned int SHADER_MAX_STAGES = 3;
+
+// Floats in the shadow copy of a uniform, enough for a mat4.
+const unsigned int SHADER_UNIFORM_MAX_FLOATS = 16;
+
+/*
+	An active uniform of a program, found by
+	reflection when the program is created.
+
+	name		-	Name without the "[0]" that arrays are
+					reported with.
+	hash		-	Shader::HashName() of the name.
+	location	-	Location the value is uploaded to.
+	type		-	GL type, e.g. GL_FLOAT_MAT4 or GL_SAMPLER_2D.
+	size		-	Number of array elements, 1 for plain uniforms.
+	uploaded	-	Whether value holds what is in the program.
+	value		-	Shadow copy of the last uploaded value.
+*/
+struct ShaderUniform
+{
+	std::string		name;
+	unsigned int	hash;
+	GLint			location;
+	GLenum			type;
+	GLint			size;
+	bool			uploaded;
+	GLfloat			value[SHADER_UNIFORM_MAX_FLOATS];
+};
+
+/*
+	Handle to a uniform resolved once through
+	Shader::GetUniform(). Setting a value only reaches
+	the driver if it differs from the last one set, so
+	the typed handles below can be set every frame.
+	Like glUniform*(), the program has to be in use.
+
+	Handles of uniforms that are not active in the
+	program (e.g. optimized out) ignore all values.
+	Debug builds warn when a handle is made for a
+	uniform of another GL type.
+*/
+class UniformHandle
+{
+public:
+
+// Functions
+
+	UniformHandle() : uniform(NULL) {}
+	UniformHandle(ShaderUniform* uniform) : uniform(uniform) {}
+
+protected:
+
+// Functions
+
+	// Warns in debug builds if the uniform isn't of the given type.
+	void CheckType(GLenum type) const
+	{
+#ifdef _DEBUG
+		if (uniform != NULL && uniform->type != type)
+			WarnType(type);
+#endif
+	}
+
+	void WarnType(GLenum type) const;
+
+	// Updates the shadow copy, returns false if there is nothing to upload.
+	bool Changed(const void* data, size_t size)
+	{
+		if (uniform == NULL)
+			return false;
+		if (uniform->uploaded && memcmp(uniform->value, data, size) == 0)
+			return false;
+
+		memcpy(uniform->value, data, size);
+		uniform->uploaded = true;
+		return true;
+	}
+
+// Variables
+
+	ShaderUniform* uniform;
+};
+
+class UniformInt : public UniformHandle
+{
+public:
+
+	UniformInt() {}
+	UniformInt(ShaderUniform* uniform) : UniformHandle(uniform) { CheckType(GL_INT); }
+
+	void Set(GLint value)
+	{
+		if (Changed(&value, sizeof(value)))
+			glUniform1i(uniform->location, value);
+	}
+};
+
+class UniformFloat : public UniformHandle
+{
+public:
+
+	UniformFloat() {}
+	UniformFloat(ShaderUniform* uniform) : UniformHandle(uniform) { CheckType(GL_FLOAT); }
+
+	void Set(GLfloat value)
+	{
+		if (Changed(&value, sizeof(value)))
+			glUniform1f(uniform->location, value);
+	}
+};
+
+class UniformVec3 : public UniformHandle
+{
+public:
+
+	UniformVec3() {}
+	UniformVec3(ShaderUniform* uniform) : UniformHandle(uniform) { CheckType(GL_FLOAT_VEC3); }
+
+	void Set(const glm::vec3& value)
+	{
+		if (Changed(glm::value_ptr(value), sizeof(value)))
+			glUniform3fv(uniform->location, 1, glm::value_ptr(value));
+	}
+};
+
+class UniformVec4 : public UniformHandle
+{
+public:
+
+	UniformVec4() {}
+	UniformVec4(ShaderUniform* uniform) : UniformHandle(uniform) {}
+
+	void Set(const glm::vec4& value)
+	{
+		if (Changed(glm::value_ptr(value), sizeof(value)))
+			glUniform4fv(uniform->location, 1, glm::value_ptr(value));
+	}
+};
+
+class UniformMat4 : public UniformHandle
+{
+public:
+
+	UniformMat4() {}
+	UniformMat4(ShaderUniform* uniform) : UniformHandle(uniform) { CheckType(GL_FLOAT_MAT4); }
+
+	void Set(const glm::mat4& value)
+	{
+		if (Changed(glm::value_ptr(value), sizeof(value)))
+			glUniformMatrix4fv(uniform->location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+};
+
+/*
+	Sampler uniform, set to the texture unit it reads from.
+	Made for samplers of any kind, not just sampler2D.
+*/
+class UniformSampler : public UniformHandle
+{
+public:
+
+	UniformSampler() {}
+	UniformSampler(ShaderUniform* uniform) : UniformHandle(uniform) { CheckType(GL_SAMPLER_2D); }
+
+	void Set(GLint unit)
+	{
+		if (Changed(&unit, sizeof(unit)))
+			glUniform1i(uniform->location, unit);
+	}
+};
 
 /*
 	Shader class that holds ID to a program object
 	that is generated by loading and compiling the
 	relevant shader codes from the given paths.
+
+	Once the program is created, its uniform blocks are
+	bound to the binding points of the shared
+	UniformBuffers by name, and all other active uniforms
+	are reflected into a small open-addressing hash table
+	so handles can be resolved without asking the driver.
+	Pass shaders by reference : the handles point into
+	this object.
 */
 class Shader
 {
@@ -24,6 +213,22 @@ public:
 	Shader();
 	Shader(const GLchar* vertexPath, const GLchar* fragmentPath);
 	Shader(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath);
+	Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const std::string& defines);
 	void Use(void);
+	ShaderUniform* GetUniform(const char* name);
+	ShaderUniform* GetUniform(unsigned int hash);
+	static unsigned int HashName(const char* name);
 	~Shader();
+
+private:
+
+// Functions
+
+	void Build(const GLchar* paths[], const GLenum types[], unsigned int count, const std::string& defines);
+	void Reflect(void);
+
+// Variables
+
+	std::vector<ShaderUniform>	uniforms;
+	std::vector<int>			uniformTable;	// Indices into uniforms, -1 if empty.
 };
\ No newline at end of file
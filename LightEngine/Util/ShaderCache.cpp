@@ -0,0 +1,254 @@
+#include "ShaderCache.h"
+#include <vector>
+#include <cstring>
+
+namespace
+{
+	// "LESC" : Light Engine Shader Cache. Bump the version when the entry layout changes.
+	const unsigned int SHADER_CACHE_MAGIC = 0x4353454C;
+	const unsigned int SHADER_CACHE_VERSION = 1;
+
+	/*
+		Header in front of the program binary in every entry.
+
+		compileTime	-	Time it took to build the program from source, in ms.
+	*/
+	struct ShaderCacheHeader
+	{
+		unsigned int		magic;
+		unsigned int		version;
+		unsigned long long	driverHash;
+		unsigned long long	sourceHash;
+		GLenum				format;
+		GLint				length;
+		double				compileTime;
+	};
+
+	/*
+		Continues a hash over a GL string, which may be NULL.
+	*/
+	unsigned long long HashGLString(unsigned long long hash, GLenum name)
+	{
+		const char* text = (const char*)glGetString(name);
+		if (text != NULL)
+			hash = hashBytes(text, strlen(text), hash);
+		return hashBytes("\n", 1, hash);
+	}
+}
+
+bool				ShaderCache::enabled = false;
+std::string			ShaderCache::cacheDirectory;
+unsigned long long	ShaderCache::driverHash = 0;
+ShaderCacheStats	ShaderCache::stats = { 0, 0, 0.0, 0.0 };
+
+/*
+	Enables the cache if the driver can hand out program
+	binaries and creates the cache directory. Has to be
+	called with a current OpenGL context.
+
+	directory	-	Directory the entries are stored in.
+*/
+bool ShaderCache::Init(const char* directory)
+{
+	enabled = false;
+	cacheDirectory = directory;
+
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+	{
+		LOG_WARNING(LOG_CATEGORY_SHADER, "Program binaries not supported, shader cache disabled.");
+		return false;
+	}
+
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if (formats == 0)
+	{
+		LOG_WARNING(LOG_CATEGORY_SHADER, "Driver offers no program binary formats, shader cache disabled.");
+		return false;
+	}
+
+	// Fails if the directory exists already, which is fine.
+	CreateDirectoryA(directory, NULL);
+
+	// Binaries are only valid for the driver that produced them.
+	driverHash = FNV_OFFSET;
+	driverHash = HashGLString(driverHash, GL_VENDOR);
+	driverHash = HashGLString(driverHash, GL_RENDERER);
+	driverHash = HashGLString(driverHash, GL_VERSION);
+	driverHash = HashGLString(driverHash, GL_SHADING_LANGUAGE_VERSION);
+
+	enabled = true;
+
+	LOG_DEBUG(LOG_CATEGORY_SHADER, "Shader cache initialized.");
+
+	return true;
+}
+
+/*
+	Whether programs are loaded from and stored in the cache.
+*/
+bool ShaderCache::IsEnabled(void)
+{
+	return enabled;
+}
+
+/*
+	Key of a program : hash of all of its sources
+	(in stage order) and of the driver.
+
+	sources	-	Final source code of every stage.
+	count	-	Number of stages.
+*/
+unsigned long long ShaderCache::Hash(const std::string* sources, unsigned int count)
+{
+	unsigned long long hash = hashBytes(&driverHash, sizeof(driverHash));
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		hash = hashBytes(sources[i].data(), sources[i].size(), hash);
+		// Separator, so that moving code between stages changes the hash.
+		hash = hashBytes("\0", 1, hash);
+	}
+	return hash;
+}
+
+/*
+	Creates a program from a cache entry. Returns 0 if
+	there is no valid entry or the driver rejects it, the
+	caller then compiles the program from source.
+
+	hash		-	Key returned by Hash().
+	compileTime	-	Receives the time the program took to
+					compile from source, in ms.
+*/
+GLuint ShaderCache::Load(unsigned long long hash, double& compileTime)
+{
+	if (!enabled)
+		return 0;
+
+	std::string path = EntryPath(hash);
+
+	FILE* file = NULL;
+	if (fopen_s(&file, path.c_str(), "rb") != 0 || file == NULL)
+		return 0;
+
+	ShaderCacheHeader header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+		header.magic == SHADER_CACHE_MAGIC &&
+		header.version == SHADER_CACHE_VERSION &&
+		header.driverHash == driverHash &&
+		header.sourceHash == hash &&
+		header.length > 0;
+
+	std::vector<char> binary;
+	if (valid)
+	{
+		binary.resize(header.length);
+		valid = fread(&binary[0], 1, header.length, file) == (size_t)header.length;
+	}
+
+	fclose(file);
+
+	if (!valid)
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_SHADER, "Shader cache entry %s is invalid, recompiling.", path.c_str());
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, &binary[0], header.length);
+
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		// Usually a driver update that kept its version string.
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_SHADER, "Driver rejected shader cache entry %s, recompiling.", path.c_str());
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	compileTime = header.compileTime;
+
+	return program;
+}
+
+/*
+	Writes the binary of a freshly linked program to the
+	cache. The program has to be linked with
+	GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+
+	program		-	Linked program object.
+	hash		-	Key returned by Hash().
+	compileTime	-	Time the program took to build, in ms.
+*/
+void ShaderCache::Store(GLuint program, unsigned long long hash, double compileTime)
+{
+	if (!enabled)
+		return;
+
+	ShaderCacheHeader header;
+	header.magic = SHADER_CACHE_MAGIC;
+	header.version = SHADER_CACHE_VERSION;
+	header.driverHash = driverHash;
+	header.sourceHash = hash;
+	header.format = 0;
+	header.length = 0;
+	header.compileTime = compileTime;
+
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &header.length);
+	if (header.length <= 0)
+		return;
+
+	std::vector<char> binary(header.length);
+	glGetProgramBinary(program, header.length, &header.length, &header.format, &binary[0]);
+
+	std::string path = EntryPath(hash);
+
+	FILE* file = NULL;
+	if (fopen_s(&file, path.c_str(), "wb") != 0 || file == NULL)
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_SHADER, "Could not write shader cache entry %s.", path.c_str());
+		return;
+	}
+
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(&binary[0], 1, header.length, file);
+	fclose(file);
+}
+
+/*
+	Adds one program to the counters of this run.
+
+	hit			-	Whether the program came from the cache.
+	buildTime	-	Time it took to create the program, in ms.
+	coldTime	-	Time it takes to compile it from source, in ms.
+*/
+void ShaderCache::RecordBuild(bool hit, double buildTime, double coldTime)
+{
+	if (hit)
+		++stats.hits;
+	else
+		++stats.misses;
+
+	stats.buildTime += buildTime;
+	stats.coldTime += coldTime;
+}
+
+/*
+	Counters of this run.
+*/
+void ShaderCache::GetStats(ShaderCacheStats& stats)
+{
+	stats = ShaderCache::stats;
+}
+
+/*
+	File of the entry with the given key.
+*/
+std::string ShaderCache::EntryPath(unsigned long long hash)
+{
+	char name[32];
+	_snprintf_s(name, sizeof(name), _TRUNCATE, "%016llx.bin", hash);
+
+	return cacheDirectory + "/" + name;
+}
\ No newline at end of file
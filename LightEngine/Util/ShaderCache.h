@@ -0,0 +1,59 @@
+#pragma once
+
+// Includes.
+#include "..\Contrib\Include\gl\glew.h"
+#include "Utility.h"
+#include <string>
+
+/*
+	Counters of the shader cache for the current run.
+
+	buildTime	-	Time spent creating programs this run, in ms.
+	coldTime	-	Time the same programs took to compile from
+					source, in ms. Measured this run for misses,
+					stored in the cache entry for hits.
+*/
+struct ShaderCacheStats
+{
+	unsigned int	hits;
+	unsigned int	misses;
+	double			buildTime;
+	double			coldTime;
+};
+
+/*
+	Persistent cache of linked program binaries
+	(glGetProgramBinary/glProgramBinary). Entries are keyed
+	by a 64-bit FNV-1a hash of the shader sources and the
+	GL vendor, renderer and version strings, so any change
+	to a shader or the driver misses the cache and the
+	program is compiled again. A binary the driver rejects
+	is recompiled and overwritten.
+*/
+class ShaderCache
+{
+public:
+
+// Functions
+
+	static bool Init(const char* directory);
+	static bool IsEnabled(void);
+	static unsigned long long Hash(const std::string* sources, unsigned int count);
+	static GLuint Load(unsigned long long hash, double& compileTime);
+	static void Store(GLuint program, unsigned long long hash, double compileTime);
+	static void RecordBuild(bool hit, double buildTime, double coldTime);
+	static void GetStats(ShaderCacheStats& stats);
+
+private:
+
+// Functions
+
+	static std::string EntryPath(unsigned long long hash);
+
+// Variables
+
+	static bool					enabled;
+	static std::string			cacheDirectory;
+	static unsigned long long	driverHash;
+	static ShaderCacheStats		stats;
+};
\ No newline at end of file
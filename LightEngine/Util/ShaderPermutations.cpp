@@ -0,0 +1,89 @@
+#include "ShaderPermutations.h"
+
+/*
+	Sets up the variants of a shader pair, nothing is
+	compiled yet.
+
+	vertexPath		-	Path to the .vert file containing vertex shader code.
+	fragmentPath	-	Path to the .frag file containing fragment shader code.
+	keywords		-	Feature keywords, bit i of a key enables keywords[i].
+	keywordCount	-	Number of keywords, at most SHADER_MAX_KEYWORDS.
+*/
+ShaderPermutations::ShaderPermutations(const GLchar* vertexPath, const GLchar* fragmentPath, const char* const* keywords, unsigned int keywordCount)
+{
+	this->vertexPath = vertexPath;
+	this->fragmentPath = fragmentPath;
+
+	if (keywordCount > SHADER_MAX_KEYWORDS)
+	{
+		LOG_ERROR(LOG_CATEGORY_SHADER, "Too many shader keywords, the last ones are ignored.");
+		keywordCount = SHADER_MAX_KEYWORDS;
+	}
+
+	for (unsigned int i = 0; i < keywordCount; ++i)
+		this->keywords.push_back(keywords[i]);
+
+	variants.assign((size_t)1 << keywordCount, NULL);
+}
+
+/*
+	Variant with the keywords of the given key enabled,
+	compiled now if it wasn't before. Bits above the
+	keyword count are ignored.
+
+	key	-	Bit i set enables keyword i.
+*/
+Shader& ShaderPermutations::Get(unsigned int key)
+{
+	key &= (unsigned int)variants.size() - 1;
+
+	if (variants[key] == NULL)
+	{
+		LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_SHADER, "Compiling variant %u of %s.", key, fragmentPath.c_str());
+		variants[key] = new Shader(vertexPath.c_str(), fragmentPath.c_str(), Defines(key));
+	}
+
+	return *variants[key];
+}
+
+/*
+	Compiles every variant that hasn't been used yet, so
+	that toggling a feature never stalls a frame.
+*/
+void ShaderPermutations::Precompile(void)
+{
+	for (unsigned int key = 0; key < variants.size(); ++key)
+		Get(key);
+}
+
+/*
+	Number of possible variants, 2^(keyword count).
+*/
+unsigned int ShaderPermutations::GetVariantCount(void) const
+{
+	return (unsigned int)variants.size();
+}
+
+/*
+	Frees the variants. Like Shader, this leaves the
+	programs to the context, which may be gone by now.
+*/
+ShaderPermutations::~ShaderPermutations()
+{
+	for (unsigned int i = 0; i < variants.size(); ++i)
+		delete variants[i];
+}
+
+/*
+	#define lines for the keywords enabled by a key.
+*/
+std::string ShaderPermutations::Defines(unsigned int key) const
+{
+	std::string defines;
+	for (unsigned int i = 0; i < keywords.size(); ++i)
+	{
+		if (key & (1u << i))
+			defines += "#define " + keywords[i] + "\n";
+	}
+	return defines;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+// Includes.
+#include "Shader.h"
+#include <vector>
+#include <string>
+
+// Most keywords a shader can be specialized on (2^n variants).
+const unsigned int SHADER_MAX_KEYWORDS = 8;
+
+/*
+	All variants of one vertex/fragment shader pair.
+	Keyword i of the list becomes "#define <keyword>" in
+	the variants whose key has bit i set, so features that
+	are off are compiled out instead of branched over.
+
+	Variants are compiled on first use, or all at once by
+	Precompile(). Get() is an array lookup, so it can be
+	called for every draw. Each variant is its own Shader
+	with its own uniforms : handles have to be resolved
+	per variant.
+*/
+class ShaderPermutations
+{
+public:
+
+// Functions
+
+	ShaderPermutations(const GLchar* vertexPath, const GLchar* fragmentPath, const char* const* keywords, unsigned int keywordCount);
+	Shader& Get(unsigned int key);
+	void Precompile(void);
+	unsigned int GetVariantCount(void) const;
+	~ShaderPermutations();
+
+private:
+
+// Functions
+
+	// Variants own GL programs, so they can't be copied.
+	ShaderPermutations(const ShaderPermutations&);
+	ShaderPermutations& operator=(const ShaderPermutations&);
+
+	std::string Defines(unsigned int key) const;
+
+// Variables
+
+	std::string					vertexPath;
+	std::string					fragmentPath;
+	std::vector<std::string>	keywords;
+	std::vector<Shader*>		variants;	// Indexed by key, NULL until compiled.
+};
\ No newline at end of file
@@ -0,0 +1,328 @@
+#include "Telemetry.h"
+#include <cmath>
+#include <chrono>
+
+namespace
+{
+	const unsigned int TELEMETRY_RING_MASK = TELEMETRY_RING_SIZE - 1;
+
+	// Samples on their way to the CSV writer.
+	FrameSample		ring[TELEMETRY_RING_SIZE];
+	unsigned int	frameIndex;
+
+	// Frame time histogram of the whole session.
+	unsigned int	histogram[TELEMETRY_BUCKETS];
+	unsigned int	frameCount;
+	unsigned int	stutterCount;
+	double			totalFrameTime;
+
+	// The last TELEMETRY_WINDOW frames and their sums, for the averages.
+	FrameSample		window[TELEMETRY_WINDOW];
+	unsigned int	windowHead;
+	unsigned int	windowCount;
+	double			windowFrameTime;
+	double			windowCpuTime;
+	double			windowGpuTime;
+	double			windowDrawCalls;
+	double			windowTriangles;
+	double			windowClusters;
+	double			windowClustersCulled;
+	double			windowTrianglesCulled;
+
+	/*
+		Histogram bucket a frame time falls into.
+	*/
+	unsigned int Bucket(double milliseconds)
+	{
+		if (milliseconds <= TELEMETRY_HISTOGRAM_MIN)
+			return 0;
+
+		double octaves = log(milliseconds / TELEMETRY_HISTOGRAM_MIN) / log(2.0);
+		unsigned int bucket = (unsigned int)(octaves * TELEMETRY_BUCKETS_PER_OCTAVE);
+
+		return (bucket < TELEMETRY_BUCKETS) ? bucket : TELEMETRY_BUCKETS - 1;
+	}
+
+	/*
+		Upper bound of a histogram bucket in ms.
+	*/
+	double BucketLimit(unsigned int bucket)
+	{
+		return TELEMETRY_HISTOGRAM_MIN * pow(2.0, (double)(bucket + 1) / TELEMETRY_BUCKETS_PER_OCTAVE);
+	}
+}
+
+unsigned int				Telemetry::drawCalls = 0;
+unsigned int				Telemetry::triangleCount = 0;
+unsigned int				Telemetry::clusterCount = 0;
+unsigned int				Telemetry::clustersCulled = 0;
+unsigned int				Telemetry::triangleCullCount = 0;
+FILE*						Telemetry::csvFile = NULL;
+std::thread					Telemetry::writer;
+std::atomic<bool>			Telemetry::running(false);
+std::atomic<unsigned int>	Telemetry::writePos(0);
+std::atomic<unsigned int>	Telemetry::readPos(0);
+unsigned int				Telemetry::droppedSamples = 0;
+
+/*
+	Resets all statistics and, if a path is given,
+	opens the CSV file and starts the writer thread.
+
+	csvPath	-	File to stream the samples to, or NULL.
+*/
+bool Telemetry::Init(const char* csvPath)
+{
+	ResetStatistics();
+
+	drawCalls = triangleCount = 0;
+	clusterCount = clustersCulled = triangleCullCount = 0;
+	droppedSamples = 0;
+	frameIndex = 0;
+
+	if (csvPath == NULL)
+		return true;
+
+	if (fopen_s(&csvFile, csvPath, "w") != 0 || csvFile == NULL)
+	{
+		csvFile = NULL;
+		LOG_FORMAT(LOG_LEVEL_ERROR, LOG_CATEGORY_CORE, "Could not open telemetry file %s.", csvPath);
+		return false;
+	}
+
+	fprintf(csvFile, "frame,time_s,frame_ms,cpu_ms,gpu_ms,draw_calls,triangles,clusters,clusters_culled,triangles_culled\n");
+
+	writePos.store(0, std::memory_order_relaxed);
+	readPos.store(0, std::memory_order_relaxed);
+	running.store(true);
+	writer = std::thread(&Telemetry::WriterLoop);
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Streaming frame telemetry to %s.", csvPath);
+
+	return true;
+}
+
+/*
+	Writes out the remaining samples, stops the writer
+	thread and closes the CSV file.
+*/
+void Telemetry::Shutdown(void)
+{
+	if (csvFile == NULL)
+		return;
+
+	running.store(false, std::memory_order_release);
+	writer.join();
+
+	fclose(csvFile);
+	csvFile = NULL;
+}
+
+/*
+	Clears the histogram, stutter count and rolling
+	window, e.g. to leave out warm-up frames. Samples
+	keep streaming to the CSV file.
+*/
+void Telemetry::ResetStatistics(void)
+{
+	for (unsigned int i = 0; i < TELEMETRY_BUCKETS; ++i)
+		histogram[i] = 0;
+
+	frameCount = 0;
+	stutterCount = 0;
+	totalFrameTime = 0.0;
+	windowHead = windowCount = 0;
+	windowFrameTime = windowCpuTime = windowGpuTime = windowDrawCalls = windowTriangles = 0.0;
+	windowClusters = windowClustersCulled = windowTrianglesCulled = 0.0;
+}
+
+/*
+	Resets the draw call, triangle and cluster counters.
+*/
+void Telemetry::BeginFrame(void)
+{
+	drawCalls = 0;
+	triangleCount = 0;
+	clusterCount = 0;
+	clustersCulled = 0;
+	triangleCullCount = 0;
+}
+
+/*
+	Records the frame that just ended.
+
+	frameTime	-	Time since the previous frame, in ms.
+	cpuTime		-	Time the main thread spent in the frame, in ms.
+	gpuTime		-	Latest GPU frame time available, in ms.
+*/
+void Telemetry::EndFrame(float frameTime, float cpuTime, float gpuTime)
+{
+	FrameSample sample;
+	sample.frame = frameIndex++;
+	sample.time = getTimeElapsed();
+	sample.frameTime = frameTime;
+	sample.cpuTime = cpuTime;
+	sample.gpuTime = gpuTime;
+	sample.drawCalls = drawCalls;
+	sample.triangles = triangleCount;
+	sample.clusters = clusterCount;
+	sample.clustersCulled = clustersCulled;
+	sample.trianglesCulled = triangleCullCount;
+
+	// Compare against the average of the frames before this one.
+	if (windowCount >= TELEMETRY_WINDOW / 4 && frameTime > TELEMETRY_STUTTER_FACTOR * windowFrameTime / windowCount)
+		++stutterCount;
+
+	++histogram[Bucket(frameTime)];
+	++frameCount;
+	totalFrameTime += frameTime;
+
+	if (windowCount == TELEMETRY_WINDOW)
+	{
+		const FrameSample& old = window[windowHead];
+		windowFrameTime -= old.frameTime;
+		windowCpuTime -= old.cpuTime;
+		windowGpuTime -= old.gpuTime;
+		windowDrawCalls -= old.drawCalls;
+		windowTriangles -= old.triangles;
+		windowClusters -= old.clusters;
+		windowClustersCulled -= old.clustersCulled;
+		windowTrianglesCulled -= old.trianglesCulled;
+	}
+	else
+	{
+		++windowCount;
+	}
+
+	window[windowHead] = sample;
+	windowHead = (windowHead + 1) % TELEMETRY_WINDOW;
+	windowFrameTime += sample.frameTime;
+	windowCpuTime += sample.cpuTime;
+	windowGpuTime += sample.gpuTime;
+	windowDrawCalls += sample.drawCalls;
+	windowTriangles += sample.triangles;
+	windowClusters += sample.clusters;
+	windowClustersCulled += sample.clustersCulled;
+	windowTrianglesCulled += sample.trianglesCulled;
+
+	if (csvFile == NULL)
+		return;
+
+	// Single producer : only the writer thread moves readPos, so the
+	// ring can't fill up between this check and the store below.
+	unsigned int pos = writePos.load(std::memory_order_relaxed);
+	if (pos - readPos.load(std::memory_order_acquire) >= TELEMETRY_RING_SIZE)
+	{
+		++droppedSamples;
+		return;
+	}
+
+	ring[pos & TELEMETRY_RING_MASK] = sample;
+	writePos.store(pos + 1, std::memory_order_release);
+}
+
+/*
+	Frame time below which the given fraction of all
+	frames lie, read off the histogram. The result is the
+	upper bound of the bucket, i.e. within 9% above the
+	exact value.
+*/
+double Telemetry::Percentile(double fraction)
+{
+	if (frameCount == 0)
+		return 0.0;
+
+	unsigned int target = (unsigned int)ceil(fraction * frameCount);
+	if (target == 0)
+		target = 1;
+
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < TELEMETRY_BUCKETS; ++i)
+	{
+		count += histogram[i];
+		if (count >= target)
+			return BucketLimit(i);
+	}
+
+	return BucketLimit(TELEMETRY_BUCKETS - 1);
+}
+
+/*
+	Fills in the percentiles of the session and the
+	averages of the last TELEMETRY_WINDOW frames.
+*/
+void Telemetry::GetSummary(TelemetrySummary& summary)
+{
+	summary.frames = frameCount;
+	summary.stutters = stutterCount;
+	summary.mean = (frameCount > 0) ? totalFrameTime / frameCount : 0.0;
+	summary.p50 = Percentile(0.5);
+	summary.p90 = Percentile(0.9);
+	summary.p99 = Percentile(0.99);
+	summary.p999 = Percentile(0.999);
+
+	double count = (windowCount > 0) ? (double)windowCount : 1.0;
+	summary.avgFrameTime = windowFrameTime / count;
+	summary.avgCpuTime = windowCpuTime / count;
+	summary.avgGpuTime = windowGpuTime / count;
+	summary.avgDrawCalls = windowDrawCalls / count;
+	summary.avgTriangles = windowTriangles / count;
+	summary.avgClusters = windowClusters / count;
+	summary.avgClustersCulled = windowClustersCulled / count;
+	summary.avgTrianglesCulled = windowTrianglesCulled / count;
+}
+
+/*
+	Writes the frame time percentiles of the session to the log.
+*/
+void Telemetry::LogReport(void)
+{
+	TelemetrySummary summary;
+	GetSummary(summary);
+
+	LOG_INFO(LOG_CATEGORY_CORE, "");
+	LOG_INFO(LOG_CATEGORY_CORE, "===Frame Telemetry===");
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Frames : %u, stutters : %u", summary.frames, summary.stutters);
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Frame time (ms) mean : %.2f, p50 : %.2f, p90 : %.2f, p99 : %.2f, p99.9 : %.2f",
+		summary.mean, summary.p50, summary.p90, summary.p99, summary.p999);
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Last %u frames avg (ms) frame : %.2f, cpu : %.2f, gpu : %.2f, draw calls : %.0f, triangles : %.0f",
+		windowCount, summary.avgFrameTime, summary.avgCpuTime, summary.avgGpuTime, summary.avgDrawCalls, summary.avgTriangles);
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_CORE, "Last %u frames avg clusters : %.0f, culled : %.0f, triangles culled : %.0f",
+		windowCount, summary.avgClusters, summary.avgClustersCulled, summary.avgTrianglesCulled);
+
+	if (droppedSamples > 0)
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_CORE, "%u telemetry samples dropped, CSV writer fell behind.", droppedSamples);
+}
+
+/*
+	Body of the CSV writer thread. Drains the ring every
+	few milliseconds until Shutdown() is called.
+*/
+void Telemetry::WriterLoop(void)
+{
+	for (;;)
+	{
+		// Read the flag first so that the last pass sees every sample.
+		bool stopping = !running.load(std::memory_order_acquire);
+
+		unsigned int pos = readPos.load(std::memory_order_relaxed);
+		unsigned int end = writePos.load(std::memory_order_acquire);
+
+		for (; pos != end; ++pos)
+		{
+			const FrameSample& s = ring[pos & TELEMETRY_RING_MASK];
+			fprintf(csvFile, "%u,%.6f,%.4f,%.4f,%.4f,%u,%u,%u,%u,%u\n",
+				s.frame, s.time, s.frameTime, s.cpuTime, s.gpuTime, s.drawCalls, s.triangles, s.clusters, s.clustersCulled, s.trianglesCulled);
+		}
+
+		if (pos != readPos.load(std::memory_order_relaxed))
+		{
+			readPos.store(pos, std::memory_order_release);
+			fflush(csvFile);
+		}
+
+		if (stopping)
+			break;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+// Includes.
+#include "Utility.h"
+#include <atomic>
+#include <thread>
+
+// Frames held in the ring between the main thread and the CSV writer. Must be a power of two.
+const unsigned int TELEMETRY_RING_SIZE = 1024;
+
+// Frames the rolling averages (window title, overlay) are taken over.
+const unsigned int TELEMETRY_WINDOW = 120;
+
+// Log-scale histogram : TELEMETRY_BUCKETS_PER_OCTAVE buckets per doubling,
+// starting at TELEMETRY_HISTOGRAM_MIN ms and covering TELEMETRY_OCTAVES doublings.
+const unsigned int TELEMETRY_BUCKETS_PER_OCTAVE = 8;
+const unsigned int TELEMETRY_OCTAVES = 14;
+const unsigned int TELEMETRY_BUCKETS = TELEMETRY_BUCKETS_PER_OCTAVE * TELEMETRY_OCTAVES;
+const double TELEMETRY_HISTOGRAM_MIN = 0.125;
+
+// A frame counts as a stutter if it takes this many times longer than the recent average.
+const double TELEMETRY_STUTTER_FACTOR = 2.0;
+
+/*
+	Everything recorded about one frame.
+
+	frameTime	-	Time since the previous frame, in ms.
+	cpuTime		-	Time the main thread spent in the frame, in ms.
+	gpuTime		-	GPU time of the latest frame whose timer
+					queries have been read back, in ms.
+*/
+struct FrameSample
+{
+	unsigned int	frame;
+	double			time;
+	float			frameTime;
+	float			cpuTime;
+	float			gpuTime;
+	unsigned int	drawCalls;
+	unsigned int	triangles;
+	unsigned int	clusters;
+	unsigned int	clustersCulled;
+	unsigned int	trianglesCulled;
+};
+
+/*
+	Frame time statistics, all times in ms.
+*/
+struct TelemetrySummary
+{
+	unsigned int	frames;
+	unsigned int	stutters;
+	double			mean;
+	double			p50;
+	double			p90;
+	double			p99;
+	double			p999;
+	double			avgFrameTime;	// Over the last TELEMETRY_WINDOW frames,
+	double			avgCpuTime;		// as are the other averages.
+	double			avgGpuTime;
+	double			avgDrawCalls;
+	double			avgTriangles;
+	double			avgClusters;
+	double			avgClustersCulled;
+	double			avgTrianglesCulled;
+};
+
+/*
+	Per-frame telemetry. The main thread records one
+	FrameSample per frame into a log-scale histogram of
+	frame times (for percentiles over the whole session)
+	and a rolling window (for averages). If a CSV file is
+	given, samples are also pushed through a lock-free
+	single-producer/single-consumer ring to a background
+	thread that streams them to disk.
+
+	Draw calls and triangles are counted by the draw sites
+	through CountDraw(), meshlets tested and culled by the
+	cluster culling through CountClusters().
+*/
+class Telemetry
+{
+public:
+
+// Functions
+
+	static bool Init(const char* csvPath);
+	static void Shutdown(void);
+	static void ResetStatistics(void);
+	static void BeginFrame(void);
+	static void EndFrame(float frameTime, float cpuTime, float gpuTime);
+	static void GetSummary(TelemetrySummary& summary);
+	static void LogReport(void);
+
+	// Called for every draw call, so it is kept inline.
+	static void CountDraw(unsigned int triangles)
+	{
+		++drawCalls;
+		triangleCount += triangles;
+	}
+
+	static void CountClusters(unsigned int clusters, unsigned int culled, unsigned int trianglesCulled)
+	{
+		clusterCount += clusters;
+		clustersCulled += culled;
+		triangleCullCount += trianglesCulled;
+	}
+
+private:
+
+// Functions
+
+	static double Percentile(double fraction);
+	static void WriterLoop(void);
+
+// Variables
+
+	static unsigned int					drawCalls;
+	static unsigned int					triangleCount;
+	static unsigned int					clusterCount;
+	static unsigned int					clustersCulled;
+	static unsigned int					triangleCullCount;
+
+	static FILE*						csvFile;
+	static std::thread					writer;
+	static std::atomic<bool>			running;
+	static std::atomic<unsigned int>	writePos;
+	static std::atomic<unsigned int>	readPos;
+	static unsigned int					droppedSamples;
+};
\ No newline at end of file
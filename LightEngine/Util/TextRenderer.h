@@ -2,6 +2,7 @@
 
 // Includes
 #include "Shader.h"
+#include "Telemetry.h"
 #include <string>
 #include "..\Contrib\Include\glm\vec3.hpp"
 #include "..\Contrib\Include\glm\vec2.hpp"
@@ -25,6 +26,7 @@ class TextRenderer
 public:
 
 	static Shader shader;
+	static UniformVec3 textColor;
 	static GLuint VAO, VBO;
 	static GLuint width, height;
 	static std::map<GLchar, Character> Characters;
@@ -40,10 +42,11 @@ public:
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 		// Compile and setup the shader
-		Shader shader("Shaders/text.vert", "Shaders/text.frag");
+		shader = Shader("Shaders/text.vert", "Shaders/text.frag");
 		glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(width), 0.0f, static_cast<GLfloat>(height));
 		shader.Use();
-		glUniformMatrix4fv(glGetUniformLocation(shader.program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+		UniformMat4(shader.GetUniform("projection")).Set(projection);
+		textColor = shader.GetUniform("textColor");
 
 		// FreeType
 		FT_Library ft;
@@ -51,9 +54,10 @@ public:
 		if (FT_Init_FreeType(&ft))
 			std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
 
-		// Load font as face
+		// Load font as face, from the pack or the loose file. FreeType reads it until FT_Done_Face().
 		FT_Face face;
-		if (FT_New_Face(ft, "Fonts/arial.ttf", 0, &face))
+		FileData font;
+		if (!FileSystem::ReadFile("Fonts/arial.ttf", font) || FT_New_Memory_Face(ft, font.GetData(), (FT_Long)font.GetSize(), 0, &face))
 			std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
 
 		// Set size to load glyphs as
@@ -123,7 +127,7 @@ public:
 	{
 		// Activate corresponding render state	
 		shader.Use();
-		glUniform3f(glGetUniformLocation(shader.program, "textColor"), color.x, color.y, color.z);
+		textColor.Set(color);
 		glActiveTexture(GL_TEXTURE0);
 		glBindVertexArray(VAO);
 
@@ -157,6 +161,7 @@ public:
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 			// Render quad
 			glDrawArrays(GL_TRIANGLES, 0, 6);
+			Telemetry::CountDraw(2);
 			// Now advance cursors for next glyph (note that advance is number of 1/64 pixels)
 			x += (ch.Advance >> 6) * scale; // Bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
 		}
@@ -171,6 +176,7 @@ public:
 };
 
 Shader TextRenderer::shader;
+UniformVec3 TextRenderer::textColor;
 GLuint TextRenderer::VAO;
 GLuint TextRenderer::VBO;
 GLuint TextRenderer::width;
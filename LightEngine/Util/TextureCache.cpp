@@ -0,0 +1,242 @@
+#include "TextureCache.h"
+
+namespace
+{
+	/*
+		Same texel data in another format is another texture.
+	*/
+	std::string FormatSuffix(GLint internalFormat)
+	{
+		char suffix[16];
+		_snprintf_s(suffix, sizeof(suffix), _TRUNCATE, "|%x", (unsigned int)internalFormat);
+		return suffix;
+	}
+}
+
+bool											TextureCache::hashContents = false;
+std::unordered_map<std::string, GLuint>			TextureCache::textures;
+std::unordered_map<GLuint, TextureCacheEntry>	TextureCache::entries;
+unsigned int									TextureCache::pathHits = 0;
+unsigned int									TextureCache::contentHits = 0;
+unsigned int									TextureCache::misses = 0;
+double											TextureCache::releasedSavedBytes = 0.0;
+
+/*
+	Resets the cache.
+
+	hashContents	-	Whether files that miss by path are
+						matched by their contents as well.
+*/
+void TextureCache::Init(bool hashContents)
+{
+	TextureCache::hashContents = hashContents;
+	textures.clear();
+	entries.clear();
+	pathHits = 0;
+	contentHits = 0;
+	misses = 0;
+	releasedSavedBytes = 0.0;
+
+	LOG_DEBUG(LOG_CATEGORY_ASSET, "Texture cache initialized.");
+}
+
+/*
+	2D texture of an image file, shared with everyone who
+	asked for the same file and format before. Has to be
+	given back with Release() once it isn't needed.
+
+	path			-	Image file, anything SOIL can load.
+	internalFormat	-	Format of the texture, e.g. GL_RGB or GL_SRGB.
+	placeholder		-	Color (0xRRGGBB) shown while the image streams in.
+*/
+GLuint TextureCache::Acquire2D(const char* path, GLint internalFormat, unsigned int placeholder)
+{
+	std::string key = FileSystem::NormalizePath(path) + FormatSuffix(internalFormat);
+
+	GLuint texture = Find(key);
+	if (texture != 0)
+	{
+		++pathHits;
+		return texture;
+	}
+
+	std::string contentKey;
+	if (hashContents)
+	{
+		FileData file;
+		if (FileSystem::ReadFile(path, file))
+		{
+			char hash[24];
+			_snprintf_s(hash, sizeof(hash), _TRUNCATE, "#%016llx", hashBytes(file.GetData(), file.GetSize()));
+			contentKey = hash + FormatSuffix(internalFormat);
+
+			texture = Find(contentKey);
+			if (texture != 0)
+			{
+				++contentHits;
+				textures[key] = texture;
+				entries[texture].keys.push_back(key);
+				LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_ASSET, "Texture %s has the same contents as a cached one.", path);
+				return texture;
+			}
+		}
+	}
+
+	++misses;
+	texture = TextureStreamer::Load2D(path, internalFormat, placeholder);
+	Insert(key, texture, GL_TEXTURE_2D);
+
+	if (!contentKey.empty())
+	{
+		textures[contentKey] = texture;
+		entries[texture].keys.push_back(contentKey);
+	}
+
+	return texture;
+}
+
+/*
+	Cubemap of six image files, shared by path like
+	Acquire2D(). Cubemaps aren't matched by contents.
+
+	faces	-	Image files in the order +X, -X, +Y, -Y, +Z, -Z.
+*/
+GLuint TextureCache::AcquireCubemap(const char* const* faces)
+{
+	std::string key = "cube";
+	for (int i = 0; i < 6; ++i)
+		key += "|" + FileSystem::NormalizePath(faces[i]);
+
+	GLuint texture = Find(key);
+	if (texture != 0)
+	{
+		++pathHits;
+		return texture;
+	}
+
+	++misses;
+	texture = TextureStreamer::LoadCubemap(faces);
+	Insert(key, texture, GL_TEXTURE_CUBE_MAP);
+	return texture;
+}
+
+/*
+	Gives back a texture from Acquire2D() or AcquireCubemap().
+	The texture is deleted when nobody holds it anymore.
+	Needs the GL context.
+
+	texture	-	Texture to release.
+*/
+void TextureCache::Release(GLuint texture)
+{
+	std::unordered_map<GLuint, TextureCacheEntry>::iterator entry = entries.find(texture);
+	if (entry == entries.end())
+	{
+		LOG_WARNING(LOG_CATEGORY_ASSET, "Released a texture that isn't in the texture cache.");
+		return;
+	}
+
+	if (--entry->second.references > 0)
+		return;
+
+	releasedSavedBytes += (entry->second.acquisitions - 1) * EstimateBytes(texture, entry->second.target);
+
+	for (size_t i = 0; i < entry->second.keys.size(); ++i)
+		textures.erase(entry->second.keys[i]);
+	entries.erase(entry);
+
+	glDeleteTextures(1, &texture);
+}
+
+/*
+	Current counters. The byte counts are read back from
+	the textures, so they need the GL context and only
+	include images that have finished streaming.
+*/
+void TextureCache::GetStats(TextureCacheStats& stats)
+{
+	stats.pathHits = pathHits;
+	stats.contentHits = contentHits;
+	stats.misses = misses;
+	stats.textures = (unsigned int)entries.size();
+	stats.residentBytes = 0.0;
+	stats.savedBytes = releasedSavedBytes;
+
+	for (std::unordered_map<GLuint, TextureCacheEntry>::iterator entry = entries.begin(); entry != entries.end(); ++entry)
+	{
+		double bytes = EstimateBytes(entry->first, entry->second.target);
+		stats.residentBytes += bytes;
+		stats.savedBytes += (entry->second.acquisitions - 1) * bytes;
+	}
+}
+
+/*
+	Logs the counters and forgets every texture. The
+	owners release theirs before this, any texture still
+	held is freed with the context. Call while the
+	context still exists.
+*/
+void TextureCache::Shutdown(void)
+{
+	TextureCacheStats stats;
+	GetStats(stats);
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "Texture cache : %u textures (%.1f MB), hits : %u by path, %u by contents, misses : %u, %.1f MB saved.",
+		stats.textures, stats.residentBytes / (1024.0 * 1024.0), stats.pathHits, stats.contentHits, stats.misses, stats.savedBytes / (1024.0 * 1024.0));
+
+	textures.clear();
+	entries.clear();
+}
+
+/*
+	Texture of a key, with one more reference taken,
+	or 0 if the key isn't cached.
+*/
+GLuint TextureCache::Find(const std::string& key)
+{
+	std::unordered_map<std::string, GLuint>::iterator texture = textures.find(key);
+	if (texture == textures.end())
+		return 0;
+
+	TextureCacheEntry& entry = entries[texture->second];
+	++entry.references;
+	++entry.acquisitions;
+	return texture->second;
+}
+
+/*
+	Adds a newly loaded texture with one reference.
+*/
+void TextureCache::Insert(const std::string& key, GLuint texture, GLenum target)
+{
+	TextureCacheEntry& entry = entries[texture];
+	entry.target = target;
+	entry.references = 1;
+	entry.acquisitions = 1;
+	entry.keys.push_back(key);
+
+	textures[key] = texture;
+}
+
+/*
+	Video memory of a texture, assuming 4 bytes per texel
+	(drivers pad RGB) and a full mip chain for 2D textures.
+	Block compressed textures use the size of their base
+	level instead.
+*/
+double TextureCache::EstimateBytes(GLuint texture, GLenum target)
+{
+	GLint width = 0, height = 0, compressed = GL_FALSE, compressedSize = 0;
+	GLenum level = (target == GL_TEXTURE_CUBE_MAP) ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : GL_TEXTURE_2D;
+
+	glBindTexture(target, texture);
+	glGetTexLevelParameteriv(level, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(level, 0, GL_TEXTURE_HEIGHT, &height);
+	glGetTexLevelParameteriv(level, 0, GL_TEXTURE_COMPRESSED, &compressed);
+	if (compressed == GL_TRUE)
+		glGetTexLevelParameteriv(level, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressedSize);
+	glBindTexture(target, 0);
+
+	double bytes = (compressed == GL_TRUE) ? (double)compressedSize : (double)width * height * 4.0;
+	return (target == GL_TEXTURE_CUBE_MAP) ? bytes * 6.0 : bytes * 4.0 / 3.0;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+// Includes.
+#include "TextureStreamer.h"
+#include "FileSystem.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/*
+	Counters of the texture cache.
+
+	pathHits		-	Acquisitions served by an already loaded path.
+	contentHits		-	Acquisitions of a new path whose file matched
+						the contents of a loaded one.
+	misses			-	Acquisitions that loaded a texture.
+	textures		-	Textures currently held.
+	residentBytes	-	Estimated video memory of those textures.
+	savedBytes		-	Estimated video memory the hits didn't allocate.
+*/
+struct TextureCacheStats
+{
+	unsigned int	pathHits;
+	unsigned int	contentHits;
+	unsigned int	misses;
+	unsigned int	textures;
+	double			residentBytes;
+	double			savedBytes;
+};
+
+/*
+	A texture held by the cache.
+
+	target			-	GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP.
+	references		-	Acquisitions not yet released.
+	acquisitions	-	Acquisitions in total, hits included.
+	keys			-	Cache keys that lead to this texture.
+*/
+struct TextureCacheEntry
+{
+	GLenum						target;
+	unsigned int				references;
+	unsigned int				acquisitions;
+	std::vector<std::string>	keys;
+};
+
+/*
+	Engine-wide, reference-counted texture cache. Textures
+	are keyed by their normalized path and format, so every
+	object that asks for the same file shares one texture.
+	With content hashing on, a file that isn't cached by
+	path is also hashed and matched against the contents
+	of the loaded files, which catches copies of a texture
+	under another name.
+
+	Misses are loaded through the TextureStreamer, so the
+	returned texture may still hold its placeholder.
+*/
+class TextureCache
+{
+public:
+
+// Functions
+
+	static void Init(bool hashContents);
+	static GLuint Acquire2D(const char* path, GLint internalFormat, unsigned int placeholder = TEXTURE_PLACEHOLDER_GREY);
+	static GLuint AcquireCubemap(const char* const* faces);
+	static void Release(GLuint texture);
+	static void GetStats(TextureCacheStats& stats);
+	static void Shutdown(void);
+
+private:
+
+// Functions
+
+	static GLuint Find(const std::string& key);
+	static void Insert(const std::string& key, GLuint texture, GLenum target);
+	static double EstimateBytes(GLuint texture, GLenum target);
+
+// Variables
+
+	static bool												hashContents;
+	static std::unordered_map<std::string, GLuint>			textures;		// Key to texture.
+	static std::unordered_map<GLuint, TextureCacheEntry>	entries;
+	static unsigned int										pathHits;
+	static unsigned int										contentHits;
+	static unsigned int										misses;
+	static double											releasedSavedBytes;	// Saved by entries that are gone.
+};
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "TextureCooker.h"
+#include "Profiler.h"
+
+/*
+	Whether textures of a format can be cooked.
+
+	internalFormat	-	Format the texture is asked for in.
+*/
+bool TextureCooker::IsCookable(GLint internalFormat)
+{
+	return getFormatTag(internalFormat) != NULL;
+}
+
+/*
+	Block format of a texture, 0 if it can't be cooked.
+
+	internalFormat	-	Format the texture is asked for in.
+	opaque			-	Whether every pixel of the image is opaque.
+*/
+GLenum TextureCooker::GetCompressedFormat(GLint internalFormat, bool opaque)
+{
+	switch (internalFormat)
+	{
+	case GL_RGB:
+	case GL_RGB8:
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case GL_SRGB:
+	case GL_SRGB8:
+		return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+	case GL_RGBA:
+	case GL_RGBA8:
+		return opaque ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case GL_SRGB_ALPHA:
+	case GL_SRGB8_ALPHA8:
+		return opaque ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+	case GL_RG:
+	case GL_RG8:
+		return GL_COMPRESSED_RG_RGTC2;
+	default:
+		return 0;
+	}
+}
+
+/*
+	Path of the cooked file of an image, e.g.
+	"floor_normal.bmp.rg.ktx", or an empty string if the
+	format can't be cooked. The same image asked for in
+	another format is cooked to another file.
+
+	path			-	Image file.
+	internalFormat	-	Format the texture is asked for in.
+*/
+std::string TextureCooker::GetCookedPath(const char* path, GLint internalFormat)
+{
+	const char* tag = getFormatTag(internalFormat);
+	if (tag == NULL)
+		return std::string();
+
+	return std::string(path) + "." + tag + ".ktx";
+}
+
+/*
+	Whether a cooked file exists and is newer than its
+	image, which may be packed.
+
+	cookedPath	-	Path to the .ktx file.
+	sourcePath	-	Path to the image it was cooked from.
+*/
+bool TextureCooker::IsFresh(const char* cookedPath, const char* sourcePath)
+{
+	unsigned long long cookedTime, sourceTime;
+	if (!getFileWriteTime(cookedPath, cookedTime) || !FileSystem::GetWriteTime(sourcePath, sourceTime))
+		return false;
+
+	return cookedTime > sourceTime;
+}
+
+/*
+	Decodes an image, builds its mip chain down to 1x1 with
+	the MipGenerator, encodes every level and writes them
+	to a KTX file.
+
+	path			-	Image file, anything SOIL can load.
+	internalFormat	-	Format the texture is asked for in, it
+						also picks how the mips are filtered.
+	mipmaps			-	Whether to store the mip chain or only level 0.
+	cookedPath		-	KTX file to write.
+	filter			-	Filter the mips are resampled with.
+	pool			-	Threads to filter and encode on, may be
+						NULL. Not the pool of the calling task.
+*/
+bool TextureCooker::Cook(const char* path, GLint internalFormat, bool mipmaps, const char* cookedPath, MipFilter filter, ThreadPool* pool)
+{
+	PROFILE_SCOPE_DETAIL("TextureCooker::Cook", path);
+	double start = getTimeElapsed();
+
+	if (!IsCookable(internalFormat))
+		return false;
+
+	int width, height, channels;
+	FileData source;
+	unsigned char* pixels = NULL;
+	if (FileSystem::ReadFile(path, source))
+		pixels = SOIL_load_image_from_memory(source.GetData(), (int)source.GetSize(), &width, &height, &channels, SOIL_LOAD_RGBA);
+	if (pixels == NULL)
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Could not load texture %s", path);
+		return false;
+	}
+
+	bool opaque = true;
+	for (size_t i = 3; opaque && i < (size_t)width * height * 4; i += 4)
+		opaque = pixels[i] == 255;
+
+	GLenum format = GetCompressedFormat(internalFormat, opaque);
+
+	std::vector<MipLevel> mips;
+	if (mipmaps)
+		MipGenerator::Generate(pixels, (unsigned int)width, (unsigned int)height, 4, MipGenerator::GetContent(internalFormat), filter, mips, pool);
+
+	std::vector<std::vector<unsigned char> > levels(mips.size() + 1);
+	size_t cookedSize = 0;
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		const unsigned char* image = (i == 0) ? pixels : &mips[i - 1].pixels[0];
+		unsigned int levelWidth = (i == 0) ? (unsigned int)width : mips[i - 1].width;
+		unsigned int levelHeight = (i == 0) ? (unsigned int)height : mips[i - 1].height;
+
+		levels[i].resize(BlockCompressor::GetImageSize(format, levelWidth, levelHeight));
+		BlockCompressor::Encode(image, levelWidth, levelHeight, format, &levels[i][0], pool);
+		cookedSize += levels[i].size();
+	}
+	SOIL_free_image_data(pixels);
+
+	if (!KtxFile::Write(cookedPath, format, getBaseFormat(format), (unsigned int)width, (unsigned int)height, levels))
+	{
+		LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Could not write cooked texture %s", cookedPath);
+		return false;
+	}
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "Texture cooked in %.1f ms: %s (%dx%d, %u levels, %u KB, was %u KB)", (getTimeElapsed() - start) * 1000.0,
+		cookedPath, width, height, (unsigned int)levels.size(), (unsigned int)(cookedSize / 1024), (unsigned int)((size_t)width * height * (mipmaps ? 16 : 12) / 3 / 1024));
+	return true;
+}
+
+/*
+	Reads the cooked file of an image, cooking it first if
+	it is missing, older than the image or lacks the mip
+	chain. Returns false if the format can't be cooked or
+	the image can't be loaded.
+
+	path			-	Image file.
+	internalFormat	-	Format the texture is asked for in.
+	mipmaps			-	Whether the texture needs its mip chain.
+	file			-	Receives the cooked texture.
+*/
+bool TextureCooker::Load(const char* path, GLint internalFormat, bool mipmaps, KtxFile& file)
+{
+	std::string cookedPath = GetCookedPath(path, internalFormat);
+	if (cookedPath.empty())
+		return false;
+
+	if (IsFresh(cookedPath.c_str(), path) && file.Read(cookedPath.c_str()))
+	{
+		bool complete = !mipmaps || file.GetLevelCount() > 1 || (file.GetWidth() == 1 && file.GetHeight() == 1);
+		if (complete)
+			return true;
+	}
+
+	return Cook(path, internalFormat, mipmaps, cookedPath.c_str()) && file.Read(cookedPath.c_str());
+}
+
+/*
+	Part of the cooked file name for a format, NULL if it
+	can't be cooked.
+*/
+const char* TextureCooker::getFormatTag(GLint internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_RGB:
+	case GL_RGB8:
+		return "rgb";
+	case GL_SRGB:
+	case GL_SRGB8:
+		return "srgb";
+	case GL_RGBA:
+	case GL_RGBA8:
+		return "rgba";
+	case GL_SRGB_ALPHA:
+	case GL_SRGB8_ALPHA8:
+		return "srgba";
+	case GL_RG:
+	case GL_RG8:
+		return "rg";
+	default:
+		return NULL;
+	}
+}
+
+/*
+	Uncompressed base format of a block format, as KTX
+	files record it.
+*/
+GLenum TextureCooker::getBaseFormat(GLenum compressedFormat)
+{
+	switch (compressedFormat)
+	{
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		return GL_RGBA;
+	case GL_COMPRESSED_RG_RGTC2:
+		return GL_RG;
+	default:
+		return GL_RGB;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+// Includes.
+#include <string>
+#include <vector>
+#include "..\Contrib\Include\gl\glew.h"
+#include "..\Contrib\Include\SOIL.h"
+#include "Utility.h"
+#include "ThreadPool.h"
+#include "BlockCompressor.h"
+#include "KtxFile.h"
+#include "MipGenerator.h"
+#include "FileSystem.h"
+
+/*
+	Cooks image files into block compressed KTX files with
+	their full mip chain (see MipGenerator), stored next
+	to the image (see GetCookedPath()). The texture format
+	a caller asks for picks the block format :
+
+		GL_RGB, GL_SRGB			-	BC1.
+		GL_RGBA, GL_SRGB_ALPHA	-	BC3, or BC1 if the image
+									is opaque.
+		GL_RG					-	BC5, for normal maps.
+
+	Load() uses the cooked file as long as it is newer
+	than the image, and cooks it again otherwise.
+*/
+class TextureCooker
+{
+public:
+
+// Functions
+
+	static bool IsCookable(GLint internalFormat);
+	static GLenum GetCompressedFormat(GLint internalFormat, bool opaque);
+	static std::string GetCookedPath(const char* path, GLint internalFormat);
+	static bool IsFresh(const char* cookedPath, const char* sourcePath);
+	static bool Cook(const char* path, GLint internalFormat, bool mipmaps, const char* cookedPath, MipFilter filter = MIP_FILTER_KAISER, ThreadPool* pool = NULL);
+	static bool Load(const char* path, GLint internalFormat, bool mipmaps, KtxFile& file);
+
+private:
+
+// Functions
+
+	static const char* getFormatTag(GLint internalFormat);
+	static GLenum getBaseFormat(GLenum compressedFormat);
+};
\ No newline at end of file
@@ -0,0 +1,529 @@
+#include "TextureStreamer.h"
+#include "Profiler.h"
+#include <cstring>
+
+bool								TextureStreamer::initialized = false;
+bool								TextureStreamer::compression = true;
+bool								TextureStreamer::cpuMipmaps = true;
+ThreadPool*							TextureStreamer::pool = NULL;
+std::mutex							TextureStreamer::mutex;
+std::condition_variable				TextureStreamer::decoded;
+std::deque<TextureStreamRequest*>	TextureStreamer::ready;
+unsigned int						TextureStreamer::decoding = 0;
+bool								TextureStreamer::cancelled = false;
+unsigned int						TextureStreamer::pending = 0;
+TextureStreamBuffer					TextureStreamer::buffers[TEXTURE_STREAM_PBO_COUNT];
+unsigned int						TextureStreamer::nextBuffer = 0;
+unsigned int						TextureStreamer::uploadCount = 0;
+double								TextureStreamer::uploadBytes = 0.0;
+
+/*
+	Creates the pixel buffers of the upload ring and turns
+	compression off if the driver can't sample the cooked
+	formats. Needs the GL context.
+
+	pool	-	Threads to decode on, NULL to decode while
+				loading, on the calling thread.
+*/
+void TextureStreamer::Init(ThreadPool* pool)
+{
+	TextureStreamer::pool = pool;
+	cancelled = false;
+	nextBuffer = 0;
+	uploadCount = 0;
+	uploadBytes = 0.0;
+
+	for (unsigned int i = 0; i < TEXTURE_STREAM_PBO_COUNT; ++i)
+	{
+		glGenBuffers(1, &buffers[i].buffer);
+		buffers[i].capacity = 0;
+		buffers[i].fence = NULL;
+	}
+
+	// DXT1/DXT5 aren't core in GL 3.3, and their sRGB variants come with EXT_texture_sRGB.
+	if (compression && (!GLEW_EXT_texture_compression_s3tc || !GLEW_EXT_texture_sRGB))
+	{
+		LOG_WARNING(LOG_CATEGORY_ASSET, "S3TC textures not supported, texture compression disabled.");
+		compression = false;
+	}
+
+	initialized = true;
+
+	LOG_DEBUG(LOG_CATEGORY_ASSET, "Texture streamer initialized.");
+}
+
+/*
+	Creates a 2D texture with a placeholder and queues its
+	image. The texture repeats and is trilinearly filtered,
+	mipmaps come with the cooked file or are generated when
+	the image arrives.
+
+	path			-	Image file, anything SOIL can load.
+	internalFormat	-	Format of the texture, e.g. GL_RGB, GL_SRGB or
+						GL_RG for normal maps.
+	placeholder		-	Color (0xRRGGBB) shown until then.
+*/
+GLuint TextureStreamer::Load2D(const char* path, GLint internalFormat, unsigned int placeholder)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	SetPlaceholder(GL_TEXTURE_2D, placeholder);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	Queue(path, texture, GL_TEXTURE_2D, GL_TEXTURE_2D, internalFormat, true);
+	return texture;
+}
+
+/*
+	Creates a cubemap with placeholder faces and queues
+	its six images. The cubemap is clamped and linearly
+	filtered, without mipmaps.
+
+	faces	-	Image files in the order +X, -X, +Y, -Y, +Z, -Z.
+*/
+GLuint TextureStreamer::LoadCubemap(const char* const* faces)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	for (GLenum i = 0; i < 6; ++i)
+		SetPlaceholder(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, TEXTURE_PLACEHOLDER_GREY);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	for (GLenum i = 0; i < 6; ++i)
+		Queue(faces[i], texture, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, GL_RGB, false);
+
+	return texture;
+}
+
+/*
+	Uploads decoded images, at most TEXTURE_STREAM_FRAME_BUDGET
+	bytes (but at least one image) per call. Called once per
+	frame on the render thread.
+*/
+void TextureStreamer::Update(void)
+{
+	Stream(TEXTURE_STREAM_FRAME_BUDGET);
+}
+
+/*
+	Blocks until every queued texture has been uploaded,
+	e.g. so that benchmarks start with all textures in
+	place.
+*/
+void TextureStreamer::Finish(void)
+{
+	PROFILE_SCOPE("TextureStreamer::Finish");
+
+	for (;;)
+	{
+		Stream(0xFFFFFFFF);
+		if (GetPendingCount() == 0)
+			break;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		if (ready.empty())
+		{
+			decoded.wait(lock, []() { return !ready.empty() || decoding == 0; });
+		}
+		else
+		{
+			// Every pixel buffer is still in use, let the GPU catch up.
+			lock.unlock();
+			glFinish();
+		}
+	}
+}
+
+/*
+	Number of textures that are queued, decoding or
+	waiting for upload.
+*/
+unsigned int TextureStreamer::GetPendingCount(void)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pending;
+}
+
+/*
+	Turns loading cooked, block compressed textures on or
+	off for the textures queued afterwards.
+
+	enabled	-	Whether textures are loaded from cooked files.
+*/
+void TextureStreamer::SetCompression(bool enabled)
+{
+	compression = enabled;
+}
+
+/*
+	Whether textures are loaded from cooked files.
+*/
+bool TextureStreamer::IsCompressionEnabled(void)
+{
+	return compression;
+}
+
+/*
+	Chooses between mips built on the decode threads and
+	glGenerateMipmap() for uncompressed textures queued
+	afterwards.
+
+	enabled	-	Whether mips are built on the CPU.
+*/
+void TextureStreamer::SetCpuMipmaps(bool enabled)
+{
+	cpuMipmaps = enabled;
+}
+
+/*
+	Whether mips of uncompressed textures are built on
+	the CPU.
+*/
+bool TextureStreamer::IsCpuMipmapsEnabled(void)
+{
+	return cpuMipmaps;
+}
+
+/*
+	Waits for the decodes that are still running, drops
+	everything that wasn't uploaded and frees the pixel
+	buffers. Textures keep their placeholders. Call before
+	the context is destroyed and before the pool is.
+*/
+void TextureStreamer::Shutdown(void)
+{
+	if (!initialized)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cancelled = true;
+		decoded.wait(lock, []() { return decoding == 0; });
+
+		while (!ready.empty())
+		{
+			FreeRequest(ready.front());
+			ready.pop_front();
+		}
+		pending = 0;
+	}
+
+	for (unsigned int i = 0; i < TEXTURE_STREAM_PBO_COUNT; ++i)
+	{
+		if (buffers[i].fence != NULL)
+			glDeleteSync(buffers[i].fence);
+		glDeleteBuffers(1, &buffers[i].buffer);
+		buffers[i].fence = NULL;
+	}
+
+	LOG_FORMAT(LOG_LEVEL_INFO, LOG_CATEGORY_ASSET, "Texture streamer : %u images uploaded, %.1f MB.", uploadCount, uploadBytes / (1024.0 * 1024.0));
+
+	pool = NULL;
+	initialized = false;
+}
+
+/*
+	Frees the pixel buffers the GPU is done with, then
+	uploads decoded images until the budget is used up
+	or the ring is full.
+
+	budget	-	Bytes to upload, the first image always goes.
+*/
+void TextureStreamer::Stream(unsigned int budget)
+{
+	PROFILE_SCOPE("TextureStreamer::Update");
+
+	RetireBuffers();
+
+	unsigned int uploaded = 0;
+	for (;;)
+	{
+		TextureStreamRequest* request;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (ready.empty())
+				break;
+			request = ready.front();
+		}
+
+		unsigned int size = GetUploadSize(request);
+		if (request->pixels != NULL || request->compressed != NULL)
+		{
+			if (uploaded > 0 && size > budget - uploaded)
+				break;
+			if (!Upload(request))
+				break;
+
+			uploaded += size;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ready.pop_front();
+			--pending;
+		}
+		FreeRequest(request);
+
+		if (uploaded >= budget)
+			break;
+	}
+}
+
+/*
+	Creates the request for one image and hands it to the
+	pool for decoding.
+*/
+void TextureStreamer::Queue(const char* path, GLuint texture, GLenum bindTarget, GLenum imageTarget, GLint internalFormat, bool mipmaps)
+{
+	TextureStreamRequest* request = new TextureStreamRequest();
+	request->path = path;
+	request->texture = texture;
+	request->bindTarget = bindTarget;
+	request->imageTarget = imageTarget;
+	request->internalFormat = internalFormat;
+	request->mipmaps = mipmaps;
+	request->width = 0;
+	request->height = 0;
+	request->pixels = NULL;
+	request->compressed = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		++pending;
+		++decoding;
+	}
+
+	if (pool != NULL)
+		pool->Submit([request]() { Decode(request); });
+	else
+		Decode(request);
+}
+
+/*
+	Decodes the image of a request and queues it for
+	upload, or with compression on reads its cooked file.
+	Runs on a pool thread.
+*/
+void TextureStreamer::Decode(TextureStreamRequest* request)
+{
+	bool skip;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		skip = cancelled;
+	}
+
+	if (!skip)
+	{
+		PROFILE_SCOPE_DETAIL("TextureStreamer::Decode", request->path.c_str());
+
+		if (compression && TextureCooker::IsCookable(request->internalFormat))
+		{
+			KtxFile* file = new KtxFile();
+			if (TextureCooker::Load(request->path.c_str(), request->internalFormat, request->mipmaps, *file))
+			{
+				request->compressed = file;
+				request->width = (int)file->GetWidth();
+				request->height = (int)file->GetHeight();
+			}
+			else
+			{
+				delete file;
+			}
+		}
+
+		if (request->compressed == NULL)
+		{
+			FileData file;
+			if (FileSystem::ReadFile(request->path.c_str(), file))
+				request->pixels = SOIL_load_image_from_memory(file.GetData(), (int)file.GetSize(), &request->width, &request->height, 0, SOIL_LOAD_RGB);
+			if (request->pixels == NULL)
+				LOG_FORMAT(LOG_LEVEL_WARNING, LOG_CATEGORY_ASSET, "Could not load texture %s", request->path.c_str());
+			else if (request->mipmaps && cpuMipmaps)
+				MipGenerator::Generate(request->pixels, request->width, request->height, 3, MipGenerator::GetContent(request->internalFormat), MIP_FILTER_KAISER, request->mips);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready.push_back(request);
+		--decoding;
+	}
+	decoded.notify_all();
+}
+
+/*
+	Copies a decoded image or cooked file into the next
+	pixel buffer of the ring and re-specifies the texture
+	from it. Returns false if that buffer is still being
+	read by the GPU.
+*/
+bool TextureStreamer::Upload(TextureStreamRequest* request)
+{
+	TextureStreamBuffer& slot = buffers[nextBuffer];
+	if (slot.fence != NULL)
+		return false;
+
+	GLsizeiptr size = (GLsizeiptr)GetUploadSize(request);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+	if (slot.capacity < size)
+	{
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+		slot.capacity = size;
+	}
+
+	// The fence has passed, so the buffer can be written without waiting.
+	bool mapped = false;
+	void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (data != NULL)
+	{
+		unsigned char* target = (unsigned char*)data;
+		if (request->compressed != NULL)
+		{
+			memcpy(target, request->compressed->GetData(), size);
+		}
+		else
+		{
+			// The mips follow the image.
+			size_t offset = (size_t)request->width * request->height * 3;
+			memcpy(target, request->pixels, offset);
+			for (size_t i = 0; i < request->mips.size(); ++i)
+			{
+				memcpy(target + offset, &request->mips[i].pixels[0], request->mips[i].pixels.size());
+				offset += request->mips[i].pixels.size();
+			}
+		}
+		mapped = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+	}
+
+	// Fall back to a plain upload from client memory.
+	if (!mapped)
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// SOIL rows are tightly packed.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(request->bindTarget, request->texture);
+	if (request->compressed != NULL)
+	{
+		// Every level is at its offset into the file, which is at the start of the buffer.
+		const KtxFile& file = *request->compressed;
+		for (unsigned int i = 0; i < file.GetLevelCount(); ++i)
+		{
+			const KtxLevel& level = file.GetLevel(i);
+			glCompressedTexImage2D(request->imageTarget, i, file.GetInternalFormat(), level.width, level.height, 0, (GLsizei)level.size,
+				mapped ? (const GLvoid*)level.offset : file.GetData() + level.offset);
+		}
+		if (request->bindTarget == GL_TEXTURE_2D)
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, file.GetLevelCount() - 1);
+	}
+	else
+	{
+		glTexImage2D(request->imageTarget, 0, request->internalFormat, request->width, request->height, 0, GL_RGB, GL_UNSIGNED_BYTE, mapped ? NULL : request->pixels);
+
+		size_t offset = (size_t)request->width * request->height * 3;
+		for (size_t i = 0; i < request->mips.size(); ++i)
+		{
+			const MipLevel& mip = request->mips[i];
+			glTexImage2D(request->imageTarget, (GLint)i + 1, request->internalFormat, mip.width, mip.height, 0, GL_RGB, GL_UNSIGNED_BYTE,
+				mapped ? (const GLvoid*)offset : &mip.pixels[0]);
+			offset += mip.pixels.size();
+		}
+
+		if (request->mipmaps && request->mips.empty())
+			glGenerateMipmap(request->bindTarget);
+	}
+	glBindTexture(request->bindTarget, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (mapped)
+	{
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		nextBuffer = (nextBuffer + 1) % TEXTURE_STREAM_PBO_COUNT;
+	}
+
+	++uploadCount;
+	uploadBytes += (double)size;
+
+	LOG_FORMAT(LOG_LEVEL_DEBUG, LOG_CATEGORY_ASSET, "Texture streamed: %s", request->path.c_str());
+	return true;
+}
+
+/*
+	Bytes a request copies into a pixel buffer : the
+	whole cooked file, or the decoded image and its mips.
+*/
+unsigned int TextureStreamer::GetUploadSize(const TextureStreamRequest* request)
+{
+	if (request->compressed != NULL)
+		return (unsigned int)request->compressed->GetDataSize();
+
+	size_t size = (size_t)request->width * request->height * 3;
+	for (size_t i = 0; i < request->mips.size(); ++i)
+		size += request->mips[i].pixels.size();
+	return (unsigned int)size;
+}
+
+/*
+	Frees a request and the image it holds.
+*/
+void TextureStreamer::FreeRequest(TextureStreamRequest* request)
+{
+	if (request->pixels != NULL)
+		SOIL_free_image_data(request->pixels);
+	delete request->compressed;
+	delete request;
+}
+
+/*
+	Frees the pixel buffers whose fence has passed.
+*/
+void TextureStreamer::RetireBuffers(void)
+{
+	for (unsigned int i = 0; i < TEXTURE_STREAM_PBO_COUNT; ++i)
+	{
+		if (buffers[i].fence == NULL)
+			continue;
+
+		GLenum result = glClientWaitSync(buffers[i].fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+		{
+			glDeleteSync(buffers[i].fence);
+			buffers[i].fence = NULL;
+		}
+	}
+}
+
+/*
+	Fills level 0 of the bound texture with a single texel.
+
+	imageTarget	-	GL_TEXTURE_2D or a cube face.
+	color		-	0xRRGGBB.
+*/
+void TextureStreamer::SetPlaceholder(GLenum imageTarget, unsigned int color)
+{
+	unsigned char texel[3] = {
+		(unsigned char)((color >> 16) & 0xFF),
+		(unsigned char)((color >> 8) & 0xFF),
+		(unsigned char)(color & 0xFF)
+	};
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(imageTarget, 0, GL_RGB8, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, texel);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
\ No newline at end of file
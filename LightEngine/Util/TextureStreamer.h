@@ -0,0 +1,139 @@
+#pragma once
+
+// Includes.
+#include "..\Contrib\Include\gl\glew.h"
+#include "..\Contrib\Include\SOIL.h"
+#include "Utility.h"
+#include "ThreadPool.h"
+#include "TextureCooker.h"
+#include "MipGenerator.h"
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <string>
+
+// Pixel buffers in the upload ring.
+const unsigned int TEXTURE_STREAM_PBO_COUNT = 4;
+
+// Bytes uploaded per Update() call, at least one image is always uploaded.
+const unsigned int TEXTURE_STREAM_FRAME_BUDGET = 8 * 1024 * 1024;
+
+// Placeholder colors (0xRRGGBB) shown until a texture has arrived.
+const unsigned int TEXTURE_PLACEHOLDER_GREY = 0x808080;
+const unsigned int TEXTURE_PLACEHOLDER_NORMAL = 0x8080FF;
+
+/*
+	One image on its way to the GPU.
+
+	path			-	File the image is decoded from.
+	texture			-	Texture it ends up in.
+	bindTarget		-	GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP.
+	imageTarget		-	Target of the glTexImage2D() call, e.g. a cube face.
+	internalFormat	-	Format of the texture, e.g. GL_SRGB.
+	mipmaps			-	Whether the texture gets mipmaps.
+	width, height	-	Size of the decoded image.
+	pixels			-	Decoded RGB data, NULL until decoded or if decoding failed.
+	mips			-	Mip levels built from pixels, empty if the
+						GL generates them.
+	compressed		-	Cooked texture with its mip chain, used
+						instead of pixels if not NULL.
+*/
+struct TextureStreamRequest
+{
+	std::string		path;
+	GLuint			texture;
+	GLenum			bindTarget;
+	GLenum			imageTarget;
+	GLint			internalFormat;
+	bool			mipmaps;
+	int				width;
+	int				height;
+	unsigned char*	pixels;
+	std::vector<MipLevel>	mips;
+	KtxFile*		compressed;
+};
+
+/*
+	Pixel buffer of the upload ring. fence is set once
+	the buffer has been used and until the GL is done
+	reading from it.
+*/
+struct TextureStreamBuffer
+{
+	GLuint		buffer;
+	GLsizeiptr	capacity;
+	GLsync		fence;
+};
+
+/*
+	Loads textures without blocking the render thread.
+
+	Load2D() and LoadCubemap() return a texture right away,
+	holding a 1x1 placeholder. The image is decoded by a
+	job on the ThreadPool, and Update() (once per frame, on
+	the render thread) copies decoded images into a ring of
+	pixel buffers and re-specifies the texture from there.
+	Every copy is followed by a fence, and a buffer is only
+	written again once its fence has passed, so the copies
+	never wait for the GPU. Callers keep the texture name
+	they were given; only its contents change.
+
+	With compression on, the decode job loads the image's
+	cooked KTX file instead (see TextureCooker), cooking it
+	on the spot the first time. Its block compressed mip
+	chain is uploaded with glCompressedTexImage2D(), so no
+	mipmaps are generated at runtime. Drivers without S3TC
+	get the uncompressed path.
+
+	Uncompressed images get their mips from the
+	MipGenerator on the decode job too, unless CPU mipmaps
+	are turned off and glGenerateMipmap() is used instead.
+*/
+class TextureStreamer
+{
+public:
+
+// Functions
+
+	static void Init(ThreadPool* pool);
+	static GLuint Load2D(const char* path, GLint internalFormat, unsigned int placeholder = TEXTURE_PLACEHOLDER_GREY);
+	static GLuint LoadCubemap(const char* const* faces);
+	static void Update(void);
+	static void Finish(void);
+	static unsigned int GetPendingCount(void);
+	static void SetCompression(bool enabled);
+	static bool IsCompressionEnabled(void);
+	static void SetCpuMipmaps(bool enabled);
+	static bool IsCpuMipmapsEnabled(void);
+	static void Shutdown(void);
+
+private:
+
+// Functions
+
+	static void Stream(unsigned int budget);
+	static void Queue(const char* path, GLuint texture, GLenum bindTarget, GLenum imageTarget, GLint internalFormat, bool mipmaps);
+	static void Decode(TextureStreamRequest* request);
+	static bool Upload(TextureStreamRequest* request);
+	static void RetireBuffers(void);
+	static unsigned int GetUploadSize(const TextureStreamRequest* request);
+	static void FreeRequest(TextureStreamRequest* request);
+	static void SetPlaceholder(GLenum imageTarget, unsigned int color);
+
+// Variables
+
+	static bool									initialized;
+	static bool									compression;
+	static bool									cpuMipmaps;
+	static ThreadPool*							pool;
+	static std::mutex							mutex;
+	static std::condition_variable				decoded;		// Signals a finished decode.
+	static std::deque<TextureStreamRequest*>	ready;			// Decoded, waiting for upload.
+	static unsigned int							decoding;		// Jobs that haven't finished yet.
+	static bool									cancelled;
+	static unsigned int							pending;		// Requests not yet uploaded.
+	static TextureStreamBuffer					buffers[TEXTURE_STREAM_PBO_COUNT];
+	static unsigned int							nextBuffer;
+	static unsigned int							uploadCount;
+	static double								uploadBytes;
+};
\ No newline at end of file
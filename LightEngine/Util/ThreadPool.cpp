@@ -0,0 +1,148 @@
+#include "ThreadPool.h"
+
+/*
+	Starts the workers.
+
+	threadCount	-	Threads that run a loop, including the
+					calling one. 0 is treated as 1.
+*/
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	task = NULL;
+	taskCount = 0;
+	nextTask = 0;
+	finishedTasks = 0;
+	stopping = false;
+
+	for (unsigned int i = 1; i < threadCount; ++i)
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+}
+
+/*
+	Runs task(0) to task(count - 1) across the pool and
+	returns once all of them have finished. The order in
+	which iterations run is undefined.
+
+	count	-	Number of iterations.
+	task	-	Called once per iteration with its index.
+*/
+void ThreadPool::ParallelFor(unsigned int count, const std::function<void(unsigned int)>& task)
+{
+	if (workers.empty() || count <= 1)
+	{
+		for (unsigned int i = 0; i < count; ++i)
+			task(i);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	this->task = &task;
+	taskCount = count;
+	nextTask = 0;
+	finishedTasks = 0;
+	wake.notify_all();
+
+	// Help out until every iteration has been taken.
+	while (nextTask < taskCount)
+	{
+		unsigned int index = nextTask++;
+		lock.unlock();
+		task(index);
+		lock.lock();
+		++finishedTasks;
+	}
+
+	done.wait(lock, [this]() { return finishedTasks == taskCount; });
+	this->task = NULL;
+}
+
+/*
+	Queues a job to run on a worker and returns at once.
+	A pool without workers runs the job right away.
+	Jobs still queued when the pool is destroyed are run
+	before the workers exit.
+
+	job	-	Function to run.
+*/
+void ThreadPool::Submit(const std::function<void()>& job)
+{
+	if (workers.empty())
+	{
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(job);
+	}
+	wake.notify_one();
+}
+
+/*
+	Threads that run a loop, including the calling one.
+*/
+unsigned int ThreadPool::GetThreadCount(void) const
+{
+	return (unsigned int)workers.size() + 1;
+}
+
+/*
+	One thread per hardware thread of the machine.
+*/
+unsigned int ThreadPool::GetDefaultThreadCount(void)
+{
+	unsigned int count = std::thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+/*
+	Runs the queued jobs, then stops and joins the workers.
+*/
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i].join();
+}
+
+/*
+	Takes iterations of the current loop, or queued jobs
+	when there are none, until the pool is destroyed.
+*/
+void ThreadPool::WorkerLoop(void)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	for (;;)
+	{
+		wake.wait(lock, [this]() { return stopping || nextTask < taskCount || !jobs.empty(); });
+
+		if (nextTask >= taskCount)
+		{
+			if (jobs.empty())
+				return;
+
+			std::function<void()> job = jobs.front();
+			jobs.pop_front();
+			lock.unlock();
+			job();
+			lock.lock();
+			continue;
+		}
+
+		unsigned int index = nextTask++;
+		const std::function<void(unsigned int)>* current = task;
+		lock.unlock();
+		(*current)(index);
+		lock.lock();
+
+		if (++finishedTasks == taskCount)
+			done.notify_all();
+	}
+}
\ No newline at end of file
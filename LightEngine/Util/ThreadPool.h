@@ -0,0 +1,59 @@
+#pragma once
+
+// Includes.
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <deque>
+
+/*
+	Fixed set of worker threads that run the iterations of
+	a parallel loop. The calling thread works on the loop
+	too, so a pool of n threads starts n - 1 workers and a
+	pool of 1 runs everything inline.
+
+	Iterations are handed out one at a time under a lock,
+	which suits coarse tasks such as one mesh each. Tasks
+	must not call ParallelFor() on the same pool.
+
+	Jobs queued with Submit() run in the background,
+	whenever no loop iterations are waiting.
+*/
+class ThreadPool
+{
+public:
+
+// Functions
+
+	ThreadPool(unsigned int threadCount);
+	void ParallelFor(unsigned int count, const std::function<void(unsigned int)>& task);
+	void Submit(const std::function<void()>& job);
+	unsigned int GetThreadCount(void) const;
+	static unsigned int GetDefaultThreadCount(void);
+	~ThreadPool();
+
+private:
+
+// Functions
+
+	// Owns threads, so it can't be copied.
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	void WorkerLoop(void);
+
+// Variables
+
+	std::vector<std::thread>					workers;
+	std::mutex									mutex;
+	std::condition_variable						wake;			// Signals new iterations, jobs or shutdown.
+	std::condition_variable						done;			// Signals the last finished iteration.
+	const std::function<void(unsigned int)>*	task;
+	unsigned int								taskCount;
+	unsigned int								nextTask;
+	unsigned int								finishedTasks;
+	std::deque<std::function<void()> >			jobs;
+	bool										stopping;
+};
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "UniformBuffer.h"
+#include <cstring>
+
+namespace
+{
+	struct BlockBinding
+	{
+		const char*	name;
+		GLuint		binding;
+	};
+
+	// Block names as declared in the shaders.
+	const BlockBinding blockBindings[] = {
+		{ "FrameConstants", UNIFORM_BINDING_FRAME },
+		{ "LightConstants", UNIFORM_BINDING_LIGHTS },
+		{ "ShadowConstants", UNIFORM_BINDING_SHADOWS }
+	};
+}
+
+/*
+	Default constructor.
+*/
+UniformBuffer::UniformBuffer()
+{
+	buffer = 0;
+	size = 0;
+}
+
+/*
+	Allocates the buffer and binds it to its binding point.
+
+	binding	-	One of the UNIFORM_BINDING_* points.
+	size	-	Size of the block's struct, e.g. sizeof(FrameConstants).
+*/
+void UniformBuffer::Create(GLuint binding, GLsizeiptr size)
+{
+	this->size = size;
+	contents.clear();
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+
+	LOG_DEBUG(LOG_CATEGORY_RENDER, "Uniform buffer created.");
+}
+
+/*
+	Uploads the whole block, unless it is identical to
+	the last upload.
+
+	data	-	Block struct of the size given to Create().
+*/
+void UniformBuffer::Update(const void* data)
+{
+	if (!contents.empty() && memcmp(&contents[0], data, size) == 0)
+		return;
+
+	contents.assign((const char*)data, (const char*)data + size);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/*
+	Deletes the buffer.
+*/
+void UniformBuffer::Destroy(void)
+{
+	if (buffer != 0)
+		glDeleteBuffers(1, &buffer);
+
+	buffer = 0;
+	contents.clear();
+}
+
+/*
+	Binding point of the shared block with the given
+	name, or -1 if the block is not a shared one.
+*/
+GLint UniformBuffer::GetBlockBinding(const char* blockName)
+{
+	for (unsigned int i = 0; i < sizeof(blockBindings) / sizeof(blockBindings[0]); ++i)
+	{
+		if (strcmp(blockBindings[i].name, blockName) == 0)
+			return (GLint)blockBindings[i].binding;
+	}
+
+	return -1;
+}
+
+/*
+	Destructor, the buffer is freed by Destroy().
+*/
+UniformBuffer::~UniformBuffer()
+{
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+// Includes.
+#include "..\Contrib\Include\gl\glew.h"
+#include "..\Contrib\Include\glm\glm.hpp"
+#include "Utility.h"
+#include <vector>
+
+// Binding points of the uniform blocks shared by all shaders.
+const GLuint UNIFORM_BINDING_FRAME = 0;
+const GLuint UNIFORM_BINDING_LIGHTS = 1;
+const GLuint UNIFORM_BINDING_SHADOWS = 2;
+
+/*
+	Contents of the FrameConstants block (std140) :
+	camera data, written once per frame.
+*/
+struct FrameConstants
+{
+	glm::mat4	view;
+	glm::mat4	projection;
+	glm::vec3	viewPos;
+	GLfloat		padding0;
+	glm::vec3	cameraDir;
+	GLfloat		padding1;
+};
+
+/*
+	Contents of the LightConstants block (std140).
+
+	lightPos		-	World-space position of the point light.
+	pointLightOn	-	1 if the point light is on.
+	flashLight		-	1 if the flash light is on.
+*/
+struct LightConstants
+{
+	glm::vec3	lightPos;
+	GLint		pointLightOn;
+	GLint		flashLight;
+	GLint		padding[3];
+};
+
+/*
+	Contents of the ShadowConstants block (std140) :
+	light-space matrices of the shadow maps.
+*/
+struct ShadowConstants
+{
+	glm::mat4	direcLightSpaceMatrix;
+	glm::mat4	pointLightSpaceMatrix;
+};
+
+/*
+	Uniform buffer object bound to a fixed binding point.
+	Shader binds every block it finds by name to the
+	matching point (see GetBlockBinding()), so a buffer
+	is written once and read by all programs.
+*/
+class UniformBuffer
+{
+public:
+
+// Functions
+
+	UniformBuffer();
+	void Create(GLuint binding, GLsizeiptr size);
+	void Update(const void* data);
+	void Destroy(void);
+	static GLint GetBlockBinding(const char* blockName);
+	~UniformBuffer();
+
+private:
+
+// Variables
+
+	GLuint				buffer;
+	GLsizeiptr			size;
+	std::vector<char>	contents;	// Last data uploaded, to skip identical updates.
+};
\ No newline at end of file
@@ -1,45 +1,171 @@
 #include "Utility.h"
 
+// Multiplier of the FNV-1a hash, and the offset basis and multiplier of its 32-bit variant.
+const unsigned long long FNV_PRIME = 1099511628211ULL;
+const unsigned int FNV_OFFSET_32 = 2166136261u;
+const unsigned int FNV_PRIME_32 = 16777619u;
+
 // Variables relevant for timer.
 __int64 countsPerSec;
-float secondsPerCount;
+__int64 startCount;
+double secondsPerCount;
 
 /*
 	Initializes the different components of
 	the Utility section : Timer and Logger.
+
+	logPath	-	File the Logger writes to.
 */
-void InitUtility()
+void InitUtility(const char* logPath)
 {
-	// Initialize Timer.
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	secondsPerCount = 1.0f / countsPerSec;
+	InitTimer();
 
 	// Initialize Logger.
-	std::ofstream outFile;
-	outFile.open("log.log", std::ios::out | std::ios::trunc);
-	outFile.close();
+	Logger::Init(logPath);
+}
+
+/*
+	Shuts down the Utility section, writing out
+	every message that is still queued in the Logger.
+*/
+void ShutdownUtility()
+{
+	Logger::Shutdown();
+}
+
+/*
+	Starts the timer, times are measured from here on.
+	Done by InitUtility(), tools that run without the
+	rest of the Utility section call it on its own.
+*/
+void InitTimer()
+{
+	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
+	QueryPerformanceCounter((LARGE_INTEGER*)&startCount);
+	secondsPerCount = 1.0 / (double)countsPerSec;
 }
 
 /*
 	Function to get the elapsed time in seconds
-	by using the performance counter of the CPU.
+	since InitTimer() by using the performance
+	counter of the CPU. Measured from engine start
+	and returned as a double so that precision
+	doesn't degrade with the machine's uptime.
+*/
+double getTimeElapsed()
+{
+	__int64 curTime;
+	QueryPerformanceCounter((LARGE_INTEGER*)&curTime);
+	return (curTime - startCount) * secondsPerCount;
+}
+
+/*
+	Function to get the elapsed time in nanoseconds
+	since InitTimer(). Whole seconds and the
+	remainder are converted separately so that the
+	multiplication can't overflow.
 */
-float getTimeElapsed()
+__int64 getTimeNanoseconds()
 {
 	__int64 curTime;
 	QueryPerformanceCounter((LARGE_INTEGER*)&curTime);
-	return curTime * secondsPerCount;
+
+	__int64 counts = curTime - startCount;
+	return (counts / countsPerSec) * 1000000000LL + ((counts % countsPerSec) * 1000000000LL) / countsPerSec;
+}
+
+/*
+	64-bit FNV-1a hash of a block of bytes. Passing the
+	result of a previous call as the hash continues it,
+	so several blocks can be hashed as one.
+
+	data	-	Bytes to hash.
+	size	-	Number of bytes.
+	hash	-	Hash to continue, FNV_OFFSET to start a new one.
+*/
+unsigned long long hashBytes(const void* data, size_t size, unsigned long long hash)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+/*
+	32-bit FNV-1a hash of a block of bytes, for hash
+	tables that don't need the 64-bit one.
+
+	data	-	Bytes to hash.
+	size	-	Number of bytes.
+*/
+unsigned int hashBytes32(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned int hash = FNV_OFFSET_32;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME_32;
+	}
+	return hash;
 }
 
 /*
 	Function to log messages to the log file
-	for debugging purposes.
+	for debugging purposes. Kept for existing
+	callers, new code should use the LOG_* macros.
 */
 void log(const char* message)
 {
-	std::ofstream outFile;
-	outFile.open("log.log", std::ios::app);
-	outFile << message;
-	outFile << "\n";
-	outFile.close();
+	LOG_INFO(LOG_CATEGORY_CORE, message);
+}
+
+/*
+	Writes a string as a quoted JSON string. File paths
+	contain backslashes, so escaping is required.
+
+	file	-	File to write to.
+	text	-	Null-terminated string.
+*/
+void writeJsonString(FILE* file, const char* text)
+{
+	fputc('"', file);
+	for (const char* c = text; *c != '\0'; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			fputc('\\', file);
+			fputc(*c, file);
+		}
+		else if ((unsigned char)*c < 0x20)
+		{
+			fprintf(file, "\\u%04x", (unsigned int)(unsigned char)*c);
+		}
+		else
+		{
+			fputc(*c, file);
+		}
+	}
+	fputc('"', file);
+}
+
+/*
+	Last write time of a file, in 100 ns units since 1601
+	(FILETIME), so that two files can be compared. Returns
+	false if the file doesn't exist.
+
+	path		-	Path to the file.
+	writeTime	-	Receives the last write time.
+*/
+bool getFileWriteTime(const char* path, unsigned long long& writeTime)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes))
+		return false;
+
+	writeTime = ((unsigned long long)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+	return true;
 }
\ No newline at end of file
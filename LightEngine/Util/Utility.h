@@ -4,8 +4,20 @@
 #include <Windows.h>
 #include <fstream>
 #include <iostream>
+#include <cstdio>
+#include "Logger.h"
+
+// Starting value of hashBytes(), the FNV-1a offset basis.
+const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
 
 // Function prototypes.
-void InitUtility();
-float getTimeElapsed();
+void InitUtility(const char* logPath = "log.log");
+void ShutdownUtility();
+void InitTimer();
+double getTimeElapsed();
+__int64 getTimeNanoseconds();
+unsigned long long hashBytes(const void* data, size_t size, unsigned long long hash = FNV_OFFSET);
+unsigned int hashBytes32(const void* data, size_t size);
+void writeJsonString(FILE* file, const char* text);
+bool getFileWriteTime(const char* path, unsigned long long& writeTime);
 void log(const char* message);
\ No newline at end of file